@@ -0,0 +1,360 @@
+#pragma once
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+/*
+ * A self-contained timing harness for the prac containers.
+ *
+ * Every benchmark case runs in a forked child process so that its
+ * peak RSS can be measured in isolation. The child runs the case a
+ * few times and reports the fastest repetition. Allocations are
+ * counted by replacing the global operator new, so include this
+ * header from exactly one translation unit per executable. Cases
+ * can also record how long individual operations took; those are
+ * reported as percentiles.
+ *
+ * Command line flags understood by bench::Suite:
+ *   --json <file>       also write the results to file as JSON
+ *   --filter <text>     only run cases whose name contains text
+ *   --scale <factor>    multiply every case's element count
+ *   --repetitions <n>   repetitions per case (default 3)
+ */
+
+namespace bench {
+/// Number of calls to the global operator new in this process.
+/// Atomic, since some benchmarks allocate from several threads.
+std::atomic<size_t> g_num_allocations(0);
+}; // namespace bench
+
+void *operator new(size_t size) {
+  bench::g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  bench::g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+  size_t align = static_cast<size_t>(alignment);
+  size = (size + align - 1) / align * align;
+  void *ptr = aligned_alloc(align, size == 0 ? align : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+  free(ptr);
+}
+
+namespace bench {
+
+/// Keep the compiler from optimizing away a value.
+template <typename T> inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Measures the part of a benchmark case between start() and stop().
+/*
+ * Time and allocations outside that window, e.g. building the input,
+ * are not counted.
+ */
+class Timer {
+public:
+  Timer() : m_elapsed_ns(0), m_allocations(0), m_running(false) {}
+
+  void start() {
+    m_running = true;
+    m_start_allocations = g_num_allocations.load();
+    m_start = std::chrono::steady_clock::now();
+  }
+
+  void stop() {
+    auto now = std::chrono::steady_clock::now();
+    m_elapsed_ns +=
+        std::chrono::duration<double, std::nano>(now - m_start).count();
+    m_allocations += g_num_allocations.load() - m_start_allocations;
+    m_running = false;
+  }
+
+  /// Record how long individual operations took, in nanoseconds.
+  /*
+   * For cases that report latency percentiles as well as throughput.
+   * Call it after stop(), since keeping the samples allocates.
+   */
+  void add_latencies(const std::vector<double> &latencies_ns) {
+    m_latencies_ns.insert(m_latencies_ns.end(), latencies_ns.begin(),
+                          latencies_ns.end());
+  }
+
+  double elapsed_ns() const { return m_elapsed_ns; }
+  size_t allocations() const { return m_allocations; }
+  bool running() const { return m_running; }
+  std::vector<double> &latencies_ns() { return m_latencies_ns; }
+
+private:
+  std::chrono::steady_clock::time_point m_start;
+  double m_elapsed_ns;
+  size_t m_start_allocations;
+  size_t m_allocations;
+  bool m_running;
+  std::vector<double> m_latencies_ns;
+};
+
+/// Percentiles of the latencies a case recorded.
+struct Latencies {
+  bool recorded;
+  double p50_ns;
+  double p90_ns;
+  double p99_ns;
+  double p999_ns;
+  double max_ns;
+};
+
+/// The measurements of one benchmark case.
+struct Result {
+  std::string name;
+  std::string container;
+  std::string type;
+  size_t ops;
+  double ns_per_op;
+  double allocs_per_op;
+  long peak_rss_kb;
+  Latencies latencies;
+  bool ok;
+};
+
+/// Runs benchmark cases and reports them.
+class Suite {
+public:
+  Suite(int argc, char **argv) : m_scale(1.0), m_repetitions(3) {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if (arg == "--json" && has_value) {
+        m_json_path = argv[++i];
+      } else if (arg == "--filter" && has_value) {
+        m_filter = argv[++i];
+      } else if (arg == "--scale" && has_value) {
+        m_scale = atof(argv[++i]);
+      } else if (arg == "--repetitions" && has_value) {
+        m_repetitions = atoi(argv[++i]);
+      } else {
+        fprintf(stderr,
+                "usage: %s [--json file] [--filter text] [--scale factor] "
+                "[--repetitions n]\n",
+                argv[0]);
+        exit(2);
+      }
+    }
+    if (m_repetitions < 1) {
+      m_repetitions = 1;
+    }
+    printf("%-28s %-18s %-12s %12s %12s %12s %12s\n", "benchmark", "container",
+           "type", "ops", "ns/op", "allocs/op", "peak rss kb");
+  }
+
+  /// Scale an element count by --scale.
+  size_t scaled(const size_t &n) const {
+    size_t result = size_t(double(n) * m_scale);
+    return result == 0 ? 1 : result;
+  }
+
+  /// Run one case.
+  /*
+   * @param name - the scenario, e.g. "push_back".
+   * @param container - the container under test, e.g. "prac::vector".
+   * @param type - the element type, e.g. "int".
+   * @param ops - the number of operations one run of body performs.
+   * @param body - a callable taking a Timer&. It sets up its input,
+   *               then brackets the measured work with start()/stop().
+   */
+  template <typename Body>
+  void run(const std::string &name, const std::string &container,
+           const std::string &type, const size_t &ops, Body body) {
+    std::string full_name = name + "/" + container + "/" + type;
+    if (!m_filter.empty() && full_name.find(m_filter) == std::string::npos) {
+      return;
+    }
+    Result result;
+    result.name = name;
+    result.container = container;
+    result.type = type;
+    result.ops = ops;
+    result.ok = false;
+    result.ns_per_op = 0;
+    result.allocs_per_op = 0;
+    result.peak_rss_kb = 0;
+    result.latencies.recorded = false;
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+      perror("pipe");
+      exit(1);
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      exit(1);
+    }
+    if (pid == 0) {
+      close(fds[0]);
+      Measurement measurement = measure(body);
+      ssize_t written = write(fds[1], &measurement, sizeof(measurement));
+      _exit(written == ssize_t(sizeof(measurement)) ? 0 : 1);
+    }
+    close(fds[1]);
+    Measurement measurement;
+    ssize_t num_read = read(fds[0], &measurement, sizeof(measurement));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (num_read == ssize_t(sizeof(measurement)) && WIFEXITED(status) &&
+        WEXITSTATUS(status) == 0) {
+      result.ok = true;
+      result.ns_per_op = measurement.elapsed_ns / double(ops);
+      result.allocs_per_op = double(measurement.allocations) / double(ops);
+      result.peak_rss_kb = measurement.peak_rss_kb;
+      result.latencies = measurement.latencies;
+      printf("%-28s %-18s %-12s %12zu %12.3f %12.4f %12ld\n", name.c_str(),
+             container.c_str(), type.c_str(), ops, result.ns_per_op,
+             result.allocs_per_op, result.peak_rss_kb);
+      if (result.latencies.recorded) {
+        printf("%-28s p50 %.0f ns, p90 %.0f ns, p99 %.0f ns, p99.9 %.0f ns, "
+               "max %.0f ns\n",
+               "", result.latencies.p50_ns, result.latencies.p90_ns,
+               result.latencies.p99_ns, result.latencies.p999_ns,
+               result.latencies.max_ns);
+      }
+    } else {
+      printf("%-28s %-18s %-12s FAILED\n", name.c_str(), container.c_str(),
+             type.c_str());
+    }
+    m_results.push_back(result);
+  }
+
+  /// Write the JSON report if one was requested.
+  /*
+   * @return the process exit code: non-zero if any case failed.
+   */
+  int finish() const {
+    bool all_ok = true;
+    for (const Result &result : m_results) {
+      all_ok = all_ok && result.ok;
+    }
+    if (m_json_path.empty()) {
+      return all_ok ? 0 : 1;
+    }
+    FILE *file = fopen(m_json_path.c_str(), "w");
+    if (file == nullptr) {
+      perror(m_json_path.c_str());
+      return 1;
+    }
+    fprintf(file, "{\n  \"scale\": %g,\n  \"repetitions\": %d,\n", m_scale,
+            m_repetitions);
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < m_results.size(); i++) {
+      const Result &result = m_results[i];
+      fprintf(file,
+              "    {\"name\": \"%s\", \"container\": \"%s\", \"type\": \"%s\", "
+              "\"ops\": %zu, \"ok\": %s, \"ns_per_op\": %.4f, "
+              "\"allocs_per_op\": %.6f, \"peak_rss_kb\": %ld",
+              result.name.c_str(), result.container.c_str(),
+              result.type.c_str(), result.ops, result.ok ? "true" : "false",
+              result.ns_per_op, result.allocs_per_op, result.peak_rss_kb);
+      if (result.latencies.recorded) {
+        fprintf(file,
+                ", \"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, "
+                "\"p999_ns\": %.1f, \"max_ns\": %.1f",
+                result.latencies.p50_ns, result.latencies.p90_ns,
+                result.latencies.p99_ns, result.latencies.p999_ns,
+                result.latencies.max_ns);
+      }
+      fprintf(file, "}%s\n", i + 1 < m_results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return all_ok ? 0 : 1;
+  }
+
+private:
+  /// What a child process reports back.
+  struct Measurement {
+    double elapsed_ns;
+    size_t allocations;
+    long peak_rss_kb;
+    Latencies latencies;
+  };
+
+  /// Run body m_repetitions times and keep the fastest run.
+  template <typename Body> Measurement measure(Body &body) const {
+    Measurement best;
+    best.elapsed_ns = -1;
+    best.allocations = 0;
+    best.latencies.recorded = false;
+    for (int rep = 0; rep < m_repetitions; rep++) {
+      Timer timer;
+      body(timer);
+      if (timer.running()) {
+        timer.stop();
+      }
+      if (best.elapsed_ns < 0 || timer.elapsed_ns() < best.elapsed_ns) {
+        best.elapsed_ns = timer.elapsed_ns();
+        best.allocations = timer.allocations();
+        best.latencies = percentiles(timer.latencies_ns());
+      }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    best.peak_rss_kb = usage.ru_maxrss;
+    return best;
+  }
+
+  /// Get the percentiles of a set of latencies, sorting them.
+  static Latencies percentiles(std::vector<double> &latencies_ns) {
+    Latencies latencies;
+    latencies.recorded = !latencies_ns.empty();
+    if (!latencies.recorded) {
+      return latencies;
+    }
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+    auto at = [&latencies_ns](const double &fraction) {
+      return latencies_ns[size_t(fraction * double(latencies_ns.size() - 1))];
+    };
+    latencies.p50_ns = at(0.5);
+    latencies.p90_ns = at(0.9);
+    latencies.p99_ns = at(0.99);
+    latencies.p999_ns = at(0.999);
+    latencies.max_ns = latencies_ns.back();
+    return latencies;
+  }
+
+  std::vector<Result> m_results;
+  std::string m_json_path;
+  std::string m_filter;
+  double m_scale;
+  int m_repetitions;
+};
+
+}; // namespace bench
@@ -0,0 +1,140 @@
+#include "bench.hpp"
+#include "btree_map.hpp"
+#include "vector.hpp"
+#include <map>
+#include <stdint.h>
+#include <utility>
+
+/*
+ * A time-series index: uint64 timestamps to uint64 values, in
+ * std::map and prac::btree_map. Builds from keys in random order
+ * (build), in increasing order (append) and, for btree_map, by bulk
+ * loading a sorted prac::vector (bulk_load); then random point
+ * lookups, and range scans of 1000 consecutive keys from random
+ * starting points, where ops counts the elements scanned. The build
+ * cases run first, so their peak rss kb compares the memory of the
+ * two containers.
+ */
+
+namespace {
+
+uint64_t nextRandom(uint64_t &state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+const size_t scan_length = 1000;
+
+/// n distinct keys, in a random order picked by seed.
+prac::vector<uint64_t> randomKeys(const size_t &n, uint64_t state) {
+  prac::vector<uint64_t> keys;
+  keys.reserve(n);
+  for (uint64_t i = 0; i < n; i++) {
+    keys.push_back(i * 16);
+  }
+  for (size_t i = n; i > 1; i--) {
+    std::swap(keys[i - 1], keys[nextRandom(state) % i]);
+  }
+  return keys;
+}
+
+template <typename Map>
+void benchBuild(bench::Suite &suite, const char *container, const size_t &n) {
+  prac::vector<uint64_t> keys = randomKeys(n, 88172645463325252ULL);
+  suite.run("build", container, "uint64", n, [&](bench::Timer &timer) {
+    timer.start();
+    Map map;
+    for (size_t i = 0; i < n; i++) {
+      map.emplace(keys[i], keys[i] + 1);
+    }
+    timer.stop();
+    bench::do_not_optimize(map.size());
+  });
+  suite.run("append", container, "uint64", n, [&](bench::Timer &timer) {
+    timer.start();
+    Map map;
+    for (uint64_t i = 0; i < n; i++) {
+      map.emplace(i * 16, i);
+    }
+    timer.stop();
+    bench::do_not_optimize(map.size());
+  });
+}
+
+void benchBulkLoad(bench::Suite &suite, const size_t &n) {
+  prac::vector<std::pair<uint64_t, uint64_t>> sorted;
+  sorted.reserve(n);
+  for (uint64_t i = 0; i < n; i++) {
+    sorted.push_back(std::make_pair(i * 16, i));
+  }
+  suite.run("bulk_load", "std::map", "uint64", n, [&](bench::Timer &timer) {
+    timer.start();
+    // With the end as a hint, each insert is amortized O(1).
+    std::map<uint64_t, uint64_t> map(sorted.begin(), sorted.end());
+    timer.stop();
+    bench::do_not_optimize(map.size());
+  });
+  suite.run("bulk_load", "prac::btree_map", "uint64", n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              prac::btree_map<uint64_t, uint64_t> map(prac::sorted_unique,
+                                                      sorted);
+              timer.stop();
+              bench::do_not_optimize(map.size());
+            });
+}
+
+template <typename Map>
+void benchQueries(bench::Suite &suite, const char *container, const size_t &n) {
+  prac::vector<uint64_t> keys = randomKeys(n, 88172645463325252ULL);
+  Map map;
+  for (size_t i = 0; i < n; i++) {
+    map.emplace(keys[i], keys[i] + 1);
+  }
+  // Looked up in another order than they were inserted in.
+  prac::vector<uint64_t> probes = randomKeys(n, 2463534242ULL);
+
+  suite.run("lookup", container, "uint64", n, [&](bench::Timer &timer) {
+    uint64_t total = 0;
+    timer.start();
+    for (size_t i = 0; i < n; i++) {
+      total += map.find(probes[i])->second;
+    }
+    timer.stop();
+    bench::do_not_optimize(total);
+  });
+
+  size_t num_scans = n / scan_length;
+  suite.run("range_scan", container, "uint64", num_scans * scan_length,
+            [&](bench::Timer &timer) {
+              uint64_t total = 0;
+              timer.start();
+              for (size_t i = 0; i < num_scans; i++) {
+                uint64_t from = probes[i] < (n - scan_length) * 16
+                                    ? probes[i]
+                                    : (n - scan_length) * 16;
+                auto it = map.lower_bound(from);
+                for (size_t j = 0; j < scan_length; j++, ++it) {
+                  total += it->second;
+                }
+              }
+              timer.stop();
+              bench::do_not_optimize(total);
+            });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  size_t n = suite.scaled(2000000);
+  benchBuild<std::map<uint64_t, uint64_t>>(suite, "std::map", n);
+  benchBuild<prac::btree_map<uint64_t, uint64_t>>(suite, "prac::btree_map", n);
+  benchBulkLoad(suite, n);
+  benchQueries<std::map<uint64_t, uint64_t>>(suite, "std::map", n);
+  benchQueries<prac::btree_map<uint64_t, uint64_t>>(suite, "prac::btree_map",
+                                                    n);
+  return suite.finish();
+}
@@ -0,0 +1,134 @@
+#include "bench.hpp"
+#include "concurrent_queue.hpp"
+#include "list.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+/*
+ * Latency of a shared work queue at 1, 4, 16 and 64 threads.
+ * prac::list behind a std::mutex is compared with
+ * prac::concurrent_queue. Every thread alternates a push and a pop on
+ * a queue that starts with some elements in it, and times each call;
+ * the push and pop cases report the percentiles of one or the other.
+ * Timing a call costs a clock read, which is included.
+ */
+
+namespace {
+
+/// A prac::list work queue behind a global lock.
+class LockedQueue {
+public:
+  void push(const uint64_t &value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_list.push_back(value);
+  }
+
+  bool try_pop(uint64_t &out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_list.size() == 0) {
+      return false;
+    }
+    out = m_list.front();
+    m_list.pop_front();
+    return true;
+  }
+
+private:
+  std::mutex m_mutex;
+  prac::list<uint64_t> m_list;
+};
+
+double nanosSince(const std::chrono::steady_clock::time_point &start) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/// Run the push/pop workload and record the latency of pushes, or of
+/// pops.
+template <typename Queue>
+void runQueue(bench::Timer &timer, const size_t &num_threads,
+              const size_t &n, const bool &time_push) {
+  Queue queue;
+  for (uint64_t i = 0; i < 1024; i++) {
+    queue.push(i);
+  }
+  size_t per_thread = n / num_threads;
+  std::vector<std::vector<double>> latencies(num_threads);
+  for (std::vector<double> &thread_latencies : latencies) {
+    thread_latencies.reserve(per_thread);
+  }
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::vector<double> &thread_latencies = latencies[t];
+      uint64_t out = 0;
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (size_t i = 0; i < per_thread; i++) {
+        auto start = std::chrono::steady_clock::now();
+        queue.push(t + i);
+        if (time_push) {
+          thread_latencies.push_back(nanosSince(start));
+        }
+        start = std::chrono::steady_clock::now();
+        queue.try_pop(out);
+        if (!time_push) {
+          thread_latencies.push_back(nanosSince(start));
+        }
+      }
+      bench::do_not_optimize(out);
+    });
+  }
+  timer.start();
+  go.store(true, std::memory_order_release);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  timer.stop();
+  for (const std::vector<double> &thread_latencies : latencies) {
+    timer.add_latencies(thread_latencies);
+  }
+}
+
+void benchThreads(bench::Suite &suite, const size_t &num_threads,
+                  const size_t &n) {
+  std::string suffix = "/" + std::to_string(num_threads) + "t";
+  // ops counts push/pop pairs.
+  size_t ops = n / num_threads * num_threads;
+  suite.run("queue_push", "mutex+list" + suffix, "uint64", ops,
+            [&](bench::Timer &timer) {
+              runQueue<LockedQueue>(timer, num_threads, n, true);
+            });
+  suite.run("queue_push", "concurrent_queue" + suffix, "uint64", ops,
+            [&](bench::Timer &timer) {
+              runQueue<prac::concurrent_queue<uint64_t>>(timer, num_threads,
+                                                         n, true);
+            });
+  suite.run("queue_pop", "mutex+list" + suffix, "uint64", ops,
+            [&](bench::Timer &timer) {
+              runQueue<LockedQueue>(timer, num_threads, n, false);
+            });
+  suite.run("queue_pop", "concurrent_queue" + suffix, "uint64", ops,
+            [&](bench::Timer &timer) {
+              runQueue<prac::concurrent_queue<uint64_t>>(timer, num_threads,
+                                                         n, false);
+            });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  size_t n = suite.scaled(1000000);
+  for (size_t num_threads : {1, 4, 16, 64}) {
+    benchThreads(suite, num_threads, n);
+  }
+  return suite.finish();
+}
@@ -0,0 +1,101 @@
+#include "bench.hpp"
+#include "concurrent_vector.hpp"
+#include "vector.hpp"
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+/*
+ * Append throughput under contention: 1, 2, 4, ... 32 writer threads
+ * (or the hardware thread count, if that is more) push_back into one
+ * shared container. prac::vector behind a std::mutex is compared with
+ * prac::concurrent_vector. ns/op is wall time per element appended,
+ * so a flat line across thread counts means appends don't scale, and
+ * a rising one means they collapse.
+ */
+
+namespace {
+
+/// Run body(thread_index, count) on num_threads threads that start
+/// together, timing from the start signal to the last join.
+template <typename Body>
+void runWriters(bench::Timer &timer, const size_t &num_threads,
+                const size_t &n, Body body) {
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    size_t count = n / num_threads + (t < n % num_threads ? 1 : 0);
+    threads.emplace_back([&go, &body, t, count]() {
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      body(t, count);
+    });
+  }
+  timer.start();
+  go.store(true, std::memory_order_release);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  timer.stop();
+}
+
+void benchThreads(bench::Suite &suite, const size_t &num_threads,
+                  const size_t &n) {
+  std::string suffix = "/" + std::to_string(num_threads) + "t";
+
+  suite.run("concurrent_push_back", "mutex+vector" + suffix, "uint64", n,
+            [&](bench::Timer &timer) {
+              prac::vector<uint64_t> values;
+              std::mutex mutex;
+              runWriters(timer, num_threads, n,
+                         [&](const size_t &t, const size_t &count) {
+                           for (size_t i = 0; i < count; i++) {
+                             std::lock_guard<std::mutex> lock(mutex);
+                             values.push_back(t + i);
+                           }
+                         });
+              bench::do_not_optimize(values.size());
+            });
+  suite.run("concurrent_push_back", "concurrent_vector" + suffix, "uint64",
+            n, [&](bench::Timer &timer) {
+              prac::concurrent_vector<uint64_t> values;
+              runWriters(timer, num_threads, n,
+                         [&](const size_t &t, const size_t &count) {
+                           for (size_t i = 0; i < count; i++) {
+                             values.push_back(t + i);
+                           }
+                         });
+              bench::do_not_optimize(values.size());
+            });
+  suite.run("concurrent_grow_by_64", "concurrent_vector" + suffix, "uint64",
+            n, [&](bench::Timer &timer) {
+              prac::concurrent_vector<uint64_t> values;
+              runWriters(timer, num_threads, n,
+                         [&](const size_t &t, const size_t &count) {
+                           for (size_t i = 0; i < count; i += 64) {
+                             values.grow_by(count - i < 64 ? count - i : 64,
+                                            t);
+                           }
+                         });
+              bench::do_not_optimize(values.size());
+            });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  size_t n = suite.scaled(4000000);
+  size_t max_threads = std::thread::hardware_concurrency();
+  if (max_threads < 32) {
+    max_threads = 32;
+  }
+  for (size_t num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+    benchThreads(suite, num_threads, n);
+  }
+  benchThreads(suite, max_threads, n);
+  return suite.finish();
+}
@@ -0,0 +1,373 @@
+#include "bench.hpp"
+#include "list.hpp"
+#include "mmap_vector.hpp"
+#include "serialize.hpp"
+#include "vector.hpp"
+#include <algorithm>
+#include <list>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+ * Compares prac::vector and prac::list against std::vector and
+ * std::list on a few workloads, each with int, std::string and a
+ * large POD element type. For the trivially copyable types,
+ * cold_start compares loading a table from a file into a
+ * prac::vector with opening it as a prac::mmap_vector, and
+ * checkpoint/restore time prac::serial against writing and reading
+ * the elements one at a time.
+ */
+
+namespace {
+
+/// A 128-byte trivially copyable record.
+struct LargePod {
+  uint64_t key;
+  uint64_t payload[15];
+  bool operator<(const LargePod &other) const { return key < other.key; }
+};
+
+uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+template <typename T> T makeValue(const uint64_t &seed);
+
+template <> int makeValue<int>(const uint64_t &seed) {
+  return int(mix(seed) & 0x7fffffff);
+}
+
+template <> std::string makeValue<std::string>(const uint64_t &seed) {
+  // Long enough to defeat the small string optimization.
+  std::string value(24, 'a');
+  uint64_t bits = mix(seed);
+  for (size_t i = 0; i < value.size(); i++) {
+    value[i] = char('a' + (bits >> (i % 8 * 8)) % 26);
+  }
+  return value;
+}
+
+template <> LargePod makeValue<LargePod>(const uint64_t &seed) {
+  LargePod value;
+  value.key = mix(seed);
+  for (size_t i = 0; i < 15; i++) {
+    value.payload[i] = value.key + i;
+  }
+  return value;
+}
+
+uint64_t checksum(const int &value) { return uint64_t(value); }
+uint64_t checksum(const std::string &value) { return value.size(); }
+uint64_t checksum(const LargePod &value) { return value.key; }
+
+template <typename T> std::vector<T> makeInput(const size_t &n) {
+  std::vector<T> input;
+  input.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    input.push_back(makeValue<T>(i));
+  }
+  return input;
+}
+
+template <typename Vector, typename T>
+void benchPushBack(bench::Suite &suite, const std::string &container,
+                   const std::string &type, const size_t &n) {
+  suite.run("push_back", container, type, n, [&](bench::Timer &timer) {
+    std::vector<T> input = makeInput<T>(n);
+    timer.start();
+    Vector vec;
+    for (size_t i = 0; i < n; i++) {
+      vec.push_back(input[i]);
+    }
+    timer.stop();
+    bench::do_not_optimize(vec[n - 1]);
+  });
+}
+
+template <typename Container, typename T>
+void benchSequentialIteration(bench::Suite &suite,
+                              const std::string &container,
+                              const std::string &type, const size_t &n) {
+  suite.run("iterate_sequential", container, type, n,
+            [&](bench::Timer &timer) {
+              std::vector<T> input = makeInput<T>(n);
+              Container values(input.begin(), input.end());
+              timer.start();
+              uint64_t sum = 0;
+              for (const auto &value : values) {
+                sum += checksum(value);
+              }
+              timer.stop();
+              bench::do_not_optimize(sum);
+            });
+}
+
+template <typename Vector, typename T>
+void benchRandomIteration(bench::Suite &suite, const std::string &container,
+                          const std::string &type, const size_t &n) {
+  suite.run("iterate_random", container, type, n, [&](bench::Timer &timer) {
+    std::vector<T> input = makeInput<T>(n);
+    Vector values(input.begin(), input.end());
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; i++) {
+      order[i] = mix(i + n) % n;
+    }
+    timer.start();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += checksum(values[order[i]]);
+    }
+    timer.stop();
+    bench::do_not_optimize(sum);
+  });
+}
+
+template <typename Vector, typename T>
+void benchSort(bench::Suite &suite, const std::string &container,
+               const std::string &type, const size_t &n) {
+  suite.run("sort", container, type, n, [&](bench::Timer &timer) {
+    std::vector<T> input = makeInput<T>(n);
+    Vector values(input.begin(), input.end());
+    timer.start();
+    std::sort(values.begin(), values.end());
+    timer.stop();
+    bench::do_not_optimize(values[0]);
+  });
+}
+
+template <typename List, typename T>
+void benchQueueChurn(bench::Suite &suite, const std::string &container,
+                     const std::string &type, const size_t &n) {
+  // A queue that stays at a steady depth: one push_back and one
+  // pop_front per operation.
+  const size_t depth = 1024;
+  suite.run("list_queue_churn", container, type, n,
+            [&](bench::Timer &timer) {
+              std::vector<T> input = makeInput<T>(depth);
+              List queue;
+              for (size_t i = 0; i < depth; i++) {
+                queue.push_back(input[i]);
+              }
+              timer.start();
+              uint64_t sum = 0;
+              for (size_t i = 0; i < n; i++) {
+                sum += checksum(queue.front());
+                queue.pop_front();
+                queue.push_back(input[i % depth]);
+              }
+              timer.stop();
+              bench::do_not_optimize(sum);
+            });
+}
+
+template <typename List, typename T>
+void benchListSort(bench::Suite &suite, const std::string &container,
+                   const std::string &type, const size_t &n) {
+  // Both sorts relink nodes in place, so only the comparisons and the
+  // pointer chasing are timed.
+  suite.run("list_sort", container, type, n, [&](bench::Timer &timer) {
+    std::vector<T> input = makeInput<T>(n);
+    List values(input.begin(), input.end());
+    timer.start();
+    values.sort();
+    timer.stop();
+    bench::do_not_optimize(values.front());
+  });
+}
+
+template <typename Container, typename T>
+void benchRangeConstruction(bench::Suite &suite, const std::string &container,
+                            const std::string &type, const size_t &n) {
+  suite.run("range_construct", container, type, n, [&](bench::Timer &timer) {
+    std::vector<T> input = makeInput<T>(n);
+    timer.start();
+    Container values(input.begin(), input.end());
+    timer.stop();
+    bench::do_not_optimize(values.size());
+  });
+}
+
+template <typename T>
+void benchColdStart(bench::Suite &suite, const std::string &type,
+                    const size_t &n) {
+  char name[] = "/tmp/prac_bench_cold_start_XXXXXX";
+  int fd = mkstemp(name);
+  if (fd < 0) {
+    return;
+  }
+  close(fd);
+  std::string path = name;
+  {
+    std::vector<T> input = makeInput<T>(n);
+    prac::mmap_vector<T> table(path);
+    table.append(input.begin(), input.end());
+  }
+  // What a service does on restart today: read every record and push
+  // it back.
+  suite.run("cold_start", "prac::vector", type, n, [&](bench::Timer &timer) {
+    timer.start();
+    FILE *file = fopen(path.c_str(), "rb");
+    fseek(file, long(prac::mmap_vector<T>::header_bytes), SEEK_SET);
+    prac::vector<T> table;
+    T value;
+    while (fread(&value, sizeof(T), 1, file) == 1) {
+      table.push_back(value);
+    }
+    fclose(file);
+    timer.stop();
+    bench::do_not_optimize(table[n / 2]);
+  });
+  // Opening the mapping and touching one element, which faults in a
+  // single page.
+  suite.run("cold_start", "prac::mmap_vector", type, n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              prac::mmap_vector<T> table(path);
+              bench::do_not_optimize(table[n / 2]);
+              timer.stop();
+            });
+  unlink(path.c_str());
+}
+
+/// Write one element the way a hand-rolled checkpoint does.
+void writeElement(FILE *file, const int &value) {
+  fwrite(&value, sizeof(value), 1, file);
+}
+void writeElement(FILE *file, const LargePod &value) {
+  fwrite(&value, sizeof(value), 1, file);
+}
+void writeElement(FILE *file, const std::string &value) {
+  uint64_t length = value.size();
+  fwrite(&length, sizeof(length), 1, file);
+  fwrite(value.data(), 1, value.size(), file);
+}
+
+bool readElement(FILE *file, int &value) {
+  return fread(&value, sizeof(value), 1, file) == 1;
+}
+bool readElement(FILE *file, LargePod &value) {
+  return fread(&value, sizeof(value), 1, file) == 1;
+}
+bool readElement(FILE *file, std::string &value) {
+  uint64_t length;
+  if (fread(&length, sizeof(length), 1, file) != 1) {
+    return false;
+  }
+  value.resize(length);
+  return fread(&value[0], 1, length, file) == length;
+}
+
+template <typename T>
+void writeElementByElement(const std::string &path,
+                           const prac::vector<T> &values) {
+  FILE *file = fopen(path.c_str(), "wb");
+  for (const T &value : values) {
+    writeElement(file, value);
+  }
+  fclose(file);
+}
+
+template <typename T>
+void writeSerialized(const int &fd, const prac::vector<T> &values) {
+  ftruncate(fd, 0);
+  lseek(fd, 0, SEEK_SET);
+  prac::serial::write(fd, values);
+}
+
+template <typename T>
+void benchCheckpoint(bench::Suite &suite, const std::string &type,
+                     const size_t &n) {
+  char name[] = "/tmp/prac_bench_checkpoint_XXXXXX";
+  int fd = mkstemp(name);
+  if (fd < 0) {
+    return;
+  }
+  std::string path = name;
+  std::vector<T> input = makeInput<T>(n);
+  prac::vector<T> values(input.begin(), input.end());
+  suite.run("checkpoint", "element_by_element", type, n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              writeElementByElement(path, values);
+              timer.stop();
+            });
+  suite.run("restore", "element_by_element", type, n,
+            [&](bench::Timer &timer) {
+              writeElementByElement(path, values);
+              timer.start();
+              FILE *file = fopen(path.c_str(), "rb");
+              prac::vector<T> restored;
+              T value;
+              while (readElement(file, value)) {
+                restored.push_back(value);
+              }
+              fclose(file);
+              timer.stop();
+              bench::do_not_optimize(restored.size());
+            });
+  suite.run("checkpoint", "prac::serial", type, n, [&](bench::Timer &timer) {
+    timer.start();
+    writeSerialized(fd, values);
+    timer.stop();
+  });
+  suite.run("restore", "prac::serial", type, n, [&](bench::Timer &timer) {
+    writeSerialized(fd, values);
+    timer.start();
+    lseek(fd, 0, SEEK_SET);
+    prac::vector<T> restored;
+    prac::serial::read(fd, restored);
+    timer.stop();
+    bench::do_not_optimize(restored.size());
+  });
+  close(fd);
+  unlink(path.c_str());
+}
+
+template <typename T>
+void benchType(bench::Suite &suite, const std::string &type,
+               const size_t &n) {
+  benchPushBack<prac::vector<T>, T>(suite, "prac::vector", type, n);
+  benchPushBack<std::vector<T>, T>(suite, "std::vector", type, n);
+
+  benchSequentialIteration<prac::vector<T>, T>(suite, "prac::vector", type,
+                                               n);
+  benchSequentialIteration<std::vector<T>, T>(suite, "std::vector", type, n);
+  benchSequentialIteration<prac::list<T>, T>(suite, "prac::list", type, n);
+  benchSequentialIteration<std::list<T>, T>(suite, "std::list", type, n);
+
+  benchRandomIteration<prac::vector<T>, T>(suite, "prac::vector", type, n);
+  benchRandomIteration<std::vector<T>, T>(suite, "std::vector", type, n);
+
+  benchSort<prac::vector<T>, T>(suite, "prac::vector", type, n);
+  benchSort<std::vector<T>, T>(suite, "std::vector", type, n);
+
+  benchQueueChurn<prac::list<T>, T>(suite, "prac::list", type, n);
+  benchQueueChurn<std::list<T>, T>(suite, "std::list", type, n);
+
+  benchListSort<prac::list<T>, T>(suite, "prac::list", type, n);
+  benchListSort<std::list<T>, T>(suite, "std::list", type, n);
+
+  benchRangeConstruction<prac::vector<T>, T>(suite, "prac::vector", type, n);
+  benchRangeConstruction<std::vector<T>, T>(suite, "std::vector", type, n);
+  benchRangeConstruction<prac::list<T>, T>(suite, "prac::list", type, n);
+  benchRangeConstruction<std::list<T>, T>(suite, "std::list", type, n);
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  benchType<int>(suite, "int", suite.scaled(1000000));
+  benchType<std::string>(suite, "std::string", suite.scaled(200000));
+  benchType<LargePod>(suite, "LargePod", suite.scaled(200000));
+  benchColdStart<int>(suite, "int", suite.scaled(1000000));
+  benchColdStart<LargePod>(suite, "LargePod", suite.scaled(200000));
+  benchCheckpoint<int>(suite, "int", suite.scaled(1000000));
+  benchCheckpoint<std::string>(suite, "std::string", suite.scaled(200000));
+  benchCheckpoint<LargePod>(suite, "LargePod", suite.scaled(200000));
+  return suite.finish();
+}
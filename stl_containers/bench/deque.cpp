@@ -0,0 +1,75 @@
+#include "bench.hpp"
+#include "deque.hpp"
+#include "list.hpp"
+#include <deque>
+#include <stdint.h>
+
+/*
+ * A windowed aggregation: a running sum over the last 1000 values of
+ * a stream, kept in a FIFO that is pushed at the back and popped at
+ * the front once per value, with prac::list, std::deque and
+ * prac::deque. window_index reads the window at random offsets, which
+ * prac::list can't do.
+ */
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+template <typename Fifo>
+void benchWindow(bench::Suite &suite, const char *container, const size_t &n,
+                 const size_t &window) {
+  suite.run("window_sum", container, "int64", n, [&](bench::Timer &timer) {
+    Fifo fifo;
+    int64_t sum = 0;
+    for (size_t i = 0; i < window; i++) {
+      fifo.push_back(int64_t(i));
+      sum += int64_t(i);
+    }
+    timer.start();
+    for (size_t i = window; i < n + window; i++) {
+      int64_t value = int64_t(mix(i) & 0xffff);
+      fifo.push_back(value);
+      sum += value - fifo.front();
+      fifo.pop_front();
+    }
+    timer.stop();
+    bench::do_not_optimize(sum);
+  });
+}
+
+template <typename Fifo>
+void benchIndex(bench::Suite &suite, const char *container, const size_t &n,
+                const size_t &window) {
+  suite.run("window_index", container, "int64", n, [&](bench::Timer &timer) {
+    Fifo fifo;
+    for (size_t i = 0; i < window; i++) {
+      fifo.push_back(int64_t(i));
+    }
+    timer.start();
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += fifo[mix(i) % window];
+    }
+    timer.stop();
+    bench::do_not_optimize(sum);
+  });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  size_t n = suite.scaled(10000000);
+  benchWindow<prac::list<int64_t>>(suite, "prac::list", n, 1000);
+  benchWindow<std::deque<int64_t>>(suite, "std::deque", n, 1000);
+  benchWindow<prac::deque<int64_t>>(suite, "prac::deque", n, 1000);
+  benchIndex<std::deque<int64_t>>(suite, "std::deque", n, 1000000);
+  benchIndex<prac::deque<int64_t>>(suite, "prac::deque", n, 1000000);
+  return suite.finish();
+}
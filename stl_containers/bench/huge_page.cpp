@@ -0,0 +1,79 @@
+#include "bench.hpp"
+#include "huge_page.hpp"
+#include "simd.hpp"
+#include "vector.hpp"
+#include <stdint.h>
+#include <string>
+
+/*
+ * What storage alignment and page size do to prac::vector.
+ *
+ * simd_sum runs prac::simd::sum over float arrays that fit in L1,
+ * allocated with the default allocator and 64-byte aligned. Default
+ * storage is only 16-byte aligned, so some of the wide loads straddle
+ * two cache lines.
+ *
+ * random_gather reads random elements of a 512MB array in 4KB pages
+ * and in transparent huge pages. With 4KB pages, nearly every read
+ * misses the TLB.
+ */
+
+namespace {
+
+template <typename Vector>
+void benchSimdSum(bench::Suite &suite, const std::string &container,
+                  const size_t &n) {
+  const size_t length = 4000;
+  const size_t passes = n / length == 0 ? 1 : n / length;
+  suite.run("simd_sum", container, "float", passes * length,
+            [&](bench::Timer &timer) {
+              Vector input;
+              for (size_t i = 0; i < length; i++) {
+                input.push_back(float(i % 100));
+              }
+              timer.start();
+              for (size_t pass = 0; pass < passes; pass++) {
+                bench::do_not_optimize(
+                    prac::simd::sum(input.data(), input.size()));
+              }
+              timer.stop();
+            });
+}
+
+template <typename Vector>
+void benchRandomGather(bench::Suite &suite, const std::string &container,
+                       const size_t &length, const size_t &n) {
+  suite.run("random_gather", container, "uint64", n,
+            [&](bench::Timer &timer) {
+              Vector values;
+              values.resize(length);
+              for (size_t i = 0; i < length; i++) {
+                values[i] = i;
+              }
+              timer.start();
+              uint64_t sum = 0;
+              uint64_t state = 12345;
+              for (size_t i = 0; i < n; i++) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                sum += values[(state >> 20) % length];
+              }
+              timer.stop();
+              bench::do_not_optimize(sum);
+            });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  size_t n = suite.scaled(20000000);
+  benchSimdSum<prac::vector<float>>(suite, "prac::vector", n);
+  benchSimdSum<prac::aligned_vector<float, 64>>(suite, "aligned_vector<64>",
+                                                n);
+  size_t length = suite.scaled(size_t(64) << 20);
+  benchRandomGather<prac::vector<uint64_t>>(suite, "prac::vector", length, n);
+  benchRandomGather<
+      prac::vector<uint64_t, prac::huge_page_allocator<uint64_t>>>(
+      suite, "huge_page_allocator", length, n);
+  return suite.finish();
+}
@@ -0,0 +1,104 @@
+#include "bench.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+/*
+ * The speedup curve of prac::parallel: every algorithm on pools of 1,
+ * 2, 4, ... threads, up to the number of hardware threads. Compare
+ * each case's ns/op with the one-thread case of the same name.
+ */
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+prac::vector<double> makeInput(const size_t &n) {
+  prac::vector<double> input;
+  input.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    input.push_back(double(mix(i) % 1000000) / 1000.0);
+  }
+  return input;
+}
+
+void benchThreads(bench::Suite &suite, const size_t &num_threads,
+                  const size_t &n) {
+  prac::parallel::thread_pool pool(num_threads);
+  std::string container =
+      "parallel/" + std::to_string(num_threads) + "t";
+
+  suite.run("parallel_for_sqrt", container, "double", n,
+            [&](bench::Timer &timer) {
+              prac::vector<double> values = makeInput(n);
+              timer.start();
+              prac::parallel::parallel_for(
+                  values, [](double &value) { value = sqrt(value) * 1.5; },
+                  0, pool);
+              timer.stop();
+              bench::do_not_optimize(values[n / 2]);
+            });
+  suite.run("parallel_reduce_sum", container, "double", n,
+            [&](bench::Timer &timer) {
+              prac::vector<double> values = makeInput(n);
+              timer.start();
+              double sum = prac::parallel::parallel_reduce(
+                  values, 0.0,
+                  [](const double &x, const double &y) { return x + y; }, 0,
+                  pool);
+              timer.stop();
+              bench::do_not_optimize(sum);
+            });
+  suite.run("parallel_transform", container, "double", n,
+            [&](bench::Timer &timer) {
+              prac::vector<double> values = makeInput(n);
+              prac::vector<double> out;
+              timer.start();
+              prac::parallel::parallel_transform(
+                  values, out, [](const double &x) { return x * x + 1.0; },
+                  0, pool);
+              timer.stop();
+              bench::do_not_optimize(out[n / 2]);
+            });
+  suite.run("parallel_sort", container, "double", n,
+            [&](bench::Timer &timer) {
+              prac::vector<double> values = makeInput(n);
+              timer.start();
+              prac::parallel::parallel_sort(values, std::less<double>(), 0,
+                                            pool);
+              timer.stop();
+              bench::do_not_optimize(values[0]);
+            });
+  suite.run("parallel_fill", container, "double", n,
+            [&](bench::Timer &timer) {
+              prac::vector<double> values;
+              timer.start();
+              prac::parallel::parallel_fill(values, n, 2.5, 0, pool);
+              timer.stop();
+              bench::do_not_optimize(values[n - 1]);
+            });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  size_t n = suite.scaled(20000000);
+  size_t max_threads = std::thread::hardware_concurrency();
+  if (max_threads == 0) {
+    max_threads = 1;
+  }
+  for (size_t num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+    benchThreads(suite, num_threads, n);
+  }
+  benchThreads(suite, max_threads, n);
+  return suite.finish();
+}
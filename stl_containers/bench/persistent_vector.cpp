@@ -0,0 +1,115 @@
+#include "bench.hpp"
+#include "persistent_vector.hpp"
+#include "vector.hpp"
+#include <stdint.h>
+
+/*
+ * A writer that keeps a table of n entries and publishes a snapshot
+ * of it after every update, as a copied prac::vector and as a
+ * prac::persistent_vector version. snapshot_update times 1000 such
+ * updates; the copy is O(n) per snapshot, the version O(log32 n).
+ * build times filling the table, and scan reading it back in order.
+ */
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+void benchSnapshots(bench::Suite &suite, const size_t &n) {
+  const size_t updates = 1000;
+
+  suite.run("build", "prac::vector", "int64", n, [&](bench::Timer &timer) {
+    timer.start();
+    prac::vector<int64_t> table;
+    for (size_t i = 0; i < n; i++) {
+      table.push_back(int64_t(i));
+    }
+    timer.stop();
+    bench::do_not_optimize(table[n / 2]);
+  });
+  suite.run("build", "prac::persistent_vector", "int64", n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              prac::persistent_vector<int64_t> table;
+              for (size_t i = 0; i < n; i++) {
+                table = table.push_back(int64_t(i));
+              }
+              timer.stop();
+              bench::do_not_optimize(table[n / 2]);
+            });
+  suite.run("build", "prac::transient_vector", "int64", n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              prac::transient_vector<int64_t> edit;
+              for (size_t i = 0; i < n; i++) {
+                edit.push_back(int64_t(i));
+              }
+              prac::persistent_vector<int64_t> table = edit.persistent();
+              timer.stop();
+              bench::do_not_optimize(table[n / 2]);
+            });
+
+  prac::vector<int64_t> copied;
+  prac::transient_vector<int64_t> edit;
+  for (size_t i = 0; i < n; i++) {
+    copied.push_back(int64_t(i));
+    edit.push_back(int64_t(i));
+  }
+  prac::persistent_vector<int64_t> versioned = edit.persistent();
+
+  suite.run("snapshot_update", "prac::vector", "int64", updates,
+            [&](bench::Timer &timer) {
+              prac::vector<int64_t> current = copied;
+              timer.start();
+              for (size_t i = 0; i < updates; i++) {
+                prac::vector<int64_t> snapshot = current;
+                snapshot[mix(i) % n] = int64_t(i);
+                current = std::move(snapshot);
+              }
+              timer.stop();
+              bench::do_not_optimize(current[0]);
+            });
+  suite.run("snapshot_update", "prac::persistent_vector", "int64", updates,
+            [&](bench::Timer &timer) {
+              prac::persistent_vector<int64_t> current = versioned;
+              timer.start();
+              for (size_t i = 0; i < updates; i++) {
+                current = current.set(mix(i) % n, int64_t(i));
+              }
+              timer.stop();
+              bench::do_not_optimize(current[0]);
+            });
+
+  suite.run("scan", "prac::vector", "int64", n, [&](bench::Timer &timer) {
+    timer.start();
+    int64_t total = 0;
+    for (const int64_t &value : copied) {
+      total += value;
+    }
+    timer.stop();
+    bench::do_not_optimize(total);
+  });
+  suite.run("scan", "prac::persistent_vector", "int64", n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              int64_t total = 0;
+              for (const int64_t &value : versioned) {
+                total += value;
+              }
+              timer.stop();
+              bench::do_not_optimize(total);
+            });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  benchSnapshots(suite, suite.scaled(1000000));
+  return suite.finish();
+}
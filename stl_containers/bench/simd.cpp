@@ -0,0 +1,107 @@
+#include "bench.hpp"
+#include "simd.hpp"
+#include <stdint.h>
+#include <string>
+
+#ifdef PRAC_SIMD_X86
+// transform()'s operations on wide vectors are always inlined; see
+// simd.hpp.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+/*
+ * Compares the prac::simd kernels on every instruction set this CPU
+ * supports, including the scalar loops they fall back to.
+ */
+
+namespace {
+
+template <typename T> prac::vector<T> makeInput(const size_t &n) {
+  prac::vector<T> input;
+  input.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    input.push_back(T(i % 1000));
+  }
+  return input;
+}
+
+template <typename T>
+void benchType(bench::Suite &suite, const std::string &type, const size_t &n,
+               const prac::simd::isa &set) {
+  // Each case makes several passes over an array that fits in L2, so
+  // the kernels rather than memory bandwidth are measured.
+  const size_t length = 16384;
+  const size_t passes = n / length == 0 ? 1 : n / length;
+  const size_t ops = passes * length;
+  std::string container = std::string("simd/") + prac::simd::isa_name(set);
+  prac::simd::set_isa(set);
+
+  suite.run("sum", container, type, ops, [&](bench::Timer &timer) {
+    prac::vector<T> input = makeInput<T>(length);
+    timer.start();
+    for (size_t pass = 0; pass < passes; pass++) {
+      bench::do_not_optimize(prac::simd::sum(input));
+    }
+    timer.stop();
+  });
+  suite.run("min_max", container, type, ops, [&](bench::Timer &timer) {
+    prac::vector<T> input = makeInput<T>(length);
+    timer.start();
+    for (size_t pass = 0; pass < passes; pass++) {
+      bench::do_not_optimize(prac::simd::min(input));
+      bench::do_not_optimize(prac::simd::max(input));
+    }
+    timer.stop();
+  });
+  suite.run("find_missing", container, type, ops, [&](bench::Timer &timer) {
+    prac::vector<T> input = makeInput<T>(length);
+    timer.start();
+    for (size_t pass = 0; pass < passes; pass++) {
+      bench::do_not_optimize(prac::simd::find(input, T(5000)));
+    }
+    timer.stop();
+  });
+  suite.run("count", container, type, ops, [&](bench::Timer &timer) {
+    prac::vector<T> input = makeInput<T>(length);
+    timer.start();
+    for (size_t pass = 0; pass < passes; pass++) {
+      bench::do_not_optimize(prac::simd::count(input, T(7)));
+    }
+    timer.stop();
+  });
+  suite.run("dot", container, type, ops, [&](bench::Timer &timer) {
+    prac::vector<T> first = makeInput<T>(length);
+    prac::vector<T> second = makeInput<T>(length);
+    timer.start();
+    for (size_t pass = 0; pass < passes; pass++) {
+      bench::do_not_optimize(prac::simd::dot(first, second));
+    }
+    timer.stop();
+  });
+  suite.run("transform_multiply", container, type, ops,
+            [&](bench::Timer &timer) {
+              prac::vector<T> first = makeInput<T>(length);
+              prac::vector<T> second = makeInput<T>(length);
+              prac::vector<T> out(length);
+              timer.start();
+              for (size_t pass = 0; pass < passes; pass++) {
+                prac::simd::transform(first, second, out,
+                                      prac::simd::multiplies());
+                bench::do_not_optimize(out[pass % length]);
+              }
+              timer.stop();
+            });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  for (int set = 0; set <= int(prac::simd::detected_isa()); set++) {
+    size_t n = suite.scaled(50000000);
+    benchType<float>(suite, "float", n, prac::simd::isa(set));
+    benchType<int32_t>(suite, "int32", n, prac::simd::isa(set));
+    benchType<int64_t>(suite, "int64", n, prac::simd::isa(set));
+  }
+  return suite.finish();
+}
@@ -0,0 +1,117 @@
+#include "bench.hpp"
+#include "soa_vector.hpp"
+#include "vector.hpp"
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+/*
+ * Scan queries over a table of 64-byte records, stored as an array of
+ * structs (prac::vector<Record>) and as a structure of arrays
+ * (prac::soa_vector with one column per field). scan_sum adds up one
+ * field; scan_filter adds up one field of the rows where another
+ * passes a test. The struct layout drags the whole record through the
+ * cache for the one or two fields each query reads.
+ */
+
+namespace {
+
+struct Record {
+  uint64_t id;
+  double price;
+  int32_t quantity;
+  int32_t flags;
+  char venue[16];
+  uint64_t extra[3];
+};
+
+typedef prac::soa_vector<uint64_t, double, int32_t, int32_t, uint64_t>
+    RecordColumns;
+
+uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+Record makeRecord(const uint64_t &seed) {
+  Record record;
+  memset(&record, 0, sizeof(record));
+  uint64_t bits = mix(seed);
+  record.id = seed;
+  record.price = double(bits % 100000) / 100;
+  record.quantity = int32_t(bits >> 32) % 1000;
+  record.flags = int32_t(bits >> 48) & 0xf;
+  record.extra[0] = bits;
+  return record;
+}
+
+void benchScans(bench::Suite &suite, const size_t &n) {
+  prac::vector<Record> records;
+  RecordColumns columns;
+  records.reserve(n);
+  columns.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    Record record = makeRecord(i);
+    records.push_back(record);
+    // The venue is left out of the columns; it would be a column of
+    // its own.
+    columns.emplace_back(record.id, record.price, record.quantity,
+                         record.flags, record.extra[0]);
+  }
+
+  suite.run("scan_sum", "prac::vector<Record>", "int32", n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              int64_t total = 0;
+              for (const Record &record : records) {
+                total += record.quantity;
+              }
+              timer.stop();
+              bench::do_not_optimize(total);
+            });
+  suite.run("scan_sum", "prac::soa_vector", "int32", n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              int64_t total = 0;
+              for (int32_t quantity : columns.column<2>()) {
+                total += quantity;
+              }
+              timer.stop();
+              bench::do_not_optimize(total);
+            });
+
+  suite.run("scan_filter", "prac::vector<Record>", "int32", n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              int64_t total = 0;
+              for (const Record &record : records) {
+                if (record.flags == 3) {
+                  total += record.quantity;
+                }
+              }
+              timer.stop();
+              bench::do_not_optimize(total);
+            });
+  suite.run("scan_filter", "prac::soa_vector", "int32", n,
+            [&](bench::Timer &timer) {
+              timer.start();
+              prac::span<const int32_t> quantities = columns.column<2>();
+              prac::span<const int32_t> flags = columns.column<3>();
+              int64_t total = 0;
+              for (size_t i = 0; i < quantities.size(); i++) {
+                total += flags[i] == 3 ? quantities[i] : 0;
+              }
+              timer.stop();
+              bench::do_not_optimize(total);
+            });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  benchScans(suite, suite.scaled(10000000));
+  return suite.finish();
+}
@@ -0,0 +1,138 @@
+#include "bench.hpp"
+#include "unordered_map.hpp"
+#include "vector.hpp"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/*
+ * A join's hash side: build a map of n keys, then probe it with keys
+ * that are all there (lookup_hit) or none of which are
+ * (lookup_miss), and churn it with an erase and an insert per op.
+ * std::unordered_map against prac::unordered_map, with uint64 keys and
+ * values and with std::string keys. peak rss kb of the build case
+ * compares their memory; each case runs in its own process.
+ */
+
+namespace {
+
+uint64_t nextRandom(uint64_t &state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+/// n distinct keys in random order, the same keys in another order to
+/// look up, and n keys that are none of them.
+template <typename Key> struct Keys {
+  prac::vector<Key> present;
+  prac::vector<Key> probes;
+  prac::vector<Key> absent;
+};
+
+template <typename Key> Key makeKey(const uint64_t &value);
+template <> uint64_t makeKey<uint64_t>(const uint64_t &value) { return value; }
+template <> std::string makeKey<std::string>(const uint64_t &value) {
+  // Long enough not to fit in the small string buffer.
+  return "customer-" + std::to_string(value) + "-0000000000";
+}
+
+template <typename Key> Keys<Key> makeKeys(const size_t &n) {
+  Keys<Key> keys;
+  uint64_t state = 88172645463325252ULL;
+  for (size_t i = 0; i < n; i++) {
+    // Even values are present, odd ones absent.
+    uint64_t value = nextRandom(state) & ~uint64_t(1);
+    keys.present.push_back(makeKey<Key>(value));
+    keys.absent.push_back(makeKey<Key>(value | 1));
+  }
+  keys.probes = keys.present;
+  for (size_t i = n; i > 1; i--) {
+    std::swap(keys.probes[i - 1], keys.probes[nextRandom(state) % i]);
+  }
+  return keys;
+}
+
+/// Run before any map is built in this process, so peak rss kb is
+/// the keys and the one map.
+template <typename Map, typename Key>
+void benchBuild(bench::Suite &suite, const char *container, const char *type,
+                const size_t &n) {
+  Keys<Key> keys = makeKeys<Key>(n);
+  suite.run("build", container, type, n, [&](bench::Timer &timer) {
+    timer.start();
+    Map map;
+    for (size_t i = 0; i < n; i++) {
+      map.emplace(keys.present[i], uint64_t(i));
+    }
+    timer.stop();
+    bench::do_not_optimize(map.size());
+  });
+}
+
+template <typename Map, typename Key>
+void benchMap(bench::Suite &suite, const char *container, const char *type,
+              const size_t &n) {
+  Keys<Key> keys = makeKeys<Key>(n);
+  Map map;
+  for (size_t i = 0; i < n; i++) {
+    map.emplace(keys.present[i], uint64_t(i));
+  }
+
+  suite.run("lookup_hit", container, type, n, [&](bench::Timer &timer) {
+    uint64_t total = 0;
+    timer.start();
+    for (size_t i = 0; i < n; i++) {
+      total += map.find(keys.probes[i])->second;
+    }
+    timer.stop();
+    bench::do_not_optimize(total);
+  });
+
+  suite.run("lookup_miss", container, type, n, [&](bench::Timer &timer) {
+    size_t found = 0;
+    timer.start();
+    for (size_t i = 0; i < n; i++) {
+      found += map.count(keys.absent[i]);
+    }
+    timer.stop();
+    bench::do_not_optimize(found);
+  });
+
+  suite.run("churn", container, type, n, [&](bench::Timer &timer) {
+    Map churned = map;
+    timer.start();
+    for (size_t i = 0; i < n; i++) {
+      churned.erase(keys.present[i]);
+      churned.emplace(keys.absent[i], uint64_t(i));
+    }
+    timer.stop();
+    bench::do_not_optimize(churned.size());
+  });
+}
+
+}; // namespace
+
+int main(int argc, char **argv) {
+  bench::Suite suite(argc, argv);
+  size_t n = suite.scaled(1000000);
+  benchBuild<std::unordered_map<uint64_t, uint64_t>, uint64_t>(
+      suite, "std::unordered_map", "uint64", n);
+  benchBuild<prac::unordered_map<uint64_t, uint64_t>, uint64_t>(
+      suite, "prac::unordered_map", "uint64", n);
+  benchBuild<std::unordered_map<std::string, uint64_t>, std::string>(
+      suite, "std::unordered_map", "string", n);
+  benchBuild<prac::unordered_map<std::string, uint64_t>, std::string>(
+      suite, "prac::unordered_map", "string", n);
+  benchMap<std::unordered_map<uint64_t, uint64_t>, uint64_t>(
+      suite, "std::unordered_map", "uint64", n);
+  benchMap<prac::unordered_map<uint64_t, uint64_t>, uint64_t>(
+      suite, "prac::unordered_map", "uint64", n);
+  benchMap<std::unordered_map<std::string, uint64_t>, std::string>(
+      suite, "std::unordered_map", "string", n);
+  benchMap<prac::unordered_map<std::string, uint64_t>, std::string>(
+      suite, "prac::unordered_map", "string", n);
+  return suite.finish();
+}
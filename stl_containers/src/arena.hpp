@@ -0,0 +1,196 @@
+#pragma once
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace prac {
+
+/// A bump-pointer arena that frees everything at once.
+/*
+ * Allocation is O(1): it rounds the cursor up to the requested
+ * alignment and advances it. Memory comes from the global operator
+ * new in blocks that double in size. Individual deallocation is a
+ * no-op, except that freeing the most recent allocation gives its
+ * space back. release() frees every block.
+ *
+ * Not thread-safe. Use one arena per thread, or thread_local_arena().
+ */
+class monotonic_arena {
+public:
+  /// Construct an empty arena.
+  /*
+   * No memory is requested until the first allocation.
+   * @param initial_block_size - the size in bytes of the first block.
+   */
+  explicit monotonic_arena(const size_t &initial_block_size = 4096)
+      : m_blocks(nullptr), m_cursor(nullptr), m_end(nullptr),
+        m_next_block_size(initial_block_size == 0 ? 4096 : initial_block_size),
+        m_bytes_reserved(0) {}
+
+  monotonic_arena(const monotonic_arena &) = delete;
+  monotonic_arena &operator=(const monotonic_arena &) = delete;
+
+  ~monotonic_arena() { this->release(); }
+
+  /// Get bytes of storage aligned to alignment.
+  /*
+   * O(1). Requests a new block from the global allocator only when
+   * the current one is exhausted.
+   * @param bytes - the number of bytes needed.
+   * @param alignment - a power of two.
+   * @return the storage.
+   */
+  void *allocate(const size_t &bytes, const size_t &alignment) {
+    char *aligned = align_up(m_cursor, alignment);
+    if (m_cursor == nullptr || aligned > m_end ||
+        bytes > size_t(m_end - aligned)) {
+      this->add_block(bytes + alignment);
+      aligned = align_up(m_cursor, alignment);
+    }
+    m_cursor = aligned + bytes;
+    return aligned;
+  }
+
+  /// Give back storage.
+  /*
+   * O(1). Only the most recent allocation can be reclaimed; anything
+   * else stays in use until release().
+   * @param storage - storage returned by allocate().
+   * @param bytes - the size that was passed to allocate().
+   */
+  void deallocate(void *storage, const size_t &bytes) {
+    if (static_cast<char *>(storage) + bytes == m_cursor) {
+      m_cursor = static_cast<char *>(storage);
+    }
+  }
+
+  /// Free every block.
+  /*
+   * O(number of blocks). Anything allocated from the arena is invalid
+   * afterwards. The arena can be used again.
+   */
+  void release() {
+    while (m_blocks != nullptr) {
+      Block *next = m_blocks->next;
+      ::operator delete(m_blocks);
+      m_blocks = next;
+    }
+    m_cursor = nullptr;
+    m_end = nullptr;
+    m_bytes_reserved = 0;
+  }
+
+  /// Get the total size of the blocks requested from the global allocator.
+  size_t bytes_reserved() const { return m_bytes_reserved; }
+
+private:
+  struct Block {
+    Block *next;
+  };
+
+  static char *align_up(char *ptr, const size_t &alignment) {
+    uintptr_t value = reinterpret_cast<uintptr_t>(ptr);
+    value = (value + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    return reinterpret_cast<char *>(value);
+  }
+
+  void add_block(const size_t &min_bytes) {
+    size_t size = m_next_block_size;
+    while (size < min_bytes + sizeof(Block)) {
+      size *= 2;
+    }
+    Block *block = static_cast<Block *>(::operator new(size));
+    block->next = m_blocks;
+    m_blocks = block;
+    m_cursor = reinterpret_cast<char *>(block) + sizeof(Block);
+    m_end = reinterpret_cast<char *>(block) + size;
+    m_bytes_reserved += size;
+    m_next_block_size = size * 2;
+  }
+
+  Block *m_blocks;
+  char *m_cursor;
+  char *m_end;
+  size_t m_next_block_size;
+  size_t m_bytes_reserved;
+};
+
+/// An allocator that draws from a monotonic_arena.
+/*
+ * Containers using it can be thrown away without freeing anything;
+ * release the arena instead. The arena must outlive every container
+ * that uses it.
+ */
+template <typename T> class arena_allocator {
+public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  arena_allocator(monotonic_arena &arena) : m_arena(&arena) {}
+  template <typename U>
+  arena_allocator(const arena_allocator<U> &other) : m_arena(other.arena()) {}
+
+  T *allocate(const size_t &n) {
+    return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *storage, const size_t &n) {
+    m_arena->deallocate(storage, n * sizeof(T));
+  }
+
+  monotonic_arena *arena() const { return m_arena; }
+
+  template <typename U> bool operator==(const arena_allocator<U> &other) const {
+    return m_arena == other.arena();
+  }
+  template <typename U> bool operator!=(const arena_allocator<U> &other) const {
+    return !(*this == other);
+  }
+
+private:
+  monotonic_arena *m_arena;
+};
+
+/// Get this thread's arena.
+/*
+ * Created on first use and destroyed when the thread exits.
+ * Call release() on it at a point where nothing allocated from
+ * it on this thread is still alive, e.g. the end of a request.
+ */
+inline monotonic_arena &thread_local_arena() {
+  thread_local monotonic_arena arena;
+  return arena;
+}
+
+/// A stateless bump allocator over thread_local_arena().
+/*
+ * Containers using it must be created and destroyed on one thread.
+ */
+template <typename T> struct thread_local_allocator {
+  typedef T value_type;
+  typedef std::true_type is_always_equal;
+
+  thread_local_allocator() = default;
+  template <typename U>
+  thread_local_allocator(const thread_local_allocator<U> &) {}
+
+  T *allocate(const size_t &n) {
+    return static_cast<T *>(
+        thread_local_arena().allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *storage, const size_t &n) {
+    thread_local_arena().deallocate(storage, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const thread_local_allocator<U> &) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const thread_local_allocator<U> &) const {
+    return false;
+  }
+};
+
+}; // namespace prac
@@ -0,0 +1,1102 @@
+#pragma once
+#include "memory.hpp"
+#include "simd.hpp"
+#include "vector.hpp"
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stddef.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+namespace prac {
+
+/// Tag for building a btree_map or btree_set from elements already
+/// sorted by key, with no key repeated.
+struct sorted_unique_t {
+  explicit sorted_unique_t() = default;
+};
+constexpr sorted_unique_t sorted_unique{};
+
+namespace detail {
+
+/// Move n elements from src to dst, which may overlap, ending their
+/// lifetime at src. The move constructor must not throw.
+template <typename T> void shift_relocate(T *dst, T *src, const size_t &n) {
+  if (n == 0 || dst == src) {
+    return;
+  }
+  if (std::is_trivially_copyable<T>::value) {
+    std::memmove(static_cast<void *>(dst), static_cast<const void *>(src),
+                 n * sizeof(T));
+  } else if (dst < src) {
+    for (size_t i = 0; i < n; i++) {
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  } else {
+    for (size_t i = n; i-- > 0;) {
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  }
+}
+
+/// Finds where a key goes among the sorted keys of a node: a binary
+/// search, for any key type and comparison.
+template <typename K, typename Compare, typename = void> struct btree_search {
+  /// Get the number of keys that are less than key, or with OrEqual,
+  /// not greater than it.
+  template <bool OrEqual>
+  static size_t rank(const K *keys, const size_t &n, const K &key,
+                     const Compare &comp) {
+    size_t low = 0;
+    size_t high = n;
+    while (low < high) {
+      size_t mid = (low + high) / 2;
+      bool before = OrEqual ? !comp(key, keys[mid]) : comp(keys[mid], key);
+      if (before) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return low;
+  }
+};
+
+#ifdef PRAC_SIMD_X86
+
+/// Keys a node can compare a vector at a time.
+template <typename K>
+struct is_btree_simd_key
+    : std::integral_constant<bool, (std::is_integral<K>::value &&
+                                    !std::is_same<K, bool>::value) ||
+                                       std::is_same<K, float>::value ||
+                                       std::is_same<K, double>::value> {};
+
+/// Finds where an arithmetic key goes among the keys of a node with
+/// vector compares.
+/*
+ * Every key of the node is compared, without a branch, and the
+ * matching lanes counted: for the few hundred bytes of keys in a
+ * node, that beats a binary search's mispredicted branches. The
+ * width is the widest the compiler was told it may use, since a
+ * run-time dispatch as in simd.hpp would cost more than the search.
+ */
+template <typename K, typename Compare>
+struct btree_search<
+    K, Compare,
+    typename std::enable_if<
+        is_btree_simd_key<K>::value &&
+        (std::is_same<Compare, std::less<K>>::value ||
+         std::is_same<Compare, std::less<>>::value)>::type> {
+#ifdef __AVX2__
+  static constexpr size_t bytes = 32;
+#else
+  static constexpr size_t bytes = 16;
+#endif
+
+  template <bool OrEqual>
+  static size_t rank(const K *keys, const size_t &n, const K &key,
+                     const Compare &) {
+    typedef typename simd::detail::vec<K, bytes>::type V;
+    typedef decltype(V{} < V{}) M;
+    const size_t lanes = bytes / sizeof(K);
+    V needle = V{} + key;
+    // A lane that compares true is -1, so the counts go down.
+    M counts = {};
+    size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      V chunk = simd::detail::load<V>(keys + i);
+      if (OrEqual) {
+        counts += chunk <= needle;
+      } else {
+        counts += chunk < needle;
+      }
+    }
+    size_t total = 0;
+    for (size_t lane = 0; lane < lanes; lane++) {
+      total += size_t(-(int64_t)counts[lane]);
+    }
+    for (; i < n; i++) {
+      total += OrEqual ? !(key < keys[i]) : keys[i] < key;
+    }
+    return total;
+  }
+};
+
+#endif
+
+/// The mapped type of a btree_set: there is none.
+struct btree_no_value {};
+
+/// The values of a leaf, next to its keys.
+template <typename V, size_t N> struct btree_values {
+  V *values() { return reinterpret_cast<V *>(m_values); }
+
+  template <typename... Args> void construct(const size_t &i, Args &&... args) {
+    new (this->values() + i) V(std::forward<Args>(args)...);
+  }
+  void destroy(const size_t &i, const size_t &n) {
+    detail::destroy(this->values() + i, n);
+  }
+  /// Move n values from src's index from to this one's index to.
+  void move_from(btree_values &src, const size_t &from, const size_t &to,
+                 const size_t &n) {
+    shift_relocate(this->values() + to, src.values() + from, n);
+  }
+
+private:
+  alignas(V) unsigned char m_values[N * sizeof(V)];
+};
+
+/// A btree_set's leaves hold keys only.
+template <size_t N> struct btree_values<btree_no_value, N> {
+  template <typename... Args> void construct(const size_t &, Args &&...) {}
+  void destroy(const size_t &, const size_t &) {}
+  void move_from(btree_values &, const size_t &, const size_t &,
+                 const size_t &) {}
+};
+
+/// What dereferencing a btree iterator gives: a pair of references to
+/// a key and its value, or for a set a reference to the key.
+template <typename K, typename V, bool Const> struct btree_reference {
+  typedef typename std::conditional<Const, const V, V>::type mapped;
+  typedef std::pair<const K &, mapped &> type;
+  typedef std::pair<const K, V> value;
+
+  template <typename Leaf> static type make(Leaf *leaf, const size_t &i) {
+    return type(leaf->keys()[i], leaf->values()[i]);
+  }
+};
+template <typename K, bool Const>
+struct btree_reference<K, btree_no_value, Const> {
+  typedef const K &type;
+  typedef K value;
+
+  template <typename Leaf> static type make(Leaf *leaf, const size_t &i) {
+    return leaf->keys()[i];
+  }
+};
+
+/// Gives an iterator whose reference isn't a real reference an
+/// operator->.
+template <typename Ref> struct btree_arrow {
+  Ref ref;
+  typename std::remove_reference<Ref>::type *operator->() { return &ref; }
+};
+
+/*
+ * A B+ tree: the elements are in the leaves, sorted, and the inner
+ * nodes hold copies of keys that steer a search to the right child.
+ *
+ * Each node holds up to N keys in one array, N being as many keys as
+ * fit in 256 bytes (4 cache lines), at least 8, so a search touches a
+ * handful of nodes instead of a node per comparison, and each node
+ * search is a scan of contiguous keys, vectorized for arithmetic keys
+ * with std::less (btree_search). Leaves keep their values in a second
+ * array, so values don't dilute the keys, and are linked both ways,
+ * so iteration and range scans walk the leaves in order without going
+ * back up the tree.
+ *
+ * A full node is split in two halves, except at the right edge of the
+ * tree, where keys mostly arrive in increasing order: there, the new
+ * node gets only the last element, so ascending inserts leave nodes
+ * nearly full. A node that falls below half full on erase takes
+ * elements from a sibling, or is merged with it.
+ *
+ * Inserting and erasing move elements between nodes, so they
+ * invalidate iterators, and K's and V's move constructors must not
+ * throw. If anything else throws, an insert leaves the tree without
+ * the new element, but possibly with a node split.
+ */
+template <typename K, typename V, typename Compare, typename Alloc>
+class btree {
+  static constexpr bool has_values = !std::is_same<V, btree_no_value>::value;
+  static constexpr size_t key_bytes = 256;
+
+public:
+  /// The most keys in a node.
+  static constexpr size_t node_keys =
+      key_bytes / sizeof(K) < 8 ? 8 : key_bytes / sizeof(K);
+
+private:
+  static constexpr size_t N = node_keys;
+  /// The fewest keys in a node, other than the root, before erase
+  /// rebalances it.
+  static constexpr size_t min_keys = N / 2 - 1;
+  /// Every inner node has at least 2 children, so no tree is higher.
+  static constexpr size_t max_height = 64;
+  typedef btree_search<K, Compare> search;
+
+  struct node_base {
+    uint32_t count;
+    bool leaf;
+    alignas(K) unsigned char key_storage[N * sizeof(K)];
+
+    K *keys() { return reinterpret_cast<K *>(key_storage); }
+    const K *keys() const { return reinterpret_cast<const K *>(key_storage); }
+  };
+
+  struct leaf_node : node_base, btree_values<V, N> {
+    leaf_node *prev;
+    leaf_node *next;
+  };
+
+  struct inner_node : node_base {
+    node_base *children[N + 1];
+  };
+
+  typedef std::allocator_traits<Alloc> alloc_traits;
+  typedef typename alloc_traits::template rebind_alloc<leaf_node>
+      leaf_allocator;
+  typedef typename alloc_traits::template rebind_alloc<inner_node>
+      inner_allocator;
+
+  /// A step of the way from the root to a leaf.
+  struct path_entry {
+    inner_node *node;
+    size_t child;
+  };
+
+public:
+  typedef K key_type;
+  typedef Compare key_compare;
+  typedef Alloc allocator_type;
+  typedef typename btree_reference<K, V, false>::type reference;
+  typedef typename btree_reference<K, V, true>::type const_reference;
+
+  /// Construction of an empty tree. Allocates nothing.
+  explicit btree(const Compare &comp = Compare(), const Alloc &alloc = Alloc())
+      : m_comp(comp), m_alloc(alloc), m_root(nullptr), m_first(nullptr),
+        m_last(nullptr), m_height(0), m_size(0) {}
+
+  /// Copy construction. O(n), with nodes filled as by a bulk load.
+  btree(const btree &other)
+      : btree(other.m_comp, alloc_traits::select_on_container_copy_construction(
+                                other.m_alloc)) {
+    this->build_sorted(other.begin(), other.size());
+  }
+
+  /// Move construction. O(1); other is left empty.
+  btree(btree &&other) noexcept : btree(other.m_comp, other.m_alloc) {
+    this->swap(other);
+  }
+
+  /// Copy assignment. O(n); provides the strong exception guarantee.
+  btree &operator=(const btree &other) {
+    if (this != &other) {
+      btree copy(other);
+      this->swap(copy);
+    }
+    return *this;
+  }
+
+  /// Move assignment. O(n) in the number of elements destroyed.
+  btree &operator=(btree &&other) noexcept {
+    if (this != &other) {
+      btree moved(std::move(other));
+      this->swap(moved);
+    }
+    return *this;
+  }
+
+  ~btree() { this->clear(); }
+
+  /// Exchange contents with another tree.
+  void swap(btree &other) noexcept {
+    std::swap(m_comp, other.m_comp);
+    std::swap(m_alloc, other.m_alloc);
+    std::swap(m_root, other.m_root);
+    std::swap(m_first, other.m_first);
+    std::swap(m_last, other.m_last);
+    std::swap(m_height, other.m_height);
+    std::swap(m_size, other.m_size);
+  }
+
+  /// A bidirectional iterator in key order, along the linked leaves.
+  template <bool Const> class basic_iterator {
+    typedef typename std::conditional<Const, const leaf_node, leaf_node>::type
+        leaf_type;
+
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef typename btree_reference<K, V, Const>::type reference;
+    typedef typename btree_reference<K, V, Const>::value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef btree_arrow<reference> pointer;
+
+    basic_iterator() : m_leaf(nullptr), m_index(0) {}
+    basic_iterator(leaf_type *leaf, const size_t &index)
+        : m_leaf(leaf), m_index(index) {}
+    /// iterator converts to const_iterator.
+    template <bool OtherConst,
+              typename = typename std::enable_if<Const && !OtherConst>::type>
+    basic_iterator(const basic_iterator<OtherConst> &other)
+        : m_leaf(other.m_leaf), m_index(other.m_index) {}
+
+    reference operator*() const {
+      return btree_reference<K, V, Const>::make(
+          const_cast<leaf_node *>(m_leaf), m_index);
+    }
+    pointer operator->() const { return pointer{**this}; }
+
+    basic_iterator &operator++() {
+      if (++m_index == m_leaf->count && m_leaf->next != nullptr) {
+        m_leaf = m_leaf->next;
+        m_index = 0;
+      }
+      return *this;
+    }
+    basic_iterator operator++(int) {
+      basic_iterator old = *this;
+      ++*this;
+      return old;
+    }
+    basic_iterator &operator--() {
+      if (m_index == 0) {
+        m_leaf = m_leaf->prev;
+        m_index = m_leaf->count;
+      }
+      m_index--;
+      return *this;
+    }
+    basic_iterator operator--(int) {
+      basic_iterator old = *this;
+      --*this;
+      return old;
+    }
+
+    template <bool OtherConst>
+    bool operator==(const basic_iterator<OtherConst> &other) const {
+      return m_leaf == other.m_leaf && m_index == other.m_index;
+    }
+    template <bool OtherConst>
+    bool operator!=(const basic_iterator<OtherConst> &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    template <bool> friend class basic_iterator;
+    friend class btree;
+
+    leaf_type *m_leaf;
+    size_t m_index;
+  };
+
+  typedef basic_iterator<false> iterator;
+  typedef basic_iterator<true> const_iterator;
+
+  iterator begin() { return iterator(m_first, 0); }
+  iterator end() { return iterator(m_last, m_last ? m_last->count : 0); }
+  const_iterator begin() const { return const_iterator(m_first, 0); }
+  const_iterator end() const {
+    return const_iterator(m_last, m_last ? m_last->count : 0);
+  }
+  const_iterator cbegin() const { return this->begin(); }
+  const_iterator cend() const { return this->end(); }
+
+  /// Get the number of elements.
+  size_t size() const { return m_size; }
+
+  /// Whether there are no elements.
+  bool empty() const { return m_size == 0; }
+
+  /// Get the number of levels of nodes: 0 when empty, 1 for a lone
+  /// leaf.
+  size_t height() const { return m_root == nullptr ? 0 : m_height + 1; }
+
+  /// Find the element with a key.
+  /*
+   * O(log n).
+   * @return an iterator to it, or end().
+   */
+  iterator find(const K &key) {
+    const_iterator found = static_cast<const btree *>(this)->find(key);
+    return iterator(const_cast<leaf_node *>(found.m_leaf), found.m_index);
+  }
+  const_iterator find(const K &key) const {
+    if (m_root == nullptr) {
+      return this->end();
+    }
+    const leaf_node *leaf = this->find_leaf(key);
+    size_t i = search::template rank<false>(leaf->keys(), leaf->count, key,
+                                            m_comp);
+    if (i == leaf->count || m_comp(key, leaf->keys()[i])) {
+      return this->end();
+    }
+    return const_iterator(leaf, i);
+  }
+
+  /// Whether there is an element with a key.
+  bool contains(const K &key) const { return this->find(key) != this->end(); }
+
+  /// Get the number of elements with a key: 0 or 1.
+  size_t count(const K &key) const { return this->contains(key) ? 1 : 0; }
+
+  /// Get an iterator to the first element whose key is not less than
+  /// key, or end().
+  iterator lower_bound(const K &key) { return this->bound<false>(key); }
+  const_iterator lower_bound(const K &key) const {
+    return const_cast<btree *>(this)->template bound<false>(key);
+  }
+
+  /// Get an iterator to the first element whose key is greater than
+  /// key, or end().
+  iterator upper_bound(const K &key) { return this->bound<true>(key); }
+  const_iterator upper_bound(const K &key) const {
+    return const_cast<btree *>(this)->template bound<true>(key);
+  }
+
+  /// Get the range of elements with a key: empty, or one element.
+  std::pair<iterator, iterator> equal_range(const K &key) {
+    return std::make_pair(this->lower_bound(key), this->upper_bound(key));
+  }
+  std::pair<const_iterator, const_iterator> equal_range(const K &key) const {
+    return std::make_pair(this->lower_bound(key), this->upper_bound(key));
+  }
+
+  /// Erase the element with a key.
+  /*
+   * O(log n). Invalidates iterators.
+   * @return the number erased: 0 or 1.
+   */
+  size_t erase(const K &key) {
+    if (m_root == nullptr) {
+      return 0;
+    }
+    path_entry path[max_height];
+    leaf_node *leaf = this->find_path(key, path);
+    size_t i = search::template rank<false>(leaf->keys(), leaf->count, key,
+                                            m_comp);
+    if (i == leaf->count || m_comp(key, leaf->keys()[i])) {
+      return 0;
+    }
+    this->erase_at(path, leaf, i);
+    return 1;
+  }
+
+  /// Erase the element at pos.
+  /*
+   * O(log n). Invalidates iterators.
+   * @return an iterator to the element after it.
+   */
+  iterator erase(const const_iterator &pos) {
+    path_entry path[max_height];
+    this->find_path(pos.m_leaf->keys()[pos.m_index], path);
+    return this->erase_at(path, const_cast<leaf_node *>(pos.m_leaf),
+                          pos.m_index);
+  }
+
+  /// Erase the elements in [first, last).
+  /*
+   * O(k log n) for k elements.
+   * @return an iterator to the element that followed them.
+   */
+  iterator erase(const_iterator first, const const_iterator &last) {
+    if (last == this->end()) {
+      while (first != this->cend()) {
+        first = this->erase(first);
+      }
+      return this->end();
+    }
+    // Erasing invalidates last, so count the elements first.
+    size_t n = 0;
+    for (const_iterator it = first; it != last; ++it) {
+      n++;
+    }
+    iterator next(const_cast<leaf_node *>(first.m_leaf), first.m_index);
+    for (; n > 0; n--) {
+      next = this->erase(next);
+    }
+    return next;
+  }
+
+  /// Remove every element, freeing every node.
+  void clear() {
+    if (m_root != nullptr) {
+      this->destroy_subtree(m_root, m_height);
+    }
+    m_root = nullptr;
+    m_first = nullptr;
+    m_last = nullptr;
+    m_height = 0;
+    m_size = 0;
+  }
+
+  /// Get a copy of the allocator.
+  Alloc get_allocator() const { return m_alloc; }
+
+  /// Get the key comparison.
+  Compare key_comp() const { return m_comp; }
+
+protected:
+  /// Insert an element with key, and a value constructed from args,
+  /// unless key is there.
+  /*
+   * key is only moved from, if KeyArg is an rvalue, once it is known
+   * to be absent.
+   * @return an iterator to the element with the key, and whether it
+   *         was inserted.
+   */
+  template <typename KeyArg, typename... Args>
+  std::pair<iterator, bool> emplace_key(KeyArg &&key, Args &&... args) {
+    if (m_root == nullptr) {
+      m_root = m_first = m_last = this->new_leaf();
+    }
+    path_entry path[max_height];
+    leaf_node *leaf = this->find_path(key, path);
+    size_t i = search::template rank<false>(leaf->keys(), leaf->count, key,
+                                            m_comp);
+    if (i < leaf->count && !m_comp(key, leaf->keys()[i])) {
+      return std::make_pair(iterator(leaf, i), false);
+    }
+    if (leaf->count == N) {
+      this->split_leaf(path, leaf, i);
+    }
+    shift_relocate(leaf->keys() + i + 1, leaf->keys() + i, leaf->count - i);
+    leaf->move_from(*leaf, i, i + 1, leaf->count - i);
+    try {
+      new (leaf->keys() + i) K(std::forward<KeyArg>(key));
+      try {
+        leaf->construct(i, std::forward<Args>(args)...);
+      } catch (...) {
+        leaf->keys()[i].~K();
+        throw;
+      }
+    } catch (...) {
+      shift_relocate(leaf->keys() + i, leaf->keys() + i + 1, leaf->count - i);
+      leaf->move_from(*leaf, i + 1, i, leaf->count - i);
+      throw;
+    }
+    leaf->count++;
+    m_size++;
+    return std::make_pair(iterator(leaf, i), true);
+  }
+
+  /// Fill an empty tree with n elements from first, in increasing order
+  /// of key: each a key for a set, or a pair of a key and its value.
+  /*
+   * O(n). The leaves are filled evenly, all but full, and the inner
+   * nodes built on top of them level by level. If first yields rvalues,
+   * they are moved from. Throws std::invalid_argument, leaving the tree
+   * empty, if a key isn't greater than the one before it.
+   */
+  template <typename It> void build_sorted(It first, const size_t &n) {
+    if (n == 0) {
+      return;
+    }
+    size_t num_leaves = (n + N - 1) / N;
+    prac::vector<node_base *> level;
+    prac::vector<const K *> level_keys;
+    prac::vector<inner_node *> inner_nodes;
+    try {
+      level.reserve(num_leaves);
+      level_keys.reserve(num_leaves);
+      inner_nodes.reserve(num_leaves);
+      for (size_t l = 0; l < num_leaves; l++) {
+        leaf_node *leaf = this->new_leaf();
+        leaf->prev = m_last;
+        if (m_last != nullptr) {
+          m_last->next = leaf;
+        } else {
+          m_first = leaf;
+        }
+        m_last = leaf;
+        level.push_back(leaf);
+        size_t count = n / num_leaves + (l < n % num_leaves ? 1 : 0);
+        for (size_t i = 0; i < count; i++, ++first) {
+          this->append_sorted(leaf, *first);
+          m_size++;
+        }
+        level_keys.push_back(leaf->keys());
+      }
+      // Each inner level takes the one below it N + 1 children at a
+      // time, spread evenly.
+      while (level.size() > 1) {
+        size_t num_nodes = (level.size() + N) / (N + 1);
+        size_t next = 0;
+        for (size_t j = 0; j < num_nodes; j++) {
+          size_t children =
+              level.size() / num_nodes + (j < level.size() % num_nodes ? 1 : 0);
+          inner_node *inner = this->new_inner();
+          inner_nodes.push_back(inner);
+          for (size_t c = 0; c < children; c++) {
+            inner->children[c] = level[next + c];
+            if (c > 0) {
+              new (inner->keys() + c - 1) K(*level_keys[next + c]);
+              inner->count++;
+            }
+          }
+          level[j] = inner;
+          level_keys[j] = level_keys[next];
+          next += children;
+        }
+        level.resize(num_nodes);
+        level_keys.resize(num_nodes);
+        m_height++;
+      }
+    } catch (...) {
+      for (size_t i = 0; i < inner_nodes.size(); i++) {
+        this->destroy_node(inner_nodes[i], false);
+      }
+      for (leaf_node *leaf = m_first; leaf != nullptr;) {
+        leaf_node *next = leaf->next;
+        this->destroy_node(leaf, true);
+        leaf = next;
+      }
+      m_first = m_last = nullptr;
+      m_height = 0;
+      m_size = 0;
+      throw;
+    }
+    m_root = level[0];
+  }
+
+private:
+  /// Nodes allocated before a split changes anything, so it can't
+  /// fail half way. Those left unused are freed.
+  struct spare_nodes {
+    btree *tree;
+    leaf_node *leaf;
+    inner_node *inner[max_height + 1];
+    size_t num_inner;
+
+    explicit spare_nodes(btree *tree_in)
+        : tree(tree_in), leaf(nullptr), num_inner(0) {}
+    ~spare_nodes() {
+      if (leaf != nullptr) {
+        tree->free_leaf(leaf);
+      }
+      while (num_inner > 0) {
+        tree->free_inner(inner[--num_inner]);
+      }
+    }
+    inner_node *take_inner() { return inner[--num_inner]; }
+  };
+
+  leaf_node *new_leaf() {
+    leaf_allocator alloc(m_alloc);
+    leaf_node *leaf = std::allocator_traits<leaf_allocator>::allocate(alloc, 1);
+    new (leaf) leaf_node;
+    leaf->count = 0;
+    leaf->leaf = true;
+    leaf->prev = nullptr;
+    leaf->next = nullptr;
+    return leaf;
+  }
+
+  inner_node *new_inner() {
+    inner_allocator alloc(m_alloc);
+    inner_node *inner =
+        std::allocator_traits<inner_allocator>::allocate(alloc, 1);
+    new (inner) inner_node;
+    inner->count = 0;
+    inner->leaf = false;
+    return inner;
+  }
+
+  void free_leaf(leaf_node *leaf) {
+    leaf_allocator alloc(m_alloc);
+    std::allocator_traits<leaf_allocator>::deallocate(alloc, leaf, 1);
+  }
+
+  void free_inner(inner_node *inner) {
+    inner_allocator alloc(m_alloc);
+    std::allocator_traits<inner_allocator>::deallocate(alloc, inner, 1);
+  }
+
+  /// Destroy a node's elements and free it; not its children.
+  void destroy_node(node_base *node, const bool &is_leaf) {
+    detail::destroy(node->keys(), node->count);
+    if (is_leaf) {
+      leaf_node *leaf = static_cast<leaf_node *>(node);
+      leaf->destroy(0, leaf->count);
+      this->free_leaf(leaf);
+    } else {
+      this->free_inner(static_cast<inner_node *>(node));
+    }
+  }
+
+  void destroy_subtree(node_base *node, const size_t &height) {
+    if (height > 0) {
+      inner_node *inner = static_cast<inner_node *>(node);
+      for (size_t c = 0; c <= inner->count; c++) {
+        this->destroy_subtree(inner->children[c], height - 1);
+      }
+    }
+    this->destroy_node(node, height == 0);
+  }
+
+  template <typename Elem> void append_sorted(leaf_node *leaf, Elem &&elem) {
+    this->append_sorted(leaf, std::forward<Elem>(elem),
+                        std::integral_constant<bool, has_values>());
+  }
+
+  /// Append a key.
+  template <typename Key>
+  void append_sorted(leaf_node *leaf, Key &&key, std::false_type) {
+    this->check_sorted(leaf, key);
+    new (leaf->keys() + leaf->count) K(std::forward<Key>(key));
+    leaf->count++;
+  }
+
+  /// Append a pair of a key and its value.
+  template <typename Pair>
+  void append_sorted(leaf_node *leaf, Pair &&elem, std::true_type) {
+    this->check_sorted(leaf, elem.first);
+    new (leaf->keys() + leaf->count) K(std::forward<Pair>(elem).first);
+    try {
+      leaf->construct(leaf->count, std::forward<Pair>(elem).second);
+    } catch (...) {
+      leaf->keys()[leaf->count].~K();
+      throw;
+    }
+    leaf->count++;
+  }
+
+  /// Throw unless key comes after the last key appended.
+  void check_sorted(const leaf_node *leaf, const K &key) const {
+    const leaf_node *prev = leaf->count > 0 ? leaf : leaf->prev;
+    if (prev != nullptr && !m_comp(prev->keys()[prev->count - 1], key)) {
+      throw std::invalid_argument(
+          "prac::btree: bulk-loaded keys must be sorted and unique");
+    }
+  }
+
+  /// Get the leaf where key is or would be.
+  const leaf_node *find_leaf(const K &key) const {
+    const node_base *node = m_root;
+    for (size_t h = m_height; h > 0; h--) {
+      const inner_node *inner = static_cast<const inner_node *>(node);
+      node = inner->children[search::template rank<true>(
+          inner->keys(), inner->count, key, m_comp)];
+    }
+    return static_cast<const leaf_node *>(node);
+  }
+
+  /// As find_leaf(), recording the way down in path, one entry per
+  /// inner node from the root.
+  leaf_node *find_path(const K &key, path_entry *path) {
+    node_base *node = m_root;
+    for (size_t d = 0; d < m_height; d++) {
+      inner_node *inner = static_cast<inner_node *>(node);
+      size_t c = search::template rank<true>(inner->keys(), inner->count, key,
+                                             m_comp);
+      path[d].node = inner;
+      path[d].child = c;
+      node = inner->children[c];
+    }
+    return static_cast<leaf_node *>(node);
+  }
+
+  template <bool Upper> iterator bound(const K &key) {
+    if (m_root == nullptr) {
+      return this->end();
+    }
+    leaf_node *leaf = const_cast<leaf_node *>(this->find_leaf(key));
+    size_t i = search::template rank<Upper>(leaf->keys(), leaf->count, key,
+                                            m_comp);
+    return this->normalize(leaf, i);
+  }
+
+  /// Get an iterator to the element at i of leaf, i possibly just past
+  /// its last element.
+  iterator normalize(leaf_node *leaf, const size_t &i) {
+    if (i == leaf->count && leaf->next != nullptr) {
+      return iterator(leaf->next, 0);
+    }
+    return iterator(leaf, i);
+  }
+
+  /// Whether the node at depth d of path is the last of its level.
+  bool rightmost(const path_entry *path, const size_t &d) const {
+    for (size_t i = 0; i < d; i++) {
+      if (path[i].child != path[i].node->count) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Split a full leaf so that an element can be inserted at i, which
+  /// is updated, along with leaf, to where it now goes.
+  void split_leaf(path_entry *path, leaf_node *&leaf, size_t &i) {
+    // Elements appended at the right edge leave the old leaf nearly
+    // full.
+    size_t split = i == N && leaf->next == nullptr ? N - 1 : N / 2;
+    // The first key of the new leaf goes up, as a copy; that and every
+    // allocation happen before anything moves.
+    K separator(leaf->keys()[split]);
+    spare_nodes spare(this);
+    spare.leaf = this->new_leaf();
+    size_t inner_needed = 0;
+    while (inner_needed < m_height &&
+           path[m_height - 1 - inner_needed].node->count == N) {
+      inner_needed++;
+    }
+    if (inner_needed == m_height) {
+      inner_needed++;
+    }
+    for (; spare.num_inner < inner_needed; spare.num_inner++) {
+      spare.inner[spare.num_inner] = this->new_inner();
+    }
+
+    leaf_node *right = spare.leaf;
+    spare.leaf = nullptr;
+    size_t moved = N - split;
+    shift_relocate(right->keys(), leaf->keys() + split, moved);
+    right->move_from(*leaf, split, 0, moved);
+    right->count = uint32_t(moved);
+    leaf->count = uint32_t(split);
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next != nullptr) {
+      leaf->next->prev = right;
+    } else {
+      m_last = right;
+    }
+    leaf->next = right;
+    this->insert_child(path, m_height, leaf, std::move(separator), right,
+                       spare);
+    if (i > split) {
+      leaf = right;
+      i -= split;
+    }
+  }
+
+  /// Add right, just split off from left at depth d, to left's parent,
+  /// after the separator, splitting parents as needed.
+  void insert_child(path_entry *path, const size_t &d, node_base *left,
+                    K &&separator, node_base *right, spare_nodes &spare) {
+    if (d == 0) {
+      inner_node *root = spare.take_inner();
+      new (root->keys()) K(std::move(separator));
+      root->children[0] = left;
+      root->children[1] = right;
+      root->count = 1;
+      m_root = root;
+      m_height++;
+      return;
+    }
+    inner_node *parent = path[d - 1].node;
+    size_t c = path[d - 1].child;
+    if (parent->count < N) {
+      this->insert_separator(parent, c, std::move(separator), right);
+      return;
+    }
+    // Split the parent around key m. At the right edge, the new node
+    // takes only the last key and child, and the new one.
+    size_t m = c == N && this->rightmost(path, d - 1) ? N - 1 : N / 2;
+    inner_node *sibling = spare.take_inner();
+    if (c == m) {
+      // The separator itself goes up, and right starts the sibling.
+      shift_relocate(sibling->keys(), parent->keys() + m, N - m);
+      std::memcpy(sibling->children + 1, parent->children + m + 1,
+                  (N - m) * sizeof(node_base *));
+      sibling->children[0] = right;
+      sibling->count = uint32_t(N - m);
+      parent->count = uint32_t(m);
+      this->insert_child(path, d - 1, parent, std::move(separator), sibling,
+                         spare);
+      return;
+    }
+    K up(std::move(parent->keys()[m]));
+    parent->keys()[m].~K();
+    shift_relocate(sibling->keys(), parent->keys() + m + 1, N - m - 1);
+    std::memcpy(sibling->children, parent->children + m + 1,
+                (N - m) * sizeof(node_base *));
+    sibling->count = uint32_t(N - m - 1);
+    parent->count = uint32_t(m);
+    if (c < m) {
+      this->insert_separator(parent, c, std::move(separator), right);
+    } else {
+      this->insert_separator(sibling, c - m - 1, std::move(separator), right);
+    }
+    this->insert_child(path, d - 1, parent, std::move(up), sibling, spare);
+  }
+
+  /// Insert separator at key c of a node with room, and right as the
+  /// child after it.
+  static void insert_separator(inner_node *node, const size_t &c,
+                               K &&separator, node_base *right) {
+    shift_relocate(node->keys() + c + 1, node->keys() + c, node->count - c);
+    std::memmove(node->children + c + 2, node->children + c + 1,
+                 (node->count - c) * sizeof(node_base *));
+    new (node->keys() + c) K(std::move(separator));
+    node->children[c + 1] = right;
+    node->count++;
+  }
+
+  /// Erase the element at i of leaf, which path leads to, rebalancing
+  /// the nodes that become too small.
+  iterator erase_at(path_entry *path, leaf_node *leaf, size_t i) {
+    leaf->keys()[i].~K();
+    leaf->destroy(i, 1);
+    shift_relocate(leaf->keys() + i, leaf->keys() + i + 1,
+                   leaf->count - i - 1);
+    leaf->move_from(*leaf, i + 1, i, leaf->count - i - 1);
+    leaf->count--;
+    m_size--;
+    if (m_height == 0) {
+      if (leaf->count == 0) {
+        this->free_leaf(leaf);
+        m_root = m_first = m_last = nullptr;
+        return this->end();
+      }
+      return this->normalize(leaf, i);
+    }
+    if (leaf->count < min_keys) {
+      this->rebalance_leaf(path, leaf, i);
+    }
+    return this->normalize(leaf, i);
+  }
+
+  /// Even out or merge an underfull leaf with a sibling. leaf and i, a
+  /// position in it, are updated to where that position went.
+  void rebalance_leaf(path_entry *path, leaf_node *&leaf, size_t &i) {
+    inner_node *parent = path[m_height - 1].node;
+    size_t c = path[m_height - 1].child;
+    size_t s = c > 0 ? c - 1 : 0;
+    leaf_node *left = static_cast<leaf_node *>(parent->children[s]);
+    leaf_node *right = static_cast<leaf_node *>(parent->children[s + 1]);
+    if (left->count + right->count <= N) {
+      if (leaf == right) {
+        i += left->count;
+        leaf = left;
+      }
+      shift_relocate(left->keys() + left->count, right->keys(), right->count);
+      left->move_from(*right, 0, left->count, right->count);
+      left->count += right->count;
+      left->next = right->next;
+      if (right->next != nullptr) {
+        right->next->prev = left;
+      } else {
+        m_last = left;
+      }
+      this->free_leaf(right);
+      this->remove_child(path, m_height - 1, s, true);
+      return;
+    }
+    size_t total = left->count + right->count;
+    if (left->count < total / 2) {
+      size_t k = total / 2 - left->count;
+      // Copy the new separator first: if that throws, nothing moved.
+      parent->keys()[s] = right->keys()[k];
+      shift_relocate(left->keys() + left->count, right->keys(), k);
+      left->move_from(*right, 0, left->count, k);
+      shift_relocate(right->keys(), right->keys() + k, right->count - k);
+      right->move_from(*right, k, 0, right->count - k);
+      left->count += uint32_t(k);
+      right->count -= uint32_t(k);
+    } else {
+      size_t k = (total + 1) / 2 - right->count;
+      parent->keys()[s] = left->keys()[left->count - k];
+      shift_relocate(right->keys() + k, right->keys(), right->count);
+      right->move_from(*right, 0, k, right->count);
+      shift_relocate(right->keys(), left->keys() + left->count - k, k);
+      right->move_from(*left, left->count - k, 0, k);
+      left->count -= uint32_t(k);
+      right->count += uint32_t(k);
+      if (leaf == right) {
+        i += k;
+      }
+    }
+  }
+
+  /// Remove key s and child s + 1, whose node was merged away, from the
+  /// inner node at depth d, rebalancing it if it becomes too small.
+  /*
+   * @param live_key - false if key s was already moved from and
+   *                   destroyed.
+   */
+  void remove_child(path_entry *path, const size_t &d, const size_t &s,
+                    const bool &live_key) {
+    inner_node *node = path[d].node;
+    if (live_key) {
+      node->keys()[s].~K();
+    }
+    shift_relocate(node->keys() + s, node->keys() + s + 1, node->count - s - 1);
+    std::memmove(node->children + s + 1, node->children + s + 2,
+                 (node->count - s - 1) * sizeof(node_base *));
+    node->count--;
+    if (d == 0) {
+      if (node->count == 0) {
+        m_root = node->children[0];
+        m_height--;
+        this->free_inner(node);
+      }
+      return;
+    }
+    if (node->count < min_keys) {
+      this->rebalance_inner(path, d);
+    }
+  }
+
+  /// Even out or merge the underfull inner node at depth d with a
+  /// sibling. Keys rotate through the parent, so nothing is copied.
+  void rebalance_inner(path_entry *path, const size_t &d) {
+    inner_node *parent = path[d - 1].node;
+    size_t c = path[d - 1].child;
+    size_t s = c > 0 ? c - 1 : 0;
+    inner_node *left = static_cast<inner_node *>(parent->children[s]);
+    inner_node *right = static_cast<inner_node *>(parent->children[s + 1]);
+    K *separator = parent->keys() + s;
+    if (left->count + 1 + right->count <= N) {
+      shift_relocate(left->keys() + left->count, separator, 1);
+      shift_relocate(left->keys() + left->count + 1, right->keys(),
+                     right->count);
+      std::memcpy(left->children + left->count + 1, right->children,
+                  (right->count + 1) * sizeof(node_base *));
+      left->count += 1 + right->count;
+      this->free_inner(right);
+      // The separator moved down, so there is no key to destroy.
+      this->remove_child(path, d - 1, s, false);
+      return;
+    }
+    size_t total = left->count + right->count;
+    if (left->count < total / 2) {
+      size_t k = total / 2 - left->count;
+      shift_relocate(left->keys() + left->count, separator, 1);
+      shift_relocate(left->keys() + left->count + 1, right->keys(), k - 1);
+      shift_relocate(separator, right->keys() + k - 1, 1);
+      std::memcpy(left->children + left->count + 1, right->children,
+                  k * sizeof(node_base *));
+      shift_relocate(right->keys(), right->keys() + k, right->count - k);
+      std::memmove(right->children, right->children + k,
+                   (right->count - k + 1) * sizeof(node_base *));
+      left->count += uint32_t(k);
+      right->count -= uint32_t(k);
+    } else {
+      size_t k = (total + 1) / 2 - right->count;
+      shift_relocate(right->keys() + k, right->keys(), right->count);
+      std::memmove(right->children + k, right->children,
+                   (right->count + 1) * sizeof(node_base *));
+      shift_relocate(right->keys() + k - 1, separator, 1);
+      shift_relocate(right->keys(), left->keys() + left->count - k + 1, k - 1);
+      shift_relocate(separator, left->keys() + left->count - k, 1);
+      std::memcpy(right->children, left->children + left->count - k + 1,
+                  k * sizeof(node_base *));
+      left->count -= uint32_t(k);
+      right->count += uint32_t(k);
+    }
+  }
+
+  Compare m_comp;
+  Alloc m_alloc;
+  node_base *m_root;
+  /// The ends of the list of leaves.
+  leaf_node *m_first;
+  leaf_node *m_last;
+  /// The number of inner levels above the leaves.
+  size_t m_height;
+  size_t m_size;
+};
+
+}; // namespace detail
+}; // namespace prac
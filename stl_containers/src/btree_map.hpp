@@ -0,0 +1,149 @@
+#pragma once
+#include "btree.hpp"
+#include "memory.hpp"
+#include "vector.hpp"
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace prac {
+
+/*
+ * A sorted map from K to V in a B+ tree with wide nodes: see
+ * detail::btree.
+ *
+ * Unlike std::map, a node holds dozens of elements, so a lookup
+ * misses the cache a few times rather than once per level of a
+ * binary tree, and an element costs little more than its key and
+ * value. In exchange, inserting and erasing invalidate iterators and
+ * references to other elements, and keys and values are stored in
+ * separate arrays, so an iterator gives a std::pair of references,
+ * as a prac::soa_vector's does: bind it with auto or const auto &,
+ * e.g. for (const auto &[key, value] : map).
+ */
+template <typename K, typename V, typename Compare = std::less<K>,
+          typename Alloc = prac::allocator<std::pair<const K, V>>>
+class btree_map : public detail::btree<K, V, Compare, Alloc> {
+  typedef detail::btree<K, V, Compare, Alloc> base;
+
+public:
+  typedef V mapped_type;
+  typedef std::pair<const K, V> value_type;
+
+  using base::base;
+  btree_map() = default;
+
+  /// Construction from a list of pairs. Later duplicates of a key are
+  /// dropped.
+  btree_map(std::initializer_list<value_type> list) {
+    this->insert(list.begin(), list.end());
+  }
+
+  /// Bulk load a map from pairs sorted by key, with no key repeated.
+  /*
+   * O(n), against O(n log n) for inserting them one by one, and the
+   * nodes come out all but full. Throws std::invalid_argument if the
+   * keys aren't sorted and unique.
+   * @param sorted - the pairs; moved from, if an rvalue.
+   */
+  btree_map(sorted_unique_t, const prac::vector<std::pair<K, V>> &sorted,
+            const Compare &comp = Compare(), const Alloc &alloc = Alloc())
+      : base(comp, alloc) {
+    this->build_sorted(sorted.begin(), sorted.size());
+  }
+  btree_map(sorted_unique_t, prac::vector<std::pair<K, V>> &&sorted,
+            const Compare &comp = Compare(), const Alloc &alloc = Alloc())
+      : base(comp, alloc) {
+    this->build_sorted(std::make_move_iterator(sorted.begin()), sorted.size());
+  }
+
+  /// Get the value for key, inserting a default-constructed one if it
+  /// isn't there.
+  V &operator[](const K &key) {
+    return (*this->try_emplace(key).first).second;
+  }
+  V &operator[](K &&key) {
+    return (*this->try_emplace(std::move(key)).first).second;
+  }
+
+  /// Get the value for key, which must be there.
+  /*
+   * Throws std::out_of_range if it isn't.
+   */
+  V &at(const K &key) {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw std::out_of_range("prac::btree_map::at");
+    }
+    return (*it).second;
+  }
+  const V &at(const K &key) const {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw std::out_of_range("prac::btree_map::at");
+    }
+    return (*it).second;
+  }
+
+  /// Insert a copy of value, unless its key is already there.
+  /*
+   * O(log n).
+   * @return an iterator to the element with the key, and whether it
+   *         was inserted.
+   */
+  std::pair<typename base::iterator, bool> insert(const value_type &value) {
+    return this->emplace_key(value.first, value.second);
+  }
+  std::pair<typename base::iterator, bool> insert(value_type &&value) {
+    return this->emplace_key(value.first, std::move(value.second));
+  }
+
+  /// Insert copies of a range.
+  template <typename It> void insert(It first, It last) {
+    for (; first != last; ++first) {
+      this->insert(*first);
+    }
+  }
+
+  /// Construct a pair from args and insert it, unless its key is
+  /// already there.
+  template <typename... Args>
+  std::pair<typename base::iterator, bool> emplace(Args &&... args) {
+    std::pair<K, V> value(std::forward<Args>(args)...);
+    return this->emplace_key(std::move(value.first), std::move(value.second));
+  }
+
+  /// Insert a value constructed from args for key, unless key is
+  /// already there, in which case args are left untouched.
+  /*
+   * @return as insert().
+   */
+  template <typename... Args>
+  std::pair<typename base::iterator, bool> try_emplace(const K &key,
+                                                       Args &&... args) {
+    return this->emplace_key(key, std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<typename base::iterator, bool> try_emplace(K &&key,
+                                                       Args &&... args) {
+    return this->emplace_key(std::move(key), std::forward<Args>(args)...);
+  }
+
+  /// Set the value for key, inserting it if it isn't there.
+  /*
+   * @return as insert().
+   */
+  template <typename M>
+  std::pair<typename base::iterator, bool> insert_or_assign(const K &key,
+                                                            M &&value) {
+    auto result = this->try_emplace(key, std::forward<M>(value));
+    if (!result.second) {
+      (*result.first).second = std::forward<M>(value);
+    }
+    return result;
+  }
+};
+
+}; // namespace prac
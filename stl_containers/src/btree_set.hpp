@@ -0,0 +1,79 @@
+#pragma once
+#include "btree.hpp"
+#include "memory.hpp"
+#include "vector.hpp"
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+namespace prac {
+
+/*
+ * A sorted set of K in a B+ tree with wide nodes: see detail::btree,
+ * and btree_map for how it differs from std. Leaves hold keys only.
+ */
+template <typename K, typename Compare = std::less<K>,
+          typename Alloc = prac::allocator<K>>
+class btree_set : public detail::btree<K, detail::btree_no_value, Compare,
+                                       Alloc> {
+  typedef detail::btree<K, detail::btree_no_value, Compare, Alloc> base;
+
+public:
+  typedef K value_type;
+
+  using base::base;
+  btree_set() = default;
+
+  /// Construction from a list of keys. Duplicates are dropped.
+  btree_set(std::initializer_list<K> list) {
+    this->insert(list.begin(), list.end());
+  }
+
+  /// Bulk load a set from sorted keys, with no key repeated.
+  /*
+   * O(n), against O(n log n) for inserting them one by one, and the
+   * nodes come out all but full. Throws std::invalid_argument if the
+   * keys aren't sorted and unique.
+   * @param sorted - the keys; moved from, if an rvalue.
+   */
+  btree_set(sorted_unique_t, const prac::vector<K> &sorted,
+            const Compare &comp = Compare(), const Alloc &alloc = Alloc())
+      : base(comp, alloc) {
+    this->build_sorted(sorted.begin(), sorted.size());
+  }
+  btree_set(sorted_unique_t, prac::vector<K> &&sorted,
+            const Compare &comp = Compare(), const Alloc &alloc = Alloc())
+      : base(comp, alloc) {
+    this->build_sorted(std::make_move_iterator(sorted.begin()), sorted.size());
+  }
+
+  /// Insert a copy of key, unless it is already there.
+  /*
+   * O(log n).
+   * @return an iterator to the element with the key, and whether it
+   *         was inserted.
+   */
+  std::pair<typename base::iterator, bool> insert(const K &key) {
+    return this->emplace_key(key);
+  }
+  std::pair<typename base::iterator, bool> insert(K &&key) {
+    return this->emplace_key(std::move(key));
+  }
+
+  /// Insert copies of a range.
+  template <typename It> void insert(It first, It last) {
+    for (; first != last; ++first) {
+      this->insert(*first);
+    }
+  }
+
+  /// Construct a key from args and insert it, unless it is already
+  /// there.
+  template <typename... Args>
+  std::pair<typename base::iterator, bool> emplace(Args &&... args) {
+    return this->emplace_key(K(std::forward<Args>(args)...));
+  }
+};
+
+}; // namespace prac
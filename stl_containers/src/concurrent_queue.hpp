@@ -0,0 +1,200 @@
+#pragma once
+#include "hazard.hpp"
+#include "memory.hpp"
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <utility>
+
+namespace prac {
+/*
+ * An unbounded multi-producer, multi-consumer FIFO queue.
+ *
+ * A Michael-Scott queue: a singly linked list of nodes, like
+ * prac::list's but linked only forwards, with atomic head and tail
+ * pointers. The head node is a dummy whose value has already been
+ * taken; the front element lives in the node after it. push() links
+ * a node after the tail with one compare-exchange, try_pop() swings
+ * the head forward with another, and either helps a lagging tail
+ * along, so both are lock-free: some thread always makes progress,
+ * and neither ever waits for another.
+ *
+ * Popped nodes are freed through the global hazard_domain, so a
+ * thread still reading a node another thread has popped past never
+ * touches freed memory.
+ *
+ * The head and tail are on separate cache lines, so producers and
+ * consumers only contend with each other when the queue is empty.
+ */
+template <typename T> class concurrent_queue {
+public:
+  typedef T value_type;
+
+  /// Construction of an empty queue.
+  concurrent_queue() {
+    Node *dummy = create_node();
+    m_head.store(dummy, std::memory_order_relaxed);
+    m_tail.store(dummy, std::memory_order_relaxed);
+  }
+
+  concurrent_queue(const concurrent_queue &) = delete;
+  concurrent_queue &operator=(const concurrent_queue &) = delete;
+
+  /// Destroy the remaining elements.
+  /*
+   * O(n). No other thread may use the queue any more.
+   */
+  ~concurrent_queue() {
+    Node *node = m_head.load(std::memory_order_relaxed);
+    // The dummy's value is gone already.
+    Node *next = node->next.load(std::memory_order_relaxed);
+    free_node(node);
+    for (node = next; node != nullptr; node = next) {
+      next = node->next.load(std::memory_order_relaxed);
+      node->value()->~T();
+      free_node(node);
+    }
+  }
+
+  /// Add an element at the back.
+  /*
+   * Lock-free, O(1) plus one allocation.
+   * @param new_elem - the new element to add.
+   */
+  void push(const T &new_elem) { this->emplace(new_elem); }
+
+  /// Add an element at the back, moving from it.
+  /*
+   * Lock-free, O(1) plus one allocation.
+   * @param new_elem - the new element to add.
+   */
+  void push(T &&new_elem) { this->emplace(std::move(new_elem)); }
+
+  /// Construct an element in place at the back.
+  /*
+   * Lock-free, O(1) plus one allocation. The element is constructed
+   * before the node is linked in, so a throwing constructor leaves
+   * the queue as it was.
+   * @param args - the arguments to T's constructor.
+   */
+  template <typename... Args> void emplace(Args &&... args) {
+    Node *node = create_node();
+    try {
+      new (node->value()) T(std::forward<Args>(args)...);
+    } catch (...) {
+      free_node(node);
+      throw;
+    }
+    hazard_domain &domain = hazard_domain::global();
+    while (true) {
+      Node *tail = domain.protect(0, m_tail);
+      Node *next = tail->next.load(std::memory_order_acquire);
+      if (next != nullptr) {
+        // Another push linked a node but hasn't moved the tail yet.
+        m_tail.compare_exchange_weak(tail, next, std::memory_order_release,
+                                     std::memory_order_relaxed);
+        continue;
+      }
+      if (tail->next.compare_exchange_weak(next, node,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        m_tail.compare_exchange_strong(tail, node, std::memory_order_release,
+                                       std::memory_order_relaxed);
+        break;
+      }
+    }
+    domain.clear(0);
+  }
+
+  /// Remove the front element, if there is one.
+  /*
+   * Lock-free, O(1), and never blocks: an empty queue returns false
+   * straight away.
+   * @param out - assigned the front element, moved from the queue.
+   *              If the assignment throws, the element is lost.
+   * @return whether there was an element.
+   */
+  bool try_pop(T &out) {
+    hazard_domain &domain = hazard_domain::global();
+    Node *head;
+    Node *next;
+    while (true) {
+      head = domain.protect(0, m_head);
+      next = domain.protect(1, head->next);
+      if (m_head.load(std::memory_order_seq_cst) != head) {
+        // head was popped past, so next may be stale.
+        continue;
+      }
+      if (next == nullptr) {
+        domain.clear(0);
+        domain.clear(1);
+        return false;
+      }
+      Node *tail = m_tail.load(std::memory_order_acquire);
+      if (head == tail) {
+        // Help the push that linked next move the tail, so the head
+        // never passes it.
+        m_tail.compare_exchange_weak(tail, next, std::memory_order_release,
+                                     std::memory_order_relaxed);
+        continue;
+      }
+      if (m_head.compare_exchange_weak(head, next, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    // Winning the compare-exchange made next the dummy, and its value
+    // ours. Slot 1 keeps it alive until we're done with it.
+    T *value = next->value();
+    try {
+      out = std::move(*value);
+    } catch (...) {
+      value->~T();
+      domain.clear(0);
+      domain.clear(1);
+      domain.retire(head, &free_node_erased);
+      throw;
+    }
+    value->~T();
+    domain.clear(0);
+    domain.clear(1);
+    domain.retire(head, &free_node_erased);
+    return true;
+  }
+
+  /// Whether the queue had no elements at the time of the call.
+  /*
+   * O(1). Only a hint while other threads push and pop.
+   */
+  bool empty() const {
+    hazard_domain &domain = hazard_domain::global();
+    Node *head = domain.protect(0, m_head);
+    bool is_empty = head->next.load(std::memory_order_acquire) == nullptr;
+    domain.clear(0);
+    return is_empty;
+  }
+
+private:
+  struct Node {
+    std::atomic<Node *> next;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T *value() { return reinterpret_cast<T *>(storage); }
+  };
+
+  static Node *create_node() {
+    Node *node = new (detail::allocate_storage<Node>(1)) Node;
+    node->next.store(nullptr, std::memory_order_relaxed);
+    return node;
+  }
+
+  static void free_node(Node *node) { detail::deallocate_storage(node); }
+
+  static void free_node_erased(void *node) {
+    free_node(static_cast<Node *>(node));
+  }
+
+  alignas(64) std::atomic<Node *> m_head;
+  alignas(64) std::atomic<Node *> m_tail;
+};
+}; // namespace prac
@@ -0,0 +1,456 @@
+#pragma once
+#include "memory.hpp"
+#include <atomic>
+#include <iterator>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace prac {
+/*
+ * An append-only vector that many threads can grow at once.
+ *
+ * Elements live in segments that double in size: segment 0 holds
+ * first_segment_size elements, segment k holds first_segment_size << k.
+ * A segment is never reallocated, so elements never move and
+ * references to them stay valid for the life of the container.
+ *
+ * push_back(), emplace_back() and grow_by() claim their indices with
+ * one fetch_add on the reserved count, and are lock-free except when a
+ * segment is first needed: one thread claims it with a
+ * compare-exchange and allocates it, and any other thread that needs
+ * it yields until it is published, so a segment is only ever
+ * allocated once. After constructing an element the writer sets the
+ * element's state to ready. size() is the length of the prefix whose
+ * elements are all done, so readers can index anything below size()
+ * while appends to later indices are still in progress.
+ *
+ * Reading an element races with nothing, but modifying an element
+ * other threads read needs synchronization of its own. clear() and
+ * destruction must not run concurrently with anything else.
+ *
+ * If T's constructor throws, the append rethrows and the element's
+ * state is set to failed instead, so size() still moves past it. The
+ * element must not be used; is_ready() tells it apart, so readers of
+ * a vector whose appends can throw check it. If a segment can't be
+ * allocated, the append throws std::bad_alloc and size() stops below
+ * its indices.
+ */
+template <typename T> class concurrent_vector {
+public:
+  /// The number of elements in the first segment.
+  static constexpr size_t first_segment_size = 32;
+
+  typedef T value_type;
+
+  concurrent_vector() : m_num_reserved(0), m_num_ready(0) {
+    for (size_t k = 0; k < max_segments; k++) {
+      m_segments[k].store(nullptr, std::memory_order_relaxed);
+      m_states[k].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  concurrent_vector(const concurrent_vector &) = delete;
+  concurrent_vector &operator=(const concurrent_vector &) = delete;
+
+  ~concurrent_vector() {
+    this->clear();
+    for (size_t k = 0; k < max_segments; k++) {
+      T *elements = m_segments[k].load(std::memory_order_relaxed);
+      state *states = m_states[k].load(std::memory_order_relaxed);
+      detail::deallocate_storage(elements);
+      if (states != nullptr) {
+        detail::destroy(states, segment_size(k));
+        detail::deallocate_storage(states);
+      }
+    }
+  }
+
+  /// Push back a new element.
+  /*
+   * Lock-free, O(1). Safe to call from any number of threads at once.
+   * @param new_elem - the new element to add.
+   * @return the index of the new element.
+   */
+  size_t push_back(const T &new_elem) { return this->emplace_back(new_elem); }
+
+  /// Push back a new element, moving from it.
+  /*
+   * Lock-free, O(1).
+   * @param new_elem - the new element to add.
+   * @return the index of the new element.
+   */
+  size_t push_back(T &&new_elem) {
+    return this->emplace_back(std::move(new_elem));
+  }
+
+  /// Construct a new element in place at the back.
+  /*
+   * Lock-free, O(1). The element is readable through the returned
+   * index by this thread straight away, and by others once size() is
+   * past it.
+   * @param args - the arguments to T's constructor.
+   * @return the index of the new element.
+   */
+  template <typename... Args> size_t emplace_back(Args &&... args) {
+    size_t index = m_num_reserved.fetch_add(1, std::memory_order_relaxed);
+    size_t k = segment_of(index);
+    T *slot = this->segment(k) + (index - segment_base(k));
+    try {
+      new (slot) T(std::forward<Args>(args)...);
+    } catch (...) {
+      this->set_state(k, index, state_failed);
+      throw;
+    }
+    this->set_state(k, index, state_ready);
+    return index;
+  }
+
+  /// Append n copies of a value as one contiguous run of indices.
+  /*
+   * Lock-free, O(n). The run may span segments, so its elements are
+   * not necessarily adjacent in memory. Every segment the run needs
+   * is allocated before any element is constructed. If a copy throws,
+   * it and the rest of the run are marked failed.
+   * @param n - the number of elements to add.
+   * @param value - the value to copy.
+   * @return the index of the first new element.
+   */
+  size_t grow_by(const size_t &n, const T &value = T()) {
+    size_t first = m_num_reserved.fetch_add(n, std::memory_order_relaxed);
+    size_t last = first + n;
+    try {
+      for (size_t index = first; index < last;) {
+        size_t k = segment_of(index);
+        this->segment(k);
+        index = segment_base(k) + segment_size(k);
+      }
+    } catch (...) {
+      this->mark_failed(first, last);
+      throw;
+    }
+    for (size_t index = first; index < last; index++) {
+      size_t k = segment_of(index);
+      T *slot = m_segments[k].load(std::memory_order_acquire) +
+                (index - segment_base(k));
+      try {
+        new (slot) T(value);
+      } catch (...) {
+        this->mark_failed(index, last);
+        throw;
+      }
+      this->set_state(k, index, state_ready);
+    }
+    return first;
+  }
+
+  /// Retrieve an element.
+  /*
+   * O(1). Valid for any index below size(), and for indices this
+   * thread got back from an append. Bounds are not checked.
+   * @param i - the index at which to retrieve the element.
+   * @return a reference to the element, which stays valid until the
+   *         container is cleared or destroyed.
+   */
+  const T &operator[](const size_t &i) const {
+    size_t k = segment_of(i);
+    return m_segments[k].load(std::memory_order_acquire)[i - segment_base(k)];
+  }
+
+  /// Retrieve an element.
+  /*
+   * O(1). See the const overload.
+   * @param i - the index at which to retrieve the element.
+   * @return a reference to the element.
+   */
+  T &operator[](const size_t &i) {
+    size_t k = segment_of(i);
+    return m_segments[k].load(std::memory_order_acquire)[i - segment_base(k)];
+  }
+
+  /// Get the number of elements readers can use.
+  /*
+   * Amortized O(1). Every element below the result has been fully
+   * constructed, unless its constructor threw; see is_ready().
+   * Advances the count past elements that are done since the last
+   * call, on behalf of every thread.
+   * @return the length of the prefix of done elements.
+   */
+  size_t size() const {
+    size_t num_ready = m_num_ready.load(std::memory_order_acquire);
+    size_t num_reserved = m_num_reserved.load(std::memory_order_relaxed);
+    size_t scanned = num_ready;
+    while (scanned < num_reserved &&
+           this->get_state(scanned) != state_pending) {
+      scanned++;
+    }
+    while (scanned > num_ready &&
+           !m_num_ready.compare_exchange_weak(num_ready, scanned,
+                                              std::memory_order_release,
+                                              std::memory_order_acquire)) {
+    }
+    return scanned > num_ready ? scanned : num_ready;
+  }
+
+  /// Whether there are no ready elements.
+  bool empty() const { return this->size() == 0; }
+
+  /// Get the number of indices handed out, ready or not.
+  size_t reserved_size() const {
+    return m_num_reserved.load(std::memory_order_relaxed);
+  }
+
+  /// Whether the element at index i has been constructed.
+  /*
+   * O(1). False while the append is in progress, and for good if T's
+   * constructor threw. Lets a reader use elements past size() whose
+   * appends have finished.
+   */
+  bool is_ready(const size_t &i) const {
+    return this->get_state(i) == state_ready;
+  }
+
+  /// Get the number of elements that fit in the allocated segments.
+  size_t capacity() const {
+    size_t num_allocated = 0;
+    for (size_t k = 0; k < max_segments; k++) {
+      T *elements = m_segments[k].load(std::memory_order_acquire);
+      if (elements != nullptr && elements != busy()) {
+        num_allocated += segment_size(k);
+      }
+    }
+    return num_allocated;
+  }
+
+  /// Destroy every element.
+  /*
+   * O(n). Not safe to call while other threads use the container.
+   * The segments are kept for reuse.
+   */
+  void clear() {
+    size_t num_reserved = m_num_reserved.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < num_reserved; i++) {
+      size_t k = segment_of(i);
+      state *states = m_states[k].load(std::memory_order_relaxed);
+      if (states == nullptr) {
+        // The segment's allocation threw, so nothing was built in it.
+        continue;
+      }
+      state &slot = states[i - segment_base(k)];
+      if (slot.load(std::memory_order_relaxed) == state_ready) {
+        (*this)[i].~T();
+      }
+      slot.store(state_pending, std::memory_order_relaxed);
+    }
+    m_num_reserved.store(0, std::memory_order_relaxed);
+    m_num_ready.store(0, std::memory_order_relaxed);
+  }
+
+  /// Iterates over the elements below size() at the time it was
+  /// created.
+  /*
+   * Random access, but not contiguous: the segments are separate
+   * allocations.
+   */
+  template <typename Value> class basic_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_const<Value>::type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Value *pointer;
+    typedef Value &reference;
+    typedef typename std::conditional<std::is_const<Value>::value,
+                                      const concurrent_vector,
+                                      concurrent_vector>::type container;
+
+    basic_iterator() : m_vec(nullptr), m_index(0) {}
+    basic_iterator(container *vec, const size_t &index)
+        : m_vec(vec), m_index(index) {}
+
+    reference operator*() const { return (*m_vec)[m_index]; }
+    pointer operator->() const { return &(*m_vec)[m_index]; }
+    reference operator[](const difference_type &n) const {
+      return (*m_vec)[m_index + n];
+    }
+
+    basic_iterator &operator++() {
+      m_index++;
+      return *this;
+    }
+    basic_iterator operator++(int) {
+      basic_iterator old = *this;
+      m_index++;
+      return old;
+    }
+    basic_iterator &operator--() {
+      m_index--;
+      return *this;
+    }
+    basic_iterator operator--(int) {
+      basic_iterator old = *this;
+      m_index--;
+      return old;
+    }
+    basic_iterator &operator+=(const difference_type &n) {
+      m_index += n;
+      return *this;
+    }
+    basic_iterator &operator-=(const difference_type &n) {
+      m_index -= n;
+      return *this;
+    }
+    basic_iterator operator+(const difference_type &n) const {
+      return basic_iterator(m_vec, m_index + n);
+    }
+    basic_iterator operator-(const difference_type &n) const {
+      return basic_iterator(m_vec, m_index - n);
+    }
+    difference_type operator-(const basic_iterator &other) const {
+      return difference_type(m_index) - difference_type(other.m_index);
+    }
+
+    bool operator==(const basic_iterator &other) const {
+      return m_index == other.m_index;
+    }
+    bool operator!=(const basic_iterator &other) const {
+      return m_index != other.m_index;
+    }
+    bool operator<(const basic_iterator &other) const {
+      return m_index < other.m_index;
+    }
+    bool operator>(const basic_iterator &other) const {
+      return m_index > other.m_index;
+    }
+    bool operator<=(const basic_iterator &other) const {
+      return m_index <= other.m_index;
+    }
+    bool operator>=(const basic_iterator &other) const {
+      return m_index >= other.m_index;
+    }
+
+  private:
+    container *m_vec;
+    size_t m_index;
+  };
+
+  typedef basic_iterator<T> iterator;
+  typedef basic_iterator<const T> const_iterator;
+
+  // Iterators. end() is taken from size() when it is called, so
+  // elements appended afterwards are not visited.
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, this->size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, this->size()); }
+
+private:
+  static constexpr size_t max_segments = 64;
+
+  /// The state of an element's append.
+  typedef std::atomic<unsigned char> state;
+  static constexpr unsigned char state_pending = 0;
+  static constexpr unsigned char state_ready = 1;
+  static constexpr unsigned char state_failed = 2;
+
+  /// Get the segment holding index i.
+  static size_t segment_of(const size_t &i) {
+    // Segment k starts at first_segment_size * (2^k - 1).
+    unsigned long long scaled = i / first_segment_size + 1;
+    return size_t(63 - __builtin_clzll(scaled));
+  }
+
+  /// Get the index of the first element of segment k.
+  static size_t segment_base(const size_t &k) {
+    return first_segment_size * ((size_t(1) << k) - 1);
+  }
+
+  static size_t segment_size(const size_t &k) {
+    return first_segment_size << k;
+  }
+
+  /// Marks a segment that a thread is allocating. Never dereferenced.
+  static T *busy() { return reinterpret_cast<T *>(uintptr_t(alignof(T))); }
+
+  /// Get segment k's elements, allocating the segment if it doesn't
+  /// exist yet.
+  T *segment(const size_t &k) {
+    T *elements = m_segments[k].load(std::memory_order_acquire);
+    if (elements == nullptr || elements == busy()) {
+      elements = this->allocate_segment(k);
+    }
+    return elements;
+  }
+
+  /// Allocate segment k, or wait for the thread allocating it.
+  T *allocate_segment(const size_t &k) {
+    T *elements = nullptr;
+    if (!m_segments[k].compare_exchange_strong(elements, busy(),
+                                               std::memory_order_acquire)) {
+      while (elements == busy()) {
+        std::this_thread::yield();
+        elements = m_segments[k].load(std::memory_order_acquire);
+      }
+      // Null if the allocating thread ran out of memory.
+      return elements != nullptr ? elements : this->allocate_segment(k);
+    }
+    size_t n = segment_size(k);
+    state *states = nullptr;
+    try {
+      states = detail::allocate_storage<state>(n);
+      elements = detail::allocate_storage<T>(n);
+    } catch (...) {
+      detail::deallocate_storage(states);
+      m_segments[k].store(nullptr, std::memory_order_release);
+      throw;
+    }
+    for (size_t i = 0; i < n; i++) {
+      new (states + i) state(state_pending);
+    }
+    // The states are published first, so that they exist by the time
+    // anyone can construct an element in the segment.
+    m_states[k].store(states, std::memory_order_release);
+    m_segments[k].store(elements, std::memory_order_release);
+    return elements;
+  }
+
+  unsigned char get_state(const size_t &i) const {
+    size_t k = segment_of(i);
+    state *states = m_states[k].load(std::memory_order_acquire);
+    return states == nullptr
+               ? state_pending
+               : states[i - segment_base(k)].load(std::memory_order_acquire);
+  }
+
+  void set_state(const size_t &k, const size_t &index,
+                 const unsigned char &value) {
+    m_states[k].load(std::memory_order_acquire)[index - segment_base(k)].store(
+        value, std::memory_order_release);
+  }
+
+  /// Mark the indices in [first, last) failed.
+  /*
+   * Doesn't allocate, so it is safe in an exception handler. Indices
+   * in segments that were never allocated are skipped.
+   */
+  void mark_failed(size_t first, const size_t &last) {
+    for (; first < last; first++) {
+      size_t k = segment_of(first);
+      state *states = m_states[k].load(std::memory_order_acquire);
+      if (states != nullptr) {
+        states[first - segment_base(k)].store(state_failed,
+                                              std::memory_order_release);
+      }
+    }
+  }
+
+  std::atomic<T *> m_segments[max_segments];
+  std::atomic<state *> m_states[max_segments];
+  /// Written by every append. Kept on its own cache line, away from
+  /// the segment table that every read loads from.
+  alignas(64) std::atomic<size_t> m_num_reserved;
+  alignas(64) mutable std::atomic<size_t> m_num_ready;
+};
+}; // namespace prac
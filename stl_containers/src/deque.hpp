@@ -0,0 +1,545 @@
+#pragma once
+#include "memory.hpp"
+#include "vector.hpp"
+#include <iterator>
+#include <memory>
+#include <stddef.h>
+#include <utility>
+
+namespace prac {
+
+namespace detail {
+
+/// The number of elements of size elem_size in a deque block: the
+/// largest power of two that fits in 4KB, but at least 16.
+constexpr size_t deque_block_size(const size_t &elem_size,
+                                  const size_t &size = 16) {
+  return size * 2 * elem_size > 4096 ? size
+                                     : deque_block_size(elem_size, size * 2);
+}
+
+}; // namespace detail
+
+/*
+ * A double-ended queue in fixed-size blocks.
+ *
+ * push and pop at either end are O(1) and never move an element:
+ * elements live in blocks of block_size, found through a map of block
+ * pointers, so only the map ever grows, and it holds one pointer per
+ * block. The map is a ring, so adding a block at the front is as
+ * cheap as at the back. Indexing is O(1): two shifts, a mask and two
+ * loads.
+ *
+ * Blocks that empty are cached and reused by the next push at either
+ * end, so a deque used as a FIFO or a sliding window stops allocating
+ * once it reaches its peak size. shrink_to_fit() gives the cached
+ * blocks back.
+ *
+ * Pushes invalidate iterators but not references; pops invalidate
+ * only iterators and references to the popped element and end().
+ */
+template <typename T, typename Alloc = prac::allocator<T>> class deque {
+  typedef std::allocator_traits<Alloc> alloc_traits;
+  typedef typename alloc_traits::template rebind_alloc<T *> map_allocator;
+  typedef prac::vector<T *, map_allocator> block_map;
+
+public:
+  typedef T value_type;
+  typedef Alloc allocator_type;
+
+  /// The number of elements in a block, a power of two.
+  static constexpr size_t block_size = detail::deque_block_size(sizeof(T));
+
+  /// Construction of an empty deque.
+  /*
+   * Allocates nothing.
+   * @param alloc - The allocator to get blocks from.
+   */
+  explicit deque(const Alloc &alloc = Alloc())
+      : m_alloc(alloc), m_map(map_allocator(alloc)), m_head(0),
+        m_num_blocks(0), m_start(0), m_num_elements(0), m_front(nullptr),
+        m_back_end(nullptr), m_cached(map_allocator(alloc)),
+        m_num_allocated(0) {}
+
+  /// Construction from STL container iterators.
+  /*
+   * O(n).
+   * @param begin - the beginning iterator.
+   * @param end - the ending iterator.
+   * @param alloc - The allocator to get blocks from.
+   */
+  template <typename Other, typename = typename std::enable_if<
+                                !std::is_integral<Other>::value>::type>
+  deque(Other begin, Other end, const Alloc &alloc = Alloc()) : deque(alloc) {
+    for (; begin != end; ++begin) {
+      this->push_back(*begin);
+    }
+  }
+
+  /// Copy construction.
+  /*
+   * O(n). The copy gets only the blocks it needs.
+   */
+  deque(const deque &other)
+      : deque(other.begin(), other.end(),
+              alloc_traits::select_on_container_copy_construction(
+                  other.m_alloc)) {}
+
+  /// Move construction.
+  /*
+   * O(1). Steals the blocks of other, which is left empty.
+   */
+  deque(deque &&other) noexcept : deque(other.m_alloc) { this->swap(other); }
+
+  /// Copy assignment. O(n); provides the strong exception guarantee.
+  deque &operator=(const deque &other) {
+    if (this != &other) {
+      deque copy(other.begin(), other.end(), m_alloc);
+      this->swap(copy);
+    }
+    return *this;
+  }
+
+  /// Move assignment. O(n) in the number of elements destroyed.
+  deque &operator=(deque &&other) noexcept {
+    if (this != &other) {
+      deque moved(std::move(other));
+      this->swap(moved);
+    }
+    return *this;
+  }
+
+  ~deque() {
+    this->clear();
+    this->release_cached_blocks();
+    if (m_num_blocks > 0) {
+      alloc_traits::deallocate(m_alloc, this->block(0), block_size);
+    }
+  }
+
+  /// Exchange contents with another deque.
+  void swap(deque &other) noexcept {
+    std::swap(m_alloc, other.m_alloc);
+    m_map.swap(other.m_map);
+    std::swap(m_head, other.m_head);
+    std::swap(m_num_blocks, other.m_num_blocks);
+    std::swap(m_start, other.m_start);
+    std::swap(m_num_elements, other.m_num_elements);
+    std::swap(m_front, other.m_front);
+    std::swap(m_back_end, other.m_back_end);
+    m_cached.swap(other.m_cached);
+    std::swap(m_num_allocated, other.m_num_allocated);
+  }
+
+  /// Add an element at the back.
+  /*
+   * O(1): at most one block is taken from the cache or allocated, and
+   * every block_size pushes at most one map slot is used up.
+   */
+  void push_back(const T &new_elem) { this->emplace_back(new_elem); }
+  void push_back(T &&new_elem) { this->emplace_back(std::move(new_elem)); }
+
+  /// Construct an element in place at the back.
+  /*
+   * If the constructor throws, nothing changes.
+   * @return a reference to the new element.
+   */
+  template <typename... Args> T &emplace_back(Args &&... args) {
+    T *slot = m_back_end;
+    bool added = false;
+    // Empty blocks at the back are dropped and an empty deque starts
+    // mid-block, so the back is at the end of the blocks exactly when
+    // it is at the end of a block.
+    if ((m_start + m_num_elements) % block_size == 0) {
+      this->add_block_back();
+      slot = this->block(m_num_blocks - 1);
+      added = true;
+    }
+    try {
+      new (slot) T(std::forward<Args>(args)...);
+    } catch (...) {
+      if (added) {
+        this->remove_block_back();
+      }
+      throw;
+    }
+    if (m_num_elements == 0) {
+      m_front = slot;
+    }
+    m_back_end = slot + 1;
+    m_num_elements++;
+    return *slot;
+  }
+
+  /// Add an element at the front.
+  /*
+   * O(1), as push_back().
+   */
+  void push_front(const T &new_elem) { this->emplace_front(new_elem); }
+  void push_front(T &&new_elem) { this->emplace_front(std::move(new_elem)); }
+
+  /// Construct an element in place at the front.
+  /*
+   * If the constructor throws, nothing changes.
+   * @return a reference to the new element.
+   */
+  template <typename... Args> T &emplace_front(Args &&... args) {
+    T *slot;
+    bool added = false;
+    if (m_start == 0) {
+      this->add_block_front();
+      slot = this->block(0) + block_size - 1;
+      added = true;
+    } else {
+      slot = m_front - 1;
+    }
+    try {
+      new (slot) T(std::forward<Args>(args)...);
+    } catch (...) {
+      if (added) {
+        this->remove_block_front();
+      }
+      throw;
+    }
+    if (m_num_elements == 0) {
+      m_back_end = slot + 1;
+    }
+    m_front = slot;
+    m_start--;
+    m_num_elements++;
+    return *slot;
+  }
+
+  /// Remove the back element.
+  /*
+   * O(1). A block left empty is cached for reuse.
+   */
+  void pop_back() {
+    m_num_elements--;
+    m_back_end--;
+    detail::destroy(m_back_end, 1);
+    if (m_num_elements == 0) {
+      this->recenter();
+    } else if (m_start + m_num_elements == (m_num_blocks - 1) * block_size) {
+      this->remove_block_back();
+      m_back_end = this->block(m_num_blocks - 1) + block_size;
+    }
+  }
+
+  /// Remove the front element.
+  /*
+   * O(1). A block left empty is cached for reuse.
+   */
+  void pop_front() {
+    detail::destroy(m_front, 1);
+    m_front++;
+    m_start++;
+    m_num_elements--;
+    if (m_num_elements == 0) {
+      this->recenter();
+    } else if (m_start == block_size) {
+      this->remove_block_front();
+      m_front = this->block(0);
+    }
+  }
+
+  /// Retrieve an element.
+  /*
+   * O(1) random access. Does not check bounds.
+   * @param i - the index at which to retrieve the element.
+   * @return a reference to the element.
+   */
+  T &operator[](const size_t &i) { return *this->element(m_start + i); }
+  const T &operator[](const size_t &i) const {
+    return *this->element(m_start + i);
+  }
+
+  T &front() { return *m_front; }
+  const T &front() const { return *m_front; }
+  T &back() { return *(m_back_end - 1); }
+  const T &back() const { return *(m_back_end - 1); }
+
+  /// Get the number of elements.
+  size_t size() const { return m_num_elements; }
+
+  /// Whether there are no elements.
+  bool empty() const { return m_num_elements == 0; }
+
+  /// Remove every element.
+  /*
+   * O(n). The blocks are cached for reuse.
+   */
+  void clear() {
+    while (m_num_elements > 0) {
+      this->pop_back();
+    }
+  }
+
+  /// Give back the blocks that are cached for reuse.
+  void shrink_to_fit() { this->release_cached_blocks(); }
+
+  /// Get a copy of the allocator.
+  Alloc get_allocator() const { return m_alloc; }
+
+  /// A random-access iterator.
+  /*
+   * Steps within a block are a pointer increment; the map is only
+   * looked at when crossing into another block.
+   */
+  template <typename Value, typename Container> class basic_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Value *pointer;
+    typedef Value &reference;
+
+    basic_iterator()
+        : m_deque(nullptr), m_pos(0), m_cur(nullptr), m_block_end(nullptr) {}
+    basic_iterator(Container *owner, const size_t &pos)
+        : m_deque(owner), m_pos(pos) {
+      this->locate();
+    }
+    /// iterator converts to const_iterator.
+    template <typename OtherValue, typename OtherContainer>
+    basic_iterator(const basic_iterator<OtherValue, OtherContainer> &other)
+        : m_deque(other.m_deque), m_pos(other.m_pos), m_cur(other.m_cur),
+          m_block_end(other.m_block_end) {}
+
+    reference operator*() const { return *m_cur; }
+    pointer operator->() const { return m_cur; }
+    reference operator[](const difference_type &n) const {
+      return *(*this + n);
+    }
+
+    basic_iterator &operator++() {
+      m_pos++;
+      if (++m_cur == m_block_end) {
+        this->locate();
+      }
+      return *this;
+    }
+    basic_iterator operator++(int) {
+      basic_iterator old = *this;
+      ++*this;
+      return old;
+    }
+    basic_iterator &operator--() {
+      m_pos--;
+      this->locate();
+      return *this;
+    }
+    basic_iterator operator--(int) {
+      basic_iterator old = *this;
+      --*this;
+      return old;
+    }
+    basic_iterator &operator+=(const difference_type &n) {
+      m_pos += n;
+      this->locate();
+      return *this;
+    }
+    basic_iterator &operator-=(const difference_type &n) {
+      return *this += -n;
+    }
+    basic_iterator operator+(const difference_type &n) const {
+      return basic_iterator(m_deque, m_pos + n);
+    }
+    basic_iterator operator-(const difference_type &n) const {
+      return basic_iterator(m_deque, m_pos - n);
+    }
+    template <typename OtherValue, typename OtherContainer>
+    difference_type
+    operator-(const basic_iterator<OtherValue, OtherContainer> &other) const {
+      return difference_type(m_pos) - difference_type(other.m_pos);
+    }
+
+    template <typename OtherValue, typename OtherContainer>
+    bool operator==(
+        const basic_iterator<OtherValue, OtherContainer> &other) const {
+      return m_pos == other.m_pos;
+    }
+    template <typename OtherValue, typename OtherContainer>
+    bool operator!=(
+        const basic_iterator<OtherValue, OtherContainer> &other) const {
+      return m_pos != other.m_pos;
+    }
+    template <typename OtherValue, typename OtherContainer>
+    bool operator<(
+        const basic_iterator<OtherValue, OtherContainer> &other) const {
+      return m_pos < other.m_pos;
+    }
+    template <typename OtherValue, typename OtherContainer>
+    bool operator>(
+        const basic_iterator<OtherValue, OtherContainer> &other) const {
+      return m_pos > other.m_pos;
+    }
+    template <typename OtherValue, typename OtherContainer>
+    bool operator<=(
+        const basic_iterator<OtherValue, OtherContainer> &other) const {
+      return m_pos <= other.m_pos;
+    }
+    template <typename OtherValue, typename OtherContainer>
+    bool operator>=(
+        const basic_iterator<OtherValue, OtherContainer> &other) const {
+      return m_pos >= other.m_pos;
+    }
+
+  private:
+    template <typename, typename> friend class basic_iterator;
+
+    /// Point m_cur at m_pos, or at nothing past the last block.
+    void locate() {
+      if (m_pos / block_size >= m_deque->m_num_blocks) {
+        m_cur = nullptr;
+        m_block_end = nullptr;
+        return;
+      }
+      T *block = m_deque->block(m_pos / block_size);
+      m_cur = block + m_pos % block_size;
+      m_block_end = block + block_size;
+    }
+
+    Container *m_deque;
+    /// The position counted from the start of the first block.
+    size_t m_pos;
+    Value *m_cur;
+    Value *m_block_end;
+  };
+
+  typedef basic_iterator<T, deque> iterator;
+  typedef basic_iterator<const T, const deque> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  iterator begin() { return iterator(this, m_start); }
+  iterator end() { return iterator(this, m_start + m_num_elements); }
+  const_iterator begin() const { return const_iterator(this, m_start); }
+  const_iterator end() const {
+    return const_iterator(this, m_start + m_num_elements);
+  }
+  const_iterator cbegin() const { return this->begin(); }
+  const_iterator cend() const { return this->end(); }
+  reverse_iterator rbegin() { return reverse_iterator(this->end()); }
+  reverse_iterator rend() { return reverse_iterator(this->begin()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(this->end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(this->begin());
+  }
+
+private:
+  /// Get the map slot of block k, counted from the first in use.
+  size_t slot(const size_t &k) const {
+    return (m_head + k) & (m_map.size() - 1);
+  }
+
+  T *block(const size_t &k) const { return m_map[this->slot(k)]; }
+
+  /// Get the element at pos, counted from the start of the first block.
+  T *element(const size_t &pos) const {
+    return this->block(pos / block_size) + pos % block_size;
+  }
+
+  /// Get a cached block, or a new one.
+  T *take_block() {
+    if (m_cached.size() > 0) {
+      T *cached = m_cached[m_cached.size() - 1];
+      m_cached.pop_back();
+      return cached;
+    }
+    // The cache must have room for every block, so that caching one
+    // in a pop never allocates.
+    if (m_cached.capacity() <= m_num_allocated) {
+      m_cached.reserve(m_num_allocated < 4 ? 8 : m_num_allocated * 2);
+    }
+    T *block = alloc_traits::allocate(m_alloc, block_size);
+    m_num_allocated++;
+    return block;
+  }
+
+  /// Double the map, or create it, when every slot is in use.
+  /*
+   * The ring is unrolled so the blocks in use start at slot 0.
+   */
+  void reserve_slot() {
+    if (m_num_blocks < m_map.size()) {
+      return;
+    }
+    size_t new_size = m_map.size() == 0 ? 8 : m_map.size() * 2;
+    block_map new_map(new_size, nullptr, m_map.get_allocator());
+    for (size_t k = 0; k < m_num_blocks; k++) {
+      new_map[k] = this->block(k);
+    }
+    m_map.swap(new_map);
+    m_head = 0;
+  }
+
+  void add_block_back() {
+    this->reserve_slot();
+    m_map[this->slot(m_num_blocks)] = this->take_block();
+    m_num_blocks++;
+  }
+
+  void add_block_front() {
+    this->reserve_slot();
+    size_t before = this->slot(m_map.size() - 1);
+    m_map[before] = this->take_block();
+    m_head = before;
+    m_num_blocks++;
+    m_start += block_size;
+  }
+
+  /// Stop using the last block, and cache it.
+  void remove_block_back() {
+    m_num_blocks--;
+    m_cached.push_back(this->block(m_num_blocks));
+  }
+
+  /// Stop using the first block, and cache it.
+  void remove_block_front() {
+    m_cached.push_back(this->block(0));
+    m_head = this->slot(1);
+    m_num_blocks--;
+    m_start -= block_size;
+  }
+
+  /// Once empty, keep one block and start in its middle, so pushes at
+  /// either end fit in it.
+  void recenter() {
+    while (m_num_blocks > 1) {
+      this->remove_block_back();
+    }
+    m_start = block_size / 2;
+    m_front = this->block(0) + m_start;
+    m_back_end = m_front;
+  }
+
+  /// Free the cached blocks.
+  void release_cached_blocks() {
+    for (T *cached : m_cached) {
+      alloc_traits::deallocate(m_alloc, cached, block_size);
+    }
+    m_num_allocated -= m_cached.size();
+    m_cached.clear();
+  }
+
+  Alloc m_alloc;
+  /// A ring of block pointers. Its size is 0 or a power of two.
+  block_map m_map;
+  /// The slot of the first block in use.
+  size_t m_head;
+  size_t m_num_blocks;
+  /// The position of the front element in the first block.
+  size_t m_start;
+  size_t m_num_elements;
+  /// The front element, and one past the back element, so the ends
+  /// are reached without the map.
+  T *m_front;
+  T *m_back_end;
+  /// Blocks not in use, with capacity for every block allocated.
+  block_map m_cached;
+  size_t m_num_allocated;
+};
+}; // namespace prac
@@ -0,0 +1,62 @@
+#pragma once
+#include <stddef.h>
+
+namespace prac {
+/*
+ * Growth policies for prac::vector.
+ *
+ * A growth policy is any type with a static member
+ *
+ *   size_t grow(size_t capacity, size_t required, size_t element_size)
+ *
+ * which returns the capacity to reallocate to when a vector holding
+ * capacity elements needs room for required elements. The result must
+ * be at least required. Growing by a constant factor keeps push_back()
+ * and resize(size() + 1) amortized O(1).
+ */
+
+/// Double the capacity, starting from 10 elements.
+/*
+ * Fewest reallocations, at the cost of up to half the storage being
+ * unused.
+ */
+struct growth_2x {
+  static size_t grow(const size_t &capacity, const size_t &required,
+                     const size_t & /*element_size*/) {
+    size_t grown = capacity == 0 ? 10 : capacity * 2;
+    return grown < required ? required : grown;
+  }
+};
+
+/// Grow the capacity by half, starting from 10 elements.
+/*
+ * Wastes at most a third of the storage, and lets a freed buffer be
+ * reused by a later reallocation of the same vector.
+ */
+struct growth_1_5x {
+  static size_t grow(const size_t &capacity, const size_t &required,
+                     const size_t & /*element_size*/) {
+    size_t grown = capacity < 2 ? 10 : capacity + capacity / 2;
+    return grown < required ? required : grown;
+  }
+};
+
+/// Round another policy's capacity up to a whole number of pages.
+/*
+ * Large allocations are served in whole pages anyway, so the rest of
+ * the last page is free capacity. Elements are never split across
+ * the rounding: the result is a whole number of elements.
+ * @tparam Policy - the policy whose result is rounded.
+ * @tparam PageSize - the page size in bytes.
+ */
+template <typename Policy, size_t PageSize = 4096> struct page_rounded {
+  static_assert(PageSize > 0, "page_rounded needs a non-zero page size");
+
+  static size_t grow(const size_t &capacity, const size_t &required,
+                     const size_t &element_size) {
+    size_t grown = Policy::grow(capacity, required, element_size);
+    size_t bytes = (grown * element_size + PageSize - 1) / PageSize * PageSize;
+    return bytes / element_size;
+  }
+};
+}; // namespace prac
@@ -0,0 +1,683 @@
+#pragma once
+#include "memory.hpp"
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace prac {
+
+/// The default hash of prac::unordered_map and unordered_set.
+/*
+ * std::hash, which for integers is the identity: the tables mix every
+ * hash before use, so that is fine.
+ */
+template <typename T> struct hash : std::hash<T> {};
+
+/// Hashes std::string, std::string_view and C strings alike, so string
+/// keys can be looked up without building a std::string.
+template <> struct hash<std::string> {
+  typedef void is_transparent;
+
+  size_t operator()(const std::string_view &str) const {
+    return std::hash<std::string_view>()(str);
+  }
+};
+
+/// The default key comparison: std::equal_to, and for std::string
+/// keys the transparent std::equal_to<>, to go with prac::hash.
+template <typename T> struct equal_to : std::equal_to<T> {};
+template <> struct equal_to<std::string> : std::equal_to<> {};
+
+namespace detail {
+
+/// Spread the entropy of a hash over all its bits: the tables take
+/// the low 7 bits for the control bytes and the rest for the slot.
+inline size_t mix_hash(const size_t &hash) {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 product =
+      static_cast<unsigned __int128>(hash) * 0x9e3779b97f4a7c15ULL;
+  return size_t(product) ^ size_t(product >> 64);
+#else
+  size_t mixed = (hash ^ (hash >> 33)) * 0xff51afd7ed558ccdULL;
+  return mixed ^ (mixed >> 33);
+#endif
+}
+
+/// The control byte of an empty slot. A full slot's is the low 7 bits
+/// of its hash, so only empty slots have the top bit set.
+constexpr uint8_t ctrl_empty = 0x80;
+
+/// 16 control bytes, compared all at once.
+/*
+ * With SSE2, a comparison is one load, one compare and one movemask,
+ * giving a bit per slot. Elsewhere it is a loop the compiler may
+ * vectorize.
+ */
+class hash_group {
+public:
+  static constexpr size_t width = 16;
+
+  explicit hash_group(const uint8_t *ctrl) {
+#ifdef __SSE2__
+    m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+#else
+    std::memcpy(m_ctrl, ctrl, width);
+#endif
+  }
+
+  /// Get a bit for each slot whose control byte is h2.
+  uint32_t match(const uint8_t &h2) const {
+#ifdef __SSE2__
+    return uint32_t(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(m_ctrl, _mm_set1_epi8(char(h2)))));
+#else
+    uint32_t bits = 0;
+    for (size_t i = 0; i < width; i++) {
+      bits |= uint32_t(m_ctrl[i] == h2) << i;
+    }
+    return bits;
+#endif
+  }
+
+  /// Get a bit for each empty slot.
+  uint32_t match_empty() const {
+#ifdef __SSE2__
+    return uint32_t(_mm_movemask_epi8(m_ctrl));
+#else
+    uint32_t bits = 0;
+    for (size_t i = 0; i < width; i++) {
+      bits |= uint32_t(m_ctrl[i] >> 7) << i;
+    }
+    return bits;
+#endif
+  }
+
+  /// Get a bit for each full slot.
+  uint32_t match_full() const { return ~this->match_empty() & 0xffff; }
+
+private:
+#ifdef __SSE2__
+  __m128i m_ctrl;
+#else
+  uint8_t m_ctrl[width];
+#endif
+};
+
+/// Whether a hash or comparison takes keys of other types.
+template <typename T, typename = void>
+struct is_transparent : std::false_type {};
+template <typename T>
+struct is_transparent<T, std::void_t<typename T::is_transparent>>
+    : std::true_type {};
+
+/// Picks the key type of a lookup. A member alias template rather than
+/// std::conditional, so that K stays deducible from the argument.
+template <bool Transparent> struct key_arg_of {
+  template <typename K, typename Key> using type = K;
+};
+template <> struct key_arg_of<false> {
+  template <typename K, typename Key> using type = Key;
+};
+
+/// How unordered_set stores its elements.
+template <typename K> struct set_policy {
+  typedef K key_type;
+  typedef K value_type;
+  /// Keys can't be changed in place.
+  typedef const K iterator_value;
+
+  static const K &key(const value_type &value) { return value; }
+
+  static void relocate(value_type *dst, value_type *src) {
+    new (dst) value_type(std::move(*src));
+    src->~value_type();
+  }
+};
+
+/// How unordered_map stores its elements.
+template <typename K, typename V> struct map_policy {
+  typedef K key_type;
+  typedef std::pair<const K, V> value_type;
+  typedef value_type iterator_value;
+
+  static const K &key(const value_type &value) { return value.first; }
+
+  static void relocate(value_type *dst, value_type *src) {
+    // The key is only const to users: it can be moved out of an
+    // element that is destroyed right after.
+    new (dst) value_type(std::move(const_cast<K &>(src->first)),
+                         std::move(src->second));
+    src->~value_type();
+  }
+};
+
+/*
+ * An open-addressing hash table in two flat arrays: the elements, and
+ * a control byte per element saying whether the slot is empty, and if
+ * not, holding 7 bits of the element's hash.
+ *
+ * A key's hash picks its home slot; it lives in the first free slot
+ * from there on, i.e. linear probing, but the probe tests 16 control
+ * bytes at a time (hash_group), so a lookup compares keys only with
+ * the elements whose 7 bits match, 1 in 128 of the others, and
+ * usually reads one group of control bytes and one element. The
+ * table grows at 7/8 full.
+ *
+ * Erasing leaves no tombstones: the elements after the hole that
+ * would still be found from their home slot if they were in it are
+ * shifted back into it, so every element stays reachable from its
+ * home slot without crossing an empty one, and lookups never slow
+ * down with churn. That moves elements, so erasing invalidates
+ * iterators to other elements, like inserting. Elements are moved
+ * when the table grows and on erase, and their move constructors
+ * must not throw.
+ *
+ * The control bytes are followed by copies of the first 15, so a
+ * group can be loaded from any slot without wrapping.
+ */
+template <typename Policy, typename Hash, typename Eq, typename Alloc>
+class hash_table {
+  typedef std::allocator_traits<Alloc> alloc_traits;
+  typedef typename alloc_traits::template rebind_alloc<uint8_t> ctrl_allocator;
+  typedef std::allocator_traits<ctrl_allocator> ctrl_traits;
+  static constexpr size_t width = hash_group::width;
+  static constexpr size_t npos = size_t(-1);
+
+protected:
+  /// Lookups take any K if Hash and Eq are transparent, and key_type
+  /// otherwise.
+  template <typename K>
+  using key_arg = typename key_arg_of<is_transparent<Hash>::value &&
+                                      is_transparent<Eq>::value>::template type<
+      K, typename Policy::key_type>;
+
+public:
+  typedef typename Policy::key_type key_type;
+  typedef typename Policy::value_type value_type;
+  typedef Hash hasher;
+  typedef Eq key_equal;
+  typedef Alloc allocator_type;
+
+  /// Construction of an empty table. Allocates nothing.
+  explicit hash_table(const Hash &hash = Hash(), const Eq &eq = Eq(),
+                      const Alloc &alloc = Alloc())
+      : m_hash(hash), m_eq(eq), m_alloc(alloc),
+        m_ctrl(const_cast<uint8_t *>(empty_group())), m_slots(nullptr),
+        m_capacity(0), m_size(0), m_growth_left(0) {}
+
+  /// Copy construction. O(n), with a single allocation.
+  hash_table(const hash_table &other)
+      : hash_table(other.m_hash, other.m_eq,
+                   alloc_traits::select_on_container_copy_construction(
+                       other.m_alloc)) {
+    this->reserve(other.m_size);
+    for (const value_type &value : other) {
+      size_t i = this->find_free(this->hash_of(Policy::key(value)));
+      new (m_slots + i) value_type(value);
+      this->occupy(i, this->hash_of(Policy::key(value)));
+    }
+  }
+
+  /// Construction from a list of elements. Later duplicates of a key
+  /// are dropped.
+  hash_table(std::initializer_list<value_type> list) : hash_table() {
+    this->reserve(list.size());
+    this->insert(list.begin(), list.end());
+  }
+
+  /// Move construction. O(1); other is left empty.
+  hash_table(hash_table &&other) noexcept
+      : hash_table(other.m_hash, other.m_eq, other.m_alloc) {
+    this->swap(other);
+  }
+
+  /// Copy assignment. O(n); provides the strong exception guarantee.
+  hash_table &operator=(const hash_table &other) {
+    if (this != &other) {
+      hash_table copy(other);
+      this->swap(copy);
+    }
+    return *this;
+  }
+
+  /// Move assignment. O(n) in the number of elements destroyed.
+  hash_table &operator=(hash_table &&other) noexcept {
+    if (this != &other) {
+      hash_table moved(std::move(other));
+      this->swap(moved);
+    }
+    return *this;
+  }
+
+  ~hash_table() {
+    this->destroy_all();
+    this->release(m_ctrl, m_slots, m_capacity);
+  }
+
+  /// Exchange contents with another table.
+  void swap(hash_table &other) noexcept {
+    std::swap(m_hash, other.m_hash);
+    std::swap(m_eq, other.m_eq);
+    std::swap(m_alloc, other.m_alloc);
+    std::swap(m_ctrl, other.m_ctrl);
+    std::swap(m_slots, other.m_slots);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_size, other.m_size);
+    std::swap(m_growth_left, other.m_growth_left);
+  }
+
+  /// A forward iterator over the full slots.
+  template <typename Value, typename Table> class basic_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename Policy::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Value *pointer;
+    typedef Value &reference;
+
+    basic_iterator() : m_table(nullptr), m_index(0) {}
+    basic_iterator(Table *table, const size_t &index)
+        : m_table(table), m_index(index) {}
+    /// iterator converts to const_iterator.
+    template <typename OtherValue, typename OtherTable>
+    basic_iterator(const basic_iterator<OtherValue, OtherTable> &other)
+        : m_table(other.m_table), m_index(other.m_index) {}
+
+    reference operator*() const { return m_table->m_slots[m_index]; }
+    pointer operator->() const { return m_table->m_slots + m_index; }
+
+    basic_iterator &operator++() {
+      m_index = m_table->next_full(m_index + 1);
+      return *this;
+    }
+    basic_iterator operator++(int) {
+      basic_iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    template <typename OtherValue, typename OtherTable>
+    bool operator==(const basic_iterator<OtherValue, OtherTable> &other) const {
+      return m_index == other.m_index;
+    }
+    template <typename OtherValue, typename OtherTable>
+    bool operator!=(const basic_iterator<OtherValue, OtherTable> &other) const {
+      return m_index != other.m_index;
+    }
+
+  private:
+    template <typename, typename> friend class basic_iterator;
+    friend class hash_table;
+
+    Table *m_table;
+    size_t m_index;
+  };
+
+  typedef basic_iterator<typename Policy::iterator_value, hash_table> iterator;
+  typedef basic_iterator<const value_type, const hash_table> const_iterator;
+
+  iterator begin() { return iterator(this, this->next_full(0)); }
+  iterator end() { return iterator(this, m_capacity); }
+  const_iterator begin() const {
+    return const_iterator(this, this->next_full(0));
+  }
+  const_iterator end() const { return const_iterator(this, m_capacity); }
+  const_iterator cbegin() const { return this->begin(); }
+  const_iterator cend() const { return this->end(); }
+
+  /// Get the number of elements.
+  size_t size() const { return m_size; }
+
+  /// Whether there are no elements.
+  bool empty() const { return m_size == 0; }
+
+  /// Get the most elements the table can hold.
+  static constexpr size_t max_size() { return max_load(max_capacity()); }
+
+  /// Get the number of slots: 0, or a power of two of at least 16.
+  size_t bucket_count() const { return m_capacity; }
+
+  /// Get the fraction of the slots that are full.
+  float load_factor() const {
+    return m_capacity == 0 ? 0.0f : float(m_size) / float(m_capacity);
+  }
+
+  /// The load factor at which the table grows.
+  static constexpr float max_load_factor() { return 0.875f; }
+
+  /// Find the element with a key.
+  /*
+   * O(1) on average. Takes any key type if Hash and Eq are
+   * transparent, e.g. a std::string_view for std::string keys.
+   * @return an iterator to it, or end().
+   */
+  template <typename K = key_type> iterator find(const key_arg<K> &key) {
+    size_t i = this->find_index(key, this->hash_of(key));
+    return iterator(this, i == npos ? m_capacity : i);
+  }
+  template <typename K = key_type>
+  const_iterator find(const key_arg<K> &key) const {
+    size_t i = this->find_index(key, this->hash_of(key));
+    return const_iterator(this, i == npos ? m_capacity : i);
+  }
+
+  /// Whether there is an element with a key.
+  template <typename K = key_type> bool contains(const key_arg<K> &key) const {
+    return this->find_index(key, this->hash_of(key)) != npos;
+  }
+
+  /// Get the number of elements with a key: 0 or 1.
+  template <typename K = key_type> size_t count(const key_arg<K> &key) const {
+    return this->contains(key) ? 1 : 0;
+  }
+
+  /// Insert a copy of value, unless its key is already there.
+  /*
+   * O(1) on average.
+   * @return an iterator to the element with the key, and whether it
+   *         was inserted.
+   */
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return this->emplace_key(Policy::key(value), value);
+  }
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return this->emplace_key(Policy::key(value), std::move(value));
+  }
+
+  /// Insert copies of a range.
+  template <typename It> void insert(It first, It last) {
+    for (; first != last; ++first) {
+      this->insert(*first);
+    }
+  }
+
+  /// Construct an element from args and insert it, unless its key is
+  /// already there.
+  /*
+   * The element is constructed first, to get its key.
+   * @return as insert().
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args) {
+    value_type value(std::forward<Args>(args)...);
+    return this->emplace_key(Policy::key(value), std::move(value));
+  }
+
+  /// Erase the element with a key.
+  /*
+   * O(1) on average. Invalidates iterators.
+   * @return the number erased: 0 or 1.
+   */
+  template <typename K = key_type> size_t erase(const key_arg<K> &key) {
+    size_t i = this->find_index(key, this->hash_of(key));
+    if (i == npos) {
+      return 0;
+    }
+    this->erase_index(i);
+    return 1;
+  }
+
+  /// Erase the element at pos.
+  /*
+   * O(1) on average. Invalidates iterators, so unlike std's it
+   * returns nothing.
+   */
+  void erase(const const_iterator &pos) { this->erase_index(pos.m_index); }
+
+  /// Remove every element. The slots are kept.
+  void clear() {
+    this->destroy_all();
+    if (m_capacity > 0) {
+      std::memset(m_ctrl, ctrl_empty, m_capacity + width - 1);
+    }
+    m_size = 0;
+    m_growth_left = max_load(m_capacity);
+  }
+
+  /// Make room for n elements without growing.
+  /*
+   * O(size()) if the table grows.
+   * @param n - the number of elements.
+   * @throws std::length_error if n is more than max_size().
+   */
+  void reserve(const size_t &n) {
+    if (n <= m_size + m_growth_left) {
+      return;
+    }
+    if (n > max_size()) {
+      throw std::length_error("prac::unordered_map::reserve");
+    }
+    size_t capacity = width;
+    while (max_load(capacity) < n) {
+      capacity *= 2;
+    }
+    this->rehash(capacity);
+  }
+
+  /// Get a copy of the allocator.
+  Alloc get_allocator() const { return m_alloc; }
+
+  /// Get the hash function.
+  Hash hash_function() const { return m_hash; }
+
+  /// Get the key comparison.
+  Eq key_eq() const { return m_eq; }
+
+protected:
+  /// Insert an element constructed from args, unless key is there.
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplace_key(const K &key, Args &&... args) {
+    size_t hash = this->hash_of(key);
+    size_t i = this->find_index(key, hash);
+    if (i != npos) {
+      return std::make_pair(iterator(this, i), false);
+    }
+    if (m_growth_left == 0) {
+      if (m_capacity == max_capacity()) {
+        throw std::length_error("prac::unordered_map is full");
+      }
+      this->rehash(m_capacity == 0 ? width : m_capacity * 2);
+    }
+    i = this->find_free(hash);
+    new (m_slots + i) value_type(std::forward<Args>(args)...);
+    this->occupy(i, hash);
+    return std::make_pair(iterator(this, i), true);
+  }
+
+  /// Get the index of the element with key, or npos.
+  template <typename K>
+  size_t find_index(const K &key, const size_t &hash) const {
+    uint8_t h2 = uint8_t(hash & 0x7f);
+    size_t pos = (hash >> 7) & this->mask();
+    while (true) {
+      hash_group group(m_ctrl + pos);
+      for (uint32_t bits = group.match(h2); bits != 0; bits &= bits - 1) {
+        size_t i = (pos + size_t(__builtin_ctz(bits))) & this->mask();
+        if (m_eq(Policy::key(m_slots[i]), key)) {
+          return i;
+        }
+      }
+      // The element would have been put in the first empty slot.
+      if (group.match_empty() != 0) {
+        return npos;
+      }
+      pos = (pos + width) & this->mask();
+    }
+  }
+
+private:
+  /// All empty, for a table with no slots, so lookups need no special
+  /// case.
+  static const uint8_t *empty_group() {
+    alignas(16) static const uint8_t group[width] = {
+        ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+        ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+        ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+        ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty};
+    return group;
+  }
+
+  static constexpr size_t max_load(const size_t &capacity) {
+    return capacity - capacity / 8;
+  }
+
+  /// Get the largest power of two number of slots whose array fits in
+  /// PTRDIFF_MAX bytes, the most operator new can hand out.
+  static constexpr size_t max_capacity() {
+    size_t capacity = width;
+    while (capacity <= size_t(PTRDIFF_MAX) / sizeof(value_type) / 2) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  size_t mask() const { return m_capacity == 0 ? 0 : m_capacity - 1; }
+
+  template <typename K> size_t hash_of(const K &key) const {
+    return mix_hash(m_hash(key));
+  }
+
+  /// Get the home slot of the element at i.
+  size_t home_of(const size_t &i) const {
+    return (this->hash_of(Policy::key(m_slots[i])) >> 7) & this->mask();
+  }
+
+  /// Get the first empty slot from the home of hash. There must be
+  /// one.
+  size_t find_free(const size_t &hash) const {
+    size_t pos = (hash >> 7) & this->mask();
+    while (true) {
+      uint32_t empty = hash_group(m_ctrl + pos).match_empty();
+      if (empty != 0) {
+        return (pos + size_t(__builtin_ctz(empty))) & this->mask();
+      }
+      pos = (pos + width) & this->mask();
+    }
+  }
+
+  /// Set the control byte of slot i, and its copy past the end.
+  void set_ctrl(const size_t &i, const uint8_t &ctrl) {
+    m_ctrl[i] = ctrl;
+    if (i < width - 1) {
+      m_ctrl[m_capacity + i] = ctrl;
+    }
+  }
+
+  /// Mark slot i, just constructed, as full.
+  void occupy(const size_t &i, const size_t &hash) {
+    this->set_ctrl(i, uint8_t(hash & 0x7f));
+    m_size++;
+    m_growth_left--;
+  }
+
+  /// Get the first full slot from i, or m_capacity.
+  size_t next_full(size_t i) const {
+    while (i < m_capacity) {
+      uint32_t full = hash_group(m_ctrl + i).match_full();
+      if (full != 0) {
+        // Bits past the end are the copies of the first slots.
+        i += size_t(__builtin_ctz(full));
+        return i < m_capacity ? i : m_capacity;
+      }
+      i += width;
+    }
+    return m_capacity;
+  }
+
+  /// Erase the element at i, shifting back the elements after it
+  /// that may take its place.
+  void erase_index(size_t hole) {
+    detail::destroy(m_slots + hole, 1);
+    for (size_t i = (hole + 1) & this->mask(); m_ctrl[i] != ctrl_empty;
+         i = (i + 1) & this->mask()) {
+      // The element at i may move back to the hole unless its home is
+      // after the hole.
+      size_t home = this->home_of(i);
+      if (((i - home) & this->mask()) >= ((i - hole) & this->mask())) {
+        Policy::relocate(m_slots + hole, m_slots + i);
+        this->set_ctrl(hole, m_ctrl[i]);
+        hole = i;
+      }
+    }
+    this->set_ctrl(hole, ctrl_empty);
+    m_size--;
+    m_growth_left++;
+  }
+
+  void destroy_all() {
+    if (!std::is_trivially_destructible<value_type>::value) {
+      for (size_t i = this->next_full(0); i < m_capacity;
+           i = this->next_full(i + 1)) {
+        detail::destroy(m_slots + i, 1);
+      }
+    }
+  }
+
+  /// Move every element into new arrays of capacity slots.
+  void rehash(const size_t &capacity) {
+    ctrl_allocator ctrl_alloc(m_alloc);
+    uint8_t *ctrl = ctrl_traits::allocate(ctrl_alloc, capacity + width - 1);
+    value_type *slots;
+    try {
+      slots = alloc_traits::allocate(m_alloc, capacity);
+    } catch (...) {
+      ctrl_traits::deallocate(ctrl_alloc, ctrl, capacity + width - 1);
+      throw;
+    }
+    std::memset(ctrl, ctrl_empty, capacity + width - 1);
+
+    uint8_t *old_ctrl = m_ctrl;
+    value_type *old_slots = m_slots;
+    size_t old_capacity = m_capacity;
+    m_ctrl = ctrl;
+    m_slots = slots;
+    m_capacity = capacity;
+    m_growth_left = max_load(capacity) - m_size;
+    for (size_t i = 0; i < old_capacity; i++) {
+      if (old_ctrl[i] == ctrl_empty) {
+        continue;
+      }
+      size_t hash = this->hash_of(Policy::key(old_slots[i]));
+      size_t j = this->find_free(hash);
+      Policy::relocate(m_slots + j, old_slots + i);
+      this->set_ctrl(j, uint8_t(hash & 0x7f));
+    }
+    this->release(old_ctrl, old_slots, old_capacity);
+  }
+
+  void release(uint8_t *ctrl, value_type *slots, const size_t &capacity) {
+    if (capacity == 0) {
+      return;
+    }
+    ctrl_allocator ctrl_alloc(m_alloc);
+    ctrl_traits::deallocate(ctrl_alloc, ctrl, capacity + width - 1);
+    alloc_traits::deallocate(m_alloc, slots, capacity);
+  }
+
+  Hash m_hash;
+  Eq m_eq;
+  Alloc m_alloc;
+  /// m_capacity control bytes, then copies of the first width - 1.
+  uint8_t *m_ctrl;
+  value_type *m_slots;
+  size_t m_capacity;
+  size_t m_size;
+  /// The number of insertions before the table must grow.
+  size_t m_growth_left;
+};
+
+}; // namespace detail
+}; // namespace prac
@@ -0,0 +1,250 @@
+#pragma once
+#include "vector.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+
+namespace prac {
+/*
+ * Hazard pointers: safe memory reclamation for lock-free containers.
+ *
+ * A thread that is about to dereference a node another thread might
+ * unlink and free first publishes the node's address in one of its
+ * hazard slots. A thread that unlinks a node retires it instead of
+ * freeing it. Retired nodes are kept in a per-thread list, and once
+ * that list is long enough, it is scanned: every node that no thread
+ * has in a hazard slot is freed, the rest wait for the next scan.
+ * The objects a scan finds free are not all freed at once: each
+ * retire() frees a couple of them, which keeps the latency of the
+ * operations that retire smooth.
+ *
+ * Each thread gets slots_per_thread slots, and at most about
+ * 2 * slots_per_thread * (number of threads) + scan_threshold retired
+ * nodes per thread are waiting at any time. Reclamation is lock-free;
+ * only a thread exiting with nodes still protected by others takes a
+ * lock, to hand them over.
+ */
+class hazard_domain {
+public:
+  /// The hazard slots each thread has.
+  static constexpr size_t slots_per_thread = 2;
+
+  /// Get the domain shared by every container.
+  static hazard_domain &global() {
+    static hazard_domain domain;
+    return domain;
+  }
+
+  hazard_domain(const hazard_domain &) = delete;
+  hazard_domain &operator=(const hazard_domain &) = delete;
+
+  /// Load a pointer and protect what it points to.
+  /*
+   * Lock-free. Once this returns, the object can't be freed until
+   * the slot is cleared or reused, even if it is retired.
+   * @param slot - the calling thread's slot to use.
+   * @param src - the shared pointer to load.
+   * @return the protected value of src.
+   */
+  template <typename T>
+  T *protect(const size_t &slot, const std::atomic<T *> &src) {
+    std::atomic<void *> &hazard = this->record().hazards[slot];
+    T *ptr = src.load(std::memory_order_seq_cst);
+    while (true) {
+      hazard.store(ptr, std::memory_order_seq_cst);
+      // If src still holds ptr, it wasn't retired before the hazard
+      // became visible to scans.
+      T *again = src.load(std::memory_order_seq_cst);
+      if (again == ptr) {
+        return ptr;
+      }
+      ptr = again;
+    }
+  }
+
+  /// Stop protecting whatever the slot holds.
+  void clear(const size_t &slot) {
+    this->record().hazards[slot].store(nullptr, std::memory_order_release);
+  }
+
+  /// Free an object once no hazard slot holds it.
+  /*
+   * Amortized O(number of threads). The object must already be
+   * unreachable from the container, so no thread can protect it
+   * anew.
+   * @param ptr - the object.
+   * @param deleter - frees the object.
+   */
+  void retire(void *ptr, void (*deleter)(void *)) {
+    ThreadState &state = this->thread_state();
+    state.retired.push_back(Retired{ptr, deleter});
+    // Two per retire, so the backlog shrinks faster than it grows.
+    for (size_t i = 0; i < 2 && state.reclaimable.size() > 0; i++) {
+      Retired &reclaimable = state.reclaimable[state.reclaimable.size() - 1];
+      reclaimable.deleter(reclaimable.ptr);
+      state.reclaimable.pop_back();
+    }
+    size_t threshold =
+        2 * slots_per_thread * m_num_records.load(std::memory_order_relaxed) +
+        scan_threshold;
+    if (state.retired.size() >= threshold) {
+      this->scan(state);
+    }
+  }
+
+  /// Free every retired object no thread is protecting, now.
+  void reclaim() {
+    ThreadState &state = this->thread_state();
+    this->scan(state);
+    state.free_reclaimable();
+  }
+
+private:
+  static constexpr size_t scan_threshold = 64;
+
+  struct Retired {
+    void *ptr;
+    void (*deleter)(void *);
+  };
+
+  /// One thread's hazard slots. Records are never freed while the
+  /// domain lives; an exiting thread's record is reused by the next.
+  struct alignas(64) Record {
+    std::atomic<void *> hazards[slots_per_thread];
+    std::atomic<bool> active;
+    Record *next;
+  };
+
+  /// What a thread keeps about the domain.
+  struct ThreadState {
+    Record *record = nullptr;
+    prac::vector<Retired> retired;
+    /// Retired objects a scan found unprotected, waiting to be freed.
+    prac::vector<Retired> reclaimable;
+    /// Scratch space for scans, kept to avoid allocating each time.
+    prac::vector<void *> hazards;
+
+    ~ThreadState() {
+      if (record == nullptr) {
+        return;
+      }
+      hazard_domain &domain = hazard_domain::global();
+      for (size_t i = 0; i < slots_per_thread; i++) {
+        record->hazards[i].store(nullptr, std::memory_order_release);
+      }
+      domain.scan(*this);
+      this->free_reclaimable();
+      if (retired.size() > 0) {
+        std::lock_guard<std::mutex> lock(domain.m_orphans_mutex);
+        domain.m_orphans.append(retired.begin(), retired.end());
+        domain.m_has_orphans.store(true, std::memory_order_relaxed);
+      }
+      record->active.store(false, std::memory_order_release);
+    }
+
+    void free_reclaimable() {
+      for (const Retired &retired : reclaimable) {
+        retired.deleter(retired.ptr);
+      }
+      reclaimable.clear();
+    }
+  };
+
+  hazard_domain() : m_records(nullptr), m_num_records(0) {}
+
+  /// Free whatever is left. No other thread may be running by now.
+  ~hazard_domain() {
+    for (const Retired &retired : m_orphans) {
+      retired.deleter(retired.ptr);
+    }
+    Record *record = m_records.load();
+    while (record != nullptr) {
+      Record *next = record->next;
+      delete record;
+      record = next;
+    }
+  }
+
+  static ThreadState &thread_state() {
+    static thread_local ThreadState state;
+    return state;
+  }
+
+  Record &record() {
+    ThreadState &state = thread_state();
+    if (state.record == nullptr) {
+      state.record = this->acquire_record();
+    }
+    return *state.record;
+  }
+
+  /// Reuse an inactive record, or add a new one.
+  Record *acquire_record() {
+    for (Record *record = m_records.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      bool active = false;
+      if (!record->active.load(std::memory_order_relaxed) &&
+          record->active.compare_exchange_strong(active, true)) {
+        return record;
+      }
+    }
+    Record *record = new Record();
+    for (size_t i = 0; i < slots_per_thread; i++) {
+      record->hazards[i].store(nullptr, std::memory_order_relaxed);
+    }
+    record->active.store(true, std::memory_order_relaxed);
+    record->next = m_records.load(std::memory_order_relaxed);
+    while (!m_records.compare_exchange_weak(record->next, record,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+    m_num_records.fetch_add(1, std::memory_order_relaxed);
+    return record;
+  }
+
+  /// Move the retired objects that aren't protected to the
+  /// reclaimable list.
+  /*
+   * O(r log h) for r retired objects and h hazard slots.
+   */
+  void scan(ThreadState &state) {
+    prac::vector<Retired> &retired = state.retired;
+    if (m_has_orphans.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(m_orphans_mutex);
+      retired.append(m_orphans.begin(), m_orphans.end());
+      m_orphans.clear();
+      m_has_orphans.store(false, std::memory_order_relaxed);
+    }
+    prac::vector<void *> &hazards = state.hazards;
+    hazards.clear();
+    for (Record *record = m_records.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      for (size_t i = 0; i < slots_per_thread; i++) {
+        void *hazard = record->hazards[i].load(std::memory_order_seq_cst);
+        if (hazard != nullptr) {
+          hazards.push_back(hazard);
+        }
+      }
+    }
+    std::sort(hazards.begin(), hazards.end());
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); i++) {
+      if (std::binary_search(hazards.begin(), hazards.end(),
+                             retired[i].ptr)) {
+        retired[kept++] = retired[i];
+      } else {
+        state.reclaimable.push_back(retired[i]);
+      }
+    }
+    retired.resize(kept);
+  }
+
+  std::atomic<Record *> m_records;
+  std::atomic<size_t> m_num_records;
+  /// Retired objects handed over by threads that exited.
+  std::mutex m_orphans_mutex;
+  prac::vector<Retired> m_orphans;
+  std::atomic<bool> m_has_orphans{false};
+};
+}; // namespace prac
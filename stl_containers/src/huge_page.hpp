@@ -0,0 +1,149 @@
+#pragma once
+#include "memory.hpp"
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <type_traits>
+
+namespace prac {
+
+/// The size of a huge page on x86-64 Linux.
+constexpr size_t huge_page_size = size_t(2) << 20;
+
+/// Where huge_page_allocator gets its huge pages.
+enum class huge_page_mode {
+  /// Ask for transparent huge pages with madvise(MADV_HUGEPAGE). The
+  /// kernel backs the mapping with huge pages where it can, and with
+  /// normal pages where it can't or transparent huge pages are off.
+  transparent,
+  /// Take pages from the pool reserved in /proc/sys/vm/nr_hugepages
+  /// with MAP_HUGETLB, and fall back to transparent when the pool is
+  /// empty.
+  reserved,
+};
+
+namespace detail {
+
+inline size_t round_to_huge_pages(const size_t &bytes) {
+  return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+}
+
+/// Map bytes of anonymous memory, a multiple of huge_page_size,
+/// starting on a huge page boundary.
+/*
+ * @throws std::bad_alloc if the memory can't be mapped at all.
+ */
+inline void *map_huge_pages(const size_t &bytes, const huge_page_mode &mode) {
+#ifdef MAP_HUGETLB
+  if (mode == huge_page_mode::reserved) {
+#ifdef MAP_HUGE_SHIFT
+    const int page_size_flag = 21 << MAP_HUGE_SHIFT;
+#else
+    const int page_size_flag = 0;
+#endif
+    void *mapped =
+        mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_size_flag, -1, 0);
+    if (mapped != MAP_FAILED) {
+      return mapped;
+    }
+  }
+#endif
+  // Transparent huge pages only back whole aligned 2MB ranges, and
+  // mmap only aligns to normal pages: map a huge page more than needed
+  // and trim both ends.
+  size_t padded = bytes + huge_page_size;
+  void *mapped = mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(mapped);
+  uintptr_t aligned =
+      (start + huge_page_size - 1) & ~uintptr_t(huge_page_size - 1);
+  if (aligned > start) {
+    munmap(mapped, aligned - start);
+  }
+  size_t tail = start + padded - (aligned + bytes);
+  if (tail > 0) {
+    munmap(reinterpret_cast<void *>(aligned + bytes), tail);
+  }
+#ifdef MADV_HUGEPAGE
+  // Fails where transparent huge pages are compiled out, which just
+  // leaves normal pages.
+  madvise(reinterpret_cast<void *>(aligned), bytes, MADV_HUGEPAGE);
+#endif
+  return reinterpret_cast<void *>(aligned);
+}
+
+}; // namespace detail
+
+/// An allocator that backs large buffers with huge pages.
+/*
+ * A buffer of a few GB in normal 4KB pages needs hundreds of
+ * thousands of TLB entries, so scanning or indexing it misses the TLB
+ * constantly; in 2MB pages it needs 512 times fewer. Allocations of
+ * at least one huge page are mapped straight from the kernel,
+ * rounded up to whole huge pages and aligned to one, with the pages
+ * picked by Mode. If huge pages aren't available, they silently get
+ * normal pages instead. Smaller allocations come from the global
+ * operator new, aligned to a cache line, since huge pages wouldn't
+ * help them.
+ *
+ * Usage:
+ *   prac::vector<float, prac::huge_page_allocator<float>> features;
+ *
+ * Stateless, so all instances compare equal.
+ */
+template <typename T, huge_page_mode Mode = huge_page_mode::transparent>
+struct huge_page_allocator {
+  typedef T value_type;
+  typedef std::true_type is_always_equal;
+  /// Allocations of at least this many bytes are mapped.
+  static constexpr size_t min_mapped_bytes = huge_page_size;
+
+  /// Needed since Mode isn't a type, so allocator_traits can't rebind
+  /// it by itself.
+  template <typename U> struct rebind {
+    typedef huge_page_allocator<U, Mode> other;
+  };
+
+  huge_page_allocator() = default;
+  template <typename U>
+  huge_page_allocator(const huge_page_allocator<U, Mode> &) {}
+
+  T *allocate(const size_t &n) {
+    if (n > size_t(-1) / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    size_t bytes = n * sizeof(T);
+    if (bytes < min_mapped_bytes) {
+      return small_allocator().allocate(n);
+    }
+    return static_cast<T *>(
+        detail::map_huge_pages(detail::round_to_huge_pages(bytes), Mode));
+  }
+
+  void deallocate(T *storage, const size_t &n) {
+    size_t bytes = n * sizeof(T);
+    if (bytes < min_mapped_bytes) {
+      small_allocator().deallocate(storage, n);
+      return;
+    }
+    munmap(storage, detail::round_to_huge_pages(bytes));
+  }
+
+  template <typename U>
+  bool operator==(const huge_page_allocator<U, Mode> &) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const huge_page_allocator<U, Mode> &) const {
+    return false;
+  }
+
+private:
+  typedef aligned_allocator<T, 64> small_allocator;
+};
+}; // namespace prac
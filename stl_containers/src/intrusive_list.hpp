@@ -0,0 +1,359 @@
+#pragma once
+#include <iterator>
+#include <stddef.h>
+#include <type_traits>
+
+namespace prac {
+
+/// The links an object needs to be in an intrusive_list.
+/*
+ * Embed one per list the object can be in at the same time. Copying
+ * an object doesn't copy its links: the copy starts out unlinked, and
+ * assigning to a linked object leaves it where it was.
+ */
+struct intrusive_list_hook {
+  intrusive_list_hook() : prev(nullptr), next(nullptr) {}
+  intrusive_list_hook(const intrusive_list_hook &)
+      : prev(nullptr), next(nullptr) {}
+  intrusive_list_hook &operator=(const intrusive_list_hook &) { return *this; }
+
+  /// Whether the object is in a list.
+  bool is_linked() const { return next != nullptr; }
+
+  intrusive_list_hook *prev;
+  intrusive_list_hook *next;
+};
+
+/// A doubly-linked list of objects that carry their own links.
+/*
+ * The list doesn't own, copy or allocate anything: it links together
+ * objects that live elsewhere, through the intrusive_list_hook member
+ * Hook of T. Inserting, unlinking and splicing are all O(1) pointer
+ * updates, so an object can move between lists (idle, active, LRU...)
+ * as often as needed without touching the allocator, and an object
+ * can be unlinked given only a reference to it.
+ *
+ * An object can be in at most one list per hook, and must be unlinked
+ * before it is destroyed. The list unlinks whatever it still holds
+ * when it is destroyed.
+ *
+ * Usage:
+ *   struct Connection {
+ *     prac::intrusive_list_hook lru_hook;
+ *     ...
+ *   };
+ *   prac::intrusive_list<Connection, &Connection::lru_hook> lru;
+ */
+template <typename T, intrusive_list_hook T::*Hook> class intrusive_list {
+public:
+  typedef T value_type;
+
+  /// Constructor for an empty list.
+  intrusive_list() : m_size(0) { m_root.prev = m_root.next = &m_root; }
+
+  intrusive_list(const intrusive_list &) = delete;
+  intrusive_list &operator=(const intrusive_list &) = delete;
+
+  /// Move construction.
+  /*
+   * O(1). other is left empty.
+   * @param other - the list to take the elements of.
+   */
+  intrusive_list(intrusive_list &&other) : intrusive_list() {
+    this->splice(this->end(), other);
+  }
+
+  /// Move assignment.
+  /*
+   * O(n) in the elements this list had, which are unlinked; O(1) in
+   * other's. other is left empty.
+   * @param other - the list to take the elements of.
+   */
+  intrusive_list &operator=(intrusive_list &&other) {
+    if (this != &other) {
+      this->clear();
+      this->splice(this->end(), other);
+    }
+    return *this;
+  }
+
+  /// Unlink every element.
+  ~intrusive_list() { this->clear(); }
+
+  template <typename Value> class basic_iterator {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef typename std::remove_const<Value>::type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Value *pointer;
+    typedef Value &reference;
+
+    basic_iterator() : m_hook(nullptr) {}
+    explicit basic_iterator(intrusive_list_hook *hook) : m_hook(hook) {}
+    /// A const_iterator can be made from an iterator.
+    template <typename Other,
+              typename = typename std::enable_if<
+                  std::is_convertible<Other *, Value *>::value>::type>
+    basic_iterator(const basic_iterator<Other> &other)
+        : m_hook(other.m_hook) {}
+
+    reference operator*() const { return *to_value(m_hook); }
+    pointer operator->() const { return to_value(m_hook); }
+
+    basic_iterator &operator++() {
+      m_hook = m_hook->next;
+      return *this;
+    }
+    basic_iterator operator++(int) {
+      basic_iterator old = *this;
+      m_hook = m_hook->next;
+      return old;
+    }
+    basic_iterator &operator--() {
+      m_hook = m_hook->prev;
+      return *this;
+    }
+    basic_iterator operator--(int) {
+      basic_iterator old = *this;
+      m_hook = m_hook->prev;
+      return old;
+    }
+
+    bool operator==(const basic_iterator &other) const {
+      return m_hook == other.m_hook;
+    }
+    bool operator!=(const basic_iterator &other) const {
+      return m_hook != other.m_hook;
+    }
+
+  private:
+    template <typename Other> friend class basic_iterator;
+    friend class intrusive_list;
+    intrusive_list_hook *m_hook;
+  };
+
+  typedef basic_iterator<T> iterator;
+  typedef basic_iterator<const T> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  /// Bidirectional iterators. All of these are created and
+  /// incremented in O(1). end() is the list's own sentinel, so
+  /// --end() is the last element.
+  iterator begin() { return iterator(m_root.next); }
+  iterator end() { return iterator(&m_root); }
+  const_iterator begin() const { return const_iterator(m_root.next); }
+  const_iterator end() const { return const_iterator(this->root()); }
+  const_iterator cbegin() const { return this->begin(); }
+  const_iterator cend() const { return this->end(); }
+  reverse_iterator rbegin() { return reverse_iterator(this->end()); }
+  reverse_iterator rend() { return reverse_iterator(this->begin()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(this->end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(this->begin());
+  }
+
+  /// Get an iterator to an element of the list.
+  /*
+   * O(1).
+   * @param elem - an element of this list.
+   */
+  iterator iterator_to(T &elem) { return iterator(&(elem.*Hook)); }
+  const_iterator iterator_to(const T &elem) const {
+    return const_iterator(const_cast<intrusive_list_hook *>(&(elem.*Hook)));
+  }
+
+  /// Link an element at the back.
+  /*
+   * O(1).
+   * @param elem - an element that isn't in a list through Hook.
+   */
+  void push_back(T &elem) { this->insert(this->end(), elem); }
+
+  /// Link an element at the front.
+  /*
+   * O(1).
+   * @param elem - an element that isn't in a list through Hook.
+   */
+  void push_front(T &elem) { this->insert(this->begin(), elem); }
+
+  /// Link an element before pos.
+  /*
+   * O(1).
+   * @param pos - the position to insert before.
+   * @param elem - an element that isn't in a list through Hook.
+   * @return an iterator to elem.
+   */
+  iterator insert(const_iterator pos, T &elem) {
+    intrusive_list_hook *hook = &(elem.*Hook);
+    link_before(pos.m_hook, hook, hook);
+    m_size++;
+    return iterator(hook);
+  }
+
+  /// Unlink the last element. The list must not be empty.
+  void pop_back() { this->unlink(this->back()); }
+
+  /// Unlink the first element. The list must not be empty.
+  void pop_front() { this->unlink(this->front()); }
+
+  /// Unlink the element at pos.
+  /*
+   * O(1).
+   * @param pos - an iterator to an element of this list.
+   * @return an iterator to the element after it.
+   */
+  iterator erase(const_iterator pos) {
+    iterator next(pos.m_hook->next);
+    this->unlink(*to_value(pos.m_hook));
+    return next;
+  }
+
+  /// Unlink an element, given only the element.
+  /*
+   * O(1). The element's hook is reset, so is_linked() is false after.
+   * @param elem - an element of this list.
+   */
+  void unlink(T &elem) {
+    intrusive_list_hook *hook = &(elem.*Hook);
+    hook->prev->next = hook->next;
+    hook->next->prev = hook->prev;
+    hook->prev = hook->next = nullptr;
+    m_size--;
+  }
+
+  /// Unlink every element.
+  /*
+   * O(n): every hook is reset, so that the elements can be linked
+   * into lists again.
+   */
+  void clear() {
+    intrusive_list_hook *hook = m_root.next;
+    while (hook != &m_root) {
+      intrusive_list_hook *next = hook->next;
+      hook->prev = hook->next = nullptr;
+      hook = next;
+    }
+    m_root.prev = m_root.next = &m_root;
+    m_size = 0;
+  }
+
+  /// Move every element of other before pos.
+  /*
+   * O(1). other is left empty.
+   * @param pos - the position in this list to insert before.
+   * @param other - another list.
+   */
+  void splice(const_iterator pos, intrusive_list &other) {
+    if (&other == this || other.empty()) {
+      return;
+    }
+    intrusive_list_hook *first = other.m_root.next;
+    intrusive_list_hook *last = other.m_root.prev;
+    size_t count = other.m_size;
+    other.m_root.prev = other.m_root.next = &other.m_root;
+    other.m_size = 0;
+    link_before(pos.m_hook, first, last);
+    m_size += count;
+  }
+
+  /// Move one element of other before pos.
+  /*
+   * O(1). other may be this list.
+   * @param pos - the position in this list to insert before.
+   * @param other - the list elem is in.
+   * @param elem - the element to move.
+   */
+  void splice(const_iterator pos, intrusive_list &other, T &elem) {
+    intrusive_list_hook *hook = &(elem.*Hook);
+    if (pos.m_hook == hook || pos.m_hook == hook->next) {
+      return;
+    }
+    other.unlink(elem);
+    link_before(pos.m_hook, hook, hook);
+    m_size++;
+  }
+
+  /// Move the elements [first, last) of other before pos.
+  /*
+   * O(1) when other is this list, otherwise O(length of the range),
+   * to keep both sizes right. pos must not be in the range.
+   * @param pos - the position in this list to insert before.
+   * @param other - the list the range is in.
+   * @param first - the first element to move.
+   * @param last - the end of the range.
+   */
+  void splice(const_iterator pos, intrusive_list &other, const_iterator first,
+              const_iterator last) {
+    if (first == last || pos == first || pos == last) {
+      return;
+    }
+    if (&other != this) {
+      size_t count = size_t(std::distance(first, last));
+      other.m_size -= count;
+      m_size += count;
+    }
+    intrusive_list_hook *front = first.m_hook;
+    intrusive_list_hook *back = last.m_hook->prev;
+    front->prev->next = last.m_hook;
+    last.m_hook->prev = front->prev;
+    link_before(pos.m_hook, front, back);
+  }
+
+  /// Get the first element. The list must not be empty.
+  T &front() { return *to_value(m_root.next); }
+  const T &front() const { return *to_value(m_root.next); }
+
+  /// Get the last element. The list must not be empty.
+  T &back() { return *to_value(m_root.prev); }
+  const T &back() const { return *to_value(m_root.prev); }
+
+  /// Get the size of the container.
+  /*
+   * O(1) complexity.
+   * @return the size of the container.
+   */
+  size_t size() const { return m_size; }
+
+  /// Whether the list has no elements.
+  bool empty() const { return m_size == 0; }
+
+private:
+  /// Get the object a hook is embedded in.
+  static T *to_value(intrusive_list_hook *hook) {
+    return reinterpret_cast<T *>(reinterpret_cast<char *>(hook) -
+                                 hook_offset());
+  }
+
+  /// The offset of Hook in T, which the compiler folds to a constant.
+  static ptrdiff_t hook_offset() {
+    // Never constructed; only its address is used.
+    alignas(T) static unsigned char probe[sizeof(T)];
+    T *obj = reinterpret_cast<T *>(probe);
+    return reinterpret_cast<char *>(&(obj->*Hook)) -
+           reinterpret_cast<char *>(obj);
+  }
+
+  /// Link the chain from front to back, whose outer links are
+  /// ignored, before next.
+  static void link_before(intrusive_list_hook *next,
+                          intrusive_list_hook *front,
+                          intrusive_list_hook *back) {
+    intrusive_list_hook *prev = next->prev;
+    front->prev = prev;
+    back->next = next;
+    prev->next = front;
+    next->prev = back;
+  }
+
+  intrusive_list_hook *root() const {
+    return const_cast<intrusive_list_hook *>(&m_root);
+  }
+
+  /// The sentinel: m_root.next is the front, m_root.prev the back.
+  intrusive_list_hook m_root;
+  size_t m_size;
+};
+}; // namespace prac
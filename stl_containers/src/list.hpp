@@ -1,12 +1,21 @@
 #pragma once
+#include "memory.hpp"
+#include "node_pool.hpp"
+#include "stats.hpp"
+#include <functional>
 #include <iterator>
+#include <memory>
 #include <stddef.h>
+#include <utility>
 
 namespace prac {
 
 /// A doubly-linked list.
 template <typename T> struct ListNode {
-  ListNode(const T &val_in) : val(val_in), last(nullptr), next(nullptr) {}
+  /// Construct the value in place from args.
+  template <typename... Args>
+  ListNode(Args &&... args)
+      : last(nullptr), next(nullptr), val(std::forward<Args>(args)...) {}
   ListNode<T> *last;
   ListNode<T> *next;
   T val;
@@ -16,23 +25,205 @@ template <typename T> struct ListNode {
 /*
  * O(1) insertion on either side of the container, O(1) 
  * iteration incrementation. No random access.
+ *
+ * Nodes come from a node_pool, which gets cache-line-aligned blocks
+ * from Alloc and recycles freed nodes, so a list that churns at a
+ * steady size makes no allocator calls. Each list owns a pool unless
+ * it is given one to share with other lists. Two lists that own their
+ * pools come to share one the first time nodes move between them, so
+ * splice() and merge() only relink; from then on they must not be used
+ * from different threads at once. Alloc can be any allocator that
+ * std::allocator_traits understands, e.g. prac::arena_allocator.
  */
-template <typename T> class list {
+template <typename T, typename Alloc = prac::allocator<T>> class list {
 public:
+  typedef Alloc allocator_type;
+  typedef std::allocator_traits<Alloc> alloc_traits;
+  typedef node_pool<ListNode<T>, Alloc> node_pool_type;
+
   /// Constructor for zero-size list.
-  list() : m_size(0), m_front(nullptr), m_back(nullptr) {}
+  /*
+   * @param alloc - The allocator the list's pool gets blocks from.
+   */
+  explicit list(const Alloc &alloc = Alloc())
+      : m_own_pool(alloc), m_pool(&m_own_pool), m_shared(nullptr), m_size(0),
+        m_front(nullptr), m_back(nullptr) {}
+
+  /// Constructor for a zero-size list that shares a pool.
+  /*
+   * The pool must outlive the list.
+   * @param pool - The pool to get nodes from.
+   */
+  explicit list(node_pool_type &pool)
+      : m_own_pool(pool.get_allocator()), m_pool(&pool), m_shared(nullptr),
+        m_size(0), m_front(nullptr), m_back(nullptr) {}
 
   /// Construction from STL container iterators.
   /*
+   * O(n). The nodes of a forward range come from one contiguous
+   * block; see append().
    * @param begin - the beginning iterator.
    * @param end - the ending iterator.
+   * @param alloc - The allocator the list's pool gets blocks from.
    */
   template <typename Other>
-  list(const Other &begin, const Other &end)
-      : m_size(0), m_front(nullptr), m_back(nullptr) {
-    for (auto itr = begin; itr != end; itr++) {
-      this->push_back(*itr);
+  list(const Other &begin, const Other &end, const Alloc &alloc = Alloc())
+      : list(alloc) {
+    this->append(begin, end);
+  }
+
+  /// Copy construction.
+  /*
+   * O(n). The copy gets a pool of its own.
+   * @param other - the list to copy.
+   */
+  list(const list &other)
+      : list(other, alloc_traits::select_on_container_copy_construction(
+                        other.get_allocator())) {}
+
+  /// Copy construction with a different allocator.
+  /*
+   * O(n).
+   * @param other - the list to copy.
+   * @param alloc - The allocator the list's pool gets blocks from.
+   */
+  list(const list &other, const Alloc &alloc) : list(alloc) {
+    this->copy_from(other);
+  }
+
+  /// Move construction.
+  /*
+   * O(1). Steals the nodes of other, which is left empty. If other
+   * shares a pool, so does the new list.
+   * @param other - the list to move from.
+   */
+  list(list &&other) noexcept
+      : list(other.m_own_pool.get_allocator()) {
+    this->swap(other);
+  }
+
+  /// Copy assignment.
+  /*
+   * O(n). Provides the strong exception guarantee. Keeps this list's
+   * pool.
+   */
+  list &operator=(const list &other) {
+    if (this != &other) {
+      list copy(this->get_allocator());
+      if (m_shared != nullptr) {
+        copy.join(m_shared);
+      } else if (!this->owns_pool()) {
+        copy.m_pool = m_pool;
+      }
+      copy.copy_from(other);
+      this->swap(copy);
+    }
+    return *this;
+  }
+
+  /// Move assignment.
+  /*
+   * O(n) in the number of nodes freed, O(1) otherwise. Unless one of
+   * the lists was given a pool of its own, the nodes are taken over.
+   * Otherwise elements are moved one by one into nodes from this
+   * list's pool.
+   */
+  list &operator=(list &&other) {
+    if (this == &other) {
+      return *this;
+    }
+    this->clear();
+    if ((this->owns_pool() && other.owns_pool()) || this->share_pool(other)) {
+      this->swap(other);
+    } else {
+      for (ListNode<T> *node = other.m_front; node != nullptr;
+           node = node->next) {
+        this->push_back(std::move(node->val));
+      }
+      other.clear();
+    }
+    return *this;
+  }
+
+  /// Exchange contents with another list in O(1).
+  /*
+   * Pools go with the nodes: a list that owned its pool hands it
+   * over, and a list that shared a pool hands over the sharing.
+   */
+  void swap(list &other) noexcept {
+    node_pool_type *pool = this->owns_pool() ? &other.m_own_pool : m_pool;
+    node_pool_type *other_pool =
+        other.owns_pool() ? &m_own_pool : other.m_pool;
+    m_own_pool.swap(other.m_own_pool);
+    m_pool = other_pool;
+    other.m_pool = pool;
+    shared_pool *shared = m_shared;
+    m_shared = other.m_shared;
+    other.m_shared = shared;
+    size_t size = m_size;
+    ListNode<T> *front = m_front;
+    ListNode<T> *back = m_back;
+    m_size = other.m_size;
+    m_front = other.m_front;
+    m_back = other.m_back;
+    other.m_size = size;
+    other.m_front = front;
+    other.m_back = back;
+  }
+
+  /// Get a copy of the allocator.
+  Alloc get_allocator() const { return m_pool->get_allocator(); }
+
+  /// Make sure n more elements can be added without calling the allocator.
+  /*
+   * O(1) apart from at most one block allocation. Useful to warm the
+   * pool up before a latency-critical phase.
+   * @param n - the number of elements.
+   */
+  void reserve_nodes(const size_t &n) { m_pool->reserve(n); }
+
+  /// Replace the contents with copies of a range.
+  /*
+   * O(n). The freed nodes are reused for the new elements.
+   * @param first - the beginning of the range. The range must not be
+   *                part of this list.
+   * @param last - the end of the range.
+   */
+  template <typename Other> void assign(Other first, Other last) {
+    this->clear();
+    this->append(first, last);
+  }
+
+  /// Add copies of a range to the back of the list.
+  /*
+   * O(n) in the length of the range. A forward range is measured
+   * once and the pool is topped up with a single block, so the new
+   * nodes sit next to each other in memory. Provides the strong
+   * exception guarantee.
+   * @param first - the beginning of the range.
+   * @param last - the end of the range.
+   */
+  template <typename Other> void append(Other first, Other last) {
+    this->insert(this->end(), first, last);
+  }
+
+#ifdef PRAC_CONTAINER_STATS
+  /// Get this list's instrumentation counters.
+  const container_stats &stats() const { return m_stats; }
+#endif
+
+  /// Remove every element.
+  /*
+   * O(n) complexity.
+   */
+  void clear() {
+    while (m_front != nullptr) {
+      ListNode<T> *last = m_front;
+      m_front = m_front->next;
+      this->destroy_node(last);
     }
+    m_back = nullptr;
+    m_size = 0;
   }
 
   /// Add one element to the back of the list.
@@ -40,34 +231,68 @@ public:
    * O(1) complexity.
    * @param new_elem - the element to add.
    */
-  void push_back(const T &new_elem) {
+  void push_back(const T &new_elem) { this->emplace_back(new_elem); }
+
+  /// Add one element to the back of the list, moving from it.
+  /*
+   * O(1) complexity.
+   * @param new_elem - the element to add.
+   */
+  void push_back(T &&new_elem) { this->emplace_back(std::move(new_elem)); }
+
+  /// Add one element to the front of the list.
+  /*
+   * O(1) complexity.
+   * @param new_elem - the element to add.
+   */
+  void push_front(const T &new_elem) { this->emplace_front(new_elem); }
+
+  /// Add one element to the front of the list, moving from it.
+  /*
+   * O(1) complexity.
+   * @param new_elem - the element to add.
+   */
+  void push_front(T &&new_elem) { this->emplace_front(std::move(new_elem)); }
+
+  /// Construct one element in place at the back of the list.
+  /*
+   * O(1) complexity. The arguments are forwarded to T's constructor
+   * inside the new node, so no temporary is copied or moved.
+   * @param args - the arguments to T's constructor.
+   * @return a reference to the new element.
+   */
+  template <typename... Args> T &emplace_back(Args &&... args) {
+    ListNode<T> *new_node = this->create_node(std::forward<Args>(args)...);
     if (m_front == nullptr) {
-      m_front = new ListNode<T>(new_elem);
+      m_front = new_node;
       m_back = m_front;
     } else {
-      m_back->next = new ListNode<T>(new_elem);
+      m_back->next = new_node;
       m_back->next->last = m_back;
       m_back = m_back->next;
     }
     m_size++;
+    return new_node->val;
   }
 
-  /// Add one element to the front of the list.
+  /// Construct one element in place at the front of the list.
   /*
    * O(1) complexity.
-   * @param new_elem - the element to add.
+   * @param args - the arguments to T's constructor.
+   * @return a reference to the new element.
    */
-  void push_front(const T &new_elem) {
+  template <typename... Args> T &emplace_front(Args &&... args) {
+    ListNode<T> *new_node = this->create_node(std::forward<Args>(args)...);
     if (m_front == nullptr) {
-      m_front = new ListNode<T>(new_elem);
+      m_front = new_node;
       m_back = m_front;
     } else {
-      ListNode<T> *new_node = new ListNode<T>(new_elem);
       new_node->next = m_front;
       m_front = new_node;
       m_front->next->last = m_front;
     }
     m_size++;
+    return new_node->val;
   }
 
   /// Get the front element.
@@ -89,11 +314,14 @@ public:
    * O(1) complexity.
    */
   void pop_front() {
+    ListNode<T> *old_front = m_front;
     m_front = m_front->next;
     if (m_front) {
-      delete m_front->last;
       m_front->last = nullptr;
+    } else {
+      m_back = nullptr;
     }
+    this->destroy_node(old_front);
     m_size--;
   }
 
@@ -102,11 +330,14 @@ public:
    * O(1) complexity.
    */
   void pop_back() {
+    ListNode<T> *old_back = m_back;
     m_back = m_back->last;
     if (m_back) {
-      delete m_back->next;
       m_back->next = nullptr;
+    } else {
+      m_front = nullptr;
     }
+    this->destroy_node(old_back);
     m_size--;
   }
 
@@ -125,11 +356,8 @@ public:
   T &back() { return m_back->val; }
 
   ~list() {
-    while (m_front != nullptr) {
-      auto last = m_front;
-      m_front = m_front->next;
-      delete last;
-    }
+    this->clear();
+    release(m_shared);
   }
 
   /// Get the size of the container.
@@ -146,6 +374,7 @@ public:
                              T                        // reference
                              > {
     ListNode<T> *m_node = nullptr;
+    friend class list;
 
   public:
     iterator(ListNode<T> *node) : m_node(node) {}
@@ -185,6 +414,301 @@ public:
     T &operator*() { return m_node->val; }
   };
 
+  /// Construct one element in place before pos.
+  /*
+   * O(1) complexity. Inserting at end() is the same as emplace_back().
+   * @param pos - the position to insert before.
+   * @param args - the arguments to T's constructor.
+   * @return an iterator to the new element.
+   */
+  template <typename... Args> iterator emplace(iterator pos, Args &&... args) {
+    ListNode<T> *next = pos.m_node;
+    if (next == nullptr) {
+      this->emplace_back(std::forward<Args>(args)...);
+      return iterator(m_back);
+    }
+    if (next == m_front) {
+      this->emplace_front(std::forward<Args>(args)...);
+      return iterator(m_front);
+    }
+    ListNode<T> *new_node = this->create_node(std::forward<Args>(args)...);
+    new_node->last = next->last;
+    new_node->next = next;
+    next->last->next = new_node;
+    next->last = new_node;
+    m_size++;
+    return iterator(new_node);
+  }
+
+  /// Insert copies of a range before pos.
+  /*
+   * O(n) in the length of the range. The nodes are reserved in one
+   * block as in append(), built into a separate chain and then linked
+   * in, so nothing changes if a copy throws.
+   * @param pos - the position to insert before.
+   * @param first - the beginning of the range.
+   * @param last - the end of the range.
+   * @return an iterator to the first inserted element, or pos if the
+   *         range is empty.
+   */
+  template <typename Other>
+  iterator insert(iterator pos, Other first, Other last) {
+    list chain(*m_pool);
+    if (detail::is_forward_iterator<Other>::value) {
+      m_pool->reserve(size_t(std::distance(first, last)));
+    }
+    for (; first != last; ++first) {
+      chain.emplace_back(*first);
+    }
+    if (chain.m_front == nullptr) {
+      return pos;
+    }
+    ListNode<T> *chain_front = chain.m_front;
+    this->link_before(pos.m_node, chain);
+    return iterator(chain_front);
+  }
+
+  /// Insert a copy of an element before pos.
+  /*
+   * O(1) complexity.
+   * @param pos - the position to insert before.
+   * @param new_elem - the element to add.
+   * @return an iterator to the new element.
+   */
+  iterator insert(iterator pos, const T &new_elem) {
+    return this->emplace(pos, new_elem);
+  }
+
+  /// Insert an element before pos, moving from it.
+  /*
+   * O(1) complexity.
+   * @param pos - the position to insert before.
+   * @param new_elem - the element to add.
+   * @return an iterator to the new element.
+   */
+  iterator insert(iterator pos, T &&new_elem) {
+    return this->emplace(pos, std::move(new_elem));
+  }
+
+  /// Remove the element at pos.
+  /*
+   * O(1) complexity. Only iterators to the removed element are
+   * invalidated.
+   * @param pos - an iterator to an element of this list.
+   * @return an iterator to the element after it.
+   */
+  iterator erase(iterator pos) {
+    ListNode<T> *node = pos.m_node;
+    ListNode<T> *next = node->next;
+    this->unlink_chain(node, node, 1);
+    this->destroy_node(node);
+    return iterator(next);
+  }
+
+  /// Remove the elements [first, last).
+  /*
+   * O(length of the range).
+   * @param first - the first element to remove.
+   * @param last - the end of the range.
+   * @return last.
+   */
+  iterator erase(iterator first, iterator last) {
+    while (first != last) {
+      first = this->erase(first);
+    }
+    return last;
+  }
+
+  /// Remove every element pred returns true for.
+  /*
+   * O(n) complexity.
+   * @param pred - called once per element, in order.
+   * @return the number of elements removed.
+   */
+  template <typename Predicate> size_t remove_if(Predicate pred) {
+    size_t num_removed = 0;
+    ListNode<T> *node = m_front;
+    while (node != nullptr) {
+      ListNode<T> *next = node->next;
+      if (pred(node->val)) {
+        this->erase(iterator(node));
+        num_removed++;
+      }
+      node = next;
+    }
+    return num_removed;
+  }
+
+  /// Move every element of other before pos.
+  /*
+   * O(1): the nodes are relinked, not copied, and iterators to them
+   * stay valid. Only if one of the lists was given a pool and the
+   * other doesn't share it is each element moved into a node from
+   * this list's pool instead, as in move assignment. other is left
+   * empty.
+   * @param pos - the position in this list to insert before.
+   * @param other - another list.
+   */
+  void splice(iterator pos, list &other) {
+    if (&other == this || other.m_front == nullptr) {
+      return;
+    }
+    if (this->share_pool(other)) {
+      this->link_before(pos.m_node, other);
+    } else {
+      this->splice(pos, other, other.begin(), other.end());
+    }
+  }
+
+  /// Move one element of other before pos.
+  /*
+   * O(1). Relinks the node, unless one of the lists was given a pool
+   * the other doesn't share; then the element is moved into a node
+   * from this list's pool. other may be this list.
+   * @param pos - the position in this list to insert before.
+   * @param other - the list the element is in.
+   * @param it - an iterator to the element to move.
+   */
+  void splice(iterator pos, list &other, iterator it) {
+    ListNode<T> *node = it.m_node;
+    // end() is the same for every list, so only within one list does
+    // pos == next mean the element is in place already.
+    if (&other == this && (pos.m_node == node || pos.m_node == node->next)) {
+      return;
+    }
+    node = this->take_node(other, node);
+    this->link_chain_before(pos.m_node, node, node, 1);
+  }
+
+  /// Move the elements [first, last) of other before pos.
+  /*
+   * The range is relinked as a whole: O(1) within one list, and
+   * O(length of the range) between two, to keep both sizes right. If
+   * one of the lists was given a pool the other doesn't share, each
+   * element is moved into a node from this list's pool instead. pos
+   * must not be in the range.
+   * @param pos - the position in this list to insert before.
+   * @param other - the list the range is in.
+   * @param first - the first element to move.
+   * @param last - the end of the range.
+   */
+  void splice(iterator pos, list &other, iterator first, iterator last) {
+    if (first == last || (&other == this && (pos == first || pos == last))) {
+      return;
+    }
+    if (!this->share_pool(other)) {
+      while (first != last) {
+        ListNode<T> *node = first.m_node;
+        ++first;
+        node = this->take_node(other, node);
+        this->link_chain_before(pos.m_node, node, node, 1);
+      }
+      return;
+    }
+    ListNode<T> *front = first.m_node;
+    ListNode<T> *back =
+        last.m_node == nullptr ? other.m_back : last.m_node->last;
+    size_t count = 0;
+    if (&other != this) {
+      count = size_t(std::distance(first, last));
+    }
+    other.unlink_chain(front, back, count);
+    this->link_chain_before(pos.m_node, front, back, count);
+  }
+
+  /// Merge another sorted list into this sorted list.
+  /*
+   * O(n + m) comparisons. Stable: of equal elements, this list's come
+   * first. Nodes are relinked, as in splice(), unless one of the lists
+   * was given a pool the other doesn't share; then other's elements
+   * are moved into nodes from this list's pool. other is left empty.
+   * If comp throws, both lists are left valid, with some of other's
+   * elements moved already.
+   * @param other - another list, sorted by comp.
+   * @param comp - the strict weak ordering both lists are sorted by.
+   */
+  template <typename Compare> void merge(list &other, Compare comp) {
+    if (&other == this) {
+      return;
+    }
+    ListNode<T> *pos = m_front;
+    while (other.m_front != nullptr) {
+      while (pos != nullptr && !comp(other.m_front->val, pos->val)) {
+        pos = pos->next;
+      }
+      if (pos == nullptr) {
+        this->splice(this->end(), other);
+        return;
+      }
+      ListNode<T> *node = this->take_node(other, other.m_front);
+      this->link_chain_before(pos, node, node, 1);
+    }
+  }
+
+  /// Merge another list sorted by operator< into this one.
+  void merge(list &other) { this->merge(other, std::less<T>()); }
+
+  /// Sort the list in place.
+  /*
+   * O(n log n) comparisons, stable, and allocates nothing: a
+   * bottom-up merge sort that relinks the existing nodes, so
+   * iterators stay valid and keep pointing at the same elements.
+   * Runs of 1, 2, 4, ... nodes are merged as they complete, each kept
+   * as a chain linked only forwards; the backward links are rebuilt
+   * in one pass at the end. If comp throws, the list keeps all its
+   * elements in an unspecified order.
+   * @param comp - a strict weak ordering.
+   */
+  template <typename Compare> void sort(Compare comp) {
+    if (m_size < 2) {
+      return;
+    }
+    // runs[i] is empty or a sorted run of 2^i nodes, holding elements
+    // that came before those of runs[i - 1].
+    ListNode<T> *runs[64] = {};
+    size_t num_runs = 0;
+    ListNode<T> *rest = m_front;
+    ListNode<T> *run = nullptr;
+    try {
+      while (rest != nullptr) {
+        run = rest;
+        rest = rest->next;
+        run->next = nullptr;
+        size_t i = 0;
+        for (; i < num_runs && runs[i] != nullptr; i++) {
+          ListNode<T> *later = run;
+          run = runs[i];
+          runs[i] = nullptr;
+          merge_runs(run, later, comp);
+        }
+        if (i == num_runs) {
+          num_runs++;
+        }
+        runs[i] = run;
+        run = nullptr;
+      }
+      for (size_t i = 0; i < num_runs; i++) {
+        if (runs[i] != nullptr) {
+          ListNode<T> *later = run;
+          run = runs[i];
+          runs[i] = nullptr;
+          merge_runs(run, later, comp);
+        }
+      }
+    } catch (...) {
+      // Every node is in exactly one of rest, run and runs.
+      for (size_t i = 0; i < num_runs; i++) {
+        rest = concat_runs(rest, runs[i]);
+      }
+      this->relink(concat_runs(rest, run));
+      throw;
+    }
+    this->relink(run);
+  }
+
+  /// Sort the list in place by operator<. See sort(comp).
+  void sort() { this->sort(std::less<T>()); }
+
   /// Forward iterators. All of these are created and incremented in O(1).
   iterator begin() { return iterator(this->m_front); }
   iterator end() { return iterator(nullptr); }
@@ -249,8 +773,260 @@ public:
   const reverse_iterator crend() const { return reverse_iterator(nullptr); }
 
 private:
+  /// A pool owned jointly by lists that have exchanged nodes.
+  struct shared_pool {
+    explicit shared_pool(const Alloc &alloc)
+        : pool(alloc), num_users(1), forward(nullptr) {}
+
+    node_pool_type pool;
+    /// The lists drawing from the pool, plus the shared pools that
+    /// forward to it.
+    size_t num_users;
+    /// The pool this one's blocks were merged into, if any.
+    shared_pool *forward;
+  };
+  typedef typename alloc_traits::template rebind_alloc<shared_pool>
+      shared_pool_allocator;
+  typedef std::allocator_traits<shared_pool_allocator> shared_pool_traits;
+
+  bool owns_pool() const { return m_pool == &m_own_pool; }
+
+  /// Make this list and other draw nodes from one pool, so that nodes
+  /// can move between them as they are.
+  /*
+   * Lists that own their pools, or share one, can always be made to
+   * share one. The first time two lists that own theirs do, a shared
+   * pool is allocated, so this may throw, changing nothing. Merging
+   * pools costs O(blocks + free slots) of the one merged.
+   * @return false if one of the lists was given a pool that the other
+   *         doesn't use, or their allocators differ.
+   */
+  bool share_pool(list &other) {
+    this->follow_forward();
+    other.follow_forward();
+    if (m_pool == other.m_pool) {
+      return true;
+    }
+    if ((!this->owns_pool() && m_shared == nullptr) ||
+        (!other.owns_pool() && other.m_shared == nullptr) ||
+        !(this->get_allocator() == other.get_allocator())) {
+      return false;
+    }
+    if (m_shared == nullptr && other.m_shared == nullptr) {
+      shared_pool_allocator alloc(this->get_allocator());
+      shared_pool *shared = shared_pool_traits::allocate(alloc, 1);
+      new (shared) shared_pool(this->get_allocator());
+      shared->pool.merge(m_own_pool);
+      m_shared = shared;
+      m_pool = &shared->pool;
+    }
+    if (m_shared == nullptr) {
+      other.m_shared->pool.merge(m_own_pool);
+      this->join(other.m_shared);
+    } else if (other.m_shared == nullptr) {
+      m_shared->pool.merge(other.m_own_pool);
+      other.join(m_shared);
+    } else {
+      // Other lists may still use other's pool, so it is left to
+      // forward them to this one.
+      m_shared->pool.merge(other.m_shared->pool);
+      other.m_shared->forward = m_shared;
+      m_shared->num_users++;
+      other.follow_forward();
+    }
+    return true;
+  }
+
+  /// Start drawing nodes from a shared pool. The blocks of the list's
+  /// current pool must have been merged into it already.
+  void join(shared_pool *shared) {
+    shared->num_users++;
+    m_shared = shared;
+    m_pool = &shared->pool;
+  }
+
+  /// Move onto the pool that this list's shared pool was merged into,
+  /// taking along the blocks it has allocated since.
+  void follow_forward() {
+    while (m_shared != nullptr && m_shared->forward != nullptr) {
+      shared_pool *old = m_shared;
+      old->forward->pool.merge(old->pool);
+      this->join(old->forward);
+      release(old);
+    }
+  }
+
+  /// Drop a list's use of a shared pool, destroying it with the last.
+  static void release(shared_pool *shared) {
+    while (shared != nullptr && --shared->num_users == 0) {
+      shared_pool *forward = shared->forward;
+      shared_pool_allocator alloc(shared->pool.get_allocator());
+      shared->~shared_pool();
+      shared_pool_traits::deallocate(alloc, shared, 1);
+      shared = forward;
+    }
+  }
+
+  /// Append copies of every element of other. Clears on failure.
+  void copy_from(const list &other) {
+    try {
+      m_pool->reserve(other.m_size);
+      for (ListNode<T> *node = other.m_front; node != nullptr;
+           node = node->next) {
+        this->push_back(node->val);
+      }
+    } catch (...) {
+      this->clear();
+      throw;
+    }
+  }
+
+  /// Move every node of other, which must share this list's pool,
+  /// in front of next (or to the back if next is nullptr).
+  void link_before(ListNode<T> *next, list &other) {
+    this->link_chain_before(next, other.m_front, other.m_back, other.m_size);
+    PRAC_STATS(m_stats.node_allocations += other.m_stats.node_allocations;
+               m_stats.node_frees += other.m_stats.node_frees;)
+    other.m_front = nullptr;
+    other.m_back = nullptr;
+    other.m_size = 0;
+  }
+
+  /// Link the nodes from front to back, whose outer links are
+  /// ignored, in front of next (or to the back if next is nullptr).
+  void link_chain_before(ListNode<T> *next, ListNode<T> *front,
+                         ListNode<T> *back, const size_t &count) {
+    ListNode<T> *last = next == nullptr ? m_back : next->last;
+    front->last = last;
+    back->next = next;
+    if (last == nullptr) {
+      m_front = front;
+    } else {
+      last->next = front;
+    }
+    if (next == nullptr) {
+      m_back = back;
+    } else {
+      next->last = back;
+    }
+    m_size += count;
+  }
+
+  /// Unlink the nodes from front to back, without destroying them.
+  /// Their outer links are left dangling.
+  void unlink_chain(ListNode<T> *front, ListNode<T> *back,
+                    const size_t &count) {
+    if (front->last == nullptr) {
+      m_front = back->next;
+    } else {
+      front->last->next = back->next;
+    }
+    if (back->next == nullptr) {
+      m_back = front->last;
+    } else {
+      back->next->last = front->last;
+    }
+    m_size -= count;
+  }
+
+  /// Unlink a node from other and get a node of this list's pool with
+  /// its value: the node itself if the lists can share a pool,
+  /// otherwise a new one its value is moved into. Nothing changes if
+  /// that throws.
+  ListNode<T> *take_node(list &other, ListNode<T> *node) {
+    if (this->share_pool(other)) {
+      other.unlink_chain(node, node, 1);
+      return node;
+    }
+    ListNode<T> *moved = this->create_node(std::move(node->val));
+    other.unlink_chain(node, node, 1);
+    other.destroy_node(node);
+    return moved;
+  }
+
+  /// Merge the forward-linked sorted run later into the one at into,
+  /// taking from into first among equals. If comp throws, into is
+  /// left holding every node of both.
+  template <typename Compare>
+  static void merge_runs(ListNode<T> *&into, ListNode<T> *later,
+                         Compare &comp) {
+    ListNode<T> *earlier = into;
+    ListNode<T> **tail = &into;
+    try {
+      while (earlier != nullptr && later != nullptr) {
+        if (comp(later->val, earlier->val)) {
+          *tail = later;
+          later = later->next;
+        } else {
+          *tail = earlier;
+          earlier = earlier->next;
+        }
+        tail = &(*tail)->next;
+      }
+    } catch (...) {
+      *tail = concat_runs(earlier, later);
+      throw;
+    }
+    *tail = earlier != nullptr ? earlier : later;
+  }
+
+  /// Join two forward-linked chains, either of which may be empty.
+  static ListNode<T> *concat_runs(ListNode<T> *first, ListNode<T> *second) {
+    if (first == nullptr) {
+      return second;
+    }
+    ListNode<T> *tail = first;
+    while (tail->next != nullptr) {
+      tail = tail->next;
+    }
+    tail->next = second;
+    return first;
+  }
+
+  /// Make a forward-linked chain of all m_size nodes the list again,
+  /// setting the backward links.
+  void relink(ListNode<T> *front) {
+    m_front = front;
+    ListNode<T> *last = nullptr;
+    for (ListNode<T> *node = front; node != nullptr; node = node->next) {
+      node->last = last;
+      last = node;
+    }
+    m_back = last;
+  }
+
+  /// Get a node from the pool and construct its value from args.
+  template <typename... Args> ListNode<T> *create_node(Args &&... args) {
+    ListNode<T> *node = m_pool->allocate();
+    try {
+      new (node) ListNode<T>(std::forward<Args>(args)...);
+    } catch (...) {
+      m_pool->deallocate(node);
+      throw;
+    }
+    PRAC_STATS(detail::stats_on_node_allocation(m_stats, stats_kind::list);)
+    return node;
+  }
+
+  /// Destroy a node's value and give the node back to the pool.
+  void destroy_node(ListNode<T> *node) {
+    node->~ListNode<T>();
+    m_pool->deallocate(node);
+    PRAC_STATS(detail::stats_on_node_free(m_stats, stats_kind::list);)
+  }
+
+  /// Used unless the list was given a pool to share, or has
+  /// exchanged nodes with another list.
+  node_pool_type m_own_pool;
+  node_pool_type *m_pool;
+  /// The pool shared with lists this one exchanged nodes with, or
+  /// nullptr.
+  shared_pool *m_shared;
   size_t m_size;
   ListNode<T> *m_front;
   ListNode<T> *m_back;
+#ifdef PRAC_CONTAINER_STATS
+  container_stats m_stats;
+#endif
 };
 }; // namespace prac
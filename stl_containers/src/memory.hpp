@@ -0,0 +1,336 @@
+#pragma once
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <stddef.h>
+
+namespace prac {
+namespace detail {
+
+/// Get raw, uninitialized storage for n elements of T.
+/*
+ * No constructors are run; the caller constructs elements in place.
+ * @param n - the number of elements to make room for.
+ * @return a pointer to the storage, or nullptr if n is zero.
+ * @throws std::bad_array_new_length if n * sizeof(T) overflows.
+ */
+template <typename T> T *allocate_storage(const size_t &n) {
+  if (n == 0) {
+    return nullptr;
+  }
+  if (n > size_t(-1) / sizeof(T)) {
+    throw std::bad_array_new_length();
+  }
+  if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+  }
+  return static_cast<T *>(::operator new(n * sizeof(T)));
+}
+
+/// Release storage obtained from allocate_storage().
+/*
+ * Elements must already have been destroyed.
+ * @param storage - the storage to release. May be nullptr.
+ */
+template <typename T> void deallocate_storage(T *storage) {
+  if (storage == nullptr) {
+    return;
+  }
+  if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    ::operator delete(storage, std::align_val_t(alignof(T)));
+  } else {
+    ::operator delete(storage);
+  }
+}
+
+/// Run the destructor of n constructed elements.
+/*
+ * Compiles to nothing for trivially destructible T.
+ */
+template <typename T> void destroy(T *first, const size_t &n) {
+  if (!std::is_trivially_destructible<T>::value) {
+    for (size_t i = 0; i < n; i++) {
+      first[i].~T();
+    }
+  }
+}
+
+/// Construct n copies of value into uninitialized storage.
+/*
+ * If a constructor throws, the elements constructed so far are
+ * destroyed before the exception propagates.
+ */
+template <typename T>
+void uninitialized_fill(T *first, const size_t &n, const T &value) {
+  size_t i = 0;
+  try {
+    for (; i < n; i++) {
+      new (first + i) T(value);
+    }
+  } catch (...) {
+    destroy(first, i);
+    throw;
+  }
+}
+
+/// Copy-construct n elements from src into uninitialized storage at dst.
+/*
+ * Trivially copyable T is copied with a single memcpy.
+ */
+template <typename T>
+void uninitialized_copy(T *dst, const T *src, const size_t &n) {
+  if (std::is_trivially_copyable<T>::value) {
+    if (n > 0) {
+      std::memcpy(static_cast<void *>(dst), static_cast<const void *>(src),
+                  n * sizeof(T));
+    }
+    return;
+  }
+  size_t i = 0;
+  try {
+    for (; i < n; i++) {
+      new (dst + i) T(src[i]);
+    }
+  } catch (...) {
+    destroy(dst, i);
+    throw;
+  }
+}
+
+/// Whether It can be measured with std::distance without using it up.
+template <typename It>
+struct is_forward_iterator
+    : std::is_convertible<typename std::iterator_traits<It>::iterator_category,
+                          std::forward_iterator_tag> {};
+
+/// Whether It points into contiguous storage of T, so that a range of
+/// it can be copied with memcpy when T is trivially copyable.
+/*
+ * True for pointers, and from C++20 for any contiguous iterator.
+ */
+template <typename T, typename It>
+struct is_contiguous_iterator_of
+    : std::integral_constant<
+          bool, std::is_same<It, T *>::value ||
+                    std::is_same<It, const T *>::value
+#if __cplusplus >= 202002L
+                    || (std::contiguous_iterator<It> &&
+                        std::is_same<std::iter_value_t<It>, T>::value)
+#endif
+          > {
+};
+
+/// memcpy n elements from a contiguous range into storage at dst.
+template <typename T, typename It>
+It uninitialized_copy_n(T *dst, It first, const size_t &n, std::true_type) {
+  if (n > 0) {
+    std::memcpy(static_cast<void *>(dst), static_cast<const void *>(&*first),
+                n * sizeof(T));
+    std::advance(first, n);
+  }
+  return first;
+}
+
+/// Copy-construct n elements one at a time into storage at dst.
+template <typename T, typename It>
+It uninitialized_copy_n(T *dst, It first, const size_t &n, std::false_type) {
+  size_t i = 0;
+  try {
+    for (; i < n; i++, ++first) {
+      new (dst + i) T(*first);
+    }
+  } catch (...) {
+    destroy(dst, i);
+    throw;
+  }
+  return first;
+}
+
+/// Copy-construct n elements from the range starting at first into
+/// uninitialized storage at dst.
+/*
+ * A contiguous range of trivially copyable T is copied with a single
+ * memcpy. If a constructor throws, the elements constructed so far
+ * are destroyed.
+ * @return the iterator past the last element copied.
+ */
+template <typename T, typename It>
+It uninitialized_copy_n(T *dst, It first, const size_t &n) {
+  return uninitialized_copy_n(
+      dst, first, n,
+      std::integral_constant<bool,
+                             std::is_trivially_copyable<T>::value &&
+                                 is_contiguous_iterator_of<T, It>::value>());
+}
+
+/// Move-construct n elements from src into uninitialized storage at
+/// dst. The elements in src are left moved-from, not destroyed.
+/*
+ * Trivially copyable T is moved with a single memmove, so the ranges
+ * may overlap in that case.
+ */
+template <typename T> void uninitialized_move(T *dst, T *src, const size_t &n) {
+  if (std::is_trivially_copyable<T>::value) {
+    if (n > 0) {
+      std::memmove(static_cast<void *>(dst), static_cast<const void *>(src),
+                   n * sizeof(T));
+    }
+    return;
+  }
+  size_t i = 0;
+  try {
+    for (; i < n; i++) {
+      new (dst + i) T(std::move(src[i]));
+    }
+  } catch (...) {
+    destroy(dst, i);
+    throw;
+  }
+}
+
+/// Relocate n elements from src into uninitialized storage at dst.
+/*
+ * Trivially copyable T is moved with a single memcpy. Otherwise
+ * elements are moved if T's move constructor is noexcept, and copied
+ * if it isn't, so a throwing copy leaves src untouched. On success
+ * the elements in src have been destroyed.
+ */
+template <typename T> void relocate(T *dst, T *src, const size_t &n) {
+  if (std::is_trivially_copyable<T>::value) {
+    if (n > 0) {
+      std::memcpy(static_cast<void *>(dst), static_cast<const void *>(src),
+                  n * sizeof(T));
+    }
+    return;
+  }
+  size_t i = 0;
+  try {
+    for (; i < n; i++) {
+      new (dst + i) T(std::move_if_noexcept(src[i]));
+    }
+  } catch (...) {
+    destroy(dst, i);
+    throw;
+  }
+  destroy(src, n);
+}
+
+/// Storage from allocate_at_least() and the number of elements it
+/// has room for.
+template <typename Pointer> struct allocation_result {
+  Pointer ptr;
+  size_t count;
+};
+
+template <typename Alloc>
+auto allocate_at_least(Alloc &alloc, const size_t &n, int)
+    -> decltype(alloc.allocate_at_least(n)) {
+  return alloc.allocate_at_least(n);
+}
+
+template <typename Alloc>
+allocation_result<typename std::allocator_traits<Alloc>::pointer>
+allocate_at_least(Alloc &alloc, const size_t &n, long) {
+  return {std::allocator_traits<Alloc>::allocate(alloc, n), n};
+}
+
+/// Allocate room for at least n elements, as C++23's
+/// std::allocator_traits::allocate_at_least does.
+/*
+ * Calls alloc.allocate_at_least(n) if Alloc has it, so an allocator
+ * can report a bigger block it hands out anyway, and allocate(n)
+ * otherwise. The storage must be deallocated with the count returned.
+ */
+template <typename Alloc>
+allocation_result<typename std::allocator_traits<Alloc>::pointer>
+allocate_at_least(Alloc &alloc, const size_t &n) {
+  return detail::allocate_at_least(alloc, n, 0);
+}
+
+}; // namespace detail
+
+/// The default allocator for prac containers.
+/*
+ * Hands out raw storage from the global operator new, honoring
+ * alignof(T). Stateless, so all instances compare equal.
+ */
+template <typename T> struct allocator {
+  typedef T value_type;
+  typedef std::true_type is_always_equal;
+
+  allocator() = default;
+  template <typename U> allocator(const allocator<U> &) {}
+
+  T *allocate(const size_t &n) { return detail::allocate_storage<T>(n); }
+  void deallocate(T *storage, const size_t &) {
+    detail::deallocate_storage(storage);
+  }
+
+  template <typename U> bool operator==(const allocator<U> &) const {
+    return true;
+  }
+  template <typename U> bool operator!=(const allocator<U> &) const {
+    return false;
+  }
+};
+
+/// An allocator whose storage is aligned to at least Alignment bytes.
+/*
+ * prac::allocator only honors alignof(T). With Alignment = 64, every
+ * buffer starts on a cache line, so SIMD loads of up to 64 bytes at
+ * multiples of their width never straddle two lines; a container
+ * using it gets that alignment on every reallocation. Stateless, so
+ * all instances compare equal.
+ * @tparam Alignment - a power of two.
+ */
+template <typename T, size_t Alignment> struct aligned_allocator {
+  static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0,
+                "aligned_allocator needs a power of two alignment");
+
+  typedef T value_type;
+  typedef std::true_type is_always_equal;
+  /// The alignment every allocation gets.
+  static constexpr size_t alignment =
+      Alignment > alignof(T) ? Alignment : alignof(T);
+
+  /// Needed since Alignment isn't a type, so allocator_traits can't
+  /// rebind it by itself.
+  template <typename U> struct rebind {
+    typedef aligned_allocator<U, Alignment> other;
+  };
+
+  aligned_allocator() = default;
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, Alignment> &) {}
+
+  T *allocate(const size_t &n) {
+    if (n == 0) {
+      return nullptr;
+    }
+    if (n > size_t(-1) / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t(alignment)));
+  }
+  void deallocate(T *storage, const size_t &) {
+    if (storage != nullptr) {
+      ::operator delete(storage, std::align_val_t(alignment));
+    }
+  }
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U, Alignment> &) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const aligned_allocator<U, Alignment> &) const {
+    return false;
+  }
+};
+
+}; // namespace prac
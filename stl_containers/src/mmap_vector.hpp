@@ -0,0 +1,412 @@
+#pragma once
+#include "growth.hpp"
+#include "memory.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+#include <stddef.h>
+
+namespace prac {
+/*
+ * A vector of trivially copyable elements that lives in a file.
+ *
+ * The file is mapped into memory with MAP_SHARED, so the elements
+ * are the file's pages. Opening an existing file costs O(1): no
+ * element is read until it is touched, and then only its page is
+ * faulted in, so the data set can be larger than RAM. Writes go to
+ * the page cache and reach the disk when the kernel writes the pages
+ * back, or when sync() is called.
+ *
+ * The file starts with a 64 byte header holding a magic number, a
+ * format version, sizeof(T) and the element count, followed by the
+ * elements. The capacity is whatever fits in the rest of the file.
+ * Growing extends the file with ftruncate() and remaps it, which
+ * moves no element data (on Linux, mremap() doesn't even copy page
+ * tables when it can extend in place). Growth picks the capacity of
+ * each extension, as for prac::vector.
+ *
+ * Like prac::vector's, pointers into the elements are invalidated
+ * by anything that grows or shrinks the capacity. Errors from the
+ * system calls are thrown as std::system_error; a file that isn't
+ * an mmap_vector of T is rejected with std::runtime_error.
+ */
+template <typename T, typename Growth = prac::growth_2x> class mmap_vector {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "mmap_vector elements are stored as raw file bytes");
+
+public:
+  /// The size of the file header, which is also the offset of the
+  /// first element.
+  static constexpr size_t header_bytes = 64;
+  static_assert(alignof(T) <= header_bytes,
+                "mmap_vector elements must fit the header's alignment");
+
+  /// Open a file, creating it if it doesn't exist.
+  /*
+   * O(1). An empty or new file becomes an empty mmap_vector. An
+   * existing file must have been written by an mmap_vector of an
+   * element type with the same size.
+   * @param path - the file to open.
+   */
+  explicit mmap_vector(const std::string &path)
+      : m_path(path), m_fd(-1), m_mapping(nullptr), m_mapped_bytes(0),
+        m_num_allocated(0) {
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+      throw_errno("open " + path);
+    }
+    try {
+      struct stat st;
+      if (::fstat(m_fd, &st) != 0) {
+        throw_errno("fstat " + path);
+      }
+      if (st.st_size == 0) {
+        this->resize_file(header_bytes);
+        this->map(header_bytes);
+        Header *header = this->header();
+        std::memcpy(header->magic, magic(), sizeof(header->magic));
+        header->version = format_version;
+        header->element_size = sizeof(T);
+        header->num_elements = 0;
+      } else {
+        this->map(size_t(st.st_size));
+        this->check_header();
+      }
+    } catch (...) {
+      this->close();
+      throw;
+    }
+  }
+
+  mmap_vector(const mmap_vector &) = delete;
+  mmap_vector &operator=(const mmap_vector &) = delete;
+
+  /// Move construction.
+  /*
+   * O(1). other is left closed; only destroying or assigning to it
+   * is valid afterwards.
+   */
+  mmap_vector(mmap_vector &&other) noexcept
+      : m_path(std::move(other.m_path)), m_fd(other.m_fd),
+        m_mapping(other.m_mapping), m_mapped_bytes(other.m_mapped_bytes),
+        m_num_allocated(other.m_num_allocated) {
+    other.m_fd = -1;
+    other.m_mapping = nullptr;
+    other.m_mapped_bytes = 0;
+    other.m_num_allocated = 0;
+  }
+
+  /// Move assignment.
+  /*
+   * O(1). Closes this vector's file first, and leaves other closed.
+   */
+  mmap_vector &operator=(mmap_vector &&other) noexcept {
+    if (this == &other) {
+      return *this;
+    }
+    this->close();
+    m_path = std::move(other.m_path);
+    m_fd = other.m_fd;
+    m_mapping = other.m_mapping;
+    m_mapped_bytes = other.m_mapped_bytes;
+    m_num_allocated = other.m_num_allocated;
+    other.m_fd = -1;
+    other.m_mapping = nullptr;
+    other.m_mapped_bytes = 0;
+    other.m_num_allocated = 0;
+    return *this;
+  }
+
+  /// Unmap and close the file.
+  /*
+   * Doesn't wait for the data to reach the disk; call sync() first
+   * for that. The file keeps its spare capacity.
+   */
+  ~mmap_vector() { this->close(); }
+
+  /// Push back a new element to the container.
+  /*
+   * Amortized O(1). Extends the file if it is full.
+   * @param new_elem - the new element to add.
+   */
+  void push_back(const T &new_elem) {
+    size_t num_elements = this->size();
+    if (num_elements >= m_num_allocated) {
+      // new_elem may live in the mapping that's about to move.
+      T copy = new_elem;
+      this->allocate(Growth::grow(m_num_allocated, num_elements + 1,
+                                  sizeof(T)));
+      this->data()[num_elements] = copy;
+    } else {
+      this->data()[num_elements] = new_elem;
+    }
+    this->header()->num_elements = num_elements + 1;
+  }
+
+  /// Remove the last element.
+  /*
+   * O(1). The container must not be empty.
+   */
+  void pop_back() { this->header()->num_elements--; }
+
+  /// Add copies of a range to the back of the container.
+  /*
+   * O(n) in the length of the range. A forward range is measured
+   * once, so the file is extended at most once, and a pointer range
+   * is copied with one memcpy.
+   * @param first - the beginning of the range. The range must not be
+   *                part of this vector.
+   * @param last - the end of the range.
+   */
+  template <typename Other> void append(Other first, Other last) {
+    if (!detail::is_forward_iterator<Other>::value) {
+      for (; first != last; ++first) {
+        this->push_back(*first);
+      }
+      return;
+    }
+    size_t num_new = size_t(std::distance(first, last));
+    size_t required = this->size() + num_new;
+    if (required > m_num_allocated) {
+      this->allocate(Growth::grow(m_num_allocated, required, sizeof(T)));
+    }
+    detail::uninitialized_copy_n(this->data() + this->size(), first, num_new);
+    this->header()->num_elements = required;
+  }
+
+  /// Retrieve an element.
+  /*
+   * O(1) random access. The first access to a page reads it from the
+   * file. Bounds are not checked.
+   * @param i - the index at which to retrieve the element.
+   * @return a reference to the element.
+   */
+  const T &operator[](const size_t &i) const { return this->data()[i]; }
+
+  /// Retrieve an element.
+  /*
+   * O(1) random access. The first access to a page reads it from the
+   * file. Bounds are not checked.
+   * @param i - the index at which to retrieve the element.
+   * @return a reference to the element.
+   */
+  T &operator[](const size_t &i) { return this->data()[i]; }
+
+  // Retrieve the size of the container.
+  /*
+   * @return the number of elements that have been stored.
+   */
+  size_t size() const { return this->header()->num_elements; }
+
+  /// Whether the container has no elements.
+  bool empty() const { return this->size() == 0; }
+
+  // Retrieve the capacity of the container.
+  /*
+   * @return the number of elements that fit in the file as it is.
+   */
+  size_t capacity() const { return m_num_allocated; }
+
+  // Resize the container.
+  /*
+   * O(n) in the number of elements added, O(1) otherwise. New
+   * elements are set to default_value. If the file has to grow, the
+   * growth policy picks the new capacity, so growing one element at
+   * a time is amortized O(1) per element. Shrinking keeps the file's
+   * size; see shrink_to_fit().
+   * @param sz - the new size of the container.
+   * @param default_value - the value to which to set the new
+   *                        elements.
+   */
+  void resize(const size_t &sz, const T &default_value = T()) {
+    size_t num_elements = this->size();
+    if (sz > num_elements) {
+      T value = default_value;
+      if (sz > m_num_allocated) {
+        this->allocate(Growth::grow(m_num_allocated, sz, sizeof(T)));
+      }
+      T *storage = this->data();
+      for (size_t i = num_elements; i < sz; i++) {
+        storage[i] = value;
+      }
+    }
+    this->header()->num_elements = sz;
+  }
+
+  /// Remove every element. The file keeps its size.
+  void clear() { this->header()->num_elements = 0; }
+
+  /// Make room for at least sz elements.
+  /*
+   * Extends the file to exactly sz elements if it holds fewer. The
+   * new pages take no disk space until they are written, on file
+   * systems with sparse files.
+   * @param sz - the number of elements we need, at least.
+   */
+  void reserve(const size_t &sz) { this->allocate(sz); }
+
+  /// Truncate the file to the elements in use.
+  void shrink_to_fit() {
+    size_t num_elements = this->size();
+    if (num_elements == m_num_allocated) {
+      return;
+    }
+    size_t bytes = header_bytes + num_elements * sizeof(T);
+    this->remap(bytes);
+    this->resize_file(bytes);
+    m_num_allocated = num_elements;
+  }
+
+  /// Write the changes back to the file.
+  /*
+   * O(number of dirty pages). Blocks until the kernel has written
+   * every modified page, header included, to the disk.
+   */
+  void sync() {
+    if (::msync(m_mapping, m_mapped_bytes, MS_SYNC) != 0) {
+      throw_errno("msync " + m_path);
+    }
+  }
+
+  /// Get the path of the file.
+  const std::string &path() const { return m_path; }
+
+  /// Iterators are plain pointers into the mapping.
+  typedef T value_type;
+  typedef T *iterator;
+  typedef const T *const_iterator;
+
+  /// Get a pointer to the elements.
+  T *data() {
+    return reinterpret_cast<T *>(static_cast<char *>(m_mapping) +
+                                 header_bytes);
+  }
+  const T *data() const {
+    return reinterpret_cast<const T *>(static_cast<const char *>(m_mapping) +
+                                       header_bytes);
+  }
+
+  // Forward iterators. All of these are created and incremented in O(1).
+  iterator begin() { return this->data(); }
+  iterator end() { return this->data() + this->size(); }
+  const_iterator begin() const { return this->data(); }
+  const_iterator end() const { return this->data() + this->size(); }
+
+private:
+  /// The first bytes of the file.
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t element_size;
+    uint64_t num_elements;
+  };
+  static_assert(sizeof(Header) <= header_bytes, "header doesn't fit");
+
+  static constexpr uint32_t format_version = 1;
+
+  static const char *magic() { return "PRACMMV"; }
+
+  [[noreturn]] static void throw_errno(const std::string &what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  Header *header() { return static_cast<Header *>(m_mapping); }
+  const Header *header() const {
+    return static_cast<const Header *>(m_mapping);
+  }
+
+  /// Reject a file that wasn't written by an mmap_vector of T.
+  void check_header() {
+    if (m_mapped_bytes < header_bytes) {
+      throw std::runtime_error(m_path + " is too small for an mmap_vector");
+    }
+    const Header *header = this->header();
+    if (std::memcmp(header->magic, magic(), sizeof(header->magic)) != 0) {
+      throw std::runtime_error(m_path + " is not an mmap_vector");
+    }
+    if (header->version != format_version) {
+      throw std::runtime_error(m_path + " has an unknown format version");
+    }
+    if (header->element_size != sizeof(T)) {
+      throw std::runtime_error(m_path + " holds elements of another size");
+    }
+    m_num_allocated = (m_mapped_bytes - header_bytes) / sizeof(T);
+    if (header->num_elements > m_num_allocated) {
+      throw std::runtime_error(m_path + " is truncated");
+    }
+  }
+
+  /// Extend the file to hold exactly sz elements, if it holds fewer.
+  void allocate(const size_t &sz) {
+    if (sz <= m_num_allocated) {
+      return;
+    }
+    size_t bytes = header_bytes + sz * sizeof(T);
+    this->resize_file(bytes);
+    this->remap(bytes);
+    m_num_allocated = sz;
+  }
+
+  void resize_file(const size_t &bytes) {
+    if (::ftruncate(m_fd, off_t(bytes)) != 0) {
+      throw_errno("ftruncate " + m_path);
+    }
+  }
+
+  void map(const size_t &bytes) {
+    void *mapping =
+        ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+      throw_errno("mmap " + m_path);
+    }
+    m_mapping = mapping;
+    m_mapped_bytes = bytes;
+  }
+
+  /// Change the size of the mapping to bytes.
+  /*
+   * The file must already be at least that large. On failure the old
+   * mapping is left in place.
+   */
+  void remap(const size_t &bytes) {
+#ifdef MREMAP_MAYMOVE
+    void *mapping = ::mremap(m_mapping, m_mapped_bytes, bytes, MREMAP_MAYMOVE);
+    if (mapping == MAP_FAILED) {
+      throw_errno("mremap " + m_path);
+    }
+    m_mapping = mapping;
+    m_mapped_bytes = bytes;
+#else
+    void *old_mapping = m_mapping;
+    size_t old_bytes = m_mapped_bytes;
+    this->map(bytes);
+    ::munmap(old_mapping, old_bytes);
+#endif
+  }
+
+  void close() {
+    if (m_mapping != nullptr) {
+      ::munmap(m_mapping, m_mapped_bytes);
+      m_mapping = nullptr;
+    }
+    if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+  std::string m_path;
+  int m_fd;
+  void *m_mapping;
+  size_t m_mapped_bytes;
+  size_t m_num_allocated;
+};
+}; // namespace prac
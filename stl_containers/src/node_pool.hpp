@@ -0,0 +1,236 @@
+#pragma once
+#include "memory.hpp"
+#include <memory>
+#include <stddef.h>
+
+namespace prac {
+
+/// A slab allocator for fixed-size nodes.
+/*
+ * Nodes are carved in address order out of cache-line-aligned blocks
+ * obtained from Alloc, and freed nodes are recycled through an
+ * intrusive free list. Once the pool has grown to its steady-state
+ * size, allocate() and deallocate() are O(1) and never call Alloc.
+ *
+ * Blocks are only given back to Alloc when the pool is destroyed.
+ * Every node must have been deallocated (or at least destroyed) by
+ * then. Not thread-safe.
+ */
+template <typename Node, typename Alloc = prac::allocator<Node>>
+class node_pool {
+  /// The unit blocks are allocated in.
+  struct alignas(64) CacheLine {
+    unsigned char bytes[64];
+  };
+
+  /// A slot holds either a node or, while free, a link in the free list.
+  union Slot {
+    Slot *next_free;
+    alignas(Node) unsigned char storage[sizeof(Node)];
+  };
+
+  /// Sits at the start of every block.
+  struct BlockHeader {
+    BlockHeader *next;
+    size_t num_lines;
+  };
+
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<
+      CacheLine>
+      block_allocator;
+  typedef std::allocator_traits<block_allocator> block_traits;
+
+  static_assert(alignof(Slot) <= alignof(CacheLine),
+                "node_pool supports nodes aligned to at most a cache line");
+
+  static constexpr size_t slot_offset =
+      (sizeof(BlockHeader) + alignof(Slot) - 1) / alignof(Slot) *
+      alignof(Slot);
+
+public:
+  /// Construct an empty pool.
+  /*
+   * No blocks are allocated until the first node is requested.
+   * @param alloc - the allocator to get blocks from.
+   * @param block_bytes - the size of a block when the pool grows by
+   *                      itself. reserve() may allocate other sizes.
+   */
+  explicit node_pool(const Alloc &alloc = Alloc(),
+                     const size_t &block_bytes = 4096)
+      : m_alloc(alloc), m_blocks(nullptr), m_free(nullptr),
+        m_next_unused(nullptr), m_end_unused(nullptr), m_num_free(0),
+        m_num_slots(0), m_slots_per_block(1) {
+    if (block_bytes > slot_offset + sizeof(Slot)) {
+      m_slots_per_block = (block_bytes - slot_offset) / sizeof(Slot);
+    }
+  }
+
+  node_pool(const node_pool &) = delete;
+  node_pool &operator=(const node_pool &) = delete;
+
+  /// Move construction. other is left empty.
+  node_pool(node_pool &&other) noexcept : node_pool(other.m_alloc) {
+    this->swap(other);
+  }
+
+  ~node_pool() {
+    while (m_blocks != nullptr) {
+      BlockHeader *next = m_blocks->next;
+      block_traits::deallocate(m_alloc, reinterpret_cast<CacheLine *>(m_blocks),
+                               m_blocks->num_lines);
+      m_blocks = next;
+    }
+  }
+
+  /// Get uninitialized storage for one node.
+  /*
+   * O(1). Only calls Alloc when no free or unused slot is left.
+   * @return storage suitably sized and aligned for Node.
+   */
+  Node *allocate() {
+    if (m_free != nullptr) {
+      Slot *slot = m_free;
+      m_free = slot->next_free;
+      m_num_free--;
+      return reinterpret_cast<Node *>(slot->storage);
+    }
+    if (m_next_unused == m_end_unused) {
+      this->add_block(m_slots_per_block);
+    }
+    Slot *slot = m_next_unused;
+    m_next_unused++;
+    return reinterpret_cast<Node *>(slot->storage);
+  }
+
+  /// Give back storage from allocate(). The node must be destroyed.
+  /*
+   * O(1). The slot is reused by the next allocate().
+   */
+  void deallocate(Node *node) {
+    Slot *slot = reinterpret_cast<Slot *>(node);
+    slot->next_free = m_free;
+    m_free = slot;
+    m_num_free++;
+  }
+
+  /// Make sure n nodes can be allocated without calling Alloc.
+  /*
+   * Allocates at most one block.
+   * @param n - the number of nodes.
+   */
+  void reserve(const size_t &n) {
+    size_t available = this->available();
+    if (available < n) {
+      this->add_block(n - available);
+    }
+  }
+
+  /// Get the number of nodes that can be allocated without calling Alloc.
+  size_t available() const {
+    return m_num_free + size_t(m_end_unused - m_next_unused);
+  }
+
+  /// Get the number of node slots in all blocks, used or not.
+  size_t capacity() const { return m_num_slots; }
+
+  /// Exchange blocks, free lists and allocators with other in O(1).
+  void swap(node_pool &other) noexcept {
+    exchange(m_alloc, other.m_alloc);
+    exchange(m_blocks, other.m_blocks);
+    exchange(m_free, other.m_free);
+    exchange(m_next_unused, other.m_next_unused);
+    exchange(m_end_unused, other.m_end_unused);
+    exchange(m_num_free, other.m_num_free);
+    exchange(m_num_slots, other.m_num_slots);
+    exchange(m_slots_per_block, other.m_slots_per_block);
+  }
+
+  /// Take over every block of other, with the nodes in them.
+  /*
+   * O(blocks + free slots of other). Nodes allocated from other are
+   * deallocated to this pool from then on, and other is left empty.
+   * The two allocators must compare equal.
+   */
+  void merge(node_pool &other) {
+    if (other.m_blocks == nullptr) {
+      return;
+    }
+    // Keep the longer run of unused slots; the other one is freed.
+    if (other.m_end_unused - other.m_next_unused >
+        m_end_unused - m_next_unused) {
+      exchange(m_next_unused, other.m_next_unused);
+      exchange(m_end_unused, other.m_end_unused);
+    }
+    while (other.m_next_unused != other.m_end_unused) {
+      other.m_end_unused--;
+      this->deallocate(reinterpret_cast<Node *>(other.m_end_unused->storage));
+    }
+    if (other.m_free != nullptr) {
+      Slot *last_free = other.m_free;
+      while (last_free->next_free != nullptr) {
+        last_free = last_free->next_free;
+      }
+      last_free->next_free = m_free;
+      m_free = other.m_free;
+      m_num_free += other.m_num_free;
+    }
+    BlockHeader *last_block = other.m_blocks;
+    while (last_block->next != nullptr) {
+      last_block = last_block->next;
+    }
+    last_block->next = m_blocks;
+    m_blocks = other.m_blocks;
+    m_num_slots += other.m_num_slots;
+    other.m_blocks = nullptr;
+    other.m_free = nullptr;
+    other.m_num_free = 0;
+    other.m_num_slots = 0;
+  }
+
+  /// Get a copy of the allocator.
+  Alloc get_allocator() const { return Alloc(m_alloc); }
+
+private:
+  template <typename V> static void exchange(V &a, V &b) {
+    V tmp = std::move(a);
+    a = std::move(b);
+    b = std::move(tmp);
+  }
+
+  /// Allocate a block with room for at least num_slots nodes.
+  /*
+   * Any unused slots of the current block go on the free list first,
+   * so nothing is lost.
+   */
+  void add_block(const size_t &num_slots) {
+    size_t bytes = slot_offset + num_slots * sizeof(Slot);
+    size_t num_lines = (bytes + sizeof(CacheLine) - 1) / sizeof(CacheLine);
+    CacheLine *lines = block_traits::allocate(m_alloc, num_lines);
+    while (m_next_unused != m_end_unused) {
+      m_end_unused--;
+      this->deallocate(reinterpret_cast<Node *>(m_end_unused->storage));
+    }
+    BlockHeader *block = reinterpret_cast<BlockHeader *>(lines);
+    block->next = m_blocks;
+    block->num_lines = num_lines;
+    m_blocks = block;
+    unsigned char *first = reinterpret_cast<unsigned char *>(lines);
+    m_next_unused = reinterpret_cast<Slot *>(first + slot_offset);
+    m_end_unused = reinterpret_cast<Slot *>(
+        first + slot_offset +
+        (num_lines * sizeof(CacheLine) - slot_offset) / sizeof(Slot) *
+            sizeof(Slot));
+    m_num_slots += size_t(m_end_unused - m_next_unused);
+  }
+
+  block_allocator m_alloc;
+  BlockHeader *m_blocks;
+  Slot *m_free;
+  Slot *m_next_unused;
+  Slot *m_end_unused;
+  size_t m_num_free;
+  size_t m_num_slots;
+  size_t m_slots_per_block;
+};
+
+}; // namespace prac
@@ -0,0 +1,594 @@
+#pragma once
+#include "vector.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+
+/*
+ * Parallel algorithms over prac::vector, run on a work-stealing pool.
+ *
+ * Every algorithm takes a grain: the number of elements below which a
+ * range is no longer split. Zero picks one that gives each thread
+ * about eight pieces of work, which balances well when elements cost
+ * about the same. Use a smaller grain when they don't, and a larger
+ * one when the work per element is tiny. Every algorithm also takes
+ * the pool to run on, thread_pool::global() by default.
+ *
+ * The calling thread always takes part, so a pool of one thread runs
+ * everything on the caller, in order. If a body throws, the rest of
+ * the work is skipped where possible and the first exception is
+ * rethrown to the caller once every started piece has finished.
+ */
+
+namespace prac {
+namespace parallel {
+
+/// A fixed set of threads that split ranges of work between them.
+/*
+ * Each worker has a deque of pending ranges. A worker splits its
+ * range in halves until it is no bigger than the grain, pushing the
+ * second half of every split onto its own deque and carrying on with
+ * the first. Idle workers steal the oldest, i.e. largest, ranges from
+ * the front of other deques; owners pop the newest from the back,
+ * which keeps their working set in cache. Callers that aren't workers
+ * share one more deque, and help out until their own work is done.
+ */
+class thread_pool {
+public:
+  /// Start the worker threads.
+  /*
+   * @param num_threads - the number of threads that run work,
+   *                      counting the caller. Zero means one per
+   *                      hardware thread.
+   */
+  explicit thread_pool(size_t num_threads = 0)
+      : m_num_threads(num_threads), m_stop(false), m_queued(0),
+        m_sleeping(0) {
+    if (m_num_threads == 0) {
+      m_num_threads = std::thread::hardware_concurrency();
+    }
+    if (m_num_threads == 0) {
+      m_num_threads = 1;
+    }
+    // One deque per worker, and one for callers from outside.
+    m_queues.reset(new Queue[m_num_threads]);
+    m_workers.reset(new std::thread[m_num_threads - 1]);
+    for (size_t i = 0; i + 1 < m_num_threads; i++) {
+      m_workers[i] = std::thread([this, i]() { this->work(i); });
+    }
+  }
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  /// Stop and join the workers. No work may be running.
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(m_sleep_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i + 1 < m_num_threads; i++) {
+      m_workers[i].join();
+    }
+  }
+
+  /// The pool shared by default, with one thread per hardware thread.
+  static thread_pool &global() {
+    static thread_pool pool;
+    return pool;
+  }
+
+  /// Get the number of threads that run work, counting the caller.
+  size_t num_threads() const { return m_num_threads; }
+
+  /// Call body(first, last) on pieces of [begin, end) in parallel.
+  /*
+   * Returns once every piece is done. Pieces don't overlap, cover the
+   * range and are at most grain long. Safe to call from inside a body.
+   * @param begin - the start of the range.
+   * @param end - the end of the range.
+   * @param grain - the longest piece, at least 1.
+   * @param body - a callable taking the bounds of a piece.
+   */
+  template <typename Body>
+  void for_range(const size_t &begin, const size_t &end, const size_t &grain,
+                 const Body &body) {
+    if (begin >= end) {
+      return;
+    }
+    Group group;
+    Task task;
+    task.run = &thread_pool::invoke<Body>;
+    task.body = &body;
+    task.begin = begin;
+    task.end = end;
+    task.grain = grain == 0 ? 1 : grain;
+    task.group = &group;
+    size_t queue = this->current_queue();
+    this->execute(task, queue);
+    // Help with any work, ours or not, until ours is finished.
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+      if (this->find_task(queue, &task)) {
+        this->execute(task, queue);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    if (group.error) {
+      std::rethrow_exception(group.error);
+    }
+  }
+
+private:
+  /// Work shared by one for_range() call.
+  struct Group {
+    Group() : pending(1), failed(false) {}
+    /// Pieces handed out and not finished yet.
+    std::atomic<size_t> pending;
+    std::atomic<bool> failed;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+  };
+
+  /// A range still to be run, maybe after further splitting.
+  struct Task {
+    void (*run)(const void *body, size_t begin, size_t end);
+    const void *body;
+    size_t begin;
+    size_t end;
+    size_t grain;
+    Group *group;
+  };
+
+  /// A deque of tasks, padded so that neighbours don't share a line.
+  struct alignas(64) Queue {
+    Queue() : head(0), tail(0) {}
+    std::mutex mutex;
+    prac::vector<Task> tasks;
+    /// Tasks before head have been stolen, and tasks from tail on
+    /// taken back by the owner; their slots are reused.
+    size_t head;
+    size_t tail;
+  };
+
+  template <typename Body>
+  static void invoke(const void *body, size_t begin, size_t end) {
+    (*static_cast<const Body *>(body))(begin, end);
+  }
+
+  /// The worker this thread is, if any.
+  struct ThreadInfo {
+    thread_pool *pool;
+    size_t queue;
+  };
+
+  static ThreadInfo &this_thread() {
+    static thread_local ThreadInfo info = {nullptr, 0};
+    return info;
+  }
+
+  /// The deque this thread pushes to: its own if it's one of our
+  /// workers, the shared one otherwise.
+  size_t current_queue() const {
+    const ThreadInfo &info = this_thread();
+    return info.pool == this ? info.queue : m_num_threads - 1;
+  }
+
+  /// Split task down to the grain, queueing the halves, then run it.
+  void execute(Task task, const size_t &queue) {
+    while (task.end - task.begin > task.grain) {
+      size_t middle = task.begin + (task.end - task.begin) / 2;
+      Task second = task;
+      second.begin = middle;
+      task.end = middle;
+      task.group->pending.fetch_add(1, std::memory_order_relaxed);
+      this->push(queue, second);
+    }
+    Group *group = task.group;
+    if (!group->failed.load(std::memory_order_relaxed)) {
+      try {
+        task.run(task.body, task.begin, task.end);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(group->error_mutex);
+        if (!group->error) {
+          group->error = std::current_exception();
+        }
+        group->failed.store(true, std::memory_order_relaxed);
+      }
+    }
+    group->pending.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  void push(const size_t &queue, const Task &task) {
+    // Counted first, so the count never drops below the real number.
+    m_queued.fetch_add(1);
+    {
+      Queue &target = m_queues[queue];
+      std::lock_guard<std::mutex> lock(target.mutex);
+      if (target.tail < target.tasks.size()) {
+        target.tasks[target.tail] = task;
+      } else {
+        target.tasks.push_back(task);
+      }
+      target.tail++;
+    }
+    if (m_sleeping.load() > 0) {
+      std::lock_guard<std::mutex> lock(m_sleep_mutex);
+      m_wake.notify_one();
+    }
+  }
+
+  /// Pop the newest task of our own deque, or steal the oldest of
+  /// another one.
+  bool find_task(const size_t &queue, Task *task) {
+    if (m_queued.load() == 0) {
+      return false;
+    }
+    if (this->take(queue, task, false)) {
+      return true;
+    }
+    // Start the search at a random victim so thieves spread out.
+    static thread_local uint32_t state = 2463534242u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    size_t start = state % m_num_threads;
+    for (size_t i = 0; i < m_num_threads; i++) {
+      size_t victim = (start + i) % m_num_threads;
+      if (victim != queue && this->take(victim, task, true)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool take(const size_t &queue, Task *task, const bool &from_front) {
+    Queue &source = m_queues[queue];
+    std::lock_guard<std::mutex> lock(source.mutex);
+    if (source.head == source.tail) {
+      return false;
+    }
+    if (from_front) {
+      *task = source.tasks[source.head];
+      source.head++;
+    } else {
+      source.tail--;
+      *task = source.tasks[source.tail];
+    }
+    if (source.head == source.tail) {
+      source.head = 0;
+      source.tail = 0;
+    }
+    m_queued.fetch_sub(1);
+    return true;
+  }
+
+  void work(const size_t &queue) {
+    this_thread().pool = this;
+    this_thread().queue = queue;
+    Task task;
+    while (true) {
+      if (this->find_task(queue, &task)) {
+        this->execute(task, queue);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(m_sleep_mutex);
+      m_sleeping.fetch_add(1);
+      m_wake.wait(lock, [this]() { return m_stop || m_queued.load() > 0; });
+      m_sleeping.fetch_sub(1);
+      if (m_stop) {
+        return;
+      }
+    }
+  }
+
+  size_t m_num_threads;
+  std::unique_ptr<Queue[]> m_queues;
+  std::unique_ptr<std::thread[]> m_workers;
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wake;
+  bool m_stop;
+  /// Tasks in all deques.
+  std::atomic<size_t> m_queued;
+  /// Workers waiting on m_wake.
+  std::atomic<size_t> m_sleeping;
+};
+
+namespace detail {
+
+/// The grain to use for n elements when the caller passed grain.
+inline size_t pick_grain(const size_t &n, const size_t &grain,
+                         const thread_pool &pool) {
+  if (grain > 0) {
+    return grain;
+  }
+  size_t pieces = 8 * pool.num_threads();
+  size_t picked = (n + pieces - 1) / pieces;
+  return picked < 1024 ? 1024 : picked;
+}
+
+/// Construct n elements at first in pieces of at most grain, with
+/// construct(dst, begin, end) building elements begin to end at dst.
+/*
+ * construct must build a whole piece or, if it throws, none of it.
+ * If any piece throws, the pieces that were built are destroyed.
+ */
+template <typename T, typename Construct>
+void construct_pieces(T *first, const size_t &n, const size_t &grain,
+                      thread_pool &pool, const Construct &construct) {
+  size_t num_pieces = (n + grain - 1) / grain;
+  std::unique_ptr<std::atomic<bool>[]> built(
+      new std::atomic<bool>[num_pieces]);
+  for (size_t piece = 0; piece < num_pieces; piece++) {
+    built[piece].store(false, std::memory_order_relaxed);
+  }
+  try {
+    pool.for_range(0, num_pieces, 1, [&](size_t piece, size_t end_piece) {
+      for (; piece < end_piece; piece++) {
+        size_t begin = piece * grain;
+        size_t end = begin + grain < n ? begin + grain : n;
+        construct(first + begin, begin, end);
+        built[piece].store(true, std::memory_order_relaxed);
+      }
+    });
+  } catch (...) {
+    for (size_t piece = 0; piece < num_pieces; piece++) {
+      if (built[piece].load(std::memory_order_relaxed)) {
+        size_t begin = piece * grain;
+        size_t end = begin + grain < n ? begin + grain : n;
+        prac::detail::destroy(first + begin, end - begin);
+      }
+    }
+    throw;
+  }
+}
+
+/// Find how many of the first k elements of merging left and right
+/// come from left. Ties go to left, as in std::merge.
+template <typename T, typename Compare>
+size_t merge_split(const size_t &k, const T *left, const size_t &num_left,
+                   const T *right, const size_t &num_right,
+                   const Compare &comp) {
+  size_t low = k > num_right ? k - num_right : 0;
+  size_t high = k < num_left ? k : num_left;
+  // The answer is the smallest i with right[k - i - 1] < left[i].
+  while (low < high) {
+    size_t i = low + (high - low) / 2;
+    if (comp(right[k - i - 1], left[i])) {
+      high = i;
+    } else {
+      low = i + 1;
+    }
+  }
+  return low;
+}
+
+}; // namespace detail
+
+/// Call body(i) for every i in [begin, end).
+template <typename Body>
+void parallel_for(const size_t &begin, const size_t &end, const Body &body,
+                  const size_t &grain = 0,
+                  thread_pool &pool = thread_pool::global()) {
+  size_t n = end > begin ? end - begin : 0;
+  pool.for_range(begin, end, detail::pick_grain(n, grain, pool),
+                 [&body](size_t first, size_t last) {
+                   for (size_t i = first; i < last; i++) {
+                     body(i);
+                   }
+                 });
+}
+
+/// Call body(element) for every element of vec.
+template <typename T, typename Alloc, typename Growth, typename Body>
+void parallel_for(vector<T, Alloc, Growth> &vec, const Body &body,
+                  const size_t &grain = 0,
+                  thread_pool &pool = thread_pool::global()) {
+  T *data = vec.data();
+  parallel::parallel_for(
+      0, vec.size(), [data, &body](size_t i) { body(data[i]); }, grain, pool);
+}
+
+/// Combine init and every element of vec with op.
+/*
+ * op must be associative. Each piece is reduced on its own, starting
+ * from its first element, and the results are then combined in
+ * order, so the result doesn't depend on scheduling.
+ * @return op(...op(op(init, vec[0]), vec[1])..., vec[n - 1]), up to
+ *         associativity.
+ */
+template <typename T, typename Alloc, typename Growth, typename Op>
+T parallel_reduce(const vector<T, Alloc, Growth> &vec, T init, const Op &op,
+                  const size_t &grain = 0,
+                  thread_pool &pool = thread_pool::global()) {
+  size_t n = vec.size();
+  if (n == 0) {
+    return init;
+  }
+  size_t piece_size = detail::pick_grain(n, grain, pool);
+  size_t num_pieces = (n + piece_size - 1) / piece_size;
+  const T *data = vec.data();
+  vector<T> partials;
+  partials.reserve(num_pieces);
+  partials.resize_with(num_pieces, [&](T *first, const size_t &) {
+    detail::construct_pieces(
+        first, num_pieces, 1, pool, [&](T *dst, size_t piece, size_t) {
+          size_t begin = piece * piece_size;
+          size_t end = begin + piece_size < n ? begin + piece_size : n;
+          T result = data[begin];
+          for (size_t i = begin + 1; i < end; i++) {
+            result = op(result, data[i]);
+          }
+          new (dst) T(std::move(result));
+        });
+  });
+  for (size_t i = 0; i < num_pieces; i++) {
+    init = op(init, partials[i]);
+  }
+  return init;
+}
+
+/// Set out to op(element) for every element of in.
+/*
+ * The results are constructed straight into out's storage.
+ * @param in - the input. Must not be out.
+ * @param out - replaced by the results.
+ */
+template <typename T, typename AllocIn, typename GrowthIn, typename U,
+          typename AllocOut, typename GrowthOut, typename Op>
+void parallel_transform(const vector<T, AllocIn, GrowthIn> &in,
+                        vector<U, AllocOut, GrowthOut> &out, const Op &op,
+                        const size_t &grain = 0,
+                        thread_pool &pool = thread_pool::global()) {
+  size_t n = in.size();
+  const T *data = in.data();
+  out.clear();
+  out.reserve(n);
+  out.resize_with(n, [&](U *first, const size_t &) {
+    detail::construct_pieces(
+        first, n, detail::pick_grain(n, grain, pool), pool,
+        [&](U *dst, size_t begin, size_t end) {
+          size_t i = begin;
+          try {
+            for (; i < end; i++) {
+              new (dst + (i - begin)) U(op(data[i]));
+            }
+          } catch (...) {
+            prac::detail::destroy(dst, i - begin);
+            throw;
+          }
+        });
+  });
+}
+
+/// Set every element of vec to value.
+template <typename T, typename Alloc, typename Growth>
+void parallel_fill(vector<T, Alloc, Growth> &vec, const T &value,
+                   const size_t &grain = 0,
+                   thread_pool &pool = thread_pool::global()) {
+  parallel::parallel_for(vec, [&value](T &elem) { elem = value; }, grain,
+                         pool);
+}
+
+/// Make vec hold n copies of value, like the fill constructor.
+/*
+ * Existing elements are destroyed, then the copies are constructed
+ * in parallel into storage of exactly n elements, unless there
+ * already was enough.
+ */
+template <typename T, typename Alloc, typename Growth>
+void parallel_fill(vector<T, Alloc, Growth> &vec, const size_t &n,
+                   const T &value, const size_t &grain = 0,
+                   thread_pool &pool = thread_pool::global()) {
+  vec.clear();
+  vec.reserve(n);
+  vec.resize_with(n, [&](T *first, const size_t &) {
+    detail::construct_pieces(first, n, detail::pick_grain(n, grain, pool),
+                             pool, [&value](T *dst, size_t begin, size_t end) {
+                               prac::detail::uninitialized_fill(
+                                   dst, end - begin, value);
+                             });
+  });
+}
+
+/// Sort vec.
+/*
+ * Pieces of the vector are sorted in parallel with std::sort, then
+ * merged pairwise in rounds. Each merge is itself split into pieces
+ * of at most grain outputs, so every round uses every thread. Not
+ * stable. Needs a buffer of n elements, built by copying vec.
+ * @param comp - the strict weak ordering to sort by.
+ */
+template <typename T, typename Alloc, typename Growth,
+          typename Compare = std::less<T>>
+void parallel_sort(vector<T, Alloc, Growth> &vec,
+                   const Compare &comp = Compare(), const size_t &grain = 0,
+                   thread_pool &pool = thread_pool::global()) {
+  size_t n = vec.size();
+  size_t piece_size = detail::pick_grain(n, grain, pool);
+  if (n <= piece_size || pool.num_threads() == 1) {
+    std::sort(vec.begin(), vec.end(), comp);
+    return;
+  }
+  size_t num_runs = (n + piece_size - 1) / piece_size;
+  T *data = vec.data();
+  pool.for_range(0, num_runs, 1, [&](size_t run, size_t end_run) {
+    for (; run < end_run; run++) {
+      size_t begin = run * piece_size;
+      size_t end = begin + piece_size < n ? begin + piece_size : n;
+      std::sort(data + begin, data + end, comp);
+    }
+  });
+
+  vector<T, Alloc, Growth> buffer(vec.get_allocator());
+  parallel_transform(vec, buffer, [](const T &elem) { return elem; }, grain,
+                     pool);
+  T *source = data;
+  T *target = buffer.data();
+  // Where each piece of the output starts in the left run of its
+  // pair. All of them are found before any element is moved, since
+  // moved-from elements can't be compared.
+  size_t num_pieces = (n + piece_size - 1) / piece_size;
+  std::unique_ptr<size_t[]> splits(new size_t[num_pieces]);
+  for (size_t run_size = piece_size; run_size < n; run_size *= 2) {
+    // Merge runs pairwise, splitting the output of all merges into
+    // pieces of piece_size. Pieces never straddle two pairs, since
+    // piece_size divides run_size.
+    auto bounds = [&](const size_t &piece, size_t *pair_begin,
+                      size_t *middle, size_t *pair_end) {
+      *pair_begin = piece * piece_size / (2 * run_size) * (2 * run_size);
+      *middle = *pair_begin + run_size < n ? *pair_begin + run_size : n;
+      *pair_end = *middle + run_size < n ? *middle + run_size : n;
+    };
+    pool.for_range(0, num_pieces, 1, [&](size_t piece, size_t end_piece) {
+      for (; piece < end_piece; piece++) {
+        size_t pair_begin, middle, pair_end;
+        bounds(piece, &pair_begin, &middle, &pair_end);
+        splits[piece] = detail::merge_split(
+            piece * piece_size - pair_begin, source + pair_begin,
+            middle - pair_begin, source + middle, pair_end - middle, comp);
+      }
+    });
+    pool.for_range(0, num_pieces, 1, [&](size_t piece, size_t end_piece) {
+      for (; piece < end_piece; piece++) {
+        size_t pair_begin, middle, pair_end;
+        bounds(piece, &pair_begin, &middle, &pair_end);
+        size_t out_begin = piece * piece_size;
+        size_t out_end =
+            out_begin + piece_size < n ? out_begin + piece_size : n;
+        size_t left_begin = splits[piece];
+        size_t left_end = out_end == pair_end ? middle - pair_begin
+                                              : splits[piece + 1];
+        T *left = source + pair_begin;
+        T *right = source + middle;
+        size_t first_k = out_begin - pair_begin;
+        size_t last_k = out_end - pair_begin;
+        std::merge(std::make_move_iterator(left + left_begin),
+                   std::make_move_iterator(left + left_end),
+                   std::make_move_iterator(right + (first_k - left_begin)),
+                   std::make_move_iterator(right + (last_k - left_end)),
+                   target + out_begin, comp);
+      }
+    });
+    T *swapped = source;
+    source = target;
+    target = swapped;
+  }
+  if (source != data) {
+    parallel::parallel_for(
+        0, n, [&](size_t i) { data[i] = std::move(source[i]); }, piece_size,
+        pool);
+  }
+}
+
+}; // namespace parallel
+}; // namespace prac
@@ -0,0 +1,669 @@
+#pragma once
+#include "hazard.hpp"
+#include "memory.hpp"
+#include <atomic>
+#include <iterator>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace prac {
+
+template <typename T> class transient_vector;
+template <typename T> class atomic_persistent_vector;
+
+/*
+ * An immutable vector whose updates return new versions that share
+ * most of their storage with the old ones.
+ *
+ * The elements live in a trie of nodes 32 wide: leaves hold 32
+ * elements, branches 32 children, so an index is looked up 5 bits at
+ * a time, in at most 7 steps for 2^32 elements. The last 1 to 32
+ * elements are kept in a separate tail leaf, so push_back() usually
+ * copies only the tail. set() copies the path from the root to one
+ * leaf, O(log32 n); everything off that path is shared. Nodes are
+ * reference counted, atomically, so versions can be read and
+ * released from any thread.
+ *
+ * The trie is always packed to the left, radix balanced, which is the
+ * regular case of an RRB tree: there is no concatenation or insertion
+ * in the middle, so no node is ever left partly full and no size
+ * tables are needed.
+ *
+ * Copying a version, i.e. taking a snapshot, is O(1) and allocates
+ * nothing: versions are a pointer to a reference-counted header. For
+ * many updates at once, transient() gives a transient_vector that
+ * edits the nodes only it can see in place. atomic_persistent_vector
+ * publishes versions to reader threads without locks.
+ */
+template <typename T> class persistent_vector {
+public:
+  typedef T value_type;
+
+  /// Construction of an empty vector. Allocates nothing.
+  persistent_vector() : m_data(nullptr) {}
+
+  /// Take a snapshot: O(1), and shares everything.
+  persistent_vector(const persistent_vector &other) : m_data(other.m_data) {
+    acquire(m_data);
+  }
+
+  persistent_vector(persistent_vector &&other) noexcept
+      : m_data(other.m_data) {
+    other.m_data = nullptr;
+  }
+
+  persistent_vector &operator=(const persistent_vector &other) {
+    acquire(other.m_data);
+    release(m_data);
+    m_data = other.m_data;
+    return *this;
+  }
+
+  persistent_vector &operator=(persistent_vector &&other) noexcept {
+    if (this != &other) {
+      release(m_data);
+      m_data = other.m_data;
+      other.m_data = nullptr;
+    }
+    return *this;
+  }
+
+  ~persistent_vector() { release(m_data); }
+
+  /// Get a version with one more element at the back.
+  /*
+   * O(log32 n): the tail is copied, and when it is full, one path of
+   * the trie.
+   * @param new_elem - the element to add.
+   * @return the new version. This one is unchanged.
+   */
+  persistent_vector push_back(const T &new_elem) const {
+    transient_vector<T> edit = this->transient();
+    edit.push_back(new_elem);
+    return edit.persistent();
+  }
+
+  /// Get a version with element i replaced.
+  /*
+   * O(log32 n): the path from the root to the leaf holding i is
+   * copied.
+   * @param i - an index less than size().
+   * @param new_elem - the new value.
+   * @return the new version. This one is unchanged.
+   */
+  persistent_vector set(const size_t &i, const T &new_elem) const {
+    transient_vector<T> edit = this->transient();
+    edit.set(i, new_elem);
+    return edit.persistent();
+  }
+
+  /// Get a transient copy, for many updates at once.
+  /*
+   * O(1). The transient starts out sharing everything with this
+   * version, and copies a node the first time it changes it; after
+   * that it changes the copy in place.
+   */
+  transient_vector<T> transient() const {
+    if (m_data == nullptr) {
+      return transient_vector<T>();
+    }
+    acquire_node(m_data->root);
+    acquire_node(m_data->tail);
+    return transient_vector<T>(m_data->size, m_data->shift, m_data->root,
+                               m_data->tail);
+  }
+
+  /// Get element i.
+  /*
+   * O(log32 n), and O(1) for the last 32 elements.
+   */
+  const T &operator[](const size_t &i) const {
+    return leaf_for(m_data->size, m_data->shift, m_data->root, m_data->tail,
+                    i)[i & mask];
+  }
+
+  /// Get the number of elements.
+  size_t size() const { return m_data == nullptr ? 0 : m_data->size; }
+
+  /// Whether there are no elements.
+  bool empty() const { return this->size() == 0; }
+
+  /// Whether two versions are the same object, rather than equal.
+  bool same_version(const persistent_vector &other) const {
+    return m_data == other.m_data;
+  }
+
+  /// Iterates in order, a leaf of 32 elements at a time.
+  class const_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+
+    const_iterator() : m_vec(nullptr), m_index(0), m_leaf(nullptr) {}
+    const_iterator(const persistent_vector *vec, const size_t &index)
+        : m_vec(vec), m_index(index), m_leaf(nullptr) {}
+
+    reference operator*() const {
+      // Look the leaf up only when crossing into a new one.
+      if (m_leaf == nullptr || m_index >> bits != m_leaf_index) {
+        m_leaf = &(*m_vec)[m_index & ~size_t(mask)];
+        m_leaf_index = m_index >> bits;
+      }
+      return m_leaf[m_index & mask];
+    }
+    pointer operator->() const { return &**this; }
+    reference operator[](const difference_type &n) const {
+      return (*m_vec)[m_index + n];
+    }
+
+    const_iterator &operator++() {
+      m_index++;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      m_index++;
+      return old;
+    }
+    const_iterator &operator--() {
+      m_index--;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      m_index--;
+      return old;
+    }
+    const_iterator &operator+=(const difference_type &n) {
+      m_index += n;
+      return *this;
+    }
+    const_iterator &operator-=(const difference_type &n) {
+      m_index -= n;
+      return *this;
+    }
+    const_iterator operator+(const difference_type &n) const {
+      return const_iterator(m_vec, m_index + n);
+    }
+    const_iterator operator-(const difference_type &n) const {
+      return const_iterator(m_vec, m_index - n);
+    }
+    difference_type operator-(const const_iterator &other) const {
+      return difference_type(m_index) - difference_type(other.m_index);
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return m_index == other.m_index;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return m_index != other.m_index;
+    }
+    bool operator<(const const_iterator &other) const {
+      return m_index < other.m_index;
+    }
+    bool operator>(const const_iterator &other) const {
+      return m_index > other.m_index;
+    }
+    bool operator<=(const const_iterator &other) const {
+      return m_index <= other.m_index;
+    }
+    bool operator>=(const const_iterator &other) const {
+      return m_index >= other.m_index;
+    }
+
+  private:
+    const persistent_vector *m_vec;
+    size_t m_index;
+    mutable const T *m_leaf;
+    mutable size_t m_leaf_index;
+  };
+
+  typedef const_iterator iterator;
+
+  /// Iterators. A version never changes, so they stay valid as long
+  /// as the version does.
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, this->size()); }
+  const_iterator cbegin() const { return this->begin(); }
+  const_iterator cend() const { return this->end(); }
+
+private:
+  friend class transient_vector<T>;
+  friend class atomic_persistent_vector<T>;
+
+  static constexpr size_t bits = 5;
+  static constexpr size_t width = size_t(1) << bits;
+  static constexpr size_t mask = width - 1;
+
+  /// What leaves and branches start with.
+  struct Node {
+    std::atomic<size_t> refs;
+    /// The values constructed, for a leaf; the children, for a branch.
+    size_t count;
+    /// The transient_vector that may change the node in place, or 0.
+    uint64_t owner;
+  };
+
+  struct Branch : Node {
+    Node *children[width];
+  };
+
+  struct Leaf : Node {
+    alignas(T) unsigned char storage[width * sizeof(T)];
+
+    T *values() { return reinterpret_cast<T *>(storage); }
+  };
+
+  /// One version: the trie, the tail and the size.
+  struct Data {
+    std::atomic<size_t> refs;
+    size_t size;
+    /// The number of index bits below the root, a multiple of 5.
+    size_t shift;
+    /// nullptr while every element fits in the tail.
+    Branch *root;
+    Leaf *tail;
+  };
+
+  explicit persistent_vector(Data *data) : m_data(data) {}
+
+  static void acquire(Data *data) {
+    if (data != nullptr) {
+      data->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  static void release(Data *data) {
+    if (data == nullptr ||
+        data->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    release_node(data->root, data->shift);
+    release_node(data->tail, 0);
+    detail::deallocate_storage(data);
+  }
+
+  static void release_erased(void *data) {
+    release(static_cast<Data *>(data));
+  }
+
+  static void acquire_node(Node *node) {
+    if (node != nullptr) {
+      node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /// Drop a reference to a node at level (0 for leaves), and free it
+  /// and what only it refers to if it was the last.
+  static void release_node(Node *node, const size_t &level) {
+    if (node == nullptr ||
+        node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    if (level == 0) {
+      Leaf *leaf = static_cast<Leaf *>(node);
+      detail::destroy(leaf->values(), leaf->count);
+      detail::deallocate_storage(leaf);
+      return;
+    }
+    Branch *branch = static_cast<Branch *>(node);
+    for (size_t i = 0; i < branch->count; i++) {
+      release_node(branch->children[i], level - bits);
+    }
+    detail::deallocate_storage(branch);
+  }
+
+  static Data *make_data(const size_t &size, const size_t &shift,
+                         Branch *root, Leaf *tail) {
+    Data *data = new (detail::allocate_storage<Data>(1)) Data;
+    data->refs.store(1, std::memory_order_relaxed);
+    data->size = size;
+    data->shift = shift;
+    data->root = root;
+    data->tail = tail;
+    return data;
+  }
+
+  /// The index of the first element in the tail.
+  static size_t tail_offset(const size_t &size) {
+    return size < width ? 0 : ((size - 1) >> bits) << bits;
+  }
+
+  /// Get the values of the leaf holding element i.
+  static const T *leaf_for(const size_t &size, const size_t &shift,
+                           Node *root, Leaf *tail, const size_t &i) {
+    if (i >= tail_offset(size)) {
+      return tail->values();
+    }
+    Node *node = root;
+    for (size_t level = shift; level > 0; level -= bits) {
+      node = static_cast<Branch *>(node)->children[(i >> level) & mask];
+    }
+    return static_cast<Leaf *>(node)->values();
+  }
+
+  Data *m_data;
+};
+
+/*
+ * A persistent_vector being edited in place, for bulk updates.
+ *
+ * It shares nodes with the version it came from until it changes
+ * them: the first change to a node copies it, tagged as belonging to
+ * this transient, and later changes go to the copy directly. So
+ * pushing n elements costs O(n) plus one copy of the tail, rather
+ * than a copy of the tail per element.
+ *
+ * A transient belongs to one thread. persistent() turns what it has
+ * built into a version in O(1) and leaves it empty.
+ */
+template <typename T> class transient_vector {
+  typedef persistent_vector<T> pv;
+  typedef typename pv::Node Node;
+  typedef typename pv::Branch Branch;
+  typedef typename pv::Leaf Leaf;
+  static constexpr size_t bits = pv::bits;
+  static constexpr size_t width = pv::width;
+  static constexpr size_t mask = pv::mask;
+
+public:
+  typedef T value_type;
+
+  /// Construction of an empty transient.
+  transient_vector()
+      : m_owner(next_owner()), m_size(0), m_shift(bits), m_root(nullptr),
+        m_tail(nullptr) {}
+
+  transient_vector(const transient_vector &) = delete;
+  transient_vector &operator=(const transient_vector &) = delete;
+
+  transient_vector(transient_vector &&other) noexcept
+      : m_owner(other.m_owner), m_size(other.m_size), m_shift(other.m_shift),
+        m_root(other.m_root), m_tail(other.m_tail) {
+    other.m_owner = next_owner();
+    other.reset();
+  }
+
+  ~transient_vector() { this->release_all(); }
+
+  /// Add an element at the back.
+  /*
+   * Amortized O(1): in place once the tail belongs to this transient,
+   * plus one path of the trie every 32 elements.
+   * @param new_elem - the element to add.
+   */
+  void push_back(const T &new_elem) {
+    size_t in_tail = m_size - pv::tail_offset(m_size);
+    if (m_tail != nullptr && in_tail < width) {
+      m_tail = this->editable_leaf(m_tail);
+      new (m_tail->values() + in_tail) T(new_elem);
+      m_tail->count++;
+      m_size++;
+      return;
+    }
+    Leaf *new_tail = this->new_leaf();
+    try {
+      new (new_tail->values()) T(new_elem);
+    } catch (...) {
+      detail::deallocate_storage(new_tail);
+      throw;
+    }
+    new_tail->count = 1;
+    if (m_tail != nullptr) {
+      try {
+        this->push_tail();
+      } catch (...) {
+        pv::release_node(new_tail, 0);
+        throw;
+      }
+    }
+    m_tail = new_tail;
+    m_size++;
+  }
+
+  /// Replace element i.
+  /*
+   * O(log32 n), in place on the nodes this transient has copied
+   * already.
+   * @param i - an index less than size().
+   * @param new_elem - the new value.
+   */
+  void set(const size_t &i, const T &new_elem) {
+    if (i >= pv::tail_offset(m_size)) {
+      m_tail = this->editable_leaf(m_tail);
+      m_tail->values()[i & mask] = new_elem;
+      return;
+    }
+    m_root = this->editable_branch(m_root, m_shift);
+    Branch *branch = m_root;
+    for (size_t level = m_shift; level > bits; level -= bits) {
+      Node *&child = branch->children[(i >> level) & mask];
+      child = this->editable_branch(static_cast<Branch *>(child),
+                                    level - bits);
+      branch = static_cast<Branch *>(child);
+    }
+    Node *&leaf = branch->children[(i >> bits) & mask];
+    leaf = this->editable_leaf(static_cast<Leaf *>(leaf));
+    static_cast<Leaf *>(leaf)->values()[i & mask] = new_elem;
+  }
+
+  /// Get element i.
+  const T &operator[](const size_t &i) const {
+    return pv::leaf_for(m_size, m_shift, m_root, m_tail, i)[i & mask];
+  }
+
+  /// Get the number of elements.
+  size_t size() const { return m_size; }
+
+  /// Turn what has been built into a version.
+  /*
+   * O(1). The transient is left empty, and can be used again.
+   * @return the new version.
+   */
+  pv persistent() {
+    if (m_size == 0) {
+      this->release_all();
+      return pv();
+    }
+    // From now on the version shares these nodes, so they must not be
+    // changed in place any more.
+    typename pv::Data *data = pv::make_data(m_size, m_shift, m_root, m_tail);
+    m_owner = next_owner();
+    this->reset();
+    return pv(data);
+  }
+
+private:
+  friend class persistent_vector<T>;
+
+  transient_vector(const size_t &size, const size_t &shift, Branch *root,
+                   Leaf *tail)
+      : m_owner(next_owner()), m_size(size), m_shift(shift), m_root(root),
+        m_tail(tail) {}
+
+  /// Transients are told apart by a number that is never reused, so
+  /// a node tagged by one that has been made persistent is never
+  /// changed again.
+  static uint64_t next_owner() {
+    static std::atomic<uint64_t> counter(0);
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  void reset() {
+    m_size = 0;
+    m_shift = bits;
+    m_root = nullptr;
+    m_tail = nullptr;
+  }
+
+  void release_all() {
+    pv::release_node(m_root, m_shift);
+    pv::release_node(m_tail, 0);
+    this->reset();
+  }
+
+  Leaf *new_leaf() {
+    Leaf *leaf = new (detail::allocate_storage<Leaf>(1)) Leaf;
+    leaf->refs.store(1, std::memory_order_relaxed);
+    leaf->count = 0;
+    leaf->owner = m_owner;
+    return leaf;
+  }
+
+  Branch *new_branch() {
+    Branch *branch = new (detail::allocate_storage<Branch>(1)) Branch;
+    branch->refs.store(1, std::memory_order_relaxed);
+    branch->count = 0;
+    branch->owner = m_owner;
+    return branch;
+  }
+
+  /// Get a leaf this transient may change: leaf itself if it is ours,
+  /// otherwise a copy, with our reference to leaf dropped.
+  Leaf *editable_leaf(Leaf *leaf) {
+    if (leaf->owner == m_owner) {
+      return leaf;
+    }
+    Leaf *copy = this->new_leaf();
+    try {
+      detail::uninitialized_copy(copy->values(),
+                                 const_cast<const T *>(leaf->values()),
+                                 leaf->count);
+    } catch (...) {
+      detail::deallocate_storage(copy);
+      throw;
+    }
+    copy->count = leaf->count;
+    pv::release_node(leaf, 0);
+    return copy;
+  }
+
+  /// Get a branch at level this transient may change, as
+  /// editable_leaf(). The copy shares the children.
+  Branch *editable_branch(Branch *branch, const size_t &level) {
+    if (branch->owner == m_owner) {
+      return branch;
+    }
+    Branch *copy = this->new_branch();
+    for (size_t i = 0; i < branch->count; i++) {
+      copy->children[i] = branch->children[i];
+      pv::acquire_node(branch->children[i]);
+    }
+    copy->count = branch->count;
+    // Ours may be the last reference, if the version this transient
+    // came from is gone: then the branch's own references to the
+    // children go with it, and the copy's keep them alive.
+    pv::release_node(branch, level);
+    return copy;
+  }
+
+  /// Move the full tail into the trie.
+  void push_tail() {
+    Leaf *tail = m_tail;
+    // The index of the first element of the tail.
+    size_t offset = m_size - width;
+    if (m_root == nullptr) {
+      m_root = this->new_branch();
+    } else if ((offset >> m_shift) >= width) {
+      // The trie is full: grow a level.
+      Branch *new_root = this->new_branch();
+      new_root->children[0] = m_root;
+      new_root->count = 1;
+      m_root = new_root;
+      m_shift += bits;
+    }
+    // Walk down, copying or creating the branches on the path.
+    m_root = this->editable_branch(m_root, m_shift);
+    Branch *branch = m_root;
+    for (size_t level = m_shift; level > bits; level -= bits) {
+      size_t index = (offset >> level) & mask;
+      if (index < branch->count) {
+        Node *&child = branch->children[index];
+        child = this->editable_branch(static_cast<Branch *>(child),
+                                      level - bits);
+        branch = static_cast<Branch *>(child);
+      } else {
+        Branch *child = this->new_branch();
+        branch->children[index] = child;
+        branch->count++;
+        branch = child;
+      }
+    }
+    branch->children[(offset >> bits) & mask] = tail;
+    branch->count++;
+  }
+
+  uint64_t m_owner;
+  size_t m_size;
+  size_t m_shift;
+  Branch *m_root;
+  Leaf *m_tail;
+};
+
+/// A persistent_vector that one thread can replace while others read
+/// it, without locks.
+/*
+ * load() takes a snapshot of the current version; store() replaces
+ * it. Readers hold on to their snapshot for as long as they like, and
+ * a version is freed once the last snapshot of it is gone. The old
+ * version's reference is handed to the global hazard_domain, so a
+ * reader that has just loaded the pointer can still take its
+ * reference. Both are lock-free; stores from several threads must be
+ * serialized by the caller if each builds on the last.
+ */
+template <typename T> class atomic_persistent_vector {
+  typedef persistent_vector<T> pv;
+
+public:
+  /// Construction holding a version.
+  explicit atomic_persistent_vector(const pv &initial = pv())
+      : m_data(initial.m_data) {
+    pv::acquire(initial.m_data);
+  }
+
+  atomic_persistent_vector(const atomic_persistent_vector &) = delete;
+  atomic_persistent_vector &
+  operator=(const atomic_persistent_vector &) = delete;
+
+  /// No other thread may use it any more.
+  ~atomic_persistent_vector() {
+    pv::release(m_data.load(std::memory_order_relaxed));
+  }
+
+  /// Take a snapshot of the current version.
+  /*
+   * Lock-free, O(1), and allocates nothing.
+   */
+  pv load() const {
+    hazard_domain &domain = hazard_domain::global();
+    typename pv::Data *data = domain.protect(0, m_data);
+    // The hazard keeps the store() that replaces data from dropping
+    // its reference until we have ours.
+    pv::acquire(data);
+    domain.clear(0);
+    return pv(data);
+  }
+
+  /// Make version the current one.
+  /*
+   * Lock-free. Readers that loaded the old version keep it.
+   * @param version - the new version.
+   */
+  void store(const pv &version) {
+    pv::acquire(version.m_data);
+    typename pv::Data *old =
+        m_data.exchange(version.m_data, std::memory_order_acq_rel);
+    if (old != nullptr) {
+      hazard_domain::global().retire(old, &pv::release_erased);
+    }
+  }
+
+private:
+  std::atomic<typename pv::Data *> m_data;
+};
+}; // namespace prac
@@ -0,0 +1,327 @@
+#pragma once
+#include "memory.hpp"
+#include "span.hpp"
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+namespace prac {
+
+/// The N of a ring_buffer whose capacity is picked at construction.
+constexpr size_t dynamic_capacity = 0;
+
+/// Which threads may use a ring_buffer.
+enum class ring_sync {
+  /// One thread at a time.
+  single_thread,
+  /// One thread pushing and another popping, concurrently. Each side
+  /// is wait-free: it never waits for the other, it only finds the
+  /// buffer full or empty.
+  spsc,
+};
+
+namespace detail {
+
+/// Where a ring_buffer keeps its elements: inline for a fixed N.
+template <typename T, size_t N> class ring_storage {
+  static_assert((N & (N - 1)) == 0,
+                "ring_buffer capacity must be a power of 2");
+
+public:
+  ring_storage() = default;
+  ring_storage(const ring_storage &) = delete;
+  ring_storage &operator=(const ring_storage &) = delete;
+
+  T *slots() { return reinterpret_cast<T *>(m_storage); }
+  static constexpr size_t capacity() { return N; }
+
+private:
+  alignas(T) unsigned char m_storage[N * sizeof(T)];
+};
+
+/// Where a ring_buffer keeps its elements: on the heap for a capacity
+/// picked at construction.
+template <typename T> class ring_storage<T, dynamic_capacity> {
+public:
+  /// Rounds capacity up to a power of two.
+  explicit ring_storage(const size_t &capacity) : m_capacity(1) {
+    while (m_capacity < capacity) {
+      m_capacity *= 2;
+    }
+    m_slots = allocate_storage<T>(m_capacity);
+  }
+  ring_storage(const ring_storage &) = delete;
+  ring_storage &operator=(const ring_storage &) = delete;
+  ~ring_storage() { deallocate_storage(m_slots); }
+
+  T *slots() { return m_slots; }
+  size_t capacity() const { return m_capacity; }
+
+private:
+  T *m_slots;
+  size_t m_capacity;
+};
+
+/// An index only one thread uses.
+template <ring_sync Sync> struct ring_index {
+  size_t value;
+
+  size_t load(std::memory_order) const { return value; }
+  void store(const size_t &new_value, std::memory_order) { value = new_value; }
+};
+
+/// An index written by one thread and read by the other.
+template <> struct ring_index<ring_sync::spsc> {
+  std::atomic<size_t> value;
+
+  size_t load(std::memory_order order) const { return value.load(order); }
+  void store(const size_t &new_value, std::memory_order order) {
+    value.store(new_value, order);
+  }
+};
+
+}; // namespace detail
+
+/*
+ * A FIFO queue of fixed capacity, a power of two, in one array.
+ *
+ * head and tail count every element ever popped and pushed, and a
+ * slot is found by masking with capacity - 1, so the buffer wraps
+ * around without a division or a branch, and full and empty are told
+ * apart without a spare slot. Pushing and popping never allocate.
+ *
+ * With N fixed the elements are stored inline; ring_buffer<T> (N of
+ * dynamic_capacity) allocates its array once, at construction.
+ * push_n() and pop_n() move whole batches, in at most two contiguous
+ * runs, and with memcpy for trivially copyable T.
+ *
+ * With Sync of ring_sync::spsc, one producer thread and one consumer
+ * thread may use it at the same time (see spsc_ring_buffer). Each
+ * side publishes its index with a release store and reads the other's
+ * with an acquire load, and the two indices are on separate cache
+ * lines, together with a cached copy of the other side's index: a
+ * side only reads the other's cache line when its copy says the
+ * buffer is full or empty. size() and empty() are then only a
+ * snapshot.
+ */
+template <typename T, size_t N = dynamic_capacity,
+          ring_sync Sync = ring_sync::single_thread>
+class ring_buffer {
+  static constexpr size_t line_size =
+      Sync == ring_sync::spsc ? 64 : alignof(size_t);
+
+public:
+  typedef T value_type;
+
+  /// Construction of an empty buffer with a fixed capacity of N.
+  ring_buffer() : m_storage() { this->init(); }
+
+  /// Construction of an empty buffer for a capacity picked at run time.
+  /*
+   * @param capacity - the minimum capacity, rounded up to a power of 2.
+   */
+  explicit ring_buffer(const size_t &capacity) : m_storage(capacity) {
+    this->init();
+  }
+
+  ring_buffer(const ring_buffer &) = delete;
+  ring_buffer &operator=(const ring_buffer &) = delete;
+
+  /// No other thread may use it any more.
+  ~ring_buffer() {
+    size_t head = m_consumer.head.load(std::memory_order_relaxed);
+    size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+    for (; head != tail; head++) {
+      detail::destroy(this->slot(head), 1);
+    }
+  }
+
+  /// Add an element at the back, if there is room.
+  /*
+   * O(1). Producer side.
+   * @return false, changing nothing, if the buffer is full.
+   */
+  bool try_push(const T &new_elem) { return this->try_emplace(new_elem); }
+  bool try_push(T &&new_elem) { return this->try_emplace(std::move(new_elem)); }
+
+  /// Construct an element in place at the back, if there is room.
+  /*
+   * O(1). Producer side.
+   * @return false, changing nothing, if the buffer is full.
+   */
+  template <typename... Args> bool try_emplace(Args &&... args) {
+    size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+    if (this->free_slots(tail, 1) == 0) {
+      return false;
+    }
+    new (this->slot(tail)) T(std::forward<Args>(args)...);
+    m_producer.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Add copies of as many elements as fit.
+  /*
+   * O(n), with at most two bulk copies. Producer side. If a copy
+   * throws, nothing is added.
+   * @param elems - the elements, in order.
+   * @return the number added, from the front of elems.
+   */
+  size_t push_n(const span<const T> &elems) {
+    size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+    size_t n = this->free_slots(tail, elems.size());
+    if (n > elems.size()) {
+      n = elems.size();
+    }
+    size_t first_run = this->run_length(tail, n);
+    detail::uninitialized_copy(this->slot(tail), elems.data(), first_run);
+    try {
+      detail::uninitialized_copy(this->slot(tail + first_run),
+                                 elems.data() + first_run, n - first_run);
+    } catch (...) {
+      detail::destroy(this->slot(tail), first_run);
+      throw;
+    }
+    m_producer.tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  /// Remove the front element, if there is one.
+  /*
+   * O(1). Consumer side.
+   * @param out - assigned the element.
+   * @return false, changing nothing, if the buffer is empty.
+   */
+  bool try_pop(T &out) {
+    size_t head = m_consumer.head.load(std::memory_order_relaxed);
+    if (this->filled_slots(head, 1) == 0) {
+      return false;
+    }
+    T *front = this->slot(head);
+    out = std::move(*front);
+    detail::destroy(front, 1);
+    m_consumer.head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Remove up to out.size() elements from the front.
+  /*
+   * O(n), with at most two bulk copies for trivially copyable T.
+   * Consumer side. If a move assignment throws, the elements moved
+   * before it are removed and the rest stay.
+   * @param out - assigned the elements, in order, e.g. a span of a
+   *              prac::vector.
+   * @return the number removed, into the front of out.
+   */
+  size_t pop_n(const span<T> &out) {
+    size_t head = m_consumer.head.load(std::memory_order_relaxed);
+    size_t n = this->filled_slots(head, out.size());
+    if (n > out.size()) {
+      n = out.size();
+    }
+    if (std::is_trivially_copyable<T>::value) {
+      size_t first_run = this->run_length(head, n);
+      copy_trivial(out.data(), this->slot(head), first_run);
+      copy_trivial(out.data() + first_run, this->slot(head + first_run),
+                   n - first_run);
+    } else {
+      size_t i = 0;
+      try {
+        for (; i < n; i++) {
+          T *front = this->slot(head + i);
+          out[i] = std::move(*front);
+          detail::destroy(front, 1);
+        }
+      } catch (...) {
+        m_consumer.head.store(head + i, std::memory_order_release);
+        throw;
+      }
+    }
+    m_consumer.head.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  /// Get the number of elements. A snapshot, with other threads.
+  size_t size() const {
+    size_t head = m_consumer.head.load(std::memory_order_acquire);
+    return m_producer.tail.load(std::memory_order_acquire) - head;
+  }
+
+  /// Whether there are no elements. A snapshot, with other threads.
+  bool empty() const { return this->size() == 0; }
+
+  /// Get the number of elements that fit.
+  size_t capacity() const { return m_storage.capacity(); }
+
+private:
+  /// The producer's index, and its copy of the consumer's.
+  struct alignas(line_size) ProducerSide {
+    detail::ring_index<Sync> tail;
+    size_t cached_head;
+  };
+
+  /// The consumer's index, and its copy of the producer's.
+  struct alignas(line_size) ConsumerSide {
+    detail::ring_index<Sync> head;
+    size_t cached_tail;
+  };
+
+  void init() {
+    m_producer.tail.store(0, std::memory_order_relaxed);
+    m_producer.cached_head = 0;
+    m_consumer.head.store(0, std::memory_order_relaxed);
+    m_consumer.cached_tail = 0;
+  }
+
+  /// With N fixed, the mask is a constant.
+  T *slot(const size_t &index) {
+    return m_storage.slots() + (index & (m_storage.capacity() - 1));
+  }
+
+  /// Get the number of free slots from tail, reading the consumer's
+  /// index only if the cached one shows fewer than wanted.
+  size_t free_slots(const size_t &tail, const size_t &wanted) {
+    size_t free = this->capacity() - (tail - m_producer.cached_head);
+    if (free < wanted) {
+      m_producer.cached_head =
+          m_consumer.head.load(std::memory_order_acquire);
+      free = this->capacity() - (tail - m_producer.cached_head);
+    }
+    return free;
+  }
+
+  /// Get the number of elements from head, as free_slots().
+  size_t filled_slots(const size_t &head, const size_t &wanted) {
+    size_t filled = m_consumer.cached_tail - head;
+    if (filled < wanted) {
+      m_consumer.cached_tail =
+          m_producer.tail.load(std::memory_order_acquire);
+      filled = m_consumer.cached_tail - head;
+    }
+    return filled;
+  }
+
+  /// Get how many of n slots from index come before the array wraps.
+  size_t run_length(const size_t &index, const size_t &n) const {
+    size_t to_end = this->capacity() - (index & (this->capacity() - 1));
+    return n < to_end ? n : to_end;
+  }
+
+  static void copy_trivial(T *dst, T *src, const size_t &n) {
+    if (n > 0) {
+      std::memcpy(static_cast<void *>(dst), static_cast<const void *>(src),
+                  n * sizeof(T));
+    }
+  }
+
+  detail::ring_storage<T, N> m_storage;
+  ProducerSide m_producer;
+  ConsumerSide m_consumer;
+};
+
+/// A ring_buffer for handing elements from one thread to another.
+template <typename T, size_t N = dynamic_capacity>
+using spsc_ring_buffer = ring_buffer<T, N, ring_sync::spsc>;
+}; // namespace prac
@@ -0,0 +1,843 @@
+#pragma once
+#include "list.hpp"
+#include "vector.hpp"
+#include <cerrno>
+#include <cstring>
+#include <limits.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+#include <stddef.h>
+
+namespace prac {
+namespace serial {
+/*
+ * A versioned binary format for the prac containers.
+ *
+ * A serialized container is a 64 byte header followed by a payload:
+ *
+ *   magic         8 bytes, "PRACSER\0"
+ *   version       uint32, format_version
+ *   flags         uint32, flag_records or 0
+ *   element_size  uint64, sizeof(T)
+ *   alignment     uint64, alignof(T)
+ *   count         uint64, the number of elements
+ *   payload_bytes uint64, the size of the payload
+ *   checksum      uint64, checksum of the payload
+ *   (8 reserved bytes, zero)
+ *
+ * The payload starts at the first multiple of the alignment after the
+ * header, so that it can be used in place. For trivially copyable T
+ * it is the elements' bytes, exactly as they are in memory. Any other
+ * T is written as records by serializer<T>; std::string records are a
+ * uint64 length followed by the characters.
+ *
+ * Everything is in the writer's byte order. A file from a machine of
+ * the other byte order fails the version check.
+ *
+ * I/O errors are thrown as std::system_error, and data that isn't
+ * valid in this format as std::runtime_error.
+ */
+
+static const uint32_t format_version = 1;
+/// Set in the header when the payload is records rather than raw
+/// elements.
+static const uint32_t flag_records = 1;
+
+/// The first bytes of a serialized container.
+struct header {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint64_t element_size;
+  uint64_t alignment;
+  uint64_t count;
+  uint64_t payload_bytes;
+  uint64_t checksum;
+  uint64_t reserved;
+};
+static_assert(sizeof(header) == 64, "the header is 64 bytes");
+
+/// Get the offset of the payload from the start of the header.
+inline size_t payload_offset(const uint64_t &alignment) {
+  return alignment <= sizeof(header)
+             ? sizeof(header)
+             : size_t((sizeof(header) + alignment - 1) / alignment *
+                      alignment);
+}
+
+/// A 64-bit checksum that can be computed incrementally.
+/*
+ * Runs at several GB/s: the input is consumed 32 bytes at a time by
+ * four independent multiply-rotate lanes, in the style of xxHash64
+ * (but not compatible with it). Feeding the same bytes in any number
+ * of update() calls gives the same value.
+ */
+class checksum {
+public:
+  checksum() : m_num_pending(0), m_total_bytes(0) {
+    m_lanes[0] = prime1 + prime2;
+    m_lanes[1] = prime2;
+    m_lanes[2] = 0;
+    m_lanes[3] = 0 - prime1;
+  }
+
+  /// Add bytes to the checksum.
+  /*
+   * O(n).
+   * @param data - the bytes.
+   * @param n - the number of bytes.
+   */
+  void update(const void *data, size_t n) {
+    if (n == 0) {
+      return;
+    }
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    m_total_bytes += n;
+    if (m_num_pending > 0) {
+      size_t taken = n < stripe_bytes - m_num_pending
+                         ? n
+                         : stripe_bytes - m_num_pending;
+      std::memcpy(m_pending + m_num_pending, bytes, taken);
+      m_num_pending += taken;
+      bytes += taken;
+      n -= taken;
+      if (m_num_pending < stripe_bytes) {
+        return;
+      }
+      this->consume(m_pending);
+      m_num_pending = 0;
+    }
+    for (; n >= stripe_bytes; n -= stripe_bytes, bytes += stripe_bytes) {
+      this->consume(bytes);
+    }
+    std::memcpy(m_pending, bytes, n);
+    m_num_pending = n;
+  }
+
+  /// Get the checksum of everything added so far.
+  uint64_t value() const {
+    uint64_t acc = rotl(m_lanes[0], 1) + rotl(m_lanes[1], 7) +
+                   rotl(m_lanes[2], 12) + rotl(m_lanes[3], 18);
+    acc ^= m_total_bytes * prime1;
+    size_t i = 0;
+    for (; i + 8 <= m_num_pending; i += 8) {
+      acc = rotl(acc ^ round(0, load(m_pending + i)), 27) * prime1 + prime2;
+    }
+    for (; i < m_num_pending; i++) {
+      acc = rotl(acc ^ (m_pending[i] * prime3), 11) * prime1;
+    }
+    acc ^= acc >> 33;
+    acc *= prime2;
+    acc ^= acc >> 29;
+    acc *= prime3;
+    return acc ^ (acc >> 32);
+  }
+
+private:
+  static constexpr uint64_t prime1 = 0x9e3779b185ebca87ULL;
+  static constexpr uint64_t prime2 = 0xc2b2ae3d27d4eb4fULL;
+  static constexpr uint64_t prime3 = 0x165667b19e3779f9ULL;
+  static constexpr size_t stripe_bytes = 32;
+
+  static uint64_t rotl(const uint64_t &x, const int &bits) {
+    return (x << bits) | (x >> (64 - bits));
+  }
+
+  static uint64_t round(const uint64_t &acc, const uint64_t &input) {
+    return rotl(acc + input * prime2, 31) * prime1;
+  }
+
+  static uint64_t load(const unsigned char *bytes) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
+  void consume(const unsigned char *stripe) {
+    m_lanes[0] = round(m_lanes[0], load(stripe));
+    m_lanes[1] = round(m_lanes[1], load(stripe + 8));
+    m_lanes[2] = round(m_lanes[2], load(stripe + 16));
+    m_lanes[3] = round(m_lanes[3], load(stripe + 24));
+  }
+
+  uint64_t m_lanes[4];
+  unsigned char m_pending[32];
+  size_t m_num_pending;
+  uint64_t m_total_bytes;
+};
+
+namespace detail {
+
+[[noreturn]] inline void throw_errno(const char *what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+/// Write all of the buffers, retrying short writes.
+inline void write_all(const int &fd, struct iovec *iov, int iovcnt) {
+  while (iovcnt > 0) {
+    ssize_t written = ::writev(fd, iov, iovcnt < IOV_MAX ? iovcnt : IOV_MAX);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_errno("writev");
+    }
+    size_t left = size_t(written);
+    while (iovcnt > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+}
+
+inline void write_all(const int &fd, const void *data, const size_t &n) {
+  struct iovec iov;
+  iov.iov_base = const_cast<void *>(data);
+  iov.iov_len = n;
+  write_all(fd, &iov, 1);
+}
+
+/// Read exactly n bytes, retrying short reads.
+/*
+ * Running out of input before n bytes is a format error.
+ */
+inline void read_all(const int &fd, void *data, size_t n) {
+  char *dst = static_cast<char *>(data);
+  while (n > 0) {
+    ssize_t num_read = ::read(fd, dst, n);
+    if (num_read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_errno("read");
+    }
+    if (num_read == 0) {
+      throw std::runtime_error("serialized container is truncated");
+    }
+    dst += num_read;
+    n -= size_t(num_read);
+  }
+}
+
+/// Write n zero bytes.
+inline void write_zeros(const int &fd, size_t n) {
+  char zeros[256] = {};
+  while (n > 0) {
+    size_t chunk = n < sizeof(zeros) ? n : sizeof(zeros);
+    write_all(fd, zeros, chunk);
+    n -= chunk;
+  }
+}
+
+/// Read and discard n bytes.
+inline void skip(const int &fd, size_t n) {
+  char discard[256];
+  while (n > 0) {
+    size_t chunk = n < sizeof(discard) ? n : sizeof(discard);
+    read_all(fd, discard, chunk);
+    n -= chunk;
+  }
+}
+
+template <typename T> header make_header(const uint32_t &flags) {
+  header head;
+  std::memset(&head, 0, sizeof(head));
+  std::memcpy(head.magic, "PRACSER", sizeof(head.magic));
+  head.version = format_version;
+  head.flags = flags;
+  head.element_size = sizeof(T);
+  head.alignment = alignof(T);
+  return head;
+}
+
+/// Reject a header that doesn't describe a container of T.
+template <typename T> void check_header(const header &head) {
+  if (std::memcmp(head.magic, "PRACSER", sizeof(head.magic)) != 0) {
+    throw std::runtime_error("not a serialized container");
+  }
+  if (head.version != format_version) {
+    throw std::runtime_error("unknown serialization format version");
+  }
+  if (head.element_size != sizeof(T) || head.alignment != alignof(T)) {
+    throw std::runtime_error("serialized elements are of another type");
+  }
+  bool records = (head.flags & flag_records) != 0;
+  if (records == std::is_trivially_copyable<T>::value) {
+    throw std::runtime_error("serialized elements are of another type");
+  }
+  if (!records && (head.count > UINT64_MAX / sizeof(T) ||
+                   head.payload_bytes != head.count * sizeof(T))) {
+    throw std::runtime_error("serialized payload has the wrong size");
+  }
+}
+
+/// Get the number of bytes left to read from fd, or UINT64_MAX if
+/// that can't be known, as for a pipe or a socket.
+inline uint64_t bytes_left(const int &fd) {
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    return UINT64_MAX;
+  }
+  off_t offset = ::lseek(fd, 0, SEEK_CUR);
+  if (offset < 0) {
+    return UINT64_MAX;
+  }
+  return offset < info.st_size ? uint64_t(info.st_size - offset) : 0;
+}
+
+/// Get how many elements to make room for before reading a payload.
+/*
+ * The header's count isn't checked until the payload has been read,
+ * so room is made for at most one element per payload byte, and only
+ * if fd is known to hold the whole payload. Otherwise it is at most
+ * 1 MB of elements, and the rest grows as they arrive. Either way,
+ * corrupt data fails by running out of input rather than by
+ * allocating whatever its header asks for.
+ * @param fd - the file descriptor, at the start of the payload.
+ * @param head - the payload's header.
+ * @throw std::runtime_error if fd ends before the payload does.
+ */
+template <typename T>
+size_t initial_capacity(const int &fd, const header &head) {
+  uint64_t available = bytes_left(fd);
+  if (available != UINT64_MAX && available < head.payload_bytes) {
+    throw std::runtime_error("serialized container is truncated");
+  }
+  uint64_t capacity =
+      head.count < head.payload_bytes ? head.count : head.payload_bytes;
+  const uint64_t unverified = (uint64_t(1) << 20) / sizeof(T) + 1;
+  if (available == UINT64_MAX && capacity > unverified) {
+    capacity = unverified;
+  }
+  return size_t(capacity);
+}
+
+}; // namespace detail
+
+class byte_writer;
+class byte_reader;
+
+/// How elements of T are written as records.
+/*
+ * Specialize this for element types that aren't trivially copyable.
+ * A specialization needs
+ *
+ *   static void write(byte_writer &out, const T &value);
+ *   static void read(byte_reader &in, T &value);
+ *
+ * where read() assigns to a default-constructed or moved-from value.
+ */
+template <typename T, typename Enable = void> struct serializer;
+
+/// Buffered output to a file descriptor, with a running checksum.
+class byte_writer {
+public:
+  explicit byte_writer(const int &fd)
+      : m_fd(fd), m_bytes_written(0), m_num_buffered(0) {}
+
+  /// Write bytes.
+  /*
+   * Amortized O(n). Writes larger than the buffer go straight to the
+   * file.
+   */
+  void write(const void *data, const size_t &n) {
+    m_checksum.update(data, n);
+    m_bytes_written += n;
+    if (m_num_buffered + n > sizeof(m_buffer)) {
+      this->flush();
+    }
+    if (n >= sizeof(m_buffer)) {
+      detail::write_all(m_fd, data, n);
+      return;
+    }
+    std::memcpy(m_buffer + m_num_buffered, data, n);
+    m_num_buffered += n;
+  }
+
+  /// Write a value's bytes.
+  template <typename T> void write_value(const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable values have raw bytes");
+    this->write(&value, sizeof(T));
+  }
+
+  /// Write out the buffer.
+  void flush() {
+    detail::write_all(m_fd, m_buffer, m_num_buffered);
+    m_num_buffered = 0;
+  }
+
+  /// Get the checksum of everything written so far.
+  uint64_t checksum() const { return m_checksum.value(); }
+
+  /// Get the number of bytes written so far.
+  uint64_t bytes_written() const { return m_bytes_written; }
+
+private:
+  int m_fd;
+  serial::checksum m_checksum;
+  uint64_t m_bytes_written;
+  size_t m_num_buffered;
+  char m_buffer[64 * 1024];
+};
+
+/// Buffered input from a file descriptor, with a running checksum.
+/*
+ * Never reads past the payload it was given the size of.
+ */
+class byte_reader {
+public:
+  byte_reader(const int &fd, const uint64_t &payload_bytes)
+      : m_fd(fd), m_bytes_left(payload_bytes), m_position(0),
+        m_num_buffered(0) {}
+
+  /// Read exactly n bytes.
+  void read(void *data, size_t n) {
+    if (n > m_bytes_left + (m_num_buffered - m_position)) {
+      throw std::runtime_error("serialized record runs past the payload");
+    }
+    char *dst = static_cast<char *>(data);
+    size_t buffered = m_num_buffered - m_position;
+    size_t taken = n < buffered ? n : buffered;
+    std::memcpy(dst, m_buffer + m_position, taken);
+    m_position += taken;
+    dst += taken;
+    n -= taken;
+    if (n >= sizeof(m_buffer)) {
+      detail::read_all(m_fd, dst, n);
+      m_checksum.update(dst, n);
+      m_bytes_left -= n;
+      return;
+    }
+    if (n > 0) {
+      this->fill();
+      std::memcpy(dst, m_buffer, n);
+      m_position = n;
+    }
+  }
+
+  /// Read a value's bytes.
+  template <typename T> void read_value(T &value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable values have raw bytes");
+    this->read(&value, sizeof(T));
+  }
+
+  /// Whether the whole payload has been read.
+  bool done() const {
+    return m_bytes_left == 0 && m_position == m_num_buffered;
+  }
+
+  /// Get the checksum of everything read from the file so far.
+  uint64_t checksum() const { return m_checksum.value(); }
+
+private:
+  void fill() {
+    size_t n = m_bytes_left < sizeof(m_buffer) ? size_t(m_bytes_left)
+                                               : sizeof(m_buffer);
+    detail::read_all(m_fd, m_buffer, n);
+    m_checksum.update(m_buffer, n);
+    m_bytes_left -= n;
+    m_num_buffered = n;
+    m_position = 0;
+  }
+
+  int m_fd;
+  serial::checksum m_checksum;
+  uint64_t m_bytes_left;
+  size_t m_position;
+  size_t m_num_buffered;
+  char m_buffer[64 * 1024];
+};
+
+/// Trivially copyable values are their bytes.
+template <typename T>
+struct serializer<
+    T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type> {
+  static void write(byte_writer &out, const T &value) {
+    out.write_value(value);
+  }
+  static void read(byte_reader &in, T &value) { in.read_value(value); }
+};
+
+/// Strings are a uint64 length followed by the characters.
+template <> struct serializer<std::string> {
+  static void write(byte_writer &out, const std::string &value) {
+    out.write_value(uint64_t(value.size()));
+    out.write(value.data(), value.size());
+  }
+  static void read(byte_reader &in, std::string &value) {
+    uint64_t length;
+    in.read_value(length);
+    // Read in chunks, so a corrupt length fails by running out of
+    // payload rather than by allocating an absurd amount of memory.
+    value.clear();
+    while (length > 0) {
+      char chunk[4096];
+      size_t n = length < sizeof(chunk) ? size_t(length) : sizeof(chunk);
+      in.read(chunk, n);
+      value.append(chunk, n);
+      length -= n;
+    }
+  }
+};
+
+/// Write elements one at a time, e.g. from a list.
+/*
+ * The elements can come from anywhere; the count is only known when
+ * finish() is called. The header is then written over the space left
+ * for it at the start, so the file descriptor must be seekable.
+ */
+template <typename T> class stream_writer {
+public:
+  /// Start writing at the current offset of fd.
+  explicit stream_writer(const int &fd)
+      : m_fd(fd), m_out(fd), m_count(0) {
+    m_start = ::lseek(fd, 0, SEEK_CUR);
+    if (m_start < 0) {
+      detail::throw_errno("lseek");
+    }
+    detail::write_zeros(fd, payload_offset(alignof(T)));
+  }
+
+  stream_writer(const stream_writer &) = delete;
+  stream_writer &operator=(const stream_writer &) = delete;
+
+  /// Write one element.
+  /*
+   * Amortized O(1) for trivially copyable T.
+   */
+  void write(const T &value) {
+    serializer<T>::write(m_out, value);
+    m_count++;
+  }
+
+  /// Flush the elements and write the header.
+  /*
+   * Must be called exactly once, after the last write(). The file
+   * offset is left at the end of the payload.
+   */
+  void finish() {
+    m_out.flush();
+    header head = detail::make_header<T>(
+        std::is_trivially_copyable<T>::value ? 0 : flag_records);
+    head.count = m_count;
+    head.payload_bytes = m_out.bytes_written();
+    head.checksum = m_out.checksum();
+    if (::pwrite(m_fd, &head, sizeof(head), m_start) !=
+        ssize_t(sizeof(head))) {
+      detail::throw_errno("pwrite");
+    }
+  }
+
+private:
+  int m_fd;
+  off_t m_start;
+  byte_writer m_out;
+  uint64_t m_count;
+};
+
+/// Read elements one at a time, e.g. into a list.
+/*
+ * The checksum is verified once the last element has been read.
+ */
+template <typename T> class stream_reader {
+public:
+  /// Read and check the header at the current offset of fd.
+  explicit stream_reader(const int &fd)
+      : m_head(read_header(fd)),
+        m_initial_capacity(detail::initial_capacity<T>(fd, m_head)),
+        m_in(fd, m_head.payload_bytes), m_num_read(0) {}
+
+  stream_reader(const stream_reader &) = delete;
+  stream_reader &operator=(const stream_reader &) = delete;
+
+  /// Get the number of elements in the stream.
+  /*
+   * As the header has it: it is only checked against the payload as
+   * the elements are read.
+   */
+  size_t size() const { return size_t(m_head.count); }
+
+  /// Get how many elements it is safe to make room for up front.
+  /*
+   * All of them, unless the header doesn't fit the input; see
+   * detail::initial_capacity().
+   */
+  size_t initial_capacity() const { return m_initial_capacity; }
+
+  /// Read the next element.
+  /*
+   * @param value - set to the element.
+   * @return false, leaving value alone, if every element has been
+   *         read.
+   */
+  bool read(T &value) {
+    if (m_num_read == m_head.count) {
+      return false;
+    }
+    serializer<T>::read(m_in, value);
+    if (++m_num_read == m_head.count) {
+      if (!m_in.done()) {
+        throw std::runtime_error("serialized payload has trailing bytes");
+      }
+      if (m_in.checksum() != m_head.checksum) {
+        throw std::runtime_error("serialized payload checksum mismatch");
+      }
+    }
+    return true;
+  }
+
+private:
+  static header read_header(const int &fd) {
+    header head;
+    detail::read_all(fd, &head, sizeof(head));
+    detail::check_header<T>(head);
+    detail::skip(fd, payload_offset(head.alignment) - sizeof(head));
+    if (head.count == 0 && head.payload_bytes != 0) {
+      throw std::runtime_error("serialized payload has trailing bytes");
+    }
+    return head;
+  }
+
+  header m_head;
+  size_t m_initial_capacity;
+  byte_reader m_in;
+  uint64_t m_num_read;
+};
+
+/// A read-only container over a serialized vector in memory.
+/*
+ * Nothing is copied: the elements are used where they are, e.g. in a
+ * buffer received from the network or a mapped file. Only trivially
+ * copyable T can be viewed. The buffer must outlive the view.
+ */
+template <typename T> class view {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "only raw payloads can be viewed in place");
+
+public:
+  typedef T value_type;
+  typedef const T *iterator;
+  typedef const T *const_iterator;
+
+  /// An empty view.
+  view() : m_data(nullptr), m_size(0) {}
+
+  /// View the serialized vector at the start of a buffer.
+  /*
+   * O(1), or O(n) with verification.
+   * @param buffer - the serialized bytes. The payload in it must be
+   *                 aligned for T, which it is if the buffer is.
+   * @param bytes - the size of the buffer.
+   * @param verify - whether to check the payload's checksum.
+   */
+  view(const void *buffer, const size_t &bytes, const bool &verify = true) {
+    header head;
+    if (bytes < sizeof(head)) {
+      throw std::runtime_error("serialized container is truncated");
+    }
+    std::memcpy(&head, buffer, sizeof(head));
+    detail::check_header<T>(head);
+    size_t offset = payload_offset(head.alignment);
+    if (bytes < offset || bytes - offset < head.payload_bytes) {
+      throw std::runtime_error("serialized container is truncated");
+    }
+    const char *payload = static_cast<const char *>(buffer) + offset;
+    if (reinterpret_cast<uintptr_t>(payload) % alignof(T) != 0) {
+      throw std::runtime_error("serialized payload is misaligned for T");
+    }
+    if (verify) {
+      checksum sum;
+      sum.update(payload, size_t(head.payload_bytes));
+      if (sum.value() != head.checksum) {
+        throw std::runtime_error("serialized payload checksum mismatch");
+      }
+    }
+    m_data = reinterpret_cast<const T *>(payload);
+    m_size = size_t(head.count);
+  }
+
+  const T &operator[](const size_t &i) const { return m_data[i]; }
+  size_t size() const { return m_size; }
+  const T *data() const { return m_data; }
+  const_iterator begin() const { return m_data; }
+  const_iterator end() const { return m_data + m_size; }
+
+private:
+  const T *m_data;
+  size_t m_size;
+};
+
+namespace detail {
+
+template <typename T, typename Alloc, typename Growth>
+void write_vector(const int &fd, const prac::vector<T, Alloc, Growth> &vec,
+                  std::true_type) {
+  header head = make_header<T>(0);
+  head.count = vec.size();
+  head.payload_bytes = uint64_t(vec.size()) * sizeof(T);
+  checksum sum;
+  sum.update(vec.data(), size_t(head.payload_bytes));
+  head.checksum = sum.value();
+  size_t pad_bytes = payload_offset(alignof(T)) - sizeof(head);
+  if (pad_bytes > 0) {
+    // Only over-aligned T pads the payload past the header.
+    write_all(fd, &head, sizeof(head));
+    write_zeros(fd, pad_bytes);
+    write_all(fd, vec.data(), size_t(head.payload_bytes));
+    return;
+  }
+  // One system call for the header and the elements.
+  struct iovec iov[2];
+  iov[0].iov_base = &head;
+  iov[0].iov_len = sizeof(head);
+  iov[1].iov_base = const_cast<T *>(vec.data());
+  iov[1].iov_len = size_t(head.payload_bytes);
+  write_all(fd, iov, 2);
+}
+
+template <typename T, typename Alloc, typename Growth>
+void write_vector(const int &fd, const prac::vector<T, Alloc, Growth> &vec,
+                  std::false_type) {
+  stream_writer<T> out(fd);
+  for (const T &value : vec) {
+    out.write(value);
+  }
+  out.finish();
+}
+
+template <typename T, typename Alloc, typename Growth>
+void read_vector(const int &fd, prac::vector<T, Alloc, Growth> &vec,
+                 std::true_type) {
+  header head;
+  read_all(fd, &head, sizeof(head));
+  check_header<T>(head);
+  skip(fd, payload_offset(head.alignment) - sizeof(head));
+  vec.clear();
+  size_t count = size_t(head.count);
+  size_t step = initial_capacity<T>(fd, head);
+  try {
+    vec.reserve(step);
+    // Read straight into the storage: all at once, unless the input's
+    // length is unknown, in which case the storage grows step elements
+    // at a time as they arrive.
+    while (vec.size() < count) {
+      size_t n = count - vec.size() < step ? count - vec.size() : step;
+      vec.resize_with(vec.size() + n, [&](T *first, const size_t &num) {
+        read_all(fd, first, num * sizeof(T));
+      });
+    }
+  } catch (...) {
+    vec.clear();
+    throw;
+  }
+  checksum sum;
+  sum.update(vec.data(), count * sizeof(T));
+  if (sum.value() != head.checksum) {
+    vec.clear();
+    throw std::runtime_error("serialized payload checksum mismatch");
+  }
+}
+
+template <typename T, typename Alloc, typename Growth>
+void read_vector(const int &fd, prac::vector<T, Alloc, Growth> &vec,
+                 std::false_type) {
+  stream_reader<T> in(fd);
+  vec.clear();
+  vec.reserve(in.initial_capacity());
+  try {
+    T value;
+    while (in.read(value)) {
+      vec.push_back(std::move(value));
+    }
+  } catch (...) {
+    vec.clear();
+    throw;
+  }
+}
+
+}; // namespace detail
+
+/// Write a vector at the current offset of fd.
+/*
+ * O(n). Trivially copyable elements go out in a single writev() with
+ * the header, straight from the vector's storage. Other elements are
+ * streamed as records, which needs fd to be seekable.
+ * @param fd - the file descriptor to write to.
+ * @param vec - the vector to write.
+ */
+template <typename T, typename Alloc, typename Growth>
+void write(const int &fd, const prac::vector<T, Alloc, Growth> &vec) {
+  detail::write_vector(fd, vec, std::is_trivially_copyable<T>());
+}
+
+/// Replace the contents of a vector with one read from fd.
+/*
+ * O(n). Reading from a file, the storage is allocated once, at the
+ * stored size; from a pipe or a socket it grows as the elements
+ * arrive. Trivially copyable elements are read into it directly. On
+ * any error vec is left empty.
+ * @param fd - the file descriptor to read from.
+ * @param vec - the vector to read into.
+ */
+template <typename T, typename Alloc, typename Growth>
+void read(const int &fd, prac::vector<T, Alloc, Growth> &vec) {
+  detail::read_vector(fd, vec, std::is_trivially_copyable<T>());
+}
+
+/// Write a list at the current offset of fd.
+/*
+ * O(n), streamed through stream_writer, so fd must be seekable. A
+ * list of trivially copyable T is written exactly as a vector of the
+ * same elements would be, and can be read back as either.
+ * @param fd - the file descriptor to write to.
+ * @param values - the list to write.
+ */
+template <typename T, typename Alloc>
+void write(const int &fd, const prac::list<T, Alloc> &values) {
+  stream_writer<T> out(fd);
+  for (typename prac::list<T, Alloc>::iterator it = values.cbegin();
+       it != values.cend(); ++it) {
+    out.write(*it);
+  }
+  out.finish();
+}
+
+/// Replace the contents of a list with one read from fd.
+/*
+ * O(n), streamed through stream_reader. Reading from a file, the
+ * nodes are reserved in the list's pool up front. On any error
+ * values is left empty.
+ * @param fd - the file descriptor to read from.
+ * @param values - the list to read into.
+ */
+template <typename T, typename Alloc>
+void read(const int &fd, prac::list<T, Alloc> &values) {
+  stream_reader<T> in(fd);
+  values.clear();
+  values.reserve_nodes(in.initial_capacity());
+  try {
+    T value;
+    while (in.read(value)) {
+      values.push_back(std::move(value));
+    }
+  } catch (...) {
+    values.clear();
+    throw;
+  }
+}
+
+}; // namespace serial
+}; // namespace prac
@@ -0,0 +1,701 @@
+#pragma once
+#include "vector.hpp"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Vectorized numeric kernels over contiguous arrays of arithmetic T,
+ * e.g. the storage of a prac::vector<float>.
+ *
+ * Each kernel is written once with GCC vector extensions and compiled
+ * three times, for SSE2 (16-byte vectors), AVX2 (32 bytes) and
+ * AVX-512 (64 bytes). The widest set the CPU supports is picked at
+ * run time, and set_isa() can pick a narrower one, e.g. to compare
+ * them. Elsewhere, or with compilers that lack the extensions, every
+ * kernel runs the scalar loop.
+ *
+ * Reductions keep several vector accumulators, so floating point sums
+ * and dot products add in a different order than a scalar loop and
+ * can differ from it in the last bits. Integer arithmetic wraps on
+ * overflow. min() and max() of data containing NaN are unspecified.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PRAC_SIMD_X86 1
+#define PRAC_SIMD_INLINE inline __attribute__((always_inline))
+// Functions passing wide vectors by value are always inlined into
+// code built for the matching instruction set, so the calling
+// convention GCC warns about never comes into play. The warning is
+// turned off for this header only, up to the pop at its end. GCC
+// reports the operations transform() instantiates at the end of the
+// calling file instead, so a caller that wants them quiet turns
+// -Wpsabi off there, as tests/simd.cpp does.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#else
+#define PRAC_SIMD_INLINE inline
+#endif
+
+namespace prac {
+namespace simd {
+
+/// The instruction sets a kernel can run with, narrowest first.
+enum class isa { scalar, sse2, avx2, avx512 };
+
+/// Get a printable name for an instruction set.
+inline const char *isa_name(const isa &set) {
+  switch (set) {
+  case isa::sse2:
+    return "sse2";
+  case isa::avx2:
+    return "avx2";
+  case isa::avx512:
+    return "avx512";
+  default:
+    return "scalar";
+  }
+}
+
+/// Get the widest instruction set this CPU supports.
+/*
+ * Detected once, with cpuid, including whether the OS saves the
+ * wider registers.
+ */
+inline isa detected_isa() {
+  static const isa detected = []() {
+#ifdef PRAC_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512dq") &&
+        __builtin_cpu_supports("avx512vl")) {
+      return isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      return isa::avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return isa::sse2;
+    }
+#endif
+    return isa::scalar;
+  }();
+  return detected;
+}
+
+namespace detail {
+inline std::atomic<int> &active_isa_storage() {
+  static std::atomic<int> active{int(detected_isa())};
+  return active;
+}
+}; // namespace detail
+
+/// Get the instruction set the kernels currently run with.
+inline isa active_isa() {
+  return isa(detail::active_isa_storage().load(std::memory_order_relaxed));
+}
+
+/// Choose the instruction set the kernels run with, for all threads.
+/*
+ * Sets wider than detected_isa() are narrowed to it.
+ * @param set - the instruction set to use.
+ * @return the instruction set now in use.
+ */
+inline isa set_isa(const isa &set) {
+  isa chosen = int(set) > int(detected_isa()) ? detected_isa() : set;
+  detail::active_isa_storage().store(int(chosen), std::memory_order_relaxed);
+  return chosen;
+}
+
+namespace detail {
+
+/// The type to do U's arithmetic in, so that integer overflow wraps
+/// instead of being undefined: unsigned, and for scalars at least as
+/// wide as unsigned int, which narrower types would be promoted past.
+template <typename U, typename = void> struct wrapping {
+  typedef U type;
+};
+template <typename U>
+struct wrapping<U, typename std::enable_if<std::is_integral<U>::value>::type> {
+  typedef typename std::common_type<typename std::make_unsigned<U>::type,
+                                    unsigned>::type type;
+};
+
+#ifdef PRAC_SIMD_X86
+/// A GCC vector wraps in a vector of unsigned lanes of the same width.
+template <typename U>
+struct wrapping<U, std::void_t<decltype(std::declval<U &>()[0])>> {
+  typedef typename std::remove_reference<decltype(
+      std::declval<U &>()[0])>::type lane;
+  typedef typename std::conditional<std::is_integral<lane>::value,
+                                    std::make_unsigned<lane>,
+                                    std::common_type<lane>>::type::type
+      wrapped_lane;
+  typedef wrapped_lane type __attribute__((vector_size(sizeof(U))));
+};
+#endif
+
+}; // namespace detail
+
+/// Elementwise operations for transform(). Each also works on vectors,
+/// and is always inlined so that it is compiled for the vector width.
+/// Integers wrap on overflow.
+struct plus {
+  template <typename U>
+  PRAC_SIMD_INLINE U operator()(const U &x, const U &y) const {
+    typedef typename detail::wrapping<U>::type W;
+    return U(W(x) + W(y));
+  }
+};
+
+struct minus {
+  template <typename U>
+  PRAC_SIMD_INLINE U operator()(const U &x, const U &y) const {
+    typedef typename detail::wrapping<U>::type W;
+    return U(W(x) - W(y));
+  }
+};
+
+struct multiplies {
+  template <typename U>
+  PRAC_SIMD_INLINE U operator()(const U &x, const U &y) const {
+    typedef typename detail::wrapping<U>::type W;
+    return U(W(x) * W(y));
+  }
+};
+
+namespace detail {
+
+template <typename T> struct check_arithmetic {
+  static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+                "prac::simd kernels need an arithmetic element type");
+};
+
+/// Add without the undefined behavior of signed overflow.
+template <typename T> T wrapping_add(const T &x, const T &y) {
+  typedef typename wrapping<T>::type U;
+  return T(U(x) + U(y));
+}
+
+/// Multiply without the undefined behavior of signed overflow, or of
+/// unsigned short operands promoted to int.
+template <typename T> T wrapping_multiply(const T &x, const T &y) {
+  typedef typename wrapping<T>::type U;
+  return T(U(x) * U(y));
+}
+
+/// The plain loops, used when no vector instruction set is available
+/// and for the ends of arrays that don't fill a whole vector.
+struct scalar_kernels {
+  template <typename T> static T sum(const T *data, const size_t &n) {
+    T total = T();
+    for (size_t i = 0; i < n; i++) {
+      total = wrapping_add(total, data[i]);
+    }
+    return total;
+  }
+
+  template <typename T> static T min(const T *data, const size_t &n) {
+    T result = data[0];
+    for (size_t i = 1; i < n; i++) {
+      result = data[i] < result ? data[i] : result;
+    }
+    return result;
+  }
+
+  template <typename T> static T max(const T *data, const size_t &n) {
+    T result = data[0];
+    for (size_t i = 1; i < n; i++) {
+      result = data[i] > result ? data[i] : result;
+    }
+    return result;
+  }
+
+  template <typename T>
+  static size_t find(const T *data, const size_t &n, const T &value) {
+    for (size_t i = 0; i < n; i++) {
+      if (data[i] == value) {
+        return i;
+      }
+    }
+    return n;
+  }
+
+  template <typename T>
+  static size_t count(const T *data, const size_t &n, const T &value) {
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) {
+      total += data[i] == value;
+    }
+    return total;
+  }
+
+  template <typename T>
+  static T dot(const T *first, const T *second, const size_t &n) {
+    T total = T();
+    for (size_t i = 0; i < n; i++) {
+      total = wrapping_add(total, wrapping_multiply(first[i], second[i]));
+    }
+    return total;
+  }
+
+  template <typename T, typename Op>
+  static void transform(const T *first, const T *second, T *out,
+                        const size_t &n, const Op &op) {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = op(first[i], second[i]);
+    }
+  }
+
+  template <typename T, typename Op>
+  static void transform(const T *first, const T &value, T *out,
+                        const size_t &n, const Op &op) {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = op(first[i], value);
+    }
+  }
+};
+
+#ifdef PRAC_SIMD_X86
+
+/// A GCC vector of Bytes / sizeof(T) lanes of T.
+template <typename T, size_t Bytes> struct vec {
+  typedef T type __attribute__((vector_size(Bytes)));
+};
+
+template <typename V, typename T> PRAC_SIMD_INLINE V load(const T *data) {
+  V result;
+  __builtin_memcpy(&result, data, sizeof(V));
+  return result;
+}
+
+template <typename V, typename T>
+PRAC_SIMD_INLINE void store(T *data, const V &value) {
+  __builtin_memcpy(data, &value, sizeof(V));
+}
+
+/// Number of leading elements to handle one by one so that the rest
+/// of data starts on a Bytes boundary.
+template <typename T, size_t Bytes>
+PRAC_SIMD_INLINE size_t head_length(const T *data, const size_t &n) {
+  size_t misalignment = size_t(uintptr_t(data) % Bytes);
+  size_t head = misalignment == 0 || misalignment % sizeof(T) != 0
+                    ? 0
+                    : (Bytes - misalignment) / sizeof(T);
+  return head < n ? head : n;
+}
+
+/// Whether any lane of a comparison result is set.
+template <typename M> PRAC_SIMD_INLINE bool any(const M &mask) {
+  uint64_t words[sizeof(M) / 8];
+  __builtin_memcpy(words, &mask, sizeof(M));
+  uint64_t combined = 0;
+  for (size_t i = 0; i < sizeof(M) / 8; i++) {
+    combined |= words[i];
+  }
+  return combined != 0;
+}
+
+/// The kernels for one vector width, compiled for that width's
+/// instruction set by the wrappers below.
+/*
+ * The array is split into a scalar head up to the first aligned
+ * element, a main loop of aligned vector loads (four vectors at a
+ * time for the reductions, so that independent accumulators hide
+ * the latency of each add), and a scalar tail.
+ */
+template <size_t Bytes> struct vector_kernels {
+  template <typename T>
+  static PRAC_SIMD_INLINE T sum(const T *data, const size_t &n) {
+    // Integer lanes add as unsigned, so that they wrap.
+    typedef typename wrapping<typename vec<T, Bytes>::type>::type V;
+    const size_t lanes = Bytes / sizeof(T);
+    size_t i = head_length<T, Bytes>(data, n);
+    T total = scalar_kernels::sum(data, i);
+    V acc0 = {}, acc1 = {}, acc2 = {}, acc3 = {};
+    for (; i + 4 * lanes <= n; i += 4 * lanes) {
+      acc0 += load<V>(data + i);
+      acc1 += load<V>(data + i + lanes);
+      acc2 += load<V>(data + i + 2 * lanes);
+      acc3 += load<V>(data + i + 3 * lanes);
+    }
+    for (; i + lanes <= n; i += lanes) {
+      acc0 += load<V>(data + i);
+    }
+    acc0 += acc1 + acc2 + acc3;
+    for (size_t lane = 0; lane < lanes; lane++) {
+      total = wrapping_add(total, T(acc0[lane]));
+    }
+    return wrapping_add(total, scalar_kernels::sum(data + i, n - i));
+  }
+
+  template <typename T>
+  static PRAC_SIMD_INLINE T min(const T *data, const size_t &n) {
+    typedef typename vec<T, Bytes>::type V;
+    const size_t lanes = Bytes / sizeof(T);
+    if (n < 2 * lanes) {
+      return scalar_kernels::min(data, n);
+    }
+    V acc = load<V>(data);
+    size_t i = lanes;
+    for (; i + lanes <= n; i += lanes) {
+      V value = load<V>(data + i);
+      acc = value < acc ? value : acc;
+    }
+    // The last vector overlaps ones already seen, which is harmless.
+    V value = load<V>(data + n - lanes);
+    acc = value < acc ? value : acc;
+    T result = acc[0];
+    for (size_t lane = 1; lane < lanes; lane++) {
+      result = acc[lane] < result ? T(acc[lane]) : result;
+    }
+    return result;
+  }
+
+  template <typename T>
+  static PRAC_SIMD_INLINE T max(const T *data, const size_t &n) {
+    typedef typename vec<T, Bytes>::type V;
+    const size_t lanes = Bytes / sizeof(T);
+    if (n < 2 * lanes) {
+      return scalar_kernels::max(data, n);
+    }
+    V acc = load<V>(data);
+    size_t i = lanes;
+    for (; i + lanes <= n; i += lanes) {
+      V value = load<V>(data + i);
+      acc = value > acc ? value : acc;
+    }
+    V value = load<V>(data + n - lanes);
+    acc = value > acc ? value : acc;
+    T result = acc[0];
+    for (size_t lane = 1; lane < lanes; lane++) {
+      result = acc[lane] > result ? T(acc[lane]) : result;
+    }
+    return result;
+  }
+
+  template <typename T>
+  static PRAC_SIMD_INLINE size_t find(const T *data, const size_t &n,
+                                      const T &value) {
+    typedef typename vec<T, Bytes>::type V;
+    const size_t lanes = Bytes / sizeof(T);
+    size_t i = head_length<T, Bytes>(data, n);
+    size_t found = scalar_kernels::find(data, i, value);
+    if (found < i) {
+      return found;
+    }
+    V needle = V{} + value;
+    for (; i + lanes <= n; i += lanes) {
+      if (any(load<V>(data + i) == needle)) {
+        return i + scalar_kernels::find(data + i, lanes, value);
+      }
+    }
+    return i + scalar_kernels::find(data + i, n - i, value);
+  }
+
+  template <typename T>
+  static PRAC_SIMD_INLINE size_t count(const T *data, const size_t &n,
+                                       const T &value) {
+    typedef typename vec<T, Bytes>::type V;
+    typedef decltype(V{} == V{}) M;
+    const size_t lanes = Bytes / sizeof(T);
+    // A matching lane compares to -1, so the per-lane counts go down.
+    // Flush them before a lane of sizeof(T) bytes can overflow.
+    const size_t max_rounds = sizeof(T) >= sizeof(size_t)
+                                  ? size_t(-1)
+                                  : (size_t(1) << (8 * sizeof(T) - 1)) - 1;
+    size_t i = head_length<T, Bytes>(data, n);
+    size_t total = scalar_kernels::count(data, i, value);
+    V needle = V{} + value;
+    while (i + lanes <= n) {
+      M counts = {};
+      for (size_t round = 0; round < max_rounds && i + lanes <= n;
+           round++, i += lanes) {
+        counts += load<V>(data + i) == needle;
+      }
+      for (size_t lane = 0; lane < lanes; lane++) {
+        total += size_t(-(int64_t)counts[lane]);
+      }
+    }
+    return total + scalar_kernels::count(data + i, n - i, value);
+  }
+
+  template <typename T>
+  static PRAC_SIMD_INLINE T dot(const T *first, const T *second,
+                                const size_t &n) {
+    typedef typename wrapping<typename vec<T, Bytes>::type>::type V;
+    const size_t lanes = Bytes / sizeof(T);
+    size_t i = head_length<T, Bytes>(first, n);
+    T total = scalar_kernels::dot(first, second, i);
+    V acc0 = {}, acc1 = {}, acc2 = {}, acc3 = {};
+    for (; i + 4 * lanes <= n; i += 4 * lanes) {
+      acc0 += load<V>(first + i) * load<V>(second + i);
+      acc1 += load<V>(first + i + lanes) * load<V>(second + i + lanes);
+      acc2 +=
+          load<V>(first + i + 2 * lanes) * load<V>(second + i + 2 * lanes);
+      acc3 +=
+          load<V>(first + i + 3 * lanes) * load<V>(second + i + 3 * lanes);
+    }
+    for (; i + lanes <= n; i += lanes) {
+      acc0 += load<V>(first + i) * load<V>(second + i);
+    }
+    acc0 += acc1 + acc2 + acc3;
+    for (size_t lane = 0; lane < lanes; lane++) {
+      total = wrapping_add(total, T(acc0[lane]));
+    }
+    return wrapping_add(total,
+                        scalar_kernels::dot(first + i, second + i, n - i));
+  }
+
+  template <typename T, typename Op>
+  static PRAC_SIMD_INLINE void transform(const T *first, const T *second,
+                                         T *out, const size_t &n,
+                                         const Op &op) {
+    typedef typename vec<T, Bytes>::type V;
+    const size_t lanes = Bytes / sizeof(T);
+    size_t i = head_length<T, Bytes>(out, n);
+    scalar_kernels::transform(first, second, out, i, op);
+    for (; i + lanes <= n; i += lanes) {
+      store(out + i, op(load<V>(first + i), load<V>(second + i)));
+    }
+    scalar_kernels::transform(first + i, second + i, out + i, n - i, op);
+  }
+
+  template <typename T, typename Op>
+  static PRAC_SIMD_INLINE void transform(const T *first, const T &value,
+                                         T *out, const size_t &n,
+                                         const Op &op) {
+    typedef typename vec<T, Bytes>::type V;
+    const size_t lanes = Bytes / sizeof(T);
+    size_t i = head_length<T, Bytes>(out, n);
+    scalar_kernels::transform(first, value, out, i, op);
+    V broadcast = V{} + value;
+    for (; i + lanes <= n; i += lanes) {
+      store(out + i, op(load<V>(first + i), broadcast));
+    }
+    scalar_kernels::transform(first + i, value, out + i, n - i, op);
+  }
+};
+
+/// Entry points compiled for one instruction set. The kernels are
+/// inlined into them, so they are built with its vector width.
+#define PRAC_SIMD_ISA_KERNELS(kernels_name, target_name, vector_bytes)        \
+  struct kernels_name {                                                        \
+    typedef vector_kernels<vector_bytes> kernels;                              \
+    template <typename T>                                                      \
+    __attribute__((target(target_name))) static T sum(const T *data,           \
+                                                      const size_t &n) {       \
+      return kernels::sum(data, n);                                            \
+    }                                                                          \
+    template <typename T>                                                      \
+    __attribute__((target(target_name))) static T min(const T *data,           \
+                                                      const size_t &n) {       \
+      return kernels::min(data, n);                                            \
+    }                                                                          \
+    template <typename T>                                                      \
+    __attribute__((target(target_name))) static T max(const T *data,           \
+                                                      const size_t &n) {       \
+      return kernels::max(data, n);                                            \
+    }                                                                          \
+    template <typename T>                                                      \
+    __attribute__((target(target_name))) static size_t                         \
+    find(const T *data, const size_t &n, const T &value) {                     \
+      return kernels::find(data, n, value);                                    \
+    }                                                                          \
+    template <typename T>                                                      \
+    __attribute__((target(target_name))) static size_t                         \
+    count(const T *data, const size_t &n, const T &value) {                    \
+      return kernels::count(data, n, value);                                   \
+    }                                                                          \
+    template <typename T>                                                      \
+    __attribute__((target(target_name))) static T                              \
+    dot(const T *first, const T *second, const size_t &n) {                    \
+      return kernels::dot(first, second, n);                                   \
+    }                                                                          \
+    template <typename T, typename Op>                                         \
+    __attribute__((target(target_name))) static void                           \
+    transform(const T *first, const T *second, T *out, const size_t &n,        \
+              const Op &op) {                                                  \
+      kernels::transform(first, second, out, n, op);                           \
+    }                                                                          \
+    template <typename T, typename Op>                                         \
+    __attribute__((target(target_name))) static void                           \
+    transform(const T *first, const T &value, T *out, const size_t &n,         \
+              const Op &op) {                                                  \
+      kernels::transform(first, value, out, n, op);                            \
+    }                                                                          \
+  };
+
+PRAC_SIMD_ISA_KERNELS(sse2_kernels, "sse2", 16)
+PRAC_SIMD_ISA_KERNELS(avx2_kernels, "avx2", 32)
+PRAC_SIMD_ISA_KERNELS(avx512_kernels,
+                      "avx512f,avx512bw,avx512dq,avx512vl", 64)
+#undef PRAC_SIMD_ISA_KERNELS
+
+/// Call kernel_call with the entry points of the active instruction set
+/// in place of kernels.
+#define PRAC_SIMD_DISPATCH(kernel_call)                                        \
+  switch (active_isa()) {                                                      \
+  case isa::avx512: {                                                          \
+    typedef detail::avx512_kernels kernels;                                    \
+    return kernel_call;                                                        \
+  }                                                                            \
+  case isa::avx2: {                                                            \
+    typedef detail::avx2_kernels kernels;                                      \
+    return kernel_call;                                                        \
+  }                                                                            \
+  case isa::sse2: {                                                            \
+    typedef detail::sse2_kernels kernels;                                      \
+    return kernel_call;                                                        \
+  }                                                                            \
+  default: {                                                                   \
+    typedef detail::scalar_kernels kernels;                                    \
+    return kernel_call;                                                        \
+  }                                                                            \
+  }
+
+#else
+
+#define PRAC_SIMD_DISPATCH(kernel_call)                                        \
+  {                                                                            \
+    typedef detail::scalar_kernels kernels;                                    \
+    return kernel_call;                                                        \
+  }
+
+#endif
+
+}; // namespace detail
+
+/// Add up n elements.
+/*
+ * @param data - the elements.
+ * @param n - the number of elements.
+ * @return the sum, or zero if n is zero.
+ */
+template <typename T> T sum(const T *data, const size_t &n) {
+  detail::check_arithmetic<T>();
+  PRAC_SIMD_DISPATCH(kernels::sum(data, n))
+}
+
+/// Get the smallest of n elements. n must not be zero.
+template <typename T> T min(const T *data, const size_t &n) {
+  detail::check_arithmetic<T>();
+  PRAC_SIMD_DISPATCH(kernels::min(data, n))
+}
+
+/// Get the largest of n elements. n must not be zero.
+template <typename T> T max(const T *data, const size_t &n) {
+  detail::check_arithmetic<T>();
+  PRAC_SIMD_DISPATCH(kernels::max(data, n))
+}
+
+/// Find the first element equal to value.
+/*
+ * @return its index, or n if there is none.
+ */
+template <typename T>
+size_t find(const T *data, const size_t &n, const T &value) {
+  detail::check_arithmetic<T>();
+  PRAC_SIMD_DISPATCH(kernels::find(data, n, value))
+}
+
+/// Count the elements equal to value.
+template <typename T>
+size_t count(const T *data, const size_t &n, const T &value) {
+  detail::check_arithmetic<T>();
+  PRAC_SIMD_DISPATCH(kernels::count(data, n, value))
+}
+
+/// Get the sum of first[i] * second[i] for i below n.
+template <typename T> T dot(const T *first, const T *second, const size_t &n) {
+  detail::check_arithmetic<T>();
+  PRAC_SIMD_DISPATCH(kernels::dot(first, second, n))
+}
+
+/// Set out[i] to op(first[i], second[i]) for i below n.
+/*
+ * out may be first or second, but must not partially overlap them.
+ * @param op - prac::simd::plus, minus or multiplies, or any function
+ *             object whose operator() is a template that also works
+ *             on GCC vectors and is always inlined.
+ */
+template <typename T, typename Op>
+void transform(const T *first, const T *second, T *out, const size_t &n,
+               const Op &op) {
+  detail::check_arithmetic<T>();
+  PRAC_SIMD_DISPATCH(kernels::transform(first, second, out, n, op))
+}
+
+/// Set out[i] to op(first[i], value) for i below n.
+template <typename T, typename Op>
+void transform(const T *first, const T &value, T *out, const size_t &n,
+               const Op &op) {
+  detail::check_arithmetic<T>();
+  PRAC_SIMD_DISPATCH(kernels::transform(first, value, out, n, op))
+}
+
+// The same kernels over a whole prac::vector.
+
+template <typename T, typename Alloc, typename Growth>
+T sum(const vector<T, Alloc, Growth> &vec) {
+  return simd::sum(vec.data(), vec.size());
+}
+
+template <typename T, typename Alloc, typename Growth>
+T min(const vector<T, Alloc, Growth> &vec) {
+  return simd::min(vec.data(), vec.size());
+}
+
+template <typename T, typename Alloc, typename Growth>
+T max(const vector<T, Alloc, Growth> &vec) {
+  return simd::max(vec.data(), vec.size());
+}
+
+template <typename T, typename Alloc, typename Growth>
+size_t find(const vector<T, Alloc, Growth> &vec, const T &value) {
+  return simd::find(vec.data(), vec.size(), value);
+}
+
+template <typename T, typename Alloc, typename Growth>
+size_t count(const vector<T, Alloc, Growth> &vec, const T &value) {
+  return simd::count(vec.data(), vec.size(), value);
+}
+
+/// Dot product over the shorter of the two vectors.
+template <typename T, typename Alloc, typename Growth>
+T dot(const vector<T, Alloc, Growth> &first,
+      const vector<T, Alloc, Growth> &second) {
+  size_t n = first.size() < second.size() ? first.size() : second.size();
+  return simd::dot(first.data(), second.data(), n);
+}
+
+/// Elementwise op over the shorter of the two vectors. out is resized
+/// to fit.
+template <typename T, typename Alloc, typename Growth, typename Op>
+void transform(const vector<T, Alloc, Growth> &first,
+               const vector<T, Alloc, Growth> &second,
+               vector<T, Alloc, Growth> &out, const Op &op) {
+  size_t n = first.size() < second.size() ? first.size() : second.size();
+  out.resize(n);
+  simd::transform(first.data(), second.data(), out.data(), n, op);
+}
+
+/// op(element, value) for every element. out is resized to fit.
+template <typename T, typename Alloc, typename Growth, typename Op>
+void transform(const vector<T, Alloc, Growth> &first, const T &value,
+               vector<T, Alloc, Growth> &out, const Op &op) {
+  out.resize(first.size());
+  simd::transform(first.data(), value, out.data(), first.size(), op);
+}
+
+#undef PRAC_SIMD_DISPATCH
+
+}; // namespace simd
+}; // namespace prac
+
+#ifdef PRAC_SIMD_X86
+#pragma GCC diagnostic pop
+#endif
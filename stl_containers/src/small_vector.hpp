@@ -0,0 +1,283 @@
+#pragma once
+#include "vector.hpp"
+#include <memory>
+#include <stddef.h>
+#include <type_traits>
+
+namespace prac {
+namespace detail {
+
+/// Room for N elements of T inside a small_vector.
+template <typename T, size_t N> struct inline_buffer {
+  T *storage() { return reinterpret_cast<T *>(bytes); }
+
+  alignas(T) unsigned char bytes[N * sizeof(T)];
+  /// Whether a vector's storage is the buffer.
+  bool in_use = false;
+};
+
+/// Hands out a small_vector's inline buffer while it is free and big
+/// enough, and storage from Alloc otherwise.
+/*
+ * Two of them compare equal if they share a buffer and their Alloc
+ * compare equal. Copies made for a copy of the container get no
+ * buffer, so they always allocate from Alloc.
+ */
+template <typename T, size_t N, typename Alloc> class inline_allocator {
+  typedef std::allocator_traits<Alloc> heap_traits;
+
+public:
+  typedef T value_type;
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::false_type propagate_on_container_move_assignment;
+  typedef std::false_type propagate_on_container_swap;
+  typedef std::false_type is_always_equal;
+
+  inline_allocator(inline_buffer<T, N> *buffer, const Alloc &alloc)
+      : m_buffer(buffer), m_alloc(alloc) {}
+
+  T *allocate(const size_t &n) { return this->allocate_at_least(n).ptr; }
+
+  /// Get the inline buffer, with room for N elements, if it is free
+  /// and n fit; otherwise exactly n elements from Alloc.
+  allocation_result<T *> allocate_at_least(const size_t &n) {
+    if (m_buffer != nullptr && !m_buffer->in_use && n <= N) {
+      m_buffer->in_use = true;
+      return {m_buffer->storage(), N};
+    }
+    return {heap_traits::allocate(m_alloc, n), n};
+  }
+
+  void deallocate(T *storage, const size_t &n) {
+    if (m_buffer != nullptr && storage == m_buffer->storage()) {
+      m_buffer->in_use = false;
+    } else {
+      heap_traits::deallocate(m_alloc, storage, n);
+    }
+  }
+
+  inline_allocator select_on_container_copy_construction() const {
+    return inline_allocator(
+        nullptr, heap_traits::select_on_container_copy_construction(m_alloc));
+  }
+
+  /// Whether storage is the inline buffer.
+  bool is_inline(const T *storage) const {
+    return m_buffer != nullptr && storage == m_buffer->storage();
+  }
+
+  /// Get a copy of the allocator the heap storage comes from.
+  Alloc heap_allocator() const { return m_alloc; }
+
+  bool operator==(const inline_allocator &other) const {
+    return m_buffer == other.m_buffer && m_alloc == other.m_alloc;
+  }
+  bool operator!=(const inline_allocator &other) const {
+    return !(*this == other);
+  }
+
+private:
+  inline_buffer<T, N> *m_buffer;
+  Alloc m_alloc;
+};
+
+}; // namespace detail
+
+/*
+ * A vector that keeps up to N elements inside the object itself.
+ *
+ * Nothing is allocated until the (N+1)th element is added, at which
+ * point the elements move to storage from Alloc. shrink_to_fit()
+ * moves them back inline once they fit again. It has the interface
+ * and iterators of prac::vector, whose storage it gets through a
+ * detail::inline_allocator, so a plain prac::vector carries no inline
+ * bookkeeping. Moves and swaps go through small_vector's own members,
+ * which never steal a buffer that lives in another object.
+ */
+template <typename T, size_t N, typename Alloc = prac::allocator<T>,
+          typename Growth = prac::growth_2x>
+class small_vector
+    : public vector<T, detail::inline_allocator<T, N, Alloc>, Growth> {
+  static_assert(N > 0, "small_vector needs room for at least one element");
+  typedef detail::inline_allocator<T, N, Alloc> inline_alloc;
+  typedef vector<T, inline_alloc, Growth> base;
+  typedef std::allocator_traits<Alloc> heap_traits;
+
+public:
+  typedef Alloc allocator_type;
+
+  /// Construction from size and default value.
+  /*
+   * Doesn't allocate if num_elements is at most N.
+   * @param num_elements - The initial size of the container.
+   * @param default_value - The value to which to set all elements.
+   * @param alloc - The allocator to get storage from once full.
+   */
+  small_vector(size_t num_elements = 0, const T &default_value = T(),
+               const Alloc &alloc = Alloc())
+      : base(inline_alloc(&m_buffer, alloc)) {
+    this->reserve(N);
+    this->resize(num_elements, default_value);
+  }
+
+  /// Construction of an empty container with a given allocator.
+  /*
+   * @param alloc - The allocator to get storage from once full.
+   */
+  explicit small_vector(const Alloc &alloc)
+      : base(inline_alloc(&m_buffer, alloc)) {
+    this->reserve(N);
+  }
+
+  /// Construction from STL container iterators.
+  /*
+   * Stays inline if a forward range has at most N elements, and
+   * allocates once otherwise. Integral arguments go to the size and
+   * value constructor instead.
+   * @param begin - the beginning iterator.
+   * @param end - the ending iterator.
+   * @param alloc - The allocator to get storage from once full.
+   */
+  template <typename Other, typename = typename std::enable_if<
+                                !std::is_integral<Other>::value>::type>
+  small_vector(const Other &begin, const Other &end,
+               const Alloc &alloc = Alloc())
+      : base(inline_alloc(&m_buffer, alloc)) {
+    this->reserve(N);
+    this->append(begin, end);
+  }
+
+  /// Copy construction.
+  /*
+   * O(n). Stays inline if other has at most N elements.
+   * @param other - the vector to copy.
+   */
+  small_vector(const small_vector &other)
+      : small_vector(other.begin(), other.end(),
+                     heap_traits::select_on_container_copy_construction(
+                         other.get_allocator())) {}
+
+  /// Copy construction from a plain vector.
+  small_vector(const vector<T, Alloc, Growth> &other)
+      : small_vector(other.begin(), other.end(),
+                     heap_traits::select_on_container_copy_construction(
+                         other.get_allocator())) {}
+
+  /// Move construction.
+  /*
+   * O(1) if other's elements are on the heap, and O(n) if they're
+   * inline, when they are moved into this one's buffer. Never
+   * allocates, since the allocators are copies and compare equal.
+   * @param other - the vector to move from.
+   */
+  small_vector(small_vector &&other) noexcept(
+      std::is_nothrow_move_constructible<T>::value)
+      : base(inline_alloc(&m_buffer, other.get_allocator())) {
+    this->reserve(N);
+    this->take_elements(other);
+  }
+
+  /// Move construction from a plain vector.
+  /*
+   * O(1): the storage is taken over, so this one starts out on the
+   * heap even if the elements would fit inline.
+   * @param other - the vector to move from.
+   */
+  small_vector(vector<T, Alloc, Growth> &&other) noexcept
+      : base(inline_alloc(&m_buffer, other.get_allocator())) {
+    this->take_storage(other);
+    if (this->capacity() == 0) {
+      this->reserve(N);
+    }
+  }
+
+  /// Copy assignment.
+  /*
+   * O(n). Copies into the existing storage, so that elements that fit
+   * stay inline. If a copy throws, this vector is left empty.
+   */
+  small_vector &operator=(const small_vector &other) {
+    if (this != &other) {
+      this->assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  /// Move assignment.
+  /*
+   * O(1) if other's elements are on the heap and the allocators
+   * compare equal. Otherwise they are relocated one by one.
+   */
+  small_vector &operator=(small_vector &&other) {
+    if (this != &other) {
+      this->clear();
+      this->take_elements(other);
+    }
+    return *this;
+  }
+
+  /// Give back the storage while the inline buffer is still alive.
+  ~small_vector() {
+    this->clear();
+    base::shrink_to_fit();
+  }
+
+  /// Exchange contents with another small_vector.
+  /*
+   * O(1) if both keep their elements on the heap. Inline elements are
+   * relocated into the other's buffer. Never allocates if the
+   * allocators compare equal.
+   */
+  void swap(small_vector &other) noexcept(
+      std::is_nothrow_move_constructible<T>::value &&
+      heap_traits::is_always_equal::value) {
+    small_vector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  /// Reduce the capacity to the size.
+  /*
+   * O(n). Elements that fit inline move back inline; otherwise the
+   * heap storage shrinks to exactly the size.
+   */
+  void shrink_to_fit() {
+    if (!this->is_inline()) {
+      base::shrink_to_fit();
+      // An empty vector gave back all of its storage.
+      this->reserve(N);
+    }
+  }
+
+  /// Get a copy of the allocator the heap storage comes from.
+  Alloc get_allocator() const {
+    return base::get_allocator().heap_allocator();
+  }
+
+private:
+  bool is_inline() const {
+    return base::get_allocator().is_inline(this->data());
+  }
+
+  /// Take over the elements of other, which is left empty. This vector
+  /// must be empty.
+  /*
+   * Steals other's heap storage if the allocators compare equal, and
+   * other goes back to its inline buffer. Otherwise the elements are
+   * moved one by one, into the inline buffer if they fit.
+   */
+  void take_elements(small_vector &other) {
+    if (!other.is_inline() &&
+        this->get_allocator() == other.get_allocator()) {
+      this->take_storage(other);
+      other.reserve(N);
+      return;
+    }
+    this->append(std::make_move_iterator(other.begin()),
+                 std::make_move_iterator(other.end()));
+    other.clear();
+  }
+
+  detail::inline_buffer<T, N> m_buffer;
+};
+}; // namespace prac
@@ -0,0 +1,382 @@
+#pragma once
+#include "span.hpp"
+#include "vector.hpp"
+#include <iterator>
+#include <stddef.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace prac {
+
+/// What dereferencing a soa_vector iterator gives: a reference to one
+/// element of each column.
+/*
+ * A std::tuple of references, so std::get and structured bindings
+ * work on it, which also assigns through to the elements and can be
+ * swapped while a temporary. That is what lets std::sort and friends
+ * rearrange the rows of a soa_vector. Assigning one reference to
+ * another copies the elements, since a temporary reference can't say
+ * whether it may be moved from; assigning a row tuple moves from it
+ * if it is an rvalue.
+ */
+template <typename... Ts> class soa_reference : public std::tuple<Ts &...> {
+  typedef std::tuple<Ts &...> base;
+
+public:
+  typedef std::tuple<typename std::remove_const<Ts>::type...> value_type;
+  /// What a row of Ts... can refer to.
+  typedef typename std::conditional<(std::is_const<Ts>::value && ...),
+                                    const value_type, value_type>::type
+      row_type;
+
+  explicit soa_reference(Ts &... elems) : base(elems...) {}
+  soa_reference(const soa_reference &other) = default;
+
+  /// Refer to the elements of a row held by value.
+  /*
+   * Algorithms like std::sort hold some rows by value while they work,
+   * and pass them to the same comparison as rows in the container, so
+   * a comparison can take its arguments as soa_reference.
+   */
+  soa_reference(row_type &row)
+      : soa_reference(row, std::index_sequence_for<Ts...>()) {}
+
+  /// Assign the elements other refers to.
+  const soa_reference &operator=(const soa_reference &other) const {
+    this->assign(other, std::index_sequence_for<Ts...>());
+    return *this;
+  }
+
+  /// Assign the elements of a row.
+  const soa_reference &operator=(const value_type &row) const {
+    this->assign(row, std::index_sequence_for<Ts...>());
+    return *this;
+  }
+
+  /// Assign the elements of a row, moving from them.
+  const soa_reference &operator=(value_type &&row) const {
+    this->assign(std::move(row), std::index_sequence_for<Ts...>());
+    return *this;
+  }
+
+  /// Copy the elements out into a row.
+  value_type value() const {
+    return value_type(static_cast<const base &>(*this));
+  }
+
+  /// Swap the elements two references refer to.
+  friend void swap(const soa_reference &first, const soa_reference &second) {
+    first.swap_elements(second, std::index_sequence_for<Ts...>());
+  }
+
+private:
+  template <size_t... Is>
+  soa_reference(row_type &row, std::index_sequence<Is...>)
+      : base(std::get<Is>(row)...) {}
+
+  template <typename Row, size_t... Is>
+  void assign(Row &&row, std::index_sequence<Is...>) const {
+    const base &refs = *this;
+    ((std::get<Is>(refs) = std::get<Is>(std::forward<Row>(row))), ...);
+  }
+
+  template <size_t... Is>
+  void swap_elements(const soa_reference &other,
+                     std::index_sequence<Is...>) const {
+    using std::swap;
+    const base &refs = *this;
+    const base &other_refs = other;
+    (swap(std::get<Is>(refs), std::get<Is>(other_refs)), ...);
+  }
+};
+
+/*
+ * A sequence of rows of Ts..., stored as a structure of arrays: each
+ * column is a prac::vector of its own, so a loop that reads one or
+ * two fields of every row streams through just those fields' memory,
+ * and compiles to the same vectorized code as a loop over a plain
+ * array.
+ *
+ * The columns grow together, with prac::vector's growth policy and
+ * allocator, and always have the same size. column<I>() gives a span
+ * over column I for fast loops; begin() and end() give random-access
+ * iterators over whole rows, whose reference is a soa_reference, for
+ * std algorithms that need to see or move rows at a time.
+ *
+ * Usage:
+ *   prac::soa_vector<uint64_t, double, std::string> trades;
+ *   trades.emplace_back(id, price, venue);
+ *   double total = 0;
+ *   for (double price : trades.column<1>()) {
+ *     total += price;
+ *   }
+ */
+template <typename... Ts> class soa_vector {
+  static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+
+public:
+  typedef std::tuple<Ts...> value_type;
+  typedef soa_reference<Ts...> reference;
+  typedef soa_reference<const Ts...> const_reference;
+
+  /// The element type of column I.
+  template <size_t I>
+  using column_type = typename std::tuple_element<I, value_type>::type;
+
+  /// The number of columns.
+  static constexpr size_t num_columns = sizeof...(Ts);
+
+  /// Construction of an empty container. Allocates nothing.
+  soa_vector() = default;
+
+  /// Add a row at the back.
+  /*
+   * Amortized O(1). If a column throws, the columns already appended
+   * to are shrunk back, so nothing changes.
+   * @param row - one element per column.
+   */
+  void push_back(const value_type &row) {
+    this->push_columns(row, std::index_sequence_for<Ts...>());
+  }
+
+  /// Add a row at the back, moving from its elements.
+  void push_back(value_type &&row) {
+    this->push_columns(std::move(row), std::index_sequence_for<Ts...>());
+  }
+
+  /// Add a row at the back, given one element per column.
+  /*
+   * Amortized O(1). Each argument is forwarded to its column's
+   * constructor, as in prac::vector::emplace_back().
+   * @param elems - one element per column.
+   */
+  template <typename... Args> void emplace_back(Args &&... elems) {
+    static_assert(sizeof...(Args) == sizeof...(Ts),
+                  "emplace_back needs one element per column");
+    this->push_columns(std::forward_as_tuple(std::forward<Args>(elems)...),
+                       std::index_sequence_for<Ts...>());
+  }
+
+  /// Remove the last row. The container must not be empty.
+  void pop_back() {
+    this->for_each_column([](auto &column) { column.pop_back(); });
+  }
+
+  /// Resize every column, default-constructing new rows.
+  /*
+   * O(n) in the number of rows added or removed. If a column throws,
+   * the columns already resized are set back to the old size.
+   * @param sz - the new number of rows.
+   */
+  void resize(const size_t &sz) {
+    size_t old_size = this->size();
+    try {
+      this->for_each_column([&sz](auto &column) { column.resize(sz); });
+    } catch (...) {
+      this->for_each_column([&old_size](auto &column) {
+        if (column.size() > old_size) {
+          column.resize(old_size);
+        }
+      });
+      throw;
+    }
+  }
+
+  /// Make every column's capacity at least sz rows.
+  void reserve(const size_t &sz) {
+    this->for_each_column([&sz](auto &column) { column.reserve(sz); });
+  }
+
+  /// Reduce every column's capacity to the size.
+  void shrink_to_fit() {
+    this->for_each_column([](auto &column) { column.shrink_to_fit(); });
+  }
+
+  /// Remove every row. The capacity is kept.
+  void clear() {
+    this->for_each_column([](auto &column) { column.clear(); });
+  }
+
+  /// Get the number of rows.
+  size_t size() const { return std::get<0>(m_columns).size(); }
+
+  /// Whether there are no rows.
+  bool empty() const { return this->size() == 0; }
+
+  /// Get the number of rows the columns have room for.
+  size_t capacity() const { return std::get<0>(m_columns).capacity(); }
+
+  /// Get column I, for loops over one field.
+  /*
+   * O(1). The span is invalidated by anything that reallocates:
+   * push_back(), emplace_back(), resize() and reserve().
+   */
+  template <size_t I> span<column_type<I>> column() {
+    return span<column_type<I>>(std::get<I>(m_columns));
+  }
+  template <size_t I> span<const column_type<I>> column() const {
+    return span<const column_type<I>>(std::get<I>(m_columns));
+  }
+
+  /// Get the storage of column I.
+  template <size_t I> column_type<I> *data() {
+    return std::get<I>(m_columns).data();
+  }
+  template <size_t I> const column_type<I> *data() const {
+    return std::get<I>(m_columns).data();
+  }
+
+  /// Get row i.
+  /*
+   * O(1) complexity.
+   * @param i - the index of the row.
+   * @return references to the row's elements.
+   */
+  reference operator[](const size_t &i) {
+    return row<reference>(*this, i, std::index_sequence_for<Ts...>());
+  }
+  const_reference operator[](const size_t &i) const {
+    return row<const_reference>(*this, i, std::index_sequence_for<Ts...>());
+  }
+
+  /// Iterates over rows, zipping the columns together.
+  template <typename Ref, typename Container> class basic_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename soa_vector::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Ref reference;
+    /// There is no object to point to; rows only exist as references.
+    typedef void pointer;
+
+    basic_iterator() : m_vec(nullptr), m_index(0) {}
+    basic_iterator(Container *vec, const size_t &index)
+        : m_vec(vec), m_index(index) {}
+    /// A const_iterator can be made from an iterator.
+    template <typename OtherRef, typename Other,
+              typename = typename std::enable_if<
+                  std::is_convertible<Other *, Container *>::value>::type>
+    basic_iterator(const basic_iterator<OtherRef, Other> &other)
+        : m_vec(other.m_vec), m_index(other.m_index) {}
+
+    reference operator*() const { return (*m_vec)[m_index]; }
+    reference operator[](const difference_type &n) const {
+      return (*m_vec)[m_index + n];
+    }
+
+    basic_iterator &operator++() {
+      m_index++;
+      return *this;
+    }
+    basic_iterator operator++(int) {
+      basic_iterator old = *this;
+      m_index++;
+      return old;
+    }
+    basic_iterator &operator--() {
+      m_index--;
+      return *this;
+    }
+    basic_iterator operator--(int) {
+      basic_iterator old = *this;
+      m_index--;
+      return old;
+    }
+    basic_iterator &operator+=(const difference_type &n) {
+      m_index += n;
+      return *this;
+    }
+    basic_iterator &operator-=(const difference_type &n) {
+      m_index -= n;
+      return *this;
+    }
+    basic_iterator operator+(const difference_type &n) const {
+      return basic_iterator(m_vec, m_index + n);
+    }
+    friend basic_iterator operator+(const difference_type &n,
+                                    const basic_iterator &itr) {
+      return itr + n;
+    }
+    basic_iterator operator-(const difference_type &n) const {
+      return basic_iterator(m_vec, m_index - n);
+    }
+    difference_type operator-(const basic_iterator &other) const {
+      return difference_type(m_index) - difference_type(other.m_index);
+    }
+
+    bool operator==(const basic_iterator &other) const {
+      return m_index == other.m_index;
+    }
+    bool operator!=(const basic_iterator &other) const {
+      return m_index != other.m_index;
+    }
+    bool operator<(const basic_iterator &other) const {
+      return m_index < other.m_index;
+    }
+    bool operator>(const basic_iterator &other) const {
+      return m_index > other.m_index;
+    }
+    bool operator<=(const basic_iterator &other) const {
+      return m_index <= other.m_index;
+    }
+    bool operator>=(const basic_iterator &other) const {
+      return m_index >= other.m_index;
+    }
+
+  private:
+    template <typename OtherRef, typename Other> friend class basic_iterator;
+    Container *m_vec;
+    size_t m_index;
+  };
+
+  typedef basic_iterator<reference, soa_vector> iterator;
+  typedef basic_iterator<const_reference, const soa_vector> const_iterator;
+
+  /// Row iterators. All of these are created and moved in O(1), and
+  /// invalidated by anything that reallocates.
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, this->size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, this->size()); }
+  const_iterator cbegin() const { return this->begin(); }
+  const_iterator cend() const { return this->end(); }
+
+private:
+  template <typename Row, size_t... Is>
+  void push_columns(Row &&row, std::index_sequence<Is...>) {
+    size_t num_pushed = 0;
+    try {
+      ((std::get<Is>(m_columns).emplace_back(
+            std::get<Is>(std::forward<Row>(row))),
+        num_pushed++),
+       ...);
+    } catch (...) {
+      ((Is < num_pushed ? std::get<Is>(m_columns).pop_back() : void()), ...);
+      throw;
+    }
+  }
+
+  template <typename Ref, typename Self, size_t... Is>
+  static Ref row(Self &self, const size_t &i, std::index_sequence<Is...>) {
+    return Ref(std::get<Is>(self.m_columns)[i]...);
+  }
+
+  template <typename Func> void for_each_column(Func func) {
+    std::apply([&func](auto &... columns) { (func(columns), ...); },
+               m_columns);
+  }
+
+  std::tuple<prac::vector<Ts>...> m_columns;
+};
+}; // namespace prac
+
+namespace std {
+/// Let structured bindings take a soa_reference apart.
+template <typename... Ts>
+struct tuple_size<prac::soa_reference<Ts...>>
+    : std::integral_constant<size_t, sizeof...(Ts)> {};
+template <size_t I, typename... Ts>
+struct tuple_element<I, prac::soa_reference<Ts...>>
+    : tuple_element<I, tuple<Ts &...>> {};
+}; // namespace std
@@ -0,0 +1,82 @@
+#pragma once
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+namespace prac {
+/*
+ * A non-owning view of n contiguous elements: a pointer and a length,
+ * like C++20's std::span with a dynamic extent.
+ *
+ * Iterators are plain pointers, so loops over a span compile to the
+ * same code as loops over the array, vectorization included. A span
+ * is only valid while the storage it views is; for a prac::vector,
+ * that is until the next reallocation.
+ */
+template <typename T> class span {
+public:
+  typedef T element_type;
+  typedef typename std::remove_cv<T>::type value_type;
+  typedef T *iterator;
+
+  /// Construction of an empty span.
+  span() : m_data(nullptr), m_size(0) {}
+
+  /// Construction from a pointer and a length.
+  /*
+   * @param data - the first element.
+   * @param size - the number of elements.
+   */
+  span(T *data, const size_t &size) : m_data(data), m_size(size) {}
+
+  /// Construction from a span of non-const elements.
+  template <typename Other,
+            typename = typename std::enable_if<
+                std::is_convertible<Other (*)[], T (*)[]>::value>::type>
+  span(const span<Other> &other) : m_data(other.data()), m_size(other.size()) {}
+
+  /// Construction from any container with contiguous storage and
+  /// data() and size(), e.g. prac::vector.
+  template <typename Container,
+            typename = typename std::enable_if<std::is_convertible<
+                typename std::remove_pointer<decltype(
+                    std::declval<Container &>().data())>::type (*)[],
+                T (*)[]>::value>::type,
+            typename = decltype(std::declval<Container &>().size())>
+  span(Container &container)
+      : m_data(container.data()), m_size(container.size()) {}
+
+  T *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  T &operator[](const size_t &i) const { return m_data[i]; }
+  T &front() const { return m_data[0]; }
+  T &back() const { return m_data[m_size - 1]; }
+
+  iterator begin() const { return m_data; }
+  iterator end() const { return m_data + m_size; }
+
+  /// Get the count elements starting at offset.
+  /*
+   * O(1). The range must be within the span.
+   * @param offset - the index of the first element.
+   * @param count - the number of elements.
+   */
+  span subspan(const size_t &offset, const size_t &count) const {
+    return span(m_data + offset, count);
+  }
+
+  /// Get the first count elements.
+  span first(const size_t &count) const { return span(m_data, count); }
+
+  /// Get the last count elements.
+  span last(const size_t &count) const {
+    return span(m_data + m_size - count, count);
+  }
+
+private:
+  T *m_data;
+  size_t m_size;
+};
+}; // namespace prac
@@ -0,0 +1,182 @@
+#pragma once
+#include <atomic>
+#include <ostream>
+#include <stddef.h>
+
+/*
+ * Opt-in instrumentation for the prac containers.
+ *
+ * Define PRAC_CONTAINER_STATS (for the whole program) to have every
+ * prac::vector and prac::list count its reallocations, relocated
+ * elements, peak capacity, growth slack and node traffic. Each
+ * container then has a stats() accessor for its own counters, and
+ * prac::stats_registry::global() holds process-wide totals.
+ *
+ * Without the define, PRAC_STATS() expands to nothing and the
+ * containers have no stats member, so there is no cost at all.
+ */
+#ifdef PRAC_CONTAINER_STATS
+#define PRAC_STATS(statement) statement
+#else
+#define PRAC_STATS(statement)
+#endif
+
+namespace prac {
+
+/// The kinds of container the registry keeps totals for.
+enum class stats_kind { vector, list };
+
+/// Counters for one container, or a snapshot of a registry total.
+struct container_stats {
+  /// Times the element storage moved to a bigger buffer.
+  size_t reallocations = 0;
+  /// Elements moved or copied into a new buffer by those reallocations.
+  size_t elements_relocated = 0;
+  /// The largest capacity ever allocated.
+  size_t peak_capacity = 0;
+  /// Capacity allocated beyond the size asked for by resize().
+  size_t slack_capacity = 0;
+  /// Nodes constructed and destroyed (lists only).
+  size_t node_allocations = 0;
+  size_t node_frees = 0;
+
+  void dump(std::ostream &out) const {
+    out << "reallocations=" << reallocations
+        << " elements_relocated=" << elements_relocated
+        << " peak_capacity=" << peak_capacity
+        << " slack_capacity=" << slack_capacity
+        << " node_allocations=" << node_allocations
+        << " node_frees=" << node_frees;
+  }
+};
+
+/// Process-wide totals, updated with relaxed atomics.
+class stats_registry {
+public:
+  static stats_registry &global() {
+    static stats_registry registry;
+    return registry;
+  }
+
+  void on_reallocation(const stats_kind &kind, const size_t &relocated) {
+    Counters &counters = m_counters[index(kind)];
+    counters.reallocations.fetch_add(1, std::memory_order_relaxed);
+    counters.elements_relocated.fetch_add(relocated,
+                                          std::memory_order_relaxed);
+  }
+
+  void on_capacity(const stats_kind &kind, const size_t &capacity) {
+    std::atomic<size_t> &peak_capacity = m_counters[index(kind)].peak_capacity;
+    size_t peak = peak_capacity.load(std::memory_order_relaxed);
+    while (peak < capacity &&
+           !peak_capacity.compare_exchange_weak(peak, capacity,
+                                                std::memory_order_relaxed)) {
+    }
+  }
+
+  void on_slack(const stats_kind &kind, const size_t &slack) {
+    m_counters[index(kind)].slack_capacity.fetch_add(
+        slack, std::memory_order_relaxed);
+  }
+
+  void on_node_allocation(const stats_kind &kind) {
+    m_counters[index(kind)].node_allocations.fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  void on_node_free(const stats_kind &kind) {
+    m_counters[index(kind)].node_frees.fetch_add(1,
+                                                 std::memory_order_relaxed);
+  }
+
+  /// Get the totals for one kind of container.
+  container_stats snapshot(const stats_kind &kind) const {
+    const Counters &counters = m_counters[index(kind)];
+    container_stats stats;
+    stats.reallocations = counters.reallocations.load();
+    stats.elements_relocated = counters.elements_relocated.load();
+    stats.peak_capacity = counters.peak_capacity.load();
+    stats.slack_capacity = counters.slack_capacity.load();
+    stats.node_allocations = counters.node_allocations.load();
+    stats.node_frees = counters.node_frees.load();
+    return stats;
+  }
+
+  /// Zero every total.
+  void reset() {
+    for (Counters &counters : m_counters) {
+      counters.reallocations = 0;
+      counters.elements_relocated = 0;
+      counters.peak_capacity = 0;
+      counters.slack_capacity = 0;
+      counters.node_allocations = 0;
+      counters.node_frees = 0;
+    }
+  }
+
+  /// Write one line of totals per kind of container.
+  void dump(std::ostream &out) const {
+    out << "prac::vector: ";
+    this->snapshot(stats_kind::vector).dump(out);
+    out << "\nprac::list: ";
+    this->snapshot(stats_kind::list).dump(out);
+    out << "\n";
+  }
+
+private:
+  struct Counters {
+    std::atomic<size_t> reallocations{0};
+    std::atomic<size_t> elements_relocated{0};
+    std::atomic<size_t> peak_capacity{0};
+    std::atomic<size_t> slack_capacity{0};
+    std::atomic<size_t> node_allocations{0};
+    std::atomic<size_t> node_frees{0};
+  };
+
+  static size_t index(const stats_kind &kind) { return size_t(kind); }
+
+  Counters m_counters[2];
+};
+
+namespace detail {
+
+/// Update a container's own counters and the registry together.
+/*
+ * Call when new element storage is allocated. It only counts as a
+ * reallocation if there was storage (even inline storage) before.
+ */
+inline void stats_on_storage(container_stats &stats, const stats_kind &kind,
+                             const size_t &old_capacity,
+                             const size_t &relocated,
+                             const size_t &new_capacity) {
+  if (old_capacity > 0) {
+    stats.reallocations++;
+    stats.elements_relocated += relocated;
+    stats_registry::global().on_reallocation(kind, relocated);
+  }
+  if (new_capacity > stats.peak_capacity) {
+    stats.peak_capacity = new_capacity;
+  }
+  stats_registry::global().on_capacity(kind, new_capacity);
+}
+
+inline void stats_on_slack(container_stats &stats, const stats_kind &kind,
+                           const size_t &slack) {
+  stats.slack_capacity += slack;
+  stats_registry::global().on_slack(kind, slack);
+}
+
+inline void stats_on_node_allocation(container_stats &stats,
+                                     const stats_kind &kind) {
+  stats.node_allocations++;
+  stats_registry::global().on_node_allocation(kind);
+}
+
+inline void stats_on_node_free(container_stats &stats,
+                               const stats_kind &kind) {
+  stats.node_frees++;
+  stats_registry::global().on_node_free(kind);
+}
+
+}; // namespace detail
+}; // namespace prac
@@ -0,0 +1,108 @@
+#pragma once
+#include "hash_table.hpp"
+#include "memory.hpp"
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace prac {
+
+/*
+ * A hash map from K to V, in flat arrays: see detail::hash_table.
+ *
+ * Unlike std::unordered_map, elements move when the table grows and
+ * when another element is erased, so references and iterators to them
+ * are invalidated by insert and erase alike; in exchange there is no
+ * allocation per element, and a lookup usually touches one group of
+ * control bytes and one element. V's move constructor must not throw.
+ *
+ * With the default Hash and Eq, a map with std::string keys can be
+ * searched with a std::string_view or a C string.
+ */
+template <typename K, typename V, typename Hash = prac::hash<K>,
+          typename Eq = prac::equal_to<K>,
+          typename Alloc = prac::allocator<std::pair<const K, V>>>
+class unordered_map
+    : public detail::hash_table<detail::map_policy<K, V>, Hash, Eq, Alloc> {
+  typedef detail::hash_table<detail::map_policy<K, V>, Hash, Eq, Alloc> base;
+
+public:
+  typedef V mapped_type;
+
+  using base::base;
+  unordered_map() = default;
+
+  /// Get the value for key, inserting a default-constructed one if
+  /// it isn't there.
+  V &operator[](const K &key) { return this->try_emplace(key).first->second; }
+  V &operator[](K &&key) {
+    return this->try_emplace(std::move(key)).first->second;
+  }
+
+  /// Get the value for key, which must be there.
+  /*
+   * Throws std::out_of_range if it isn't.
+   */
+  template <typename K2 = K>
+  V &at(const typename base::template key_arg<K2> &key) {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw std::out_of_range("prac::unordered_map::at");
+    }
+    return it->second;
+  }
+  template <typename K2 = K>
+  const V &at(const typename base::template key_arg<K2> &key) const {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw std::out_of_range("prac::unordered_map::at");
+    }
+    return it->second;
+  }
+
+  /// Insert a value constructed from args for key, unless key is
+  /// already there, in which case args are left untouched.
+  /*
+   * @return an iterator to the element with the key, and whether it
+   *         was inserted.
+   */
+  template <typename... Args>
+  std::pair<typename base::iterator, bool> try_emplace(const K &key,
+                                                       Args &&... args) {
+    return this->emplace_key(
+        key, std::piecewise_construct, std::forward_as_tuple(key),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+  template <typename... Args>
+  std::pair<typename base::iterator, bool> try_emplace(K &&key,
+                                                       Args &&... args) {
+    return this->emplace_key(
+        key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  /// Set the value for key, inserting it if it isn't there.
+  /*
+   * @return as try_emplace().
+   */
+  template <typename M>
+  std::pair<typename base::iterator, bool> insert_or_assign(const K &key,
+                                                            M &&value) {
+    auto result = this->try_emplace(key, std::forward<M>(value));
+    if (!result.second) {
+      result.first->second = std::forward<M>(value);
+    }
+    return result;
+  }
+  template <typename M>
+  std::pair<typename base::iterator, bool> insert_or_assign(K &&key,
+                                                            M &&value) {
+    auto result = this->try_emplace(std::move(key), std::forward<M>(value));
+    if (!result.second) {
+      result.first->second = std::forward<M>(value);
+    }
+    return result;
+  }
+};
+
+}; // namespace prac
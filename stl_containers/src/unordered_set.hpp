@@ -0,0 +1,23 @@
+#pragma once
+#include "hash_table.hpp"
+#include "memory.hpp"
+
+namespace prac {
+
+/*
+ * A hash set of K, in flat arrays: see detail::hash_table, and
+ * unordered_map for how it differs from std. Iterators give const
+ * references, since changing a key in place would lose it.
+ */
+template <typename K, typename Hash = prac::hash<K>,
+          typename Eq = prac::equal_to<K>, typename Alloc = prac::allocator<K>>
+class unordered_set
+    : public detail::hash_table<detail::set_policy<K>, Hash, Eq, Alloc> {
+  typedef detail::hash_table<detail::set_policy<K>, Hash, Eq, Alloc> base;
+
+public:
+  using base::base;
+  unordered_set() = default;
+};
+
+}; // namespace prac
@@ -1,43 +1,192 @@
 #pragma once
+#include "growth.hpp"
+#include "memory.hpp"
+#include "stats.hpp"
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <stddef.h>
 
 namespace prac {
 /*
  * A dynamically-sized container with contiguous storage.
  * Insertion in O(1) amortized time, random O(1) access.
+ *
+ * Storage comes from Alloc, which can be any allocator that
+ * std::allocator_traits understands, e.g. prac::arena_allocator.
+ * Growth picks the capacity of each reallocation; see growth.hpp.
  */
-template <typename T> class vector {
+template <typename T, typename Alloc = prac::allocator<T>,
+          typename Growth = prac::growth_2x>
+class vector {
+  typedef std::allocator_traits<Alloc> alloc_traits;
+
 public:
+  typedef Alloc allocator_type;
+
   /// Construction from size and default value.
   /*
    * @param num_elements - The initial size of the container.
    * @param end - The value to which to set all elements.
+   * @param alloc - The allocator to get storage from.
+   *
+   * Allocates exactly num_elements, so an empty vector allocates
+   * nothing.
    */
-  vector(size_t num_elements = 0, T default_value = T())
-      : m_num_elements(num_elements) {
-    m_num_allocated = 10 + num_elements;
-    m_storage = new T[m_num_allocated];
-    for (size_t i = 0; i < m_num_elements; i++) {
-      m_storage[i] = default_value;
-    }
+  vector(size_t num_elements = 0, T default_value = T(),
+         const Alloc &alloc = Alloc())
+      : vector(alloc) {
+    this->allocate(num_elements);
+    detail::uninitialized_fill(m_storage, num_elements, default_value);
+    m_num_elements = num_elements;
   }
 
+  /// Construction of an empty container with a given allocator.
+  /*
+   * Allocates nothing.
+   * @param alloc - The allocator to get storage from.
+   */
+  explicit vector(const Alloc &alloc)
+      : m_alloc(alloc), m_storage(nullptr), m_num_allocated(0),
+        m_num_elements(0) {}
+
   /// Construction from STL container iterators.
   /*
+   * O(n). A forward range is measured first and gets exactly one
+   * allocation; see append(). Integral arguments go to the size and
+   * value constructor instead.
    * @param begin - the beginning iterator.
    * @param end - the ending iterator.
+   * @param alloc - The allocator to get storage from.
    */
-  template <typename Other> vector(const Other &begin, const Other &end) {
-    m_num_allocated = 10;
-    m_num_elements = 0;
-    m_storage = new T[m_num_allocated];
-    for (auto itr = begin; itr != end; itr++) {
-      this->push_back(*itr);
+  template <typename Other, typename = typename std::enable_if<
+                                !std::is_integral<Other>::value>::type>
+  vector(const Other &begin, const Other &end, const Alloc &alloc = Alloc())
+      : vector(alloc) {
+    this->append(begin, end);
+  }
+
+  /// Copy construction.
+  /*
+   * O(n). The copy gets exactly as much storage as it needs.
+   * @param other - the vector to copy.
+   */
+  vector(const vector &other)
+      : vector(other, alloc_traits::select_on_container_copy_construction(
+                          other.m_alloc)) {}
+
+  /// Copy construction with a different allocator.
+  /*
+   * O(n).
+   * @param other - the vector to copy.
+   * @param alloc - The allocator to get storage from.
+   */
+  vector(const vector &other, const Alloc &alloc)
+      : vector(alloc) {
+    this->copy_elements(other);
+  }
+
+  /// Move construction.
+  /*
+   * O(1). Steals the storage of other, which is left empty, along
+   * with its stats counters.
+   * @param other - the vector to move from.
+   */
+  vector(vector &&other) noexcept
+      : m_alloc(std::move(other.m_alloc)), m_storage(other.m_storage),
+        m_num_allocated(other.m_num_allocated),
+        m_num_elements(other.m_num_elements) {
+    other.m_storage = nullptr;
+    other.m_num_allocated = 0;
+    other.m_num_elements = 0;
+    PRAC_STATS(m_stats = other.m_stats; other.m_stats = container_stats();)
+  }
+
+  /// Copy assignment.
+  /*
+   * O(n). Provides the strong exception guarantee. Keeps this
+   * vector's allocator.
+   */
+  vector &operator=(const vector &other) {
+    if (this != &other) {
+      vector copy(other, m_alloc);
+      this->swap(copy);
     }
+    return *this;
+  }
+
+  /// Move assignment.
+  /*
+   * O(n) in the number of elements destroyed, O(1) otherwise. If the
+   * allocators differ and don't propagate, elements are moved one by
+   * one into storage from this vector's allocator.
+   */
+  vector &operator=(vector &&other) noexcept(
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value) {
+    if (this == &other) {
+      return *this;
+    }
+    if (alloc_traits::propagate_on_container_move_assignment::value ||
+        m_alloc == other.m_alloc) {
+      if (alloc_traits::propagate_on_container_move_assignment::value) {
+        this->release();
+        m_alloc = std::move(other.m_alloc);
+      }
+      this->take_storage(other);
+    } else {
+      vector moved(m_alloc);
+      moved.allocate(other.m_num_elements);
+      detail::relocate(moved.m_storage, other.m_storage, other.m_num_elements);
+      moved.m_num_elements = other.m_num_elements;
+      other.m_num_elements = 0;
+      this->swap(moved);
+      other.release();
+      PRAC_STATS(m_stats = other.m_stats; other.m_stats = container_stats();)
+    }
+    return *this;
+  }
+
+  ~vector() { this->release(); }
+
+  /// Exchange contents with another vector in O(1).
+  /*
+   * Allocators and stats counters are exchanged too. The allocators
+   * should either propagate on swap or compare equal.
+   */
+  void swap(vector &other) noexcept {
+    Alloc alloc = std::move(m_alloc);
+    T *storage = m_storage;
+    size_t num_allocated = m_num_allocated;
+    size_t num_elements = m_num_elements;
+    m_alloc = std::move(other.m_alloc);
+    m_storage = other.m_storage;
+    m_num_allocated = other.m_num_allocated;
+    m_num_elements = other.m_num_elements;
+    other.m_alloc = std::move(alloc);
+    other.m_storage = storage;
+    other.m_num_allocated = num_allocated;
+    other.m_num_elements = num_elements;
+    PRAC_STATS(std::swap(m_stats, other.m_stats);)
   }
 
+  /// Remove every element.
+  /*
+   * O(n) in the number of elements destroyed. The storage is kept.
+   */
+  void clear() {
+    detail::destroy(m_storage, m_num_elements);
+    m_num_elements = 0;
+  }
+
+  /// Get a copy of the allocator.
+  Alloc get_allocator() const { return m_alloc; }
+
+#ifdef PRAC_CONTAINER_STATS
+  /// Get this vector's instrumentation counters.
+  const container_stats &stats() const { return m_stats; }
+#endif
+
   /// Push back a new element to the container.
   /*
    * This can result in a reallocation if we haven't
@@ -45,12 +194,84 @@ public:
    * to O(1).
    * @param new_elem - the new element to add.
    */
-  void push_back(const T &new_elem) {
+  void push_back(const T &new_elem) { this->emplace_back(new_elem); }
+
+  /// Push back a new element to the container, moving from it.
+  /*
+   * Amortized O(1).
+   * @param new_elem - the new element to add.
+   */
+  void push_back(T &&new_elem) { this->emplace_back(std::move(new_elem)); }
+
+  /// Replace the contents with copies of a range.
+  /*
+   * O(n). A forward range that doesn't fit in the current storage
+   * gets exactly one new allocation of its size.
+   * @param first - the beginning of the range. The range must not be
+   *                part of this vector.
+   * @param last - the end of the range.
+   */
+  template <typename Other> void assign(Other first, Other last) {
+    this->clear();
+    if (!detail::is_forward_iterator<Other>::value) {
+      this->append(first, last);
+      return;
+    }
+    size_t num_new = size_t(std::distance(first, last));
+    if (num_new > m_num_allocated) {
+      this->release();
+    }
+    this->append_n(first, num_new);
+  }
+
+  /// Add copies of a range to the back of the container.
+  /*
+   * O(n) in the length of the range. A forward range is measured
+   * once, so there is at most one reallocation, and the elements are
+   * constructed in one pass: a single memcpy for trivially copyable T
+   * from a pointer range (or any contiguous range in C++20). An empty
+   * vector allocates exactly the length of the range; otherwise the
+   * growth policy picks the capacity. Input ranges are pushed back
+   * one by one.
+   * @param first - the beginning of the range. The range must not be
+   *                part of this vector.
+   * @param last - the end of the range.
+   */
+  template <typename Other> void append(Other first, Other last) {
+    if (!detail::is_forward_iterator<Other>::value) {
+      for (; first != last; ++first) {
+        this->emplace_back(*first);
+      }
+      return;
+    }
+    this->append_n(first, size_t(std::distance(first, last)));
+  }
+
+  /// Construct a new element in place at the back of the container.
+  /*
+   * Amortized O(1). The arguments are forwarded to T's constructor
+   * and the element is built directly in the storage, so no
+   * temporary is copied or moved.
+   * @param args - the arguments to T's constructor.
+   * @return a reference to the new element.
+   */
+  template <typename... Args> T &emplace_back(Args &&... args) {
     if (m_num_elements >= m_num_allocated) {
-      this->allocate(m_num_allocated * 2);
+      this->grow_and_construct_back(std::forward<Args>(args)...);
+    } else {
+      new (m_storage + m_num_elements) T(std::forward<Args>(args)...);
     }
-    m_storage[m_num_elements] = new_elem;
     m_num_elements++;
+    return m_storage[m_num_elements - 1];
+  }
+
+  /// Remove the back element.
+  /*
+   * O(1). The storage is kept. The container must not be empty.
+   */
+  void pop_back() {
+    m_num_elements--;
+    detail::destroy(m_storage + m_num_elements, 1);
   }
 
   /// Retrieve an element.
@@ -85,6 +306,12 @@ public:
    */
   size_t size() const { return m_num_elements; }
 
+  // Retrieve the capacity of the container.
+  /*
+   * @return the number of elements that fit without a reallocation.
+   */
+  size_t capacity() const { return m_num_allocated; }
+
   // Resize the container.
   /*
    * Up to O(n)
@@ -93,21 +320,42 @@ public:
    * be added to the end. If the requested size is smaller, there
    * will obviously be a loss of elements. A reallocation will
    * occur if the new size is beyond the current allocated storage
-   * size.
+   * size, and it grows the capacity by the growth policy, so
+   * growing one element at a time is amortized O(1) per element.
    * @param sz - the new size of the container.
    * @param default_value - the value to which to set the new
    *                        storage.
    */
   void resize(const size_t &sz, const T &default_value = T()) {
-    // Reallocate
+    this->resize_with(sz, [&default_value](T *first, const size_t &n) {
+      detail::uninitialized_fill(first, n, default_value);
+    });
+  }
+
+  /// Resize the container, letting init construct the new elements.
+  /*
+   * Like resize(), for ways of building elements that vector has no
+   * interface for, e.g. prac::parallel constructing them on several
+   * threads. If the container grows, init(first, n) is called with
+   * uninitialized storage for the n new elements. It must construct
+   * all of them, or, if it throws, none.
+   * @param sz - the new size of the container.
+   * @param init - a callable taking a T * and a size_t.
+   */
+  template <typename Init> void resize_with(const size_t &sz, Init init) {
     if (sz > m_num_elements) {
-      this->allocate(sz + 10);
-      // Allocate copied our values. We need to set the
-      // remaining defaults.
-      for (size_t i = m_num_elements; i < sz; i++) {
-        m_storage[i] = default_value;
+      // Reallocate
+      if (sz > m_num_allocated) {
+        size_t new_allocated = Growth::grow(m_num_allocated, sz, sizeof(T));
+        this->allocate(new_allocated);
+        PRAC_STATS(detail::stats_on_slack(m_stats, stats_kind::vector,
+                                          new_allocated - sz);)
       }
-      // Change the tracking variable.
+      // Allocate moved our values. We need to construct the
+      // remaining ones.
+      init(m_storage + m_num_elements, sz - m_num_elements);
+    } else {
+      detail::destroy(m_storage + sz, m_num_elements - sz);
     }
     m_num_elements = sz;
   }
@@ -115,175 +363,315 @@ public:
   // Allocate at least sz elements in the storage.
   /*
    * Up to O(n)
+   * The new storage is left uninitialized past size(). Existing
+   * elements are relocated: one memcpy for trivially copyable T,
+   * a move for T with a noexcept move constructor, a copy otherwise.
    * @param sz - the number of elements w need, at least.
    */
   void allocate(const size_t &sz) {
     if (sz > m_num_allocated) {
-      T *new_storage = new T[sz];
-      for (size_t i = 0; i < m_num_elements; i++) {
-        new_storage[i] = m_storage[i];
+      auto allocation = detail::allocate_at_least(m_alloc, sz);
+      try {
+        detail::relocate(allocation.ptr, m_storage, m_num_elements);
+      } catch (...) {
+        alloc_traits::deallocate(m_alloc, allocation.ptr, allocation.count);
+        throw;
       }
-      delete[] m_storage;
-      m_num_allocated = sz;
-      m_storage = new_storage;
+      this->deallocate_storage();
+      PRAC_STATS(detail::stats_on_storage(m_stats, stats_kind::vector,
+                                          m_num_allocated, m_num_elements,
+                                          allocation.count);)
+      m_num_allocated = allocation.count;
+      m_storage = allocation.ptr;
     }
   }
 
-  class iterator
-      : public std::iterator<std::input_iterator_tag, // iterator_category
-                             T,                       // value_type
-                             size_t,                       // difference_type
-                             const T *,               // pointer
-                             T                        // reference
-                             > {
-    vector<T> *m_vector = nullptr;
-    size_t m_pos;
-
-  public:
-    iterator(vector<T> *vector, size_t pos = 0)
-        : m_vector(vector), m_pos(pos) {}
-
-    /// Prefix
-    iterator &operator++() {
-      m_pos++;
-      return *this;
-    }
+  /// Allocate at least sz elements in the storage.
+  /*
+   * The same as allocate(), under the standard library's name. The
+   * growth policy is not consulted: if sz is more than capacity(),
+   * exactly sz elements are allocated.
+   * @param sz - the number of elements we need, at least.
+   */
+  void reserve(const size_t &sz) { this->allocate(sz); }
 
-    /// Postfix
-    iterator operator++(int) {
-      iterator retval = *this;
-      ++(*this);
-      return retval;
+  /// Reduce the capacity to the size.
+  /*
+   * O(n). An empty vector gives back all of its storage. The
+   * allocator may hand back room for more than the size; see
+   * detail::allocate_at_least().
+   */
+  void shrink_to_fit() {
+    if (m_num_allocated == m_num_elements) {
+      return;
     }
-
-    /// Prefix
-    iterator &operator--() {
-      m_pos--;
-      return *this;
+    if (m_num_elements == 0) {
+      this->release();
+      return;
     }
-
-    /// Postfix
-    iterator operator--(int) {
-      iterator retval = *this;
-      --(*this);
-      return retval;
+    auto allocation = detail::allocate_at_least(m_alloc, m_num_elements);
+    try {
+      detail::relocate(allocation.ptr, m_storage, m_num_elements);
+    } catch (...) {
+      alloc_traits::deallocate(m_alloc, allocation.ptr, allocation.count);
+      throw;
     }
+    this->deallocate_storage();
+    m_num_allocated = allocation.count;
+    m_storage = allocation.ptr;
+  }
 
-    size_t operator-(const iterator &iterator) {
-      return this->m_pos - iterator.m_pos;
-    }
+  /// Iterators are plain pointers into the storage.
+  /*
+   * That makes them contiguous iterators (C++20) and random-access
+   * iterators with signed differences, so std::sort, std::copy and
+   * friends take their pointer fast paths. Like std::vector's, they
+   * are invalidated by any reallocation.
+   */
+  typedef T value_type;
+  typedef T *iterator;
+  typedef const T *const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
-    iterator operator+(const size_t &count) {
-      iterator return_val = *this;
-      return_val.m_pos += count;
-      return return_val;
-    }
+  /// Get a pointer to the storage.
+  /*
+   * The first size() elements are valid. May be nullptr when empty.
+   */
+  T *data() { return m_storage; }
+  const T *data() const { return m_storage; }
 
-    iterator operator-(const size_t &count) {
-      iterator return_val = *this;
-      return_val.m_pos -= count;
-      return return_val;
+  /// Construct a new element in place before pos.
+  /*
+   * O(n) in the number of elements after pos. Inserting at end() is
+   * the same as emplace_back().
+   * @param pos - the position to insert before.
+   * @param args - the arguments to T's constructor.
+   * @return an iterator to the new element.
+   */
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args &&... args) {
+    size_t index = size_t(pos - m_storage);
+    if (index == m_num_elements) {
+      this->emplace_back(std::forward<Args>(args)...);
+      return m_storage + index;
     }
-
-    bool operator<(const iterator &iterator) {
-      return this->m_pos < iterator.m_pos;
+    // args may refer to an element we're about to shift.
+    T new_elem(std::forward<Args>(args)...);
+    this->emplace_back(std::move(m_storage[m_num_elements - 1]));
+    for (size_t i = m_num_elements - 2; i > index; i--) {
+      m_storage[i] = std::move(m_storage[i - 1]);
     }
+    m_storage[index] = std::move(new_elem);
+    return m_storage + index;
+  }
 
-    bool operator>(const iterator &iterator) {
-      return this->m_pos > iterator.m_pos;
+  /// Insert copies of a range before pos.
+  /*
+   * O(n + m) for m elements after pos. A forward range is measured
+   * once, so there is at most one reallocation and the elements
+   * after pos move once. An input range is first collected into a
+   * temporary vector. Provides the basic exception guarantee.
+   * @param pos - the position to insert before.
+   * @param first - the beginning of the range. The range must not be
+   *                part of this vector.
+   * @param last - the end of the range.
+   * @return an iterator to the first inserted element, or pos if the
+   *         range is empty.
+   */
+  template <typename Other>
+  iterator insert(const_iterator pos, Other first, Other last) {
+    size_t index = size_t(pos - m_storage);
+    if (!detail::is_forward_iterator<Other>::value) {
+      vector collected(first, last, m_alloc);
+      return this->insert(pos, std::make_move_iterator(collected.begin()),
+                          std::make_move_iterator(collected.end()));
     }
-
-    bool operator==(iterator other) const { return m_pos == other.m_pos; }
-
-    bool operator!=(iterator other) const { return !(*this == other); }
-
-    const T &operator*() const { return m_vector->operator[](m_pos); }
-
-    T &operator*() { return m_vector->operator[](m_pos); }
-  };
-
-  // Forward iterators. All of these are created and incremented in O(1).
-  iterator begin() { return iterator(this); }
-  iterator end() { return iterator(this, this->size()); }
-  const iterator cbegin() const { return iterator(this); }
-  const iterator cend() const { return iterator(this, this->size()); }
-
-  class reverse_iterator
-      : public std::iterator<std::input_iterator_tag, // iterator_category
-                             T,                       // value_type
-                             size_t,                       // difference_type
-                             const T *,               // pointer
-                             T                        // reference
-                             > {
-    vector<T> *m_vector = nullptr;
-    size_t m_pos;
-
-  public:
-    reverse_iterator(vector<T> *vector, size_t pos = 0)
-        : m_vector(vector), m_pos(pos) {}
-    reverse_iterator &operator++() {
-      m_pos++;
-      return *this;
+    size_t num_new = size_t(std::distance(first, last));
+    if (index == m_num_elements || num_new == 0) {
+      this->append_n(first, num_new);
+      return m_storage + index;
     }
-    reverse_iterator operator++(int) {
-      reverse_iterator retval = *this;
-      ++(*this);
-      return retval;
+    size_t required = m_num_elements + num_new;
+    if (required > m_num_allocated) {
+      this->allocate(Growth::grow(m_num_allocated, required, sizeof(T)));
     }
-
-    reverse_iterator &operator--() {
-      m_pos--;
-      return *this;
+    T *gap = m_storage + index;
+    T *old_end = m_storage + m_num_elements;
+    size_t num_after = m_num_elements - index;
+    if (std::is_trivially_copyable<T>::value) {
+      detail::uninitialized_move(gap + num_new, gap, num_after);
+      detail::uninitialized_copy_n(gap, first, num_new);
+      m_num_elements = required;
+    } else if (num_after > num_new) {
+      // The last num_new elements move into uninitialized storage,
+      // the rest of the tail shifts up and the range is assigned
+      // over the gap.
+      detail::uninitialized_move(old_end, old_end - num_new, num_new);
+      m_num_elements = required;
+      for (T *dst = old_end - 1; dst >= gap + num_new; dst--) {
+        *dst = std::move(*(dst - num_new));
+      }
+      for (size_t i = 0; i < num_new; i++, ++first) {
+        gap[i] = *first;
+      }
+    } else {
+      // The part of the range past the old end is constructed, the
+      // whole tail moves after it and the rest of the range is
+      // assigned over the tail's old place.
+      Other mid = first;
+      std::advance(mid, num_after);
+      detail::uninitialized_copy_n(old_end, mid, num_new - num_after);
+      m_num_elements += num_new - num_after;
+      detail::uninitialized_move(gap + num_new, gap, num_after);
+      m_num_elements = required;
+      for (size_t i = 0; i < num_after; i++, ++first) {
+        gap[i] = *first;
+      }
     }
+    return gap;
+  }
 
-    reverse_iterator operator--(int) {
-      reverse_iterator retval = *this;
-      --(*this);
-      return retval;
-    }
+  // Forward iterators. All of these are created and incremented in O(1).
+  iterator begin() { return m_storage; }
+  iterator end() { return m_storage + m_num_elements; }
+  const_iterator begin() const { return m_storage; }
+  const_iterator end() const { return m_storage + m_num_elements; }
+  const_iterator cbegin() const { return m_storage; }
+  const_iterator cend() const { return m_storage + m_num_elements; }
 
-    size_t operator-(const reverse_iterator &iterator) {
-      return this->m_pos - iterator.m_pos;
-    }
+  // Reverse iterators. All of these are created and incremented in O(1).
+  reverse_iterator rbegin() { return reverse_iterator(this->end()); }
+  reverse_iterator rend() { return reverse_iterator(this->begin()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(this->end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(this->begin());
+  }
+  const_reverse_iterator crbegin() const {
+    return const_reverse_iterator(this->end());
+  }
+  const_reverse_iterator crend() const {
+    return const_reverse_iterator(this->begin());
+  }
 
-    bool operator<(const reverse_iterator &iterator) {
-      return this->m_pos < iterator.m_pos;
-    }
+protected:
+  template <typename, typename, typename> friend class vector;
 
-    bool operator>(const reverse_iterator &iterator) {
-      return this->m_pos > iterator.m_pos;
-    }
+  /// Take over the storage, elements and stats counters of other in
+  /// O(1), leaving it empty with no storage.
+  /*
+   * This vector's own elements and storage are released first. Its
+   * allocator must be able to deallocate other's storage.
+   */
+  template <typename OtherAlloc>
+  void take_storage(vector<T, OtherAlloc, Growth> &other) noexcept {
+    this->release();
+    m_storage = other.m_storage;
+    m_num_allocated = other.m_num_allocated;
+    m_num_elements = other.m_num_elements;
+    other.m_storage = nullptr;
+    other.m_num_allocated = 0;
+    other.m_num_elements = 0;
+    PRAC_STATS(m_stats = other.m_stats; other.m_stats = container_stats();)
+  }
 
-    reverse_iterator operator+(const size_t &count) {
-      reverse_iterator return_val = *this;
-      return_val.m_pos += count;
-      return return_val;
+private:
+  /// Add copies of the num_new elements starting at first to the back
+  /// of the container.
+  /*
+   * The length of the range has already been measured, so it is
+   * walked only once. An empty vector allocates exactly num_new;
+   * otherwise the growth policy picks the capacity.
+   */
+  template <typename Other>
+  void append_n(const Other &first, const size_t &num_new) {
+    size_t required = m_num_elements + num_new;
+    if (required > m_num_allocated) {
+      this->allocate(m_num_elements == 0
+                         ? required
+                         : Growth::grow(m_num_allocated, required, sizeof(T)));
     }
+    detail::uninitialized_copy_n(m_storage + m_num_elements, first, num_new);
+    m_num_elements = required;
+  }
 
-    reverse_iterator operator-(const size_t &count) {
-      reverse_iterator return_val = *this;
-      return_val.m_pos -= count;
-      return return_val;
+  /// Copy every element of other into this vector, which must be empty.
+  void copy_elements(const vector &other) {
+    if (other.m_num_elements > m_num_allocated) {
+      this->allocate(other.m_num_elements);
+    }
+    try {
+      detail::uninitialized_copy(m_storage, other.m_storage,
+                                 other.m_num_elements);
+    } catch (...) {
+      this->release();
+      throw;
     }
+    m_num_elements = other.m_num_elements;
+  }
 
-    bool operator==(reverse_iterator other) const {
-      return m_pos == other.m_pos;
+  /// Reallocate to the capacity the growth policy picks and construct
+  /// one element at the back from args.
+  /*
+   * The new element is constructed in the new storage before the old
+   * elements are relocated, since args may refer to one of them.
+   * Does not update m_num_elements.
+   */
+  template <typename... Args> void grow_and_construct_back(Args &&... args) {
+    auto allocation = detail::allocate_at_least(
+        m_alloc, Growth::grow(m_num_allocated, m_num_elements + 1, sizeof(T)));
+    T *new_storage = allocation.ptr;
+    try {
+      new (new_storage + m_num_elements) T(std::forward<Args>(args)...);
+    } catch (...) {
+      alloc_traits::deallocate(m_alloc, new_storage, allocation.count);
+      throw;
     }
-    bool operator!=(reverse_iterator other) const { return !(*this == other); }
-    T &operator*() const {
-      return m_vector->operator[](m_vector->size() - m_pos - 1);
+    try {
+      detail::relocate(new_storage, m_storage, m_num_elements);
+    } catch (...) {
+      detail::destroy(new_storage + m_num_elements, 1);
+      alloc_traits::deallocate(m_alloc, new_storage, allocation.count);
+      throw;
     }
-  };
+    this->deallocate_storage();
+    PRAC_STATS(detail::stats_on_storage(m_stats, stats_kind::vector,
+                                        m_num_allocated, m_num_elements,
+                                        allocation.count);)
+    m_num_allocated = allocation.count;
+    m_storage = new_storage;
+  }
 
-  // Reverse iterators. All of these are created and incremented in O(1).
-  reverse_iterator rbegin() { return reverse_iterator(this); }
-  reverse_iterator rend() { return reverse_iterator(this, this->size()); }
-  const reverse_iterator crbegin() const { return iterator(this); }
-  const reverse_iterator crend() const { return iterator(this, this->size()); }
+  /// Destroy all elements and give back the storage.
+  void release() {
+    detail::destroy(m_storage, m_num_elements);
+    this->deallocate_storage();
+    m_storage = nullptr;
+    m_num_allocated = 0;
+    m_num_elements = 0;
+  }
 
-private:
+  /// Give the storage back to the allocator. Elements must already
+  /// have been destroyed or relocated.
+  void deallocate_storage() {
+    if (m_storage != nullptr) {
+      alloc_traits::deallocate(m_alloc, m_storage, m_num_allocated);
+    }
+  }
+
+  Alloc m_alloc;
   T *m_storage;
   size_t m_num_allocated;
   size_t m_num_elements;
+#ifdef PRAC_CONTAINER_STATS
+  container_stats m_stats;
+#endif
 };
+
+/// A prac::vector whose storage starts on an Alignment-byte boundary,
+/// after every reallocation. See aligned_allocator.
+template <typename T, size_t Alignment, typename Growth = prac::growth_2x>
+using aligned_vector = vector<T, aligned_allocator<T, Alignment>, Growth>;
 }; // namespace prac
@@ -0,0 +1,113 @@
+#include "arena.hpp"
+#include "assert.hpp"
+#include "list.hpp"
+#include "test_utils.hpp"
+#include "vector.hpp"
+#include <stdint.h>
+#include <string>
+
+template <typename T>
+using arena_vector = prac::vector<T, prac::arena_allocator<T>>;
+template <typename T>
+using arena_list = prac::list<T, prac::arena_allocator<T>>;
+
+void testArenaAlignment() {
+  prac::monotonic_arena arena(64);
+  for (size_t alignment = 1; alignment <= 256; alignment *= 2) {
+    void *storage = arena.allocate(3, alignment);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(storage) % alignment, 0);
+  }
+  // A request larger than the block size gets a block of its own.
+  void *big = arena.allocate(10000, 16);
+  ASSERT(big != nullptr);
+  ASSERT(arena.bytes_reserved() >= 10000);
+  arena.release();
+  ASSERT_EQ(arena.bytes_reserved(), 0);
+}
+
+void testArenaReclaimsLastAllocation() {
+  prac::monotonic_arena arena;
+  void *first = arena.allocate(100, 8);
+  arena.deallocate(first, 100);
+  void *second = arena.allocate(100, 8);
+  ASSERT(first == second);
+}
+
+template <typename T> void testArenaContainers() {
+  prac::monotonic_arena arena;
+  prac::arena_allocator<T> alloc(arena);
+  arena_vector<T> vec(alloc);
+  arena_list<T> new_list(alloc);
+  std::vector<T> stl_vec;
+  for (size_t i = 0; i < 1000; i++) {
+    T val = randomVal<T>();
+    vec.push_back(val);
+    new_list.push_back(val);
+    stl_vec.push_back(val);
+  }
+  ASSERT_EQ(vec.size(), stl_vec.size());
+  ASSERT_EQ(new_list.size(), stl_vec.size());
+  size_t i = 0;
+  for (const auto &elem : new_list) {
+    ASSERT(vec[i] == stl_vec[i]);
+    ASSERT(elem == stl_vec[i]);
+    i++;
+  }
+  // Copies and moves keep using the arena.
+  arena_vector<T> copied_vec(vec);
+  arena_list<T> moved_list(std::move(new_list));
+  ASSERT(copied_vec.get_allocator() == alloc);
+  ASSERT(moved_list.get_allocator() == alloc);
+  ASSERT_EQ(copied_vec.size(), stl_vec.size());
+  ASSERT_EQ(moved_list.size(), stl_vec.size());
+  ASSERT_EQ(new_list.size(), 0);
+  while (moved_list.size() > 0) {
+    moved_list.pop_front();
+  }
+}
+
+void testArenaAvoidsGlobalAllocator() {
+  prac::monotonic_arena arena(1 << 20);
+  prac::arena_allocator<int> alloc(arena);
+  // Warm up so the arena has its block.
+  arena.deallocate(arena.allocate(1, 1), 1);
+  size_t allocations_before = g_num_allocations;
+  {
+    arena_vector<int> vec(alloc);
+    arena_list<int> new_list(alloc);
+    for (int i = 0; i < 1000; i++) {
+      vec.push_back(i);
+      new_list.push_back(i);
+    }
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+}
+
+void testThreadLocalAllocator() {
+  {
+    prac::vector<int, prac::thread_local_allocator<int>> vec;
+    prac::list<std::string, prac::thread_local_allocator<std::string>>
+        new_list;
+    for (int i = 0; i < 1000; i++) {
+      vec.push_back(i);
+      new_list.push_back(std::to_string(i));
+    }
+    for (int i = 0; i < 1000; i++) {
+      ASSERT_EQ(vec[i], i);
+      ASSERT(new_list.front() == std::to_string(i));
+      new_list.pop_front();
+    }
+  }
+  ASSERT(prac::thread_local_arena().bytes_reserved() > 0);
+  prac::thread_local_arena().release();
+  ASSERT_EQ(prac::thread_local_arena().bytes_reserved(), 0);
+}
+
+int main(int argc, char **argv) {
+  testArenaAlignment();
+  testArenaReclaimsLastAllocation();
+  testArenaContainers<int>();
+  testArenaContainers<std::string>();
+  testArenaAvoidsGlobalAllocator();
+  testThreadLocalAllocator();
+}
@@ -0,0 +1,377 @@
+#include "btree_map.hpp"
+#include "assert.hpp"
+#include "btree_set.hpp"
+#include "test_utils.hpp"
+#include "vector.hpp"
+#include <functional>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+
+namespace {
+
+/// Counts live instances, to check that nothing leaks or is destroyed
+/// twice when elements move between nodes.
+struct Tracked {
+  static int num_live;
+
+  Tracked(const int &value_in = 0) : value(value_in) { num_live++; }
+  Tracked(const Tracked &other) : value(other.value) { num_live++; }
+  Tracked(Tracked &&other) noexcept : value(other.value) { num_live++; }
+  Tracked &operator=(const Tracked &other) = default;
+  ~Tracked() { num_live--; }
+
+  int value;
+};
+int Tracked::num_live = 0;
+
+/// Throws on a copy once copies_left runs out.
+struct ThrowOnCopy {
+  static int copies_left;
+
+  ThrowOnCopy(const int &value_in = 0) : value(value_in) {}
+  ThrowOnCopy(const ThrowOnCopy &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy failed");
+    }
+  }
+  ThrowOnCopy(ThrowOnCopy &&other) noexcept : value(other.value) {}
+  ThrowOnCopy &operator=(const ThrowOnCopy &) = default;
+
+  int value;
+};
+int ThrowOnCopy::copies_left = 0;
+
+/// Check contents, order both ways, and bounds against std::map.
+template <typename Map, typename Expected>
+void assertSameElements(const Map &map, const Expected &expected) {
+  ASSERT_EQ(map.size(), expected.size());
+  ASSERT_EQ(map.empty(), expected.empty());
+  auto it = map.begin();
+  for (const auto &elem : expected) {
+    ASSERT(it != map.end());
+    ASSERT((*it).first == elem.first);
+    ASSERT(it->second == elem.second);
+    ++it;
+  }
+  ASSERT(it == map.end());
+  auto rit = expected.rbegin();
+  for (auto back = map.end(); back != map.begin(); ++rit) {
+    --back;
+    ASSERT(back->first == rit->first);
+  }
+  ASSERT(rit == expected.rend());
+}
+
+}; // namespace
+
+void testRandomOps() {
+  // Random inserts and erases over a small key range, so that nodes
+  // split, borrow and merge over and over, checked against std::map.
+  prac::btree_map<int, std::string> map;
+  std::map<int, std::string> expected;
+  for (int i = 0; i < 60000; i++) {
+    int key = randomVal<int>() % 3000;
+    // Phases of mostly inserts and mostly erases.
+    bool inserting = (i / 10000) % 2 == 0 ? randomVal<int>() % 4 != 0
+                                           : randomVal<int>() % 4 == 0;
+    if (inserting) {
+      std::string value = std::to_string(i);
+      bool inserted = map.insert(std::make_pair(key, value)).second;
+      ASSERT_EQ(inserted, expected.insert(std::make_pair(key, value)).second);
+    } else {
+      ASSERT_EQ(map.erase(key), expected.erase(key));
+    }
+    if (i % 5000 == 0) {
+      assertSameElements(map, expected);
+    }
+  }
+  assertSameElements(map, expected);
+  for (int i = 0; i < 3000; i++) {
+    int key = randomVal<int>() % 3100;
+    auto lower = map.lower_bound(key);
+    auto expected_lower = expected.lower_bound(key);
+    ASSERT_EQ(lower == map.end(), expected_lower == expected.end());
+    if (expected_lower != expected.end()) {
+      ASSERT_EQ(lower->first, expected_lower->first);
+    }
+    auto upper = map.upper_bound(key);
+    auto expected_upper = expected.upper_bound(key);
+    ASSERT_EQ(upper == map.end(), expected_upper == expected.end());
+    if (expected_upper != expected.end()) {
+      ASSERT_EQ(upper->first, expected_upper->first);
+    }
+    ASSERT_EQ(map.contains(key), expected.count(key) == 1);
+  }
+  // Erase everything, in random order, down to an empty tree.
+  while (!expected.empty()) {
+    int key = randomVal<int>() % 3000;
+    ASSERT_EQ(map.erase(key), expected.erase(key));
+  }
+  ASSERT(map.empty());
+  ASSERT_EQ(map.height(), 0);
+  ASSERT(map.begin() == map.end());
+}
+
+void testSequential() {
+  // Ascending inserts, as with timestamps, leave the leaves nearly
+  // full: about one allocation per node_keys - 1 elements.
+  const size_t n = 100000;
+  const size_t node_keys = prac::btree_set<uint64_t>::node_keys;
+  size_t allocations_before = g_num_allocations;
+  prac::btree_set<uint64_t> set;
+  for (uint64_t i = 0; i < n; i++) {
+    ASSERT(set.insert(i * 10).second);
+  }
+  size_t allocations = g_num_allocations - allocations_before;
+  ASSERT(allocations < n / (node_keys - 1) + n / (node_keys - 1) / 8 + 8);
+  ASSERT(set.height() <= 4);
+  ASSERT_EQ(set.size(), n);
+  uint64_t expected = 0;
+  for (const uint64_t &key : set) {
+    ASSERT_EQ(key, expected);
+    expected += 10;
+  }
+  ASSERT(set.contains(990));
+  ASSERT(!set.contains(995));
+  ASSERT_EQ(*set.lower_bound(995), 1000);
+
+  // Descending inserts, then erasing from the front and the back.
+  prac::btree_set<uint64_t> down;
+  for (uint64_t i = n; i-- > 0;) {
+    down.insert(i);
+  }
+  ASSERT_EQ(*down.begin(), 0);
+  for (uint64_t i = 0; i < n / 2; i++) {
+    ASSERT_EQ(down.erase(i), 1);
+    ASSERT_EQ(down.erase(n - 1 - i), 1);
+    if (i % 1000 == 0 && !down.empty()) {
+      ASSERT_EQ(*down.begin(), i + 1);
+      ASSERT_EQ(*--down.end(), n - 2 - i);
+    }
+  }
+  ASSERT(down.empty());
+}
+
+void testBulkLoad() {
+  for (size_t n : {0, 1, 7, 33, 1000, 100000}) {
+    prac::vector<std::pair<uint64_t, uint64_t>> sorted;
+    for (uint64_t i = 0; i < n; i++) {
+      sorted.push_back(std::make_pair(i * 3, i));
+    }
+    size_t allocations_before = g_num_allocations;
+    prac::btree_map<uint64_t, uint64_t> map(prac::sorted_unique, sorted);
+    size_t node_keys = prac::btree_map<uint64_t, uint64_t>::node_keys;
+    // Full leaves, inner nodes over them, and the lists of each level.
+    ASSERT(g_num_allocations - allocations_before <=
+           n / node_keys + n / node_keys / 4 + 8);
+    ASSERT_EQ(map.size(), n);
+    for (uint64_t i = 0; i < n; i++) {
+      ASSERT(map.contains(i * 3));
+      ASSERT(!map.contains(i * 3 + 1));
+      ASSERT_EQ(map.at(i * 3), i);
+    }
+    // It takes inserts and erases like any other tree.
+    std::map<uint64_t, uint64_t> expected(sorted.begin(), sorted.end());
+    for (int i = 0; i < 2000; i++) {
+      uint64_t key = uint64_t(randomVal<int>()) % (3 * n + 3);
+      if (randomVal<int>() & 1) {
+        map.insert(std::make_pair(key, uint64_t(i)));
+        expected.insert(std::make_pair(key, uint64_t(i)));
+      } else {
+        ASSERT_EQ(map.erase(key), expected.erase(key));
+      }
+    }
+    assertSameElements(map, expected);
+  }
+
+  // Moved in from a vector of strings.
+  prac::vector<std::string> words;
+  for (int i = 0; i < 500; i++) {
+    words.push_back(std::string(40, 'a') + std::to_string(1000 + i));
+  }
+  prac::btree_set<std::string> set(prac::sorted_unique, std::move(words));
+  ASSERT_EQ(set.size(), 500);
+  ASSERT(set.contains(std::string(40, 'a') + "1499"));
+
+  // Out of order or repeated keys are refused, and nothing leaks.
+  {
+    prac::vector<std::pair<int, Tracked>> unsorted;
+    for (int i = 0; i < 300; i++) {
+      unsorted.push_back(std::make_pair(i == 250 ? 3 : i, Tracked(i)));
+    }
+    bool threw = false;
+    try {
+      prac::btree_map<int, Tracked> bad(prac::sorted_unique, unsorted);
+    } catch (const std::invalid_argument &) {
+      threw = true;
+    }
+    ASSERT(threw);
+  }
+  ASSERT_EQ(Tracked::num_live, 0);
+}
+
+void testRangeScan() {
+  prac::btree_map<int64_t, double> series;
+  for (int64_t t = 0; t < 50000; t++) {
+    series[t * 5] = double(t);
+  }
+  // Everything in [1000, 2000], along the leaves.
+  double total = 0;
+  size_t count = 0;
+  for (auto it = series.lower_bound(1000), end = series.upper_bound(2000);
+       it != end; ++it) {
+    total += it->second;
+    count++;
+  }
+  ASSERT_EQ(count, 201);
+  ASSERT(total == double((200 + 400) * 201 / 2));
+  auto range = series.equal_range(1005);
+  ASSERT(range.first != range.second);
+  ASSERT_EQ(range.first->first, 1005);
+  range = series.equal_range(1006);
+  ASSERT(range.first == range.second);
+
+  // Drop everything before a cutoff, as retention would.
+  auto next = series.erase(series.begin(), series.lower_bound(100000));
+  ASSERT(next == series.begin());
+  ASSERT_EQ(next->first, 100000);
+  ASSERT_EQ(series.size(), 30000);
+  next = series.erase(series.lower_bound(200000), series.end());
+  ASSERT(next == series.end());
+  ASSERT_EQ(series.size(), 20000);
+  ASSERT_EQ((--series.end())->first, 199995);
+}
+
+void testKeyTypes() {
+  // Keys searched by binary search: strings, and ints in reverse.
+  prac::btree_map<std::string, int> words;
+  std::map<std::string, int> expected_words;
+  for (int i = 0; i < 5000; i++) {
+    std::string key = std::to_string(randomVal<int>() % 2000);
+    words.insert_or_assign(key, i);
+    expected_words[key] = i;
+  }
+  assertSameElements(words, expected_words);
+
+  prac::btree_set<int, std::greater<int>> reversed{5, 1, 9, 3, 7, 3};
+  ASSERT_EQ(reversed.size(), 5);
+  ASSERT_EQ(*reversed.begin(), 9);
+  ASSERT_EQ(*reversed.lower_bound(6), 5);
+
+  prac::btree_set<double> reals;
+  std::set<double> expected_reals;
+  for (int i = 0; i < 5000; i++) {
+    double value = double(randomVal<int>() % 1000) / 8.0 - 50.0;
+    ASSERT_EQ(reals.insert(value).second, expected_reals.insert(value).second);
+  }
+  ASSERT(std::equal(reals.begin(), reals.end(), expected_reals.begin(),
+                    expected_reals.end()));
+  ASSERT(*reals.lower_bound(-49.99) == *expected_reals.lower_bound(-49.99));
+}
+
+void testMapInterface() {
+  prac::btree_map<int, std::string> map{{3, "c"}, {1, "a"}, {2, "b"}, {1, "x"}};
+  ASSERT_EQ(map.size(), 3);
+  ASSERT(map.at(1) == "a");
+  map[4] = "d";
+  ASSERT(map[5].empty());
+  ASSERT(!map.try_emplace(4, "dd").second);
+  ASSERT(map.at(4) == "d");
+  ASSERT(!map.insert_or_assign(4, "dd").second);
+  ASSERT(map.at(4) == "dd");
+  ASSERT(map.emplace(6, "f").second);
+  bool threw = false;
+  try {
+    map.at(7);
+  } catch (const std::out_of_range &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  auto next = map.erase(map.find(2));
+  ASSERT_EQ(next->first, 3);
+  for (const auto &[key, value] : map) {
+    ASSERT(key != 2);
+    ASSERT(key == 5 || !value.empty());
+  }
+
+  prac::btree_map<int, std::string> copy(map);
+  copy[10] = "j";
+  ASSERT_EQ(map.size(), 5);
+  ASSERT_EQ(copy.size(), 6);
+  prac::btree_map<int, std::string> moved(std::move(copy));
+  ASSERT_EQ(moved.size(), 6);
+  ASSERT(copy.empty());
+  copy = moved;
+  ASSERT(copy.at(10) == "j");
+  map = std::move(moved);
+  ASSERT_EQ(map.size(), 6);
+}
+
+void testLifetimes() {
+  {
+    prac::btree_map<std::string, Tracked> map;
+    for (int i = 0; i < 5000; i++) {
+      map.try_emplace(std::to_string(i), i);
+      if (i % 3 == 0) {
+        map.erase(std::to_string(i / 2));
+      }
+    }
+    ASSERT_EQ(Tracked::num_live, int(map.size()));
+    for (const auto &[key, value] : map) {
+      ASSERT(key == std::to_string(value.value));
+    }
+    prac::btree_map<std::string, Tracked> copy(map);
+    ASSERT_EQ(Tracked::num_live, int(2 * map.size()));
+    copy.clear();
+    ASSERT_EQ(Tracked::num_live, int(map.size()));
+    map.erase(map.begin(), map.end());
+    ASSERT_EQ(Tracked::num_live, 0);
+    for (int i = 0; i < 1000; i++) {
+      map.try_emplace(std::to_string(i), i);
+    }
+  }
+  ASSERT_EQ(Tracked::num_live, 0);
+}
+
+void testExceptionSafety() {
+  prac::btree_map<int, ThrowOnCopy> map;
+  ThrowOnCopy::copies_left = 1000000;
+  for (int i = 0; i < 1000; i++) {
+    ThrowOnCopy value(i);
+    map.try_emplace(i * 2, value);
+  }
+  // Inserting into full leaves splits them before the copy throws.
+  for (int i = 0; i < 1000; i += 7) {
+    ThrowOnCopy value(i);
+    ThrowOnCopy::copies_left = 0;
+    bool threw = false;
+    try {
+      map.try_emplace(i * 2 + 1, value);
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    ASSERT(threw);
+  }
+  ThrowOnCopy::copies_left = 1000000;
+  ASSERT_EQ(map.size(), 1000);
+  int expected = 0;
+  for (const auto &[key, value] : map) {
+    ASSERT_EQ(key, expected * 2);
+    ASSERT_EQ(value.value, expected);
+    expected++;
+  }
+}
+
+int main(int argc, char **argv) {
+  testRandomOps();
+  testSequential();
+  testBulkLoad();
+  testRangeScan();
+  testKeyTypes();
+  testMapInterface();
+  testLifetimes();
+  testExceptionSafety();
+}
@@ -0,0 +1,129 @@
+#include "concurrent_queue.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Counts live instances, to check that nothing leaks or is destroyed
+/// twice.
+struct Tracked {
+  static std::atomic<int> num_live;
+
+  Tracked(const uint64_t &value_in = 0) : value(value_in) { num_live++; }
+  Tracked(const Tracked &other) : value(other.value) { num_live++; }
+  Tracked &operator=(const Tracked &other) {
+    value = other.value;
+    return *this;
+  }
+  ~Tracked() { num_live--; }
+
+  uint64_t value;
+};
+std::atomic<int> Tracked::num_live(0);
+
+}; // namespace
+
+void testSingleThread() {
+  prac::concurrent_queue<std::string> queue;
+  ASSERT(queue.empty());
+  std::string out = "unchanged";
+  ASSERT(!queue.try_pop(out));
+  ASSERT(out == "unchanged");
+  std::vector<std::string> pushed;
+  for (size_t i = 0; i < 1000; i++) {
+    pushed.push_back(randomVal<std::string>());
+    queue.push(pushed.back());
+  }
+  queue.emplace(3, 'z');
+  ASSERT(!queue.empty());
+  for (size_t i = 0; i < pushed.size(); i++) {
+    ASSERT(queue.try_pop(out));
+    ASSERT(out == pushed[i]);
+  }
+  ASSERT(queue.try_pop(out));
+  ASSERT(out == "zzz");
+  ASSERT(!queue.try_pop(out));
+  ASSERT(queue.empty());
+}
+
+void testDestroysRemaining() {
+  {
+    prac::concurrent_queue<Tracked> queue;
+    for (uint64_t i = 0; i < 100; i++) {
+      queue.push(Tracked(i));
+    }
+    Tracked out;
+    for (uint64_t i = 0; i < 40; i++) {
+      ASSERT(queue.try_pop(out));
+      ASSERT_EQ(out.value, i);
+    }
+  }
+  ASSERT_EQ(Tracked::num_live.load(), 0);
+}
+
+void testConcurrent(const size_t &num_producers, const size_t &num_consumers) {
+  const uint64_t per_producer = 20000;
+  prac::concurrent_queue<Tracked> queue;
+  std::atomic<uint64_t> num_popped(0);
+  std::vector<std::vector<uint64_t>> popped(num_consumers);
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < num_producers; p++) {
+    threads.emplace_back([&queue, p, per_producer]() {
+      for (uint64_t i = 0; i < per_producer; i++) {
+        queue.push(Tracked(p * per_producer + i));
+      }
+    });
+  }
+  uint64_t total = num_producers * per_producer;
+  for (size_t c = 0; c < num_consumers; c++) {
+    threads.emplace_back([&, c]() {
+      Tracked out;
+      while (num_popped.load() < total) {
+        if (queue.try_pop(out)) {
+          popped[c].push_back(out.value);
+          num_popped++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  ASSERT(queue.empty());
+  // Every element came out exactly once, and each consumer saw every
+  // producer's elements in the order they were pushed.
+  std::vector<int> seen(total, 0);
+  for (const std::vector<uint64_t> &values : popped) {
+    std::vector<uint64_t> last(num_producers, 0);
+    std::vector<bool> any(num_producers, false);
+    for (uint64_t value : values) {
+      seen[value]++;
+      size_t producer = value / per_producer;
+      ASSERT(!any[producer] || value > last[producer]);
+      last[producer] = value;
+      any[producer] = true;
+    }
+  }
+  for (uint64_t i = 0; i < total; i++) {
+    ASSERT_EQ(seen[i], 1);
+  }
+}
+
+int main(int argc, char **argv) {
+  testSingleThread();
+  testDestroysRemaining();
+  testConcurrent(1, 1);
+  testConcurrent(4, 4);
+  testConcurrent(2, 6);
+  testConcurrent(6, 2);
+  // Nodes retired by the consumer threads, which have exited, are
+  // freed by later scans or when the domain is destroyed at exit.
+  prac::hazard_domain::global().reclaim();
+  ASSERT_EQ(Tracked::num_live.load(), 0);
+}
@@ -0,0 +1,236 @@
+#include "concurrent_vector.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+void testSingleThread() {
+  prac::concurrent_vector<std::string> vec;
+  ASSERT(vec.empty());
+  ASSERT_EQ(vec.capacity(), 0);
+  std::vector<std::string> stl_vec;
+  for (size_t i = 0; i < 1000; i++) {
+    std::string val = randomVal<std::string>();
+    ASSERT_EQ(vec.push_back(val), i);
+    stl_vec.push_back(val);
+  }
+  const std::string *first = &vec[0];
+  const std::string *last = &vec[999];
+  // Appending never moves existing elements.
+  ASSERT_EQ(vec.grow_by(100000, "x"), 1000);
+  ASSERT(&vec[0] == first);
+  ASSERT(&vec[999] == last);
+  ASSERT_EQ(vec.size(), 101000);
+  ASSERT(vec.capacity() >= vec.size());
+  for (size_t i = 0; i < stl_vec.size(); i++) {
+    ASSERT(vec[i] == stl_vec[i]);
+  }
+  ASSERT(vec[100999] == "x");
+  // Iterators are random access across segment boundaries.
+  ASSERT_EQ(vec.end() - vec.begin(), 101000);
+  ASSERT(std::equal(stl_vec.begin(), stl_vec.end(), vec.begin()));
+  ASSERT(*(vec.begin() + 500) == stl_vec[500]);
+
+  size_t capacity = vec.capacity();
+  vec.clear();
+  ASSERT_EQ(vec.size(), 0);
+  ASSERT_EQ(vec.capacity(), capacity);
+  vec.emplace_back(3, 'y');
+  ASSERT(vec[0] == "yyy");
+}
+
+void testConcurrentAppends() {
+  const size_t num_threads = 8;
+  const size_t per_thread = 20000;
+  prac::concurrent_vector<size_t> vec;
+  std::atomic<bool> done(false);
+  std::atomic<size_t> reader_failures(0);
+  // Reads everything below size() while the writers run. Elements
+  // are never zero once constructed.
+  std::thread reader([&]() {
+    size_t last_size = 0;
+    while (!done.load()) {
+      size_t size = vec.size();
+      if (size < last_size) {
+        reader_failures++;
+      }
+      for (size_t i = last_size; i < size; i++) {
+        if (vec[i] == 0) {
+          reader_failures++;
+        }
+      }
+      last_size = size;
+    }
+  });
+  std::vector<std::thread> writers;
+  for (size_t t = 0; t < num_threads; t++) {
+    writers.emplace_back([&vec, t, per_thread]() {
+      for (size_t j = 0; j < per_thread; j++) {
+        size_t value = t * per_thread + j + 1;
+        if (j % 100 == 0) {
+          size_t first = vec.grow_by(3, value);
+          ASSERT_EQ(vec[first + 2], value);
+        } else {
+          size_t index = vec.push_back(value);
+          ASSERT_EQ(vec[index], value);
+        }
+      }
+    });
+  }
+  for (std::thread &writer : writers) {
+    writer.join();
+  }
+  done = true;
+  reader.join();
+  ASSERT_EQ(reader_failures.load(), 0);
+
+  size_t num_grow_by = num_threads * (per_thread / 100);
+  ASSERT_EQ(vec.size(), num_threads * per_thread + 2 * num_grow_by);
+  ASSERT_EQ(vec.reserved_size(), vec.size());
+  // Every value was appended exactly once, or three times for grow_by.
+  std::vector<size_t> counts(num_threads * per_thread + 1, 0);
+  for (size_t value : vec) {
+    counts[value]++;
+  }
+  for (size_t t = 0; t < num_threads; t++) {
+    for (size_t j = 0; j < per_thread; j++) {
+      ASSERT_EQ(counts[t * per_thread + j + 1], j % 100 == 0 ? 3 : 1);
+    }
+  }
+}
+
+void testSegmentsAllocatedOnce() {
+  // Every thread starts appending at once, so they race for each new
+  // segment, but only one of them allocates it.
+  const size_t num_threads = 8;
+  prac::concurrent_vector<size_t> vec;
+  std::atomic<bool> go(false);
+  std::vector<std::thread> writers;
+  for (size_t t = 0; t < num_threads; t++) {
+    writers.emplace_back([&vec, &go]() {
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      for (size_t j = 0; j < 5000; j++) {
+        vec.push_back(j);
+      }
+    });
+  }
+  size_t allocations_before = g_num_allocations;
+  go = true;
+  for (std::thread &writer : writers) {
+    writer.join();
+  }
+  size_t num_segments = 0;
+  size_t capacity = 0;
+  while (capacity < vec.capacity()) {
+    capacity += prac::concurrent_vector<size_t>::first_segment_size
+                << num_segments;
+    num_segments++;
+  }
+  // The elements and the states of each segment.
+  ASSERT_EQ(g_num_allocations - allocations_before, 2 * num_segments);
+  ASSERT_EQ(vec.size(), num_threads * 5000);
+}
+
+/// Throws from its constructor when given a negative value, and
+/// from its copy constructor once copies_left runs out.
+struct Fragile {
+  static int num_live;
+  static int copies_left;
+
+  Fragile(const int &value_in) : value(value_in) {
+    if (value < 0) {
+      throw std::runtime_error("negative");
+    }
+    num_live++;
+  }
+  Fragile(const Fragile &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy failed");
+    }
+    num_live++;
+  }
+  ~Fragile() { num_live--; }
+
+  int value;
+};
+int Fragile::num_live = 0;
+int Fragile::copies_left = -1;
+
+void testThrowingConstructor() {
+  {
+    prac::concurrent_vector<Fragile> vec;
+    vec.emplace_back(1);
+    bool threw = false;
+    try {
+      vec.emplace_back(-1);
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    ASSERT(threw);
+    vec.emplace_back(3);
+    // size() moves past the failed element, which isn't ready.
+    ASSERT_EQ(vec.size(), 3);
+    ASSERT(vec.is_ready(0));
+    ASSERT(!vec.is_ready(1));
+    ASSERT(vec.is_ready(2));
+    ASSERT_EQ(vec[2].value, 3);
+
+    // A failed copy fails the rest of its run, across segments.
+    Fragile::copies_left = 10;
+    threw = false;
+    try {
+      vec.grow_by(100, Fragile(7));
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    ASSERT(threw);
+    ASSERT_EQ(vec.size(), 103);
+    ASSERT(vec.is_ready(12));
+    ASSERT(!vec.is_ready(13));
+    ASSERT(!vec.is_ready(102));
+    ASSERT_EQ(vec.push_back(Fragile(4)), 103);
+    ASSERT_EQ(vec.size(), 104);
+    ASSERT_EQ(Fragile::num_live, 13);
+    vec.clear();
+    ASSERT_EQ(Fragile::num_live, 0);
+    vec.emplace_back(5);
+    ASSERT_EQ(vec.size(), 1);
+  }
+  ASSERT_EQ(Fragile::num_live, 0);
+}
+
+/// Too big for any segment of it to be allocated.
+struct Huge {
+  char bytes[size_t(1) << 40];
+};
+
+void testFailedSegmentAllocation() {
+  prac::concurrent_vector<Huge> vec;
+  bool threw = false;
+  try {
+    vec.emplace_back();
+  } catch (const std::bad_alloc &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  // The index was handed out, but its segment doesn't exist.
+  ASSERT_EQ(vec.reserved_size(), 1);
+  ASSERT_EQ(vec.capacity(), 0);
+  ASSERT(!vec.is_ready(0));
+  vec.clear();
+  ASSERT_EQ(vec.reserved_size(), 0);
+}
+
+int main(int argc, char **argv) {
+  testSingleThread();
+  testConcurrentAppends();
+  testSegmentsAllocatedOnce();
+  testThrowingConstructor();
+  testFailedSegmentAllocation();
+}
@@ -0,0 +1,241 @@
+#include "deque.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <deque>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/// Throws on a copy once copies_left runs out.
+struct ThrowOnCopy {
+  static int copies_left;
+
+  ThrowOnCopy(const int &value_in = 0) : value(value_in) {}
+  ThrowOnCopy(const ThrowOnCopy &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy failed");
+    }
+  }
+  ThrowOnCopy &operator=(const ThrowOnCopy &) = default;
+
+  int value;
+};
+int ThrowOnCopy::copies_left = 0;
+
+template <typename T>
+void assertSameElements(const prac::deque<T> &deq,
+                        const std::deque<T> &expected) {
+  ASSERT_EQ(deq.size(), expected.size());
+  ASSERT_EQ(deq.empty(), expected.empty());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT(deq[i] == expected[i]);
+  }
+  ASSERT(std::equal(deq.begin(), deq.end(), expected.begin(), expected.end()));
+  ASSERT(std::equal(deq.rbegin(), deq.rend(), expected.rbegin(),
+                    expected.rend()));
+  if (!expected.empty()) {
+    ASSERT(deq.front() == expected.front());
+    ASSERT(deq.back() == expected.back());
+  }
+}
+
+}; // namespace
+
+void testBothEnds() {
+  // Random pushes and pops at both ends, checked against std::deque.
+  prac::deque<std::string> deq;
+  std::deque<std::string> expected;
+  for (int i = 0; i < 20000; i++) {
+    int op = randomVal<int>() & 7;
+    if (op < 2 || expected.empty()) {
+      expected.push_back(randomVal<std::string>());
+      deq.push_back(expected.back());
+    } else if (op < 4) {
+      expected.push_front(randomVal<std::string>());
+      deq.push_front(expected.front());
+    } else if (op < 5) {
+      expected.pop_back();
+      deq.pop_back();
+    } else if (op < 6) {
+      expected.pop_front();
+      deq.pop_front();
+    } else if (op < 7) {
+      deq.emplace_back(3, 'b');
+      expected.emplace_back(3, 'b');
+    } else {
+      deq.emplace_front(3, 'f');
+      expected.emplace_front(3, 'f');
+    }
+    if (i % 1000 == 0) {
+      assertSameElements(deq, expected);
+    }
+  }
+  assertSameElements(deq, expected);
+  while (!expected.empty()) {
+    expected.pop_front();
+    deq.pop_front();
+  }
+  assertSameElements(deq, expected);
+}
+
+void testReferencesStable() {
+  // Pushes never move an element.
+  prac::deque<int> deq;
+  deq.push_back(1);
+  int *first = &deq.front();
+  for (int i = 0; i < 10000; i++) {
+    deq.push_back(i);
+    deq.push_front(-i);
+  }
+  ASSERT(first == &deq[10000]);
+  ASSERT_EQ(*first, 1);
+}
+
+void testRecyclesBlocks() {
+  // A sliding window stops allocating once it reaches its peak size.
+  prac::deque<int> window;
+  for (int i = 0; i < 1000; i++) {
+    window.push_back(i);
+  }
+  int64_t sum = std::accumulate(window.begin(), window.end(), int64_t(0));
+  for (int i = 1000; i < 3000; i++) {
+    window.push_back(i);
+    sum += i - window.front();
+    window.pop_front();
+  }
+  size_t allocations_before = g_num_allocations;
+  for (int i = 3000; i < 200000; i++) {
+    window.push_back(i);
+    sum += i - window.front();
+    window.pop_front();
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  ASSERT_EQ(window.size(), 1000);
+  ASSERT_EQ(sum, std::accumulate(window.begin(), window.end(), int64_t(0)));
+  ASSERT_EQ(window.front(), 199000);
+
+  // And so does one used as a LIFO at the front.
+  prac::deque<int> stack;
+  for (int round = 0; round < 10; round++) {
+    // The first round starts on a block boundary, later ones in the
+    // middle of the block that emptying keeps, so they need one more.
+    if (round == 2) {
+      allocations_before = g_num_allocations;
+    }
+    for (int i = 0; i < 5000; i++) {
+      stack.push_front(i);
+    }
+    for (int i = 0; i < 5000; i++) {
+      stack.pop_back();
+    }
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  stack.shrink_to_fit();
+  ASSERT(stack.empty());
+}
+
+void testIterators() {
+  prac::deque<int> deq;
+  for (int i = 0; i < 1000; i++) {
+    deq.push_back(i);
+    deq.push_front(-i - 1);
+  }
+  ASSERT_EQ(size_t(deq.end() - deq.begin()), deq.size());
+  ASSERT(std::is_sorted(deq.begin(), deq.end()));
+  prac::deque<int>::iterator itr = deq.begin() + 700;
+  ASSERT_EQ(*itr, -300);
+  ASSERT_EQ(itr[600], 300);
+  itr -= 500;
+  ASSERT_EQ(*itr, -800);
+  ASSERT_EQ(*--itr, -801);
+  const prac::deque<int> &const_deq = deq;
+  prac::deque<int>::const_iterator citr = deq.begin();
+  ASSERT(citr == const_deq.begin());
+  ASSERT(const_deq.end() - 1 == const_deq.begin() + 1999);
+  ASSERT(citr < const_deq.end());
+
+  std::reverse(deq.begin(), deq.end());
+  ASSERT_EQ(deq.front(), 999);
+  ASSERT_EQ(deq.back(), -1000);
+  std::sort(deq.begin(), deq.end());
+  ASSERT_EQ(deq[0], -1000);
+  ASSERT(std::is_sorted(deq.begin(), deq.end()));
+  ASSERT(std::binary_search(deq.begin(), deq.end(), 123));
+  for (int &value : deq) {
+    value *= 2;
+  }
+  ASSERT_EQ(deq[1999], 1998);
+}
+
+void testCopyAndMove() {
+  prac::deque<std::string> deq;
+  std::deque<std::string> expected;
+  for (int i = 0; i < 700; i++) {
+    expected.push_front(randomVal<std::string>());
+    deq.push_front(expected.front());
+  }
+  prac::deque<std::string> copy(deq);
+  assertSameElements(copy, expected);
+  prac::deque<std::string> moved(std::move(copy));
+  assertSameElements(moved, expected);
+  ASSERT(copy.empty());
+  copy = moved;
+  assertSameElements(copy, expected);
+  copy.pop_front();
+  ASSERT_EQ(moved.size(), 700);
+  prac::deque<std::string> assigned;
+  assigned.push_back("old");
+  assigned = std::move(moved);
+  assertSameElements(assigned, expected);
+  assigned.clear();
+  ASSERT(assigned.empty());
+  assigned.push_back("again");
+  ASSERT(assigned.front() == "again");
+  prac::deque<std::string> ranged(expected.begin(), expected.end());
+  assertSameElements(ranged, expected);
+}
+
+void testExceptionSafety() {
+  prac::deque<ThrowOnCopy> deq;
+  ThrowOnCopy value(5);
+  ThrowOnCopy::copies_left = 1000000;
+  for (size_t i = 0; i < prac::deque<ThrowOnCopy>::block_size; i++) {
+    deq.push_back(value);
+  }
+  // Both pushes need a new block, and neither changes the deque.
+  ThrowOnCopy::copies_left = 0;
+  bool threw = false;
+  try {
+    deq.push_back(value);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ThrowOnCopy::copies_left = 0;
+  threw = false;
+  try {
+    deq.push_front(value);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ThrowOnCopy::copies_left = 1000000;
+  ASSERT_EQ(deq.size(), prac::deque<ThrowOnCopy>::block_size);
+  deq.push_front(ThrowOnCopy(1));
+  deq.push_back(ThrowOnCopy(2));
+  ASSERT_EQ(deq.front().value, 1);
+  ASSERT_EQ(deq.back().value, 2);
+  ASSERT_EQ(deq[1].value, 5);
+}
+
+int main(int argc, char **argv) {
+  testBothEnds();
+  testReferencesStable();
+  testRecyclesBlocks();
+  testIterators();
+  testCopyAndMove();
+  testExceptionSafety();
+}
@@ -0,0 +1,76 @@
+#include "huge_page.hpp"
+#include "assert.hpp"
+#include "list.hpp"
+#include "test_utils.hpp"
+#include "vector.hpp"
+#include <stdint.h>
+#include <string>
+
+namespace {
+
+template <prac::huge_page_mode Mode>
+using HugeVector =
+    prac::vector<uint64_t, prac::huge_page_allocator<uint64_t, Mode>>;
+
+bool isAligned(const void *ptr, const size_t &alignment) {
+  return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+}; // namespace
+
+template <prac::huge_page_mode Mode> void testHugeVector() {
+  HugeVector<Mode> values;
+  // Small buffers come from operator new, cache-line aligned.
+  size_t allocations_before = g_num_allocations;
+  values.push_back(1);
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  ASSERT(isAligned(values.data(), 64));
+
+  // Large ones are mapped, on a huge page boundary. Without huge pages
+  // to be had, they are normal pages.
+  const size_t n = 3 * prac::huge_page_size / sizeof(uint64_t) + 5;
+  values.reserve(prac::huge_page_size / sizeof(uint64_t));
+  ASSERT(isAligned(values.data(), prac::huge_page_size));
+  allocations_before = g_num_allocations;
+  for (size_t i = 1; i < n; i++) {
+    values.push_back(i);
+    if (values.capacity() * sizeof(uint64_t) >= prac::huge_page_size) {
+      ASSERT(isAligned(values.data(), prac::huge_page_size));
+    }
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  ASSERT_EQ(values.size(), n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(values[i], i == 0 ? 1 : i);
+  }
+
+  // Back down to operator new, and up again.
+  values.resize(100);
+  values.shrink_to_fit();
+  ASSERT(isAligned(values.data(), 64));
+  ASSERT_EQ(values[99], 99);
+  values.reserve(prac::huge_page_size);
+  ASSERT(isAligned(values.data(), prac::huge_page_size));
+  ASSERT_EQ(values[99], 99);
+  HugeVector<Mode> copied(values);
+  ASSERT_EQ(copied.size(), 100);
+  ASSERT_EQ(copied[42], 42);
+}
+
+void testRebind() {
+  // Node containers rebind the allocator to their node type.
+  prac::list<std::string, prac::huge_page_allocator<std::string>> strings;
+  for (size_t i = 0; i < 1000; i++) {
+    strings.push_back(randomVal<std::string>());
+  }
+  ASSERT_EQ(strings.size(), 1000);
+  prac::list<int, prac::aligned_allocator<int, 128>> ints;
+  ints.push_back(3);
+  ASSERT_EQ(ints.front(), 3);
+}
+
+int main(int argc, char **argv) {
+  testHugeVector<prac::huge_page_mode::transparent>();
+  testHugeVector<prac::huge_page_mode::reserved>();
+  testRebind();
+}
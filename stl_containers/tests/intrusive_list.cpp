@@ -0,0 +1,212 @@
+#include "intrusive_list.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Something that lives in two lists at once, like a connection that
+/// is in the LRU list and in either the idle or the active list.
+struct Connection {
+  Connection(const int &id_in = 0) : id(id_in) {}
+
+  int id;
+  std::string name;
+  prac::intrusive_list_hook lru_hook;
+  prac::intrusive_list_hook state_hook;
+};
+
+typedef prac::intrusive_list<Connection, &Connection::lru_hook> LruList;
+typedef prac::intrusive_list<Connection, &Connection::state_hook> StateList;
+
+template <typename List> std::vector<int> ids(const List &list) {
+  std::vector<int> result;
+  for (const Connection &conn : list) {
+    result.push_back(conn.id);
+  }
+  return result;
+}
+
+}; // namespace
+
+void testPushPop() {
+  std::vector<Connection> conns(5);
+  for (size_t i = 0; i < conns.size(); i++) {
+    conns[i].id = int(i);
+  }
+  LruList list;
+  ASSERT(list.empty());
+  ASSERT(list.begin() == list.end());
+  list.push_back(conns[1]);
+  list.push_back(conns[2]);
+  list.push_front(conns[0]);
+  ASSERT_EQ(list.size(), 3);
+  ASSERT_EQ(list.front().id, 0);
+  ASSERT_EQ(list.back().id, 2);
+  ASSERT(ids(list) == std::vector<int>({0, 1, 2}));
+  ASSERT(conns[1].lru_hook.is_linked());
+  ASSERT(!conns[1].state_hook.is_linked());
+  ASSERT(!conns[3].lru_hook.is_linked());
+
+  list.pop_front();
+  ASSERT(!conns[0].lru_hook.is_linked());
+  list.pop_back();
+  ASSERT_EQ(list.size(), 1);
+  ASSERT_EQ(list.front().id, 1);
+  list.pop_back();
+  ASSERT(list.empty());
+}
+
+void testIterators() {
+  std::vector<Connection> conns(10);
+  std::list<int> expected;
+  LruList list;
+  for (size_t i = 0; i < conns.size(); i++) {
+    conns[i].id = randomVal<int>();
+    list.push_back(conns[i]);
+    expected.push_back(conns[i].id);
+  }
+  ASSERT(std::equal(list.begin(), list.end(), expected.begin(),
+                    [](const Connection &conn, const int &id) {
+                      return conn.id == id;
+                    }));
+  ASSERT(std::equal(list.rbegin(), list.rend(), expected.rbegin(),
+                    [](const Connection &conn, const int &id) {
+                      return conn.id == id;
+                    }));
+  ASSERT_EQ(size_t(std::distance(list.begin(), list.end())), conns.size());
+  LruList::iterator it = list.end();
+  --it;
+  ASSERT(&*it == &conns.back());
+  ASSERT_EQ(it->id, conns.back().id);
+  LruList::const_iterator cit = it;
+  ASSERT(cit == list.iterator_to(conns.back()));
+
+  // insert() and erase() at an iterator.
+  Connection extra(-1);
+  LruList::iterator inserted = list.insert(list.iterator_to(conns[3]), extra);
+  ASSERT_EQ(list.size(), conns.size() + 1);
+  ASSERT(std::next(inserted) == list.iterator_to(conns[3]));
+  ASSERT(std::prev(inserted) == list.iterator_to(conns[2]));
+  LruList::iterator after = list.erase(inserted);
+  ASSERT(&*after == &conns[3]);
+  ASSERT(!extra.lru_hook.is_linked());
+  ASSERT_EQ(list.size(), conns.size());
+}
+
+void testUnlink() {
+  std::vector<Connection> conns(6);
+  LruList list;
+  for (size_t i = 0; i < conns.size(); i++) {
+    conns[i].id = int(i);
+    list.push_back(conns[i]);
+  }
+  // Middle, front and back, each given only the element.
+  list.unlink(conns[2]);
+  list.unlink(conns[0]);
+  list.unlink(conns[5]);
+  ASSERT(ids(list) == std::vector<int>({1, 3, 4}));
+  ASSERT(!conns[2].lru_hook.is_linked());
+  // An unlinked element can go back in, anywhere.
+  list.push_front(conns[5]);
+  ASSERT(ids(list) == std::vector<int>({5, 1, 3, 4}));
+  list.clear();
+  ASSERT(list.empty());
+  for (const Connection &conn : conns) {
+    ASSERT(!conn.lru_hook.is_linked());
+  }
+}
+
+void testSplice() {
+  std::vector<Connection> conns(8);
+  LruList first;
+  LruList second;
+  for (size_t i = 0; i < conns.size(); i++) {
+    conns[i].id = int(i);
+    (i < 4 ? first : second).push_back(conns[i]);
+  }
+
+  // One element, between lists and within one.
+  first.splice(first.begin(), second, conns[6]);
+  ASSERT(ids(first) == std::vector<int>({6, 0, 1, 2, 3}));
+  ASSERT(ids(second) == std::vector<int>({4, 5, 7}));
+  first.splice(first.end(), first, conns[6]);
+  ASSERT(ids(first) == std::vector<int>({0, 1, 2, 3, 6}));
+  first.splice(first.iterator_to(conns[6]), first, conns[3]);
+  ASSERT(ids(first) == std::vector<int>({0, 1, 2, 3, 6}));
+
+  // A range, between lists and within one.
+  first.splice(first.iterator_to(conns[1]), second, second.begin(),
+               second.iterator_to(conns[7]));
+  ASSERT(ids(first) == std::vector<int>({0, 4, 5, 1, 2, 3, 6}));
+  ASSERT(ids(second) == std::vector<int>({7}));
+  ASSERT_EQ(first.size(), 7);
+  ASSERT_EQ(second.size(), 1);
+  first.splice(first.begin(), first, first.iterator_to(conns[2]),
+               first.end());
+  ASSERT(ids(first) == std::vector<int>({2, 3, 6, 0, 4, 5, 1}));
+  ASSERT_EQ(first.size(), 7);
+
+  // Everything.
+  second.splice(second.begin(), first);
+  ASSERT(first.empty());
+  ASSERT(first.begin() == first.end());
+  ASSERT(ids(second) == std::vector<int>({2, 3, 6, 0, 4, 5, 1, 7}));
+  ASSERT_EQ(second.size(), 8);
+
+  LruList moved(std::move(second));
+  ASSERT(second.empty());
+  ASSERT_EQ(moved.size(), 8);
+  ASSERT(ids(moved) == std::vector<int>({2, 3, 6, 0, 4, 5, 1, 7}));
+  first = std::move(moved);
+  ASSERT_EQ(first.size(), 8);
+  ASSERT_EQ(first.back().id, 7);
+  ASSERT(&*std::prev(first.end()) == &conns[7]);
+}
+
+void testChurnAllocations() {
+  // Connections move between the idle and active lists and to the
+  // back of the LRU list, as a server's would, without allocating.
+  std::vector<Connection> conns(64);
+  LruList lru;
+  StateList idle;
+  StateList active;
+  for (size_t i = 0; i < conns.size(); i++) {
+    conns[i].id = int(i);
+    lru.push_back(conns[i]);
+    idle.push_back(conns[i]);
+  }
+  std::vector<bool> is_active(conns.size(), false);
+  size_t allocations_before = g_num_allocations;
+  for (size_t round = 0; round < 100000; round++) {
+    size_t i = size_t(rand()) % conns.size();
+    Connection &conn = conns[i];
+    lru.splice(lru.end(), lru, conn);
+    StateList &from = is_active[i] ? active : idle;
+    is_active[i] = rand() % 2 == 0;
+    StateList &to = is_active[i] ? active : idle;
+    to.splice(to.end(), from, conn);
+    // Evict the least recently used and bring it straight back.
+    Connection &oldest = lru.front();
+    lru.pop_front();
+    lru.push_back(oldest);
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  ASSERT_EQ(lru.size(), conns.size());
+  ASSERT_EQ(idle.size() + active.size(), conns.size());
+  ASSERT_EQ(size_t(std::distance(idle.begin(), idle.end())), idle.size());
+  ASSERT_EQ(size_t(std::distance(active.rbegin(), active.rend())),
+            active.size());
+}
+
+int main(int argc, char **argv) {
+  testPushPop();
+  testIterators();
+  testUnlink();
+  testSplice();
+  testChurnAllocations();
+}
@@ -1,9 +1,16 @@
 #include "list.hpp"
 #include "assert.hpp"
 #include "test_utils.hpp"
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <list>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 namespace {
 
@@ -21,6 +28,33 @@ prac::list<T> randomList(std::list<T> *stl_list = nullptr,
   return new_list;
 }
 
+/// Check both directions, so the backward links are checked too.
+template <typename T>
+void assertSameElements(prac::list<T> &new_list, const std::list<T> &stl_list) {
+  ASSERT_EQ(new_list.size(), stl_list.size());
+  auto stl_itr = stl_list.begin();
+  for (const auto &elem : new_list) {
+    ASSERT(elem == *stl_itr);
+    stl_itr++;
+  }
+  ASSERT(stl_itr == stl_list.end());
+  for (auto ritr = new_list.rbegin(); ritr != new_list.rend(); ritr++) {
+    stl_itr--;
+    ASSERT(*ritr == *stl_itr);
+  }
+  ASSERT(stl_itr == stl_list.begin());
+}
+
+/// Orders by key only, so that sorting can be checked for stability.
+struct KeyedValue {
+  int key;
+  int order;
+  bool operator<(const KeyedValue &other) const { return key < other.key; }
+  bool operator==(const KeyedValue &other) const {
+    return key == other.key && order == other.order;
+  }
+};
+
 }; // namespace
 
 template <typename T> void testConstruction() { prac::list<T> new_list; }
@@ -115,6 +149,522 @@ template <typename T> void testSTLConstruction() {
   ASSERT(stl_itr == stl_list.end());
 }
 
+void testEmplace() {
+  // A string long enough to defeat the small string optimization,
+  // so every copy of it costs an allocation.
+  const std::string payload(100, 'x');
+  prac::list<std::string> new_list;
+  // With the nodes reserved up front, only copies of the payload
+  // allocate.
+  new_list.reserve_nodes(5);
+  size_t allocations_before = g_num_allocations;
+  new_list.push_back(payload);
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  // Moving in costs nothing.
+  std::string moved_payload(payload);
+  allocations_before = g_num_allocations;
+  new_list.push_back(std::move(moved_payload));
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  moved_payload = payload;
+  allocations_before = g_num_allocations;
+  new_list.push_front(std::move(moved_payload));
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  // Constructing in place builds the string inside the node.
+  allocations_before = g_num_allocations;
+  new_list.emplace_back(100, 'y');
+  new_list.emplace_front(100, 'z');
+  ASSERT_EQ(g_num_allocations - allocations_before, 2);
+  ASSERT_EQ(new_list.size(), 5);
+  ASSERT(new_list.front() == std::string(100, 'z'));
+  ASSERT(new_list.back() == std::string(100, 'y'));
+
+  prac::list<CopyCounter> counters;
+  CopyCounter::reset();
+  counters.emplace_back(3);
+  counters.emplace_front(2);
+  counters.push_back(CopyCounter(4));
+  ASSERT_EQ(CopyCounter::num_copies, 0);
+  ASSERT_EQ(CopyCounter::num_moves, 1);
+
+  // Insert in the middle, at the front and at the end.
+  prac::list<int> ints;
+  ints.push_back(1);
+  ints.push_back(3);
+  auto itr = ints.begin();
+  itr++;
+  itr = ints.emplace(itr, 2);
+  ASSERT_EQ(*itr, 2);
+  ints.emplace(ints.begin(), 0);
+  ints.emplace(ints.end(), 4);
+  ASSERT_EQ(ints.size(), 5);
+  int expected = 0;
+  for (auto val : ints) {
+    ASSERT_EQ(val, expected);
+    expected++;
+  }
+  expected = 4;
+  for (auto ritr = ints.rbegin(); ritr != ints.rend(); ritr++) {
+    ASSERT_EQ(*ritr, expected);
+    expected--;
+  }
+}
+
+template <typename T> void testNodePool() {
+  // Declared first, since lists sharing it must be destroyed before it.
+  typename prac::list<T>::node_pool_type pool;
+  // A queue that churns at a steady size makes no allocator calls.
+  prac::list<T> queue;
+  queue.reserve_nodes(64);
+  std::vector<T> values;
+  for (size_t i = 0; i < 64; i++) {
+    values.push_back(randomVal<T>());
+  }
+  size_t allocations_before = g_num_allocations;
+  for (size_t i = 0; i < 10000; i++) {
+    if (queue.size() == 64) {
+      // The element pushed 64 iterations ago.
+      ASSERT(queue.front() == values[i % 64]);
+      queue.pop_front();
+    }
+    queue.push_back(values[i % 64]);
+  }
+  if (std::is_trivially_copyable<T>::value) {
+    ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  }
+  ASSERT_EQ(queue.size(), 64);
+  std::list<T> stl_queue(queue.begin(), queue.end());
+
+  // Freed nodes are handed out again.
+  const T *back_address = &queue.back();
+  queue.pop_back();
+  queue.push_back(values[0]);
+  ASSERT(&queue.back() == back_address);
+
+  // Lists can share a pool, and nodes freed by one are reused by the
+  // other. Moving a list keeps it on the shared pool.
+  prac::list<T> first(pool);
+  prac::list<T> second(pool);
+  for (size_t i = 0; i < 100; i++) {
+    first.push_back(values[i % 64]);
+  }
+  size_t capacity = pool.capacity();
+  while (first.size() > 0) {
+    first.pop_front();
+  }
+  for (size_t i = 0; i < 100; i++) {
+    second.push_front(values[i % 64]);
+  }
+  ASSERT_EQ(pool.capacity(), capacity);
+  prac::list<T> moved(std::move(second));
+  ASSERT_EQ(moved.size(), 100);
+  moved.push_back(values[0]);
+  ASSERT(pool.capacity() >= 101);
+  size_t available = pool.available();
+  moved = prac::list<T>(stl_queue.begin(), stl_queue.end());
+  ASSERT_EQ(moved.size(), stl_queue.size());
+  ASSERT(pool.available() > available);
+  auto stl_itr = stl_queue.begin();
+  for (const auto &elem : moved) {
+    ASSERT(elem == *stl_itr);
+    stl_itr++;
+  }
+  // Copies and swaps.
+  prac::list<T> copied(moved);
+  ASSERT_EQ(copied.size(), moved.size());
+  copied.swap(queue);
+  queue.swap(moved);
+  ASSERT_EQ(copied.size(), 64);
+  copied = moved;
+  ASSERT_EQ(copied.size(), moved.size());
+}
+
+template <typename T> void testBulkInsert() {
+  std::vector<T> values;
+  for (size_t i = 0; i < 40; i++) {
+    values.push_back(randomVal<T>());
+  }
+  // A forward range gets one contiguous block of nodes.
+  prac::list<T> new_list(values.begin(), values.end());
+  ASSERT_EQ(new_list.size(), values.size());
+  const T *last_address = nullptr;
+  size_t i = 0;
+  for (const auto &elem : new_list) {
+    ASSERT(elem == values[i]);
+    // Consecutive elements sit in consecutive slots.
+    ASSERT(last_address == nullptr || &elem > last_address);
+    last_address = &elem;
+    i++;
+  }
+
+  std::list<T> stl_list(values.begin(), values.end());
+  size_t offset = rand() % values.size();
+  auto pos = new_list.begin();
+  auto stl_pos = stl_list.begin();
+  for (size_t j = 0; j < offset; j++) {
+    pos++;
+    stl_pos++;
+  }
+  auto inserted = new_list.insert(pos, values.begin(), values.begin() + 7);
+  stl_list.insert(stl_pos, values.begin(), values.begin() + 7);
+  ASSERT(*inserted == values[0]);
+  new_list.insert(new_list.begin(), values.begin() + 3, values.begin() + 5);
+  stl_list.insert(stl_list.begin(), values.begin() + 3, values.begin() + 5);
+  new_list.append(values.begin() + 10, values.end());
+  stl_list.insert(stl_list.end(), values.begin() + 10, values.end());
+  ASSERT(new_list.insert(new_list.begin(), values.begin(), values.begin()) ==
+         new_list.begin());
+  ASSERT_EQ(new_list.size(), stl_list.size());
+  auto stl_itr = stl_list.begin();
+  for (const auto &elem : new_list) {
+    ASSERT(elem == *stl_itr);
+    stl_itr++;
+  }
+  for (auto ritr = new_list.rbegin(); ritr != new_list.rend(); ritr++) {
+    stl_itr--;
+    ASSERT(*ritr == *stl_itr);
+  }
+
+  new_list.assign(values.begin(), values.begin() + 5);
+  ASSERT_EQ(new_list.size(), 5);
+  ASSERT(new_list.front() == values[0]);
+  ASSERT(new_list.back() == values[4]);
+}
+
+void testBulkInsertAllocations() {
+  // One block for the nodes of a forward range, however long.
+  std::vector<int> ids(10000);
+  for (size_t i = 0; i < ids.size(); i++) {
+    ids[i] = int(i);
+  }
+  size_t allocations_before = g_num_allocations;
+  prac::list<int> loaded(ids.begin(), ids.end());
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  ASSERT_EQ(loaded.size(), ids.size());
+  ASSERT_EQ(loaded.back(), 9999);
+  allocations_before = g_num_allocations;
+  loaded.assign(ids.begin(), ids.end());
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+
+  // Input ranges work too, a node at a time.
+  std::istringstream input("1 2 3 4");
+  prac::list<int> parsed;
+  parsed.append(std::istream_iterator<int>(input),
+                std::istream_iterator<int>());
+  ASSERT_EQ(parsed.size(), 4);
+  ASSERT_EQ(parsed.back(), 4);
+}
+
+template <typename T> void testInsertErase() {
+  std::list<T> stl_list;
+  prac::list<T> new_list = randomList<T>(&stl_list, 30);
+  for (size_t round = 0; round < 200; round++) {
+    size_t offset = rand() % (new_list.size() + 1);
+    auto pos = new_list.begin();
+    auto stl_pos = stl_list.begin();
+    for (size_t j = 0; j < offset; j++) {
+      pos++;
+      stl_pos++;
+    }
+    if (rand() % 2 == 0 || new_list.size() == 0) {
+      T val = randomVal<T>();
+      auto inserted = new_list.insert(pos, val);
+      stl_list.insert(stl_pos, val);
+      ASSERT(*inserted == val);
+    } else if (pos != new_list.end()) {
+      auto next = pos;
+      next++;
+      ASSERT(new_list.erase(pos) == next);
+      stl_list.erase(stl_pos);
+    }
+  }
+  assertSameElements(new_list, stl_list);
+
+  // Moving in, and erasing ranges.
+  T val = randomVal<T>();
+  T moved_val = val;
+  new_list.insert(new_list.end(), std::move(moved_val));
+  stl_list.push_back(val);
+  auto last = new_list.begin();
+  auto stl_last = stl_list.begin();
+  for (size_t j = 0; j < new_list.size() / 2; j++) {
+    last++;
+    stl_last++;
+  }
+  ASSERT(new_list.erase(new_list.begin(), last) == last);
+  stl_list.erase(stl_list.begin(), stl_last);
+  assertSameElements(new_list, stl_list);
+  new_list.erase(new_list.begin(), new_list.end());
+  ASSERT_EQ(new_list.size(), 0);
+  ASSERT(new_list.begin() == new_list.end());
+}
+
+void testRemoveIf() {
+  prac::list<int> new_list;
+  std::list<int> stl_list;
+  for (int i = 0; i < 100; i++) {
+    int val = rand() % 10;
+    new_list.push_back(val);
+    stl_list.push_back(val);
+  }
+  auto is_odd = [](const int &val) { return val % 2 != 0; };
+  size_t num_odd = size_t(std::count_if(stl_list.begin(), stl_list.end(),
+                                        is_odd));
+  ASSERT_EQ(new_list.remove_if(is_odd), num_odd);
+  stl_list.remove_if(is_odd);
+  assertSameElements(new_list, stl_list);
+  ASSERT_EQ(new_list.remove_if([](const int &) { return true; }),
+            stl_list.size());
+  ASSERT_EQ(new_list.size(), 0);
+}
+
+template <typename T> void testSplice() {
+  typename prac::list<T>::node_pool_type pool;
+  std::list<T> stl_first;
+  std::list<T> stl_second;
+  prac::list<T> first(pool);
+  prac::list<T> second(pool);
+  for (size_t i = 0; i < 20; i++) {
+    T val = randomVal<T>();
+    first.push_back(val);
+    stl_first.push_back(val);
+    val = randomVal<T>();
+    second.push_back(val);
+    stl_second.push_back(val);
+  }
+  auto nth = [](auto itr, const size_t &n) {
+    for (size_t j = 0; j < n; j++) {
+      itr++;
+    }
+    return itr;
+  };
+
+  // Lists sharing a pool only relink nodes.
+  const T *moved_address = &*nth(second.begin(), 3);
+  size_t allocations_before = g_num_allocations;
+  first.splice(nth(first.begin(), 5), second, nth(second.begin(), 3));
+  stl_first.splice(nth(stl_first.begin(), 5), stl_second,
+                   nth(stl_second.begin(), 3));
+  ASSERT(&*nth(first.begin(), 5) == moved_address);
+  first.splice(first.end(), second, second.begin());
+  stl_first.splice(stl_first.end(), stl_second, stl_second.begin());
+  first.splice(first.begin(), first, nth(first.begin(), 7));
+  stl_first.splice(stl_first.begin(), stl_first, nth(stl_first.begin(), 7));
+  first.splice(nth(first.begin(), 2), second, nth(second.begin(), 4),
+               nth(second.begin(), 9));
+  stl_first.splice(nth(stl_first.begin(), 2), stl_second,
+                   nth(stl_second.begin(), 4), nth(stl_second.begin(), 9));
+  first.splice(first.begin(), first, nth(first.begin(), 10), first.end());
+  stl_first.splice(stl_first.begin(), stl_first, nth(stl_first.begin(), 10),
+                   stl_first.end());
+  second.splice(nth(second.begin(), 1), first);
+  stl_second.splice(nth(stl_second.begin(), 1), stl_first);
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  assertSameElements(first, stl_first);
+  assertSameElements(second, stl_second);
+  first.splice(first.end(), second);
+  stl_first.splice(stl_first.end(), stl_second);
+  assertSameElements(first, stl_first);
+  assertSameElements(second, stl_second);
+
+  // A list given a pool and one with a pool of its own can't exchange
+  // nodes, so elements are moved across.
+  prac::list<T> own_pool;
+  std::list<T> stl_own_pool;
+  own_pool.splice(own_pool.end(), first, nth(first.begin(), 6));
+  stl_own_pool.splice(stl_own_pool.end(), stl_first,
+                      nth(stl_first.begin(), 6));
+  own_pool.splice(own_pool.begin(), first, first.begin(),
+                  nth(first.begin(), 10));
+  stl_own_pool.splice(stl_own_pool.begin(), stl_first, stl_first.begin(),
+                      nth(stl_first.begin(), 10));
+  own_pool.splice(nth(own_pool.begin(), 3), first);
+  stl_own_pool.splice(nth(stl_own_pool.begin(), 3), stl_first);
+  assertSameElements(first, stl_first);
+  assertSameElements(own_pool, stl_own_pool);
+}
+
+template <typename T> void testSpliceBetweenOwnPools() {
+  std::vector<T> values;
+  for (size_t i = 0; i < 300; i++) {
+    values.push_back(randomVal<T>());
+  }
+  prac::list<T> kept;
+  std::list<T> stl_kept;
+  {
+    // Lists that own their pools come to share one, so nodes are
+    // relinked and iterators to them stay valid, as for std::list.
+    prac::list<T> first(values.begin(), values.begin() + 100);
+    prac::list<T> second(values.begin() + 100, values.begin() + 200);
+    std::list<T> stl_first(values.begin(), values.begin() + 100);
+    std::list<T> stl_second(values.begin() + 100, values.begin() + 200);
+    auto moved = second.begin();
+    moved++;
+    const T *moved_address = &*moved;
+    first.splice(first.begin(), second, moved);
+    stl_first.splice(stl_first.begin(), stl_second,
+                     std::next(stl_second.begin()));
+    ASSERT(first.begin() == moved);
+    ASSERT(&*first.begin() == moved_address);
+    auto range_front = second.begin();
+    const T *range_address = &*range_front;
+    size_t allocations_before = g_num_allocations;
+    first.splice(first.end(), second, range_front,
+                 std::next(second.begin(), 50));
+    stl_first.splice(stl_first.end(), stl_second, stl_second.begin(),
+                     std::next(stl_second.begin(), 50));
+    second.splice(second.begin(), first);
+    stl_second.splice(stl_second.begin(), stl_first);
+    ASSERT_EQ(g_num_allocations - allocations_before, 0);
+    ASSERT(&*range_front == range_address);
+    assertSameElements(first, stl_first);
+    assertSameElements(second, stl_second);
+
+    // A third list joins them, and a separate pair's pool is merged in.
+    prac::list<T> third(values.begin() + 200, values.begin() + 250);
+    prac::list<T> fourth(values.begin() + 250, values.end());
+    prac::list<T> fifth;
+    fifth.splice(fifth.end(), fourth, fourth.begin());
+    third.splice(third.end(), fifth);
+    second.splice(second.end(), third, third.begin(), third.end());
+    fourth.push_back(values[0]);
+    first.splice(first.end(), fourth);
+    stl_second.insert(stl_second.end(), values.begin() + 200,
+                      values.begin() + 251);
+    stl_first.insert(stl_first.end(), values.begin() + 251, values.end());
+    stl_first.push_back(values[0]);
+    assertSameElements(second, stl_second);
+    assertSameElements(first, stl_first);
+
+    // The nodes outlive the lists they were built in.
+    kept.splice(kept.end(), second);
+    kept.merge(first, [](const T &, const T &) { return false; });
+    stl_kept.splice(stl_kept.end(), stl_second);
+    stl_kept.splice(stl_kept.end(), stl_first);
+  }
+  assertSameElements(kept, stl_kept);
+  kept.pop_front();
+  stl_kept.pop_front();
+  kept.push_back(values[1]);
+  stl_kept.push_back(values[1]);
+  assertSameElements(kept, stl_kept);
+}
+
+template <typename T> void testMerge() {
+  typename prac::list<T>::node_pool_type pool;
+  std::vector<T> values;
+  for (size_t i = 0; i < 60; i++) {
+    values.push_back(randomVal<T>());
+  }
+  std::sort(values.begin(), values.begin() + 25);
+  std::sort(values.begin() + 25, values.end());
+  std::list<T> stl_first(values.begin(), values.begin() + 25);
+  std::list<T> stl_second(values.begin() + 25, values.end());
+  prac::list<T> first(pool);
+  prac::list<T> second(pool);
+  first.append(values.begin(), values.begin() + 25);
+  second.append(values.begin() + 25, values.end());
+  size_t allocations_before = g_num_allocations;
+  first.merge(second);
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  stl_first.merge(stl_second);
+  assertSameElements(first, stl_first);
+  ASSERT_EQ(second.size(), 0);
+
+  // Into an empty list, from a list with its own pool, and with a
+  // comparison of its own.
+  prac::list<T> own_pool(values.begin(), values.begin() + 25);
+  std::list<T> stl_own_pool(values.begin(), values.begin() + 25);
+  second.merge(own_pool);
+  stl_second.merge(stl_own_pool);
+  assertSameElements(second, stl_second);
+  ASSERT_EQ(own_pool.size(), 0);
+  prac::list<T> descending(values.rbegin(), values.rend());
+  std::list<T> stl_descending(values.rbegin(), values.rend());
+  descending.sort(std::greater<T>());
+  stl_descending.sort(std::greater<T>());
+  prac::list<T> other_descending(descending);
+  std::list<T> stl_other_descending(stl_descending);
+  descending.merge(other_descending, std::greater<T>());
+  stl_descending.merge(stl_other_descending, std::greater<T>());
+  assertSameElements(descending, stl_descending);
+}
+
+template <typename T> void testSort() {
+  for (size_t size : {0, 1, 2, 3, 31, 64, 1000, 1023}) {
+    std::list<T> stl_list;
+    prac::list<T> new_list = randomList<T>(&stl_list, size);
+    std::vector<const T *> addresses;
+    for (const auto &elem : new_list) {
+      addresses.push_back(&elem);
+    }
+    size_t allocations_before = g_num_allocations;
+    new_list.sort();
+    ASSERT_EQ(g_num_allocations - allocations_before, 0);
+    stl_list.sort();
+    assertSameElements(new_list, stl_list);
+    // Nodes were relinked, not values moved.
+    std::vector<const T *> sorted_addresses;
+    for (const auto &elem : new_list) {
+      sorted_addresses.push_back(&elem);
+    }
+    std::sort(addresses.begin(), addresses.end());
+    std::sort(sorted_addresses.begin(), sorted_addresses.end());
+    ASSERT(addresses == sorted_addresses);
+  }
+}
+
+void testSortStability() {
+  prac::list<KeyedValue> new_list;
+  std::list<KeyedValue> stl_list;
+  for (int i = 0; i < 5000; i++) {
+    KeyedValue val{rand() % 50, i};
+    new_list.push_back(val);
+    stl_list.push_back(val);
+  }
+  new_list.sort();
+  stl_list.sort();
+  assertSameElements(new_list, stl_list);
+  for (auto itr = new_list.begin(), next = ++new_list.begin();
+       next != new_list.end(); itr++, next++) {
+    ASSERT((*itr).key < (*next).key ||
+           ((*itr).key == (*next).key && (*itr).order < (*next).order));
+  }
+}
+
+void testSortThrows() {
+  // A throwing comparison loses no elements and leaves the links
+  // consistent.
+  for (size_t throw_after : {0, 1, 10, 500, 2000}) {
+    prac::list<int> new_list;
+    std::vector<int> values;
+    for (size_t i = 0; i < 500; i++) {
+      values.push_back(rand() % 1000);
+      new_list.push_back(values.back());
+    }
+    size_t num_comparisons = 0;
+    bool threw = false;
+    try {
+      new_list.sort([&](const int &a, const int &b) {
+        if (num_comparisons++ == throw_after) {
+          throw std::runtime_error("comparison failed");
+        }
+        return a < b;
+      });
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    ASSERT_EQ(threw, throw_after < num_comparisons);
+    std::vector<int> forward(new_list.begin(), new_list.end());
+    std::vector<int> backward(new_list.rbegin(), new_list.rend());
+    std::reverse(backward.begin(), backward.end());
+    ASSERT(forward == backward);
+    ASSERT_EQ(forward.size(), new_list.size());
+    std::sort(forward.begin(), forward.end());
+    std::sort(values.begin(), values.end());
+    ASSERT(forward == values);
+  }
+}
+
 template <typename T> void testAll() {
   testConstruction<T>();
   testPushBack<T>();
@@ -123,9 +673,21 @@ template <typename T> void testAll() {
   testForwardIterators<T>();
   testReverseIterators<T>();
   testSTLConstruction<T>();
+  testNodePool<T>();
+  testBulkInsert<T>();
+  testInsertErase<T>();
+  testSplice<T>();
+  testSpliceBetweenOwnPools<T>();
+  testMerge<T>();
+  testSort<T>();
 }
 
 int main(int argc, char **argv) {
   testAll<int>();
   testAll<std::string>();
+  testEmplace();
+  testBulkInsertAllocations();
+  testRemoveIf();
+  testSortStability();
+  testSortThrows();
 }
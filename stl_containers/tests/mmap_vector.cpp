@@ -0,0 +1,166 @@
+#include "mmap_vector.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <stdint.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct Point {
+  double x;
+  double y;
+  int32_t id;
+};
+
+/// A fresh path in the temporary directory, removed when it goes out
+/// of scope.
+struct TempPath {
+  TempPath() {
+    char name[] = "/tmp/prac_mmap_vector_XXXXXX";
+    int fd = mkstemp(name);
+    ASSERT(fd >= 0);
+    close(fd);
+    path = name;
+  }
+  ~TempPath() { unlink(path.c_str()); }
+
+  std::string path;
+};
+
+size_t fileSize(const std::string &path) {
+  struct stat st;
+  ASSERT_EQ(stat(path.c_str(), &st), 0);
+  return size_t(st.st_size);
+}
+
+}; // namespace
+
+void testPushBackAndReopen() {
+  TempPath tmp;
+  std::vector<int64_t> stl_vec;
+  {
+    prac::mmap_vector<int64_t> vec(tmp.path);
+    ASSERT_EQ(vec.size(), 0);
+    ASSERT(vec.empty());
+    for (size_t i = 0; i < 100000; i++) {
+      int64_t val = randomVal<int64_t>();
+      vec.push_back(val);
+      stl_vec.push_back(val);
+    }
+    ASSERT_EQ(vec.size(), stl_vec.size());
+    ASSERT(vec.capacity() >= vec.size());
+    // Pushing back an element of the vector itself while it grows.
+    while (vec.size() < vec.capacity()) {
+      vec.push_back(vec[0]);
+      stl_vec.push_back(stl_vec[0]);
+    }
+    vec.push_back(vec[vec.size() - 1]);
+    stl_vec.push_back(stl_vec.back());
+    vec.sync();
+  }
+  // Everything is still there after reopening, without reading it.
+  prac::mmap_vector<int64_t> vec(tmp.path);
+  ASSERT_EQ(vec.size(), stl_vec.size());
+  for (size_t i = 0; i < stl_vec.size(); i++) {
+    ASSERT_EQ(vec[i], stl_vec[i]);
+  }
+  size_t i = 0;
+  for (const int64_t &val : vec) {
+    ASSERT_EQ(val, stl_vec[i++]);
+  }
+  vec.pop_back();
+  ASSERT_EQ(vec.size(), stl_vec.size() - 1);
+}
+
+void testResizeAndShrink() {
+  TempPath tmp;
+  prac::mmap_vector<Point> vec(tmp.path);
+  vec.resize(1000, Point{1.0, 2.0, 3});
+  ASSERT_EQ(vec.size(), 1000);
+  ASSERT_EQ(vec[999].id, 3);
+  vec[10].id = 42;
+  vec.resize(10);
+  ASSERT_EQ(vec.size(), 10);
+  size_t capacity = vec.capacity();
+  ASSERT(capacity >= 1000);
+  vec.resize(20);
+  // Growing back doesn't resurrect old values.
+  ASSERT_EQ(vec[10].id, 0);
+  ASSERT_EQ(vec.capacity(), capacity);
+  vec.shrink_to_fit();
+  ASSERT_EQ(vec.capacity(), 20);
+  ASSERT_EQ(fileSize(tmp.path),
+            prac::mmap_vector<Point>::header_bytes + 20 * sizeof(Point));
+  vec.reserve(5000);
+  ASSERT_EQ(vec.capacity(), 5000);
+  ASSERT_EQ(vec[9].x, 1.0);
+  vec.clear();
+  ASSERT_EQ(vec.size(), 0);
+}
+
+void testAppend() {
+  TempPath tmp;
+  std::vector<int32_t> stl_vec;
+  for (int32_t i = 0; i < 5000; i++) {
+    stl_vec.push_back(i * 3);
+  }
+  prac::mmap_vector<int32_t> vec(tmp.path);
+  vec.push_back(-1);
+  vec.append(stl_vec.data(), stl_vec.data() + stl_vec.size());
+  vec.append(stl_vec.begin(), stl_vec.begin() + 10);
+  ASSERT_EQ(vec.size(), 5011);
+  ASSERT_EQ(vec[0], -1);
+  ASSERT_EQ(vec[4999], stl_vec[4998]);
+  ASSERT_EQ(vec[5010], stl_vec[9]);
+
+  prac::mmap_vector<int32_t> moved(std::move(vec));
+  ASSERT_EQ(moved.size(), 5011);
+  ASSERT(moved.path() == tmp.path);
+}
+
+void testRejectsOtherFiles() {
+  TempPath tmp;
+  {
+    prac::mmap_vector<int32_t> vec(tmp.path);
+    vec.push_back(1);
+  }
+  bool threw = false;
+  try {
+    prac::mmap_vector<int64_t> wrong_type(tmp.path);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+
+  TempPath garbage;
+  FILE *file = fopen(garbage.path.c_str(), "w");
+  for (int i = 0; i < 100; i++) {
+    fputc('x', file);
+  }
+  fclose(file);
+  threw = false;
+  try {
+    prac::mmap_vector<int32_t> not_ours(garbage.path);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+
+  threw = false;
+  try {
+    prac::mmap_vector<int32_t> missing_dir("/nonexistent/dir/file");
+  } catch (const std::system_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+int main(int argc, char **argv) {
+  testPushBackAndReopen();
+  testResizeAndShrink();
+  testAppend();
+  testRejectsOtherFiles();
+}
@@ -0,0 +1,171 @@
+#include "parallel.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void testForRange(prac::parallel::thread_pool &pool) {
+  // Every index is visited exactly once, for any grain.
+  size_t grains[] = {1, 7, 1000, 100000};
+  for (size_t grain : grains) {
+    std::vector<std::atomic<int>> visits(10000);
+    for (auto &visit : visits) {
+      visit = 0;
+    }
+    pool.for_range(0, visits.size(), grain, [&](size_t begin, size_t end) {
+      ASSERT(end - begin <= grain);
+      for (size_t i = begin; i < end; i++) {
+        visits[i]++;
+      }
+    });
+    for (auto &visit : visits) {
+      ASSERT_EQ(visit.load(), 1);
+    }
+  }
+  // Nested calls from inside a body.
+  std::atomic<size_t> total(0);
+  prac::parallel::parallel_for(
+      0, 16,
+      [&](size_t /*i*/) {
+        prac::parallel::parallel_for(
+            0, 100, [&](size_t j) { total += j; }, 10, pool);
+      },
+      1, pool);
+  ASSERT_EQ(total.load(), 16 * 4950);
+}
+
+void testAlgorithms(prac::parallel::thread_pool &pool) {
+  prac::vector<int> values;
+  for (int i = 0; i < 100000; i++) {
+    values.push_back(i % 1000);
+  }
+  prac::parallel::parallel_for(values, [](int &value) { value *= 2; }, 0,
+                               pool);
+  ASSERT_EQ(values[999], 1998);
+  long long sum = prac::parallel::parallel_reduce(
+      values, 0, [](const int &x, const int &y) { return x + y; }, 0, pool);
+  ASSERT_EQ(sum, 100 * 999000);
+  // The order of combination is fixed, so non-commutative ops work.
+  prac::vector<std::string> letters;
+  for (int i = 0; i < 5000; i++) {
+    letters.push_back(std::string(1, char('a' + i % 26)));
+  }
+  std::string joined = prac::parallel::parallel_reduce(
+      letters, std::string(">"),
+      [](const std::string &x, const std::string &y) { return x + y; }, 64,
+      pool);
+  ASSERT_EQ(joined.size(), 5001);
+  for (size_t i = 1; i < joined.size(); i++) {
+    ASSERT_EQ(joined[i], char('a' + (i - 1) % 26));
+  }
+
+  prac::vector<std::string> strings;
+  prac::parallel::parallel_transform(
+      values, strings, [](const int &value) { return std::to_string(value); },
+      100, pool);
+  ASSERT_EQ(strings.size(), values.size());
+  ASSERT(strings[999] == "1998");
+
+  prac::parallel::parallel_fill(strings, std::string(30, 'f'), 0, pool);
+  ASSERT(strings[12345] == std::string(30, 'f'));
+  prac::parallel::parallel_fill(strings, 1000, std::string("x"), 0, pool);
+  ASSERT_EQ(strings.size(), 1000);
+  ASSERT(strings[999] == "x");
+  prac::vector<double> doubles;
+  prac::parallel::parallel_fill(doubles, 50000, 1.5, 0, pool);
+  ASSERT_EQ(doubles.capacity(), 50000);
+  ASSERT(doubles[49999] == 1.5);
+}
+
+template <typename T> void testSort(prac::parallel::thread_pool &pool) {
+  size_t sizes[] = {0, 1, 17, 5000, 100000};
+  size_t grains[] = {0, 1000, 333};
+  for (size_t size : sizes) {
+    for (size_t grain : grains) {
+      prac::vector<T> vec;
+      std::vector<T> stl_vec;
+      for (size_t i = 0; i < size; i++) {
+        T val = randomVal<T>();
+        vec.push_back(val);
+        stl_vec.push_back(val);
+      }
+      prac::parallel::parallel_sort(vec, std::less<T>(), grain, pool);
+      std::sort(stl_vec.begin(), stl_vec.end());
+      ASSERT_EQ(vec.size(), stl_vec.size());
+      for (size_t i = 0; i < size; i++) {
+        ASSERT(vec[i] == stl_vec[i]);
+      }
+    }
+  }
+  // A custom order.
+  prac::vector<T> vec;
+  for (size_t i = 0; i < 20000; i++) {
+    vec.push_back(randomVal<T>());
+  }
+  prac::parallel::parallel_sort(vec, std::greater<T>(), 0, pool);
+  for (size_t i = 1; i < vec.size(); i++) {
+    ASSERT(vec[i - 1] >= vec[i]);
+  }
+}
+
+void testExceptions(prac::parallel::thread_pool &pool) {
+  bool thrown = false;
+  try {
+    prac::parallel::parallel_for(
+        0, 1000,
+        [](size_t i) {
+          if (i == 500) {
+            throw std::runtime_error("boom");
+          }
+        },
+        10, pool);
+  } catch (const std::runtime_error &error) {
+    thrown = std::string(error.what()) == "boom";
+  }
+  ASSERT(thrown);
+  // A failed construction destroys what it built.
+  prac::vector<int> values(10000, 1);
+  prac::vector<std::string> strings;
+  std::atomic<size_t> calls(0);
+  thrown = false;
+  try {
+    prac::parallel::parallel_transform(
+        values, strings,
+        [&calls](const int & /*value*/) -> std::string {
+          if (++calls == 5000) {
+            throw std::runtime_error("boom");
+          }
+          return std::string(40, 's');
+        },
+        100, pool);
+  } catch (const std::runtime_error &) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+  ASSERT_EQ(strings.size(), 0);
+  // The pool still works.
+  std::atomic<size_t> count(0);
+  prac::parallel::parallel_for(0, 100, [&](size_t) { count++; }, 1, pool);
+  ASSERT_EQ(count.load(), 100);
+}
+
+int main(int argc, char **argv) {
+  size_t thread_counts[] = {1, 2, 4};
+  for (size_t num_threads : thread_counts) {
+    prac::parallel::thread_pool pool(num_threads);
+    ASSERT_EQ(pool.num_threads(), num_threads);
+    testForRange(pool);
+    testAlgorithms(pool);
+    testSort<int>(pool);
+    testSort<std::string>(pool);
+    testExceptions(pool);
+  }
+  // The global pool.
+  prac::vector<int> values(1000, 3);
+  ASSERT_EQ(prac::parallel::parallel_reduce(
+                values, 0, [](const int &x, const int &y) { return x + y; }),
+            3000);
+}
@@ -0,0 +1,294 @@
+#include "persistent_vector.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Counts live instances, to check that shared nodes are destroyed
+/// exactly once.
+struct Tracked {
+  static std::atomic<int> num_live;
+
+  Tracked(const uint64_t &value_in = 0) : value(value_in) { num_live++; }
+  Tracked(const Tracked &other) : value(other.value) { num_live++; }
+  Tracked &operator=(const Tracked &other) {
+    value = other.value;
+    return *this;
+  }
+  ~Tracked() { num_live--; }
+
+  uint64_t value;
+};
+std::atomic<int> Tracked::num_live(0);
+
+/// Throws on a copy once copies_left runs out.
+struct ThrowOnCopy {
+  static int copies_left;
+
+  ThrowOnCopy(const int &value_in = 0) : value(value_in) {}
+  ThrowOnCopy(const ThrowOnCopy &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy failed");
+    }
+  }
+  ThrowOnCopy &operator=(const ThrowOnCopy &) = default;
+
+  int value;
+};
+int ThrowOnCopy::copies_left = 0;
+
+template <typename T>
+void assertSameElements(const prac::persistent_vector<T> &vec,
+                        const std::vector<T> &expected) {
+  ASSERT_EQ(vec.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT(vec[i] == expected[i]);
+  }
+  ASSERT(std::equal(vec.begin(), vec.end(), expected.begin()));
+}
+
+}; // namespace
+
+void testPushBack() {
+  // Sizes around where the tail fills and the trie grows a level.
+  const size_t sizes[] = {0,    1,    31,   32,   33,        64,
+                          65,   1024, 1056, 1057, 32768 + 32, 40000};
+  prac::persistent_vector<std::string> vec;
+  std::vector<std::string> expected;
+  std::vector<prac::persistent_vector<std::string>> versions;
+  std::vector<std::vector<std::string>> expected_versions;
+  for (const size_t &size : sizes) {
+    while (expected.size() < size) {
+      expected.push_back(randomVal<std::string>());
+      vec = vec.push_back(expected.back());
+    }
+    assertSameElements(vec, expected);
+    versions.push_back(vec);
+    expected_versions.push_back(expected);
+  }
+  // Every old version is still intact.
+  for (size_t i = 0; i < versions.size(); i++) {
+    assertSameElements(versions[i], expected_versions[i]);
+  }
+  ASSERT(prac::persistent_vector<std::string>().empty());
+  ASSERT(!vec.empty());
+}
+
+void testSet() {
+  prac::persistent_vector<int> vec;
+  std::vector<int> expected;
+  for (int i = 0; i < 5000; i++) {
+    expected.push_back(i);
+    vec = vec.push_back(i);
+  }
+  std::vector<prac::persistent_vector<int>> versions;
+  std::vector<std::vector<int>> expected_versions;
+  for (int i = 0; i < 200; i++) {
+    size_t index = randomVal<size_t>() % expected.size();
+    if (i % 10 == 0) {
+      // The tail.
+      index = expected.size() - 1 - index % 8;
+    }
+    expected[index] = randomVal<int>();
+    prac::persistent_vector<int> changed = vec.set(index, expected[index]);
+    ASSERT(vec[index] != expected[index] || vec[index] == changed[index]);
+    vec = changed;
+    versions.push_back(vec);
+    expected_versions.push_back(expected);
+  }
+  for (size_t i = 0; i < versions.size(); i++) {
+    assertSameElements(versions[i], expected_versions[i]);
+  }
+}
+
+void testSnapshots() {
+  prac::persistent_vector<int> vec;
+  for (int i = 0; i < 100000; i++) {
+    vec = vec.push_back(i);
+  }
+  // A snapshot is a reference: it allocates nothing.
+  size_t allocations_before = g_num_allocations;
+  std::vector<prac::persistent_vector<int>> snapshots;
+  snapshots.reserve(100);
+  size_t reserved = g_num_allocations;
+  for (int i = 0; i < 100; i++) {
+    snapshots.push_back(vec);
+  }
+  ASSERT_EQ(g_num_allocations, reserved);
+  ASSERT(snapshots[50].same_version(vec));
+  // An update allocates a path, not a copy.
+  allocations_before = g_num_allocations;
+  prac::persistent_vector<int> changed = vec.set(12345, -1);
+  ASSERT(g_num_allocations - allocations_before <= 6);
+  ASSERT_EQ(changed[12345], -1);
+  ASSERT_EQ(snapshots[99][12345], 12345);
+  ASSERT(!changed.same_version(vec));
+  ASSERT_EQ(std::accumulate(vec.begin(), vec.end(), int64_t(0)),
+            int64_t(99999) * 100000 / 2);
+}
+
+void testTransient() {
+  prac::persistent_vector<Tracked> original;
+  for (uint64_t i = 0; i < 100; i++) {
+    original = original.push_back(Tracked(i));
+  }
+  {
+    prac::transient_vector<Tracked> edit = original.transient();
+    for (uint64_t i = 100; i < 50000; i++) {
+      edit.push_back(Tracked(i));
+    }
+    for (uint64_t i = 0; i < 50000; i += 7) {
+      edit.set(i, Tracked(i * 2));
+    }
+    ASSERT_EQ(edit.size(), 50000);
+    ASSERT_EQ(edit[49].value, 49 * 2);
+    prac::persistent_vector<Tracked> built = edit.persistent();
+    ASSERT_EQ(edit.size(), 0);
+    ASSERT_EQ(built.size(), 50000);
+    for (uint64_t i = 0; i < 50000; i++) {
+      ASSERT_EQ(built[i].value, i % 7 == 0 ? i * 2 : i);
+    }
+    // The transient never touched the version it started from.
+    ASSERT_EQ(original.size(), 100);
+    for (uint64_t i = 0; i < 100; i++) {
+      ASSERT_EQ(original[i].value, i);
+    }
+    // Later edits through the same transient don't reach built.
+    edit.push_back(Tracked(7));
+    ASSERT_EQ(edit[0].value, 7);
+    ASSERT_EQ(built[0].value, 0);
+
+    // In place, a push costs an allocation only every 32 elements.
+    prac::transient_vector<Tracked> fresh;
+    size_t allocations_before = g_num_allocations;
+    for (uint64_t i = 0; i < 32 * 32 * 32; i++) {
+      fresh.push_back(Tracked(i));
+    }
+    ASSERT(g_num_allocations - allocations_before <= 32 * 32 + 32 + 2);
+  }
+  original = prac::persistent_vector<Tracked>();
+  ASSERT_EQ(Tracked::num_live.load(), 0);
+}
+
+void testTransientOutlivesSource() {
+  // Once the version is gone, the transient holds the only references
+  // to its nodes, and copying one on write must free the original.
+  {
+    prac::persistent_vector<Tracked> version;
+    for (uint64_t i = 0; i < 5000; i++) {
+      version = version.push_back(Tracked(i));
+    }
+    prac::transient_vector<Tracked> edit = version.transient();
+    version = prac::persistent_vector<Tracked>();
+    for (uint64_t i = 0; i < 5000; i += 3) {
+      edit.set(i, Tracked(i + 1));
+    }
+    for (uint64_t i = 0; i < 100; i++) {
+      edit.push_back(Tracked(i));
+    }
+    ASSERT_EQ(Tracked::num_live.load(), 5100);
+    for (uint64_t i = 0; i < 5000; i++) {
+      ASSERT_EQ(edit[i].value, i % 3 == 0 ? i + 1 : i);
+    }
+  }
+  ASSERT_EQ(Tracked::num_live.load(), 0);
+}
+
+void testExceptionSafety() {
+  prac::persistent_vector<ThrowOnCopy> vec;
+  ThrowOnCopy::copies_left = 1000000;
+  for (int i = 0; i < 40; i++) {
+    vec = vec.push_back(ThrowOnCopy(i));
+  }
+  // Copying the tail fails partway through.
+  ThrowOnCopy::copies_left = 3;
+  bool threw = false;
+  try {
+    vec = vec.push_back(ThrowOnCopy(40));
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ThrowOnCopy::copies_left = 2;
+  threw = false;
+  try {
+    vec = vec.set(5, ThrowOnCopy(-5));
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ThrowOnCopy::copies_left = 1000000;
+  ASSERT_EQ(vec.size(), 40);
+  for (int i = 0; i < 40; i++) {
+    ASSERT_EQ(vec[i].value, i);
+  }
+}
+
+void testPublication() {
+  // A writer publishes versions in which every element equals the
+  // size; readers must only ever see whole versions.
+  prac::atomic_persistent_vector<Tracked> published;
+  std::atomic<bool> done(false);
+  std::atomic<size_t> inconsistent(0);
+  std::atomic<size_t> loads(0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; t++) {
+    readers.emplace_back([&] {
+      size_t last_size = 0;
+      while (!done.load()) {
+        prac::persistent_vector<Tracked> snapshot = published.load();
+        if (snapshot.size() < last_size) {
+          inconsistent++;
+        }
+        last_size = snapshot.size();
+        for (const Tracked &value : snapshot) {
+          if (value.value != snapshot.size()) {
+            inconsistent++;
+          }
+        }
+        loads++;
+      }
+    });
+  }
+  prac::persistent_vector<Tracked> current;
+  for (uint64_t size = 1; size <= 300; size++) {
+    prac::transient_vector<Tracked> edit = current.transient();
+    for (uint64_t i = 0; i < size - 1; i++) {
+      edit.set(i, Tracked(size));
+    }
+    edit.push_back(Tracked(size));
+    current = edit.persistent();
+    published.store(current);
+    if (size % 50 == 0) {
+      std::this_thread::yield();
+    }
+  }
+  done = true;
+  for (std::thread &reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(inconsistent.load(), 0);
+  ASSERT(loads.load() > 0);
+  ASSERT_EQ(published.load().size(), 300);
+  current = prac::persistent_vector<Tracked>();
+  published.store(current);
+  prac::hazard_domain::global().reclaim();
+  ASSERT_EQ(Tracked::num_live.load(), 0);
+}
+
+int main(int argc, char **argv) {
+  testPushBack();
+  testSet();
+  testSnapshots();
+  testTransient();
+  testTransientOutlivesSource();
+  testExceptionSafety();
+  testPublication();
+}
@@ -0,0 +1,240 @@
+#include "ring_buffer.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include "vector.hpp"
+#include <atomic>
+#include <deque>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+/// Counts live instances, to check that nothing leaks or is destroyed
+/// twice.
+struct Tracked {
+  static std::atomic<int> num_live;
+
+  Tracked(const uint64_t &value_in = 0) : value(value_in) { num_live++; }
+  Tracked(const Tracked &other) : value(other.value) { num_live++; }
+  Tracked &operator=(const Tracked &other) {
+    value = other.value;
+    return *this;
+  }
+  ~Tracked() { num_live--; }
+
+  uint64_t value;
+};
+std::atomic<int> Tracked::num_live(0);
+
+/// Throws on a copy once copies_left runs out.
+struct ThrowOnCopy {
+  static int copies_left;
+
+  ThrowOnCopy(const int &value_in = 0) : value(value_in) {}
+  ThrowOnCopy(const ThrowOnCopy &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy failed");
+    }
+  }
+  ThrowOnCopy &operator=(const ThrowOnCopy &) = default;
+
+  int value;
+};
+int ThrowOnCopy::copies_left = 0;
+
+}; // namespace
+
+void testFixed() {
+  prac::ring_buffer<std::string, 16> ring;
+  ASSERT_EQ(ring.capacity(), 16);
+  ASSERT(ring.empty());
+  std::string out = "unchanged";
+  ASSERT(!ring.try_pop(out));
+  ASSERT(out == "unchanged");
+  // Random pushes and pops wrap around many times.
+  std::deque<std::string> expected;
+  for (int i = 0; i < 10000; i++) {
+    if (randomVal<int>() % 3 != 0) {
+      std::string value(i % 7, 'a' + i % 26);
+      bool pushed = ring.try_push(value);
+      ASSERT_EQ(pushed, expected.size() < 16);
+      if (pushed) {
+        expected.push_back(value);
+      }
+    } else {
+      bool popped = ring.try_pop(out);
+      ASSERT_EQ(popped, !expected.empty());
+      if (popped) {
+        ASSERT(out == expected.front());
+        expected.pop_front();
+      }
+    }
+    ASSERT_EQ(ring.size(), expected.size());
+  }
+  while (ring.try_emplace(3, 'z')) {
+  }
+  ASSERT_EQ(ring.size(), 16);
+}
+
+void testDynamic() {
+  prac::ring_buffer<int> ring(1000);
+  ASSERT_EQ(ring.capacity(), 1024);
+  // The array is allocated once, at construction.
+  size_t allocations_before = g_num_allocations;
+  int out = 0;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 1024; i++) {
+      ASSERT(ring.try_push(i));
+    }
+    ASSERT(!ring.try_push(-1));
+    for (int i = 0; i < 1024; i++) {
+      ASSERT(ring.try_pop(out));
+      ASSERT_EQ(out, i);
+    }
+    ASSERT(ring.empty());
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  ASSERT_EQ(prac::ring_buffer<int>(1).capacity(), 1);
+}
+
+void testBulk() {
+  prac::ring_buffer<uint64_t, 64> ring;
+  prac::vector<uint64_t> in;
+  prac::vector<uint64_t> out(40);
+  uint64_t next_in = 0;
+  uint64_t next_out = 0;
+  for (int round = 0; round < 500; round++) {
+    in.clear();
+    size_t batch = size_t(randomVal<int>() & 63);
+    for (size_t i = 0; i < batch; i++) {
+      in.push_back(next_in + i);
+    }
+    size_t free = ring.capacity() - ring.size();
+    size_t pushed = ring.push_n(in);
+    ASSERT_EQ(pushed, batch < free ? batch : free);
+    next_in += pushed;
+    size_t available = ring.size();
+    size_t want = size_t(randomVal<int>() & 31) + 1;
+    size_t popped = ring.pop_n(prac::span<uint64_t>(out).first(want));
+    ASSERT_EQ(popped, want < available ? want : available);
+    for (size_t i = 0; i < popped; i++) {
+      ASSERT_EQ(out[i], next_out + i);
+    }
+    next_out += popped;
+  }
+  ASSERT_EQ(ring.size(), next_in - next_out);
+
+  // The same with elements that aren't trivially copyable.
+  {
+    prac::ring_buffer<Tracked, 8> tracked;
+    prac::vector<Tracked> batch;
+    for (uint64_t i = 0; i < 6; i++) {
+      batch.push_back(Tracked(i));
+    }
+    ASSERT_EQ(tracked.push_n(batch), 6);
+    prac::vector<Tracked> received(4);
+    ASSERT_EQ(tracked.pop_n(received), 4);
+    ASSERT_EQ(received[3].value, 3);
+    // Wraps around the end of the array.
+    ASSERT_EQ(tracked.push_n(batch), 6);
+    ASSERT_EQ(tracked.size(), 8);
+    ASSERT_EQ(tracked.pop_n(received), 4);
+    ASSERT_EQ(received[0].value, 4);
+    ASSERT_EQ(received[2].value, 0);
+  }
+  ASSERT_EQ(Tracked::num_live.load(), 0);
+}
+
+void testExceptionSafety() {
+  prac::ring_buffer<ThrowOnCopy, 8> ring;
+  prac::vector<ThrowOnCopy> batch;
+  ThrowOnCopy::copies_left = 1000000;
+  for (int i = 0; i < 6; i++) {
+    batch.push_back(ThrowOnCopy(i));
+  }
+  ASSERT_EQ(ring.push_n(batch), 6);
+  ThrowOnCopy out;
+  for (int i = 0; i < 5; i++) {
+    ASSERT(ring.try_pop(out));
+  }
+  // The copy into the second run, after the wrap, throws.
+  ThrowOnCopy::copies_left = 4;
+  bool threw = false;
+  try {
+    ring.push_n(batch);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ThrowOnCopy::copies_left = 1000000;
+  ASSERT_EQ(ring.size(), 1);
+  ASSERT(ring.try_pop(out));
+  ASSERT_EQ(out.value, 5);
+}
+
+void testSpsc() {
+  // One thread hands a sequence to another, one at a time and in
+  // batches; it must arrive complete and in order.
+  const uint64_t count = 1000000;
+  prac::spsc_ring_buffer<uint64_t> ring(1024);
+  std::thread consumer([&] {
+    prac::vector<uint64_t> batch(100);
+    uint64_t expected = 0;
+    bool in_order = true;
+    while (expected < count) {
+      size_t popped = 0;
+      if (expected % 3 == 0) {
+        popped = ring.pop_n(batch);
+      } else if (ring.try_pop(batch[0])) {
+        popped = 1;
+      }
+      if (popped == 0) {
+        std::this_thread::yield();
+      }
+      for (size_t i = 0; i < popped; i++) {
+        in_order = in_order && batch[i] == expected;
+        expected++;
+      }
+    }
+    ASSERT(in_order);
+  });
+  prac::vector<uint64_t> batch;
+  uint64_t next = 0;
+  while (next < count) {
+    size_t pushed = 0;
+    if (next % 2 == 0) {
+      batch.clear();
+      for (uint64_t i = next; i < next + 64 && i < count; i++) {
+        batch.push_back(i);
+      }
+      pushed = ring.push_n(batch);
+    } else if (ring.try_push(next)) {
+      pushed = 1;
+    }
+    if (pushed == 0) {
+      std::this_thread::yield();
+    }
+    next += pushed;
+  }
+  consumer.join();
+  ASSERT(ring.empty());
+
+  // Elements left behind are destroyed with the buffer.
+  {
+    prac::spsc_ring_buffer<Tracked, 32> tracked;
+    for (uint64_t i = 0; i < 20; i++) {
+      tracked.try_push(Tracked(i));
+    }
+  }
+  ASSERT_EQ(Tracked::num_live.load(), 0);
+}
+
+int main(int argc, char **argv) {
+  testFixed();
+  testDynamic();
+  testBulk();
+  testExceptionSafety();
+  testSpsc();
+}
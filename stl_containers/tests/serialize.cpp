@@ -0,0 +1,342 @@
+#include "serialize.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/// A temporary file, open for reading and writing, removed when it
+/// goes out of scope.
+struct TempFile {
+  TempFile() {
+    char name[] = "/tmp/prac_serialize_XXXXXX";
+    fd = mkstemp(name);
+    ASSERT(fd >= 0);
+    path = name;
+  }
+  ~TempFile() {
+    close(fd);
+    unlink(path.c_str());
+  }
+
+  /// Go back to the start, to read what was written.
+  void rewind() { ASSERT_EQ(lseek(fd, 0, SEEK_SET), 0); }
+
+  /// Get everything in the file.
+  std::vector<char> contents() {
+    std::vector<char> bytes(size_t(lseek(fd, 0, SEEK_END)));
+    ASSERT_EQ(pread(fd, bytes.data(), bytes.size(), 0),
+              ssize_t(bytes.size()));
+    return bytes;
+  }
+
+  int fd;
+  std::string path;
+};
+
+struct alignas(128) Wide {
+  int64_t value;
+};
+
+template <typename T> prac::vector<T> makeVector(const size_t &size) {
+  prac::vector<T> vec;
+  for (size_t i = 0; i < size; i++) {
+    vec.push_back(randomVal<T>());
+  }
+  return vec;
+}
+
+template <typename Container>
+bool throwsRuntimeError(const int &fd, Container &out) {
+  try {
+    prac::serial::read(fd, out);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+}; // namespace
+
+void testChecksum() {
+  std::string text;
+  for (size_t i = 0; i < 1000; i++) {
+    text += randomVal<std::string>();
+  }
+  prac::serial::checksum whole;
+  whole.update(text.data(), text.size());
+  // Any split gives the same value.
+  for (size_t split = 0; split < 100; split++) {
+    prac::serial::checksum pieces;
+    size_t i = 0;
+    for (size_t n = split; i < text.size(); n = n * 3 % 101 + 1) {
+      size_t chunk = n < text.size() - i ? n : text.size() - i;
+      pieces.update(text.data() + i, chunk);
+      i += chunk;
+    }
+    ASSERT_EQ(pieces.value(), whole.value());
+  }
+  prac::serial::checksum changed;
+  text[text.size() / 2]++;
+  changed.update(text.data(), text.size());
+  ASSERT(changed.value() != whole.value());
+}
+
+template <typename T> void testVectorRoundTrip() {
+  for (size_t size : {0, 1, 7, 1000, 100000}) {
+    TempFile file;
+    prac::vector<T> vec = makeVector<T>(size);
+    prac::serial::write(file.fd, vec);
+    file.rewind();
+    prac::vector<T> loaded = makeVector<T>(5);
+    prac::serial::read(file.fd, loaded);
+    ASSERT_EQ(loaded.size(), vec.size());
+    for (size_t i = 0; i < vec.size(); i++) {
+      ASSERT(loaded[i] == vec[i]);
+    }
+    // Nothing past the container was read.
+    char byte;
+    ASSERT_EQ(::read(file.fd, &byte, 1), 0);
+  }
+}
+
+void testSingleAllocation() {
+  TempFile file;
+  prac::vector<int> vec = makeVector<int>(50000);
+  prac::serial::write(file.fd, vec);
+  file.rewind();
+  prac::vector<int> loaded;
+  size_t allocations_before = g_num_allocations;
+  prac::serial::read(file.fd, loaded);
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  ASSERT_EQ(loaded.capacity(), vec.size());
+}
+
+void testView() {
+  TempFile file;
+  prac::vector<int64_t> vec = makeVector<int64_t>(1000);
+  prac::serial::write(file.fd, vec);
+  std::vector<char> bytes = file.contents();
+  ASSERT_EQ(bytes.size(), sizeof(prac::serial::header) + 1000 * 8);
+  // std::vector's storage is aligned for any fundamental type.
+  prac::serial::view<int64_t> view(bytes.data(), bytes.size());
+  ASSERT_EQ(view.size(), 1000);
+  for (size_t i = 0; i < vec.size(); i++) {
+    ASSERT_EQ(view[i], vec[i]);
+  }
+  ASSERT(view.data() == reinterpret_cast<const int64_t *>(bytes.data() + 64));
+  // A vector can be built from the view with one memcpy.
+  prac::vector<int64_t> copy(view.begin(), view.end());
+  ASSERT_EQ(copy[999], vec[999]);
+
+  bool threw = false;
+  try {
+    prac::serial::view<int64_t> truncated(bytes.data(), bytes.size() - 1);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  bytes[100]++;
+  threw = false;
+  try {
+    prac::serial::view<int64_t> corrupt(bytes.data(), bytes.size());
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  // Without verification, the view is O(1) and trusts the payload.
+  prac::serial::view<int64_t> unverified(bytes.data(), bytes.size(), false);
+  ASSERT_EQ(unverified.size(), 1000);
+  threw = false;
+  try {
+    prac::serial::view<int32_t> wrong_type(bytes.data(), bytes.size());
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+}
+
+void testOverAligned() {
+  TempFile file;
+  prac::vector<Wide> vec;
+  for (int64_t i = 0; i < 10; i++) {
+    vec.push_back(Wide{i});
+  }
+  prac::serial::write(file.fd, vec);
+  ASSERT_EQ(file.contents().size(), 128 + 10 * sizeof(Wide));
+  file.rewind();
+  prac::vector<Wide> loaded;
+  prac::serial::read(file.fd, loaded);
+  ASSERT_EQ(loaded.size(), 10);
+  ASSERT_EQ(loaded[9].value, 9);
+}
+
+template <typename T> void testListRoundTrip() {
+  TempFile file;
+  prac::list<T> values;
+  std::vector<T> stl_vec;
+  for (size_t i = 0; i < 20000; i++) {
+    T val = randomVal<T>();
+    values.push_back(val);
+    stl_vec.push_back(val);
+  }
+  prac::serial::write(file.fd, values);
+  // A second container follows the first in the same file.
+  prac::serial::write(file.fd, values);
+  file.rewind();
+  for (size_t copy = 0; copy < 2; copy++) {
+    prac::list<T> loaded;
+    loaded.push_back(T());
+    prac::serial::read(file.fd, loaded);
+    ASSERT_EQ(loaded.size(), stl_vec.size());
+    size_t i = 0;
+    for (const T &val : loaded) {
+      ASSERT(val == stl_vec[i++]);
+    }
+  }
+  // A list of trivially copyable elements reads back as a vector.
+  if (std::is_trivially_copyable<T>::value) {
+    file.rewind();
+    prac::vector<T> loaded;
+    prac::serial::read(file.fd, loaded);
+    ASSERT_EQ(loaded.size(), stl_vec.size());
+    ASSERT(loaded[19999] == stl_vec[19999]);
+  }
+}
+
+void testStreaming() {
+  TempFile file;
+  prac::serial::stream_writer<std::string> out(file.fd);
+  for (size_t i = 0; i < 100; i++) {
+    out.write(std::string(i, 'a' + i % 26));
+  }
+  out.finish();
+  file.rewind();
+  prac::serial::stream_reader<std::string> in(file.fd);
+  ASSERT_EQ(in.size(), 100);
+  std::string value;
+  size_t i = 0;
+  while (in.read(value)) {
+    ASSERT(value == std::string(i, 'a' + i % 26));
+    i++;
+  }
+  ASSERT_EQ(i, 100);
+}
+
+void testRejectsBadInput() {
+  TempFile file;
+  prac::vector<std::string> strings = makeVector<std::string>(500);
+  prac::serial::write(file.fd, strings);
+  std::vector<char> bytes = file.contents();
+
+  // The wrong element type.
+  file.rewind();
+  prac::vector<int> ints;
+  ASSERT(throwsRuntimeError(file.fd, ints));
+  ASSERT_EQ(ints.size(), 0);
+
+  // A corrupt payload.
+  bytes[bytes.size() - 3]++;
+  ASSERT_EQ(pwrite(file.fd, bytes.data(), bytes.size(), 0),
+            ssize_t(bytes.size()));
+  file.rewind();
+  prac::vector<std::string> loaded;
+  ASSERT(throwsRuntimeError(file.fd, loaded));
+  ASSERT_EQ(loaded.size(), 0);
+
+  // A truncated payload.
+  ASSERT_EQ(ftruncate(file.fd, off_t(bytes.size() / 2)), 0);
+  file.rewind();
+  prac::list<std::string> list_loaded;
+  ASSERT(throwsRuntimeError(file.fd, list_loaded));
+  ASSERT_EQ(list_loaded.size(), 0);
+
+  // Not serialized at all.
+  ASSERT_EQ(ftruncate(file.fd, 0), 0);
+  ASSERT_EQ(pwrite(file.fd, "hello, world", 12, 0), 12);
+  file.rewind();
+  ASSERT(throwsRuntimeError(file.fd, loaded));
+}
+
+void testRejectsBadHeaders() {
+  TempFile file;
+  prac::vector<int> ints = makeVector<int>(1000);
+  prac::serial::write(file.fd, ints);
+  const off_t count_at = offsetof(prac::serial::header, count);
+  const off_t payload_at = offsetof(prac::serial::header, payload_bytes);
+
+  // A payload a few bytes longer than its elements, which are all
+  // there.
+  uint64_t payload_bytes = ints.size() * sizeof(int) + 3;
+  ASSERT_EQ(pwrite(file.fd, &payload_bytes, 8, payload_at), 8);
+  ASSERT_EQ(pwrite(file.fd, "abc", 3, lseek(file.fd, 0, SEEK_END)), 3);
+  file.rewind();
+  prac::vector<int> loaded;
+  ASSERT(throwsRuntimeError(file.fd, loaded));
+  ASSERT_EQ(loaded.size(), 0);
+
+  // A count whose payload size overflows.
+  uint64_t count = UINT64_MAX / 2;
+  ASSERT_EQ(pwrite(file.fd, &count, 8, count_at), 8);
+  file.rewind();
+  ASSERT(throwsRuntimeError(file.fd, loaded));
+
+  // A huge count that agrees with its payload size, which the file
+  // doesn't have: nothing is allocated for it.
+  count = uint64_t(1) << 40;
+  payload_bytes = count * sizeof(int);
+  ASSERT_EQ(pwrite(file.fd, &count, 8, count_at), 8);
+  ASSERT_EQ(pwrite(file.fd, &payload_bytes, 8, payload_at), 8);
+  file.rewind();
+  prac::vector<int> fresh;
+  ASSERT(throwsRuntimeError(file.fd, fresh));
+  ASSERT_EQ(fresh.capacity(), 0);
+  std::vector<char> bytes = file.contents();
+
+  // The same from a pipe, whose length isn't known: the storage
+  // grows with the data until the input runs out.
+  int ends[2];
+  ASSERT_EQ(pipe(ends), 0);
+  ASSERT_EQ(write(ends[1], bytes.data(), bytes.size()),
+            ssize_t(bytes.size()));
+  close(ends[1]);
+  ASSERT(throwsRuntimeError(ends[0], loaded));
+  ASSERT_EQ(loaded.size(), 0);
+  close(ends[0]);
+
+  // Records with a huge count: room is made for no more elements
+  // than the payload has bytes.
+  TempFile records;
+  prac::vector<std::string> strings = makeVector<std::string>(100);
+  prac::serial::write(records.fd, strings);
+  ASSERT_EQ(pwrite(records.fd, &count, 8, count_at), 8);
+  records.rewind();
+  prac::vector<std::string> loaded_strings;
+  ASSERT(throwsRuntimeError(records.fd, loaded_strings));
+  ASSERT_EQ(loaded_strings.size(), 0);
+  ASSERT(loaded_strings.capacity() <= records.contents().size());
+  records.rewind();
+  prac::list<std::string> list_loaded;
+  ASSERT(throwsRuntimeError(records.fd, list_loaded));
+  ASSERT_EQ(list_loaded.size(), 0);
+}
+
+int main(int argc, char **argv) {
+  testChecksum();
+  testVectorRoundTrip<int>();
+  testVectorRoundTrip<double>();
+  testVectorRoundTrip<std::string>();
+  testSingleAllocation();
+  testView();
+  testOverAligned();
+  testListRoundTrip<int>();
+  testListRoundTrip<std::string>();
+  testStreaming();
+  testRejectsBadInput();
+  testRejectsBadHeaders();
+}
@@ -0,0 +1,153 @@
+#include "simd.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <stdint.h>
+#include <vector>
+
+#ifdef PRAC_SIMD_X86
+// transform()'s operations on wide vectors are always inlined; see
+// simd.hpp.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace {
+
+/// Every instruction set this CPU can run, narrowest first.
+std::vector<prac::simd::isa> supportedSets() {
+  std::vector<prac::simd::isa> sets;
+  for (int set = 0; set <= int(prac::simd::detected_isa()); set++) {
+    sets.push_back(prac::simd::isa(set));
+  }
+  return sets;
+}
+
+/// Small values, so that float sums of them are exact and repeats are
+/// common enough to count.
+template <typename T> T smallVal() { return T(rand() % 41 - 20); }
+
+}; // namespace
+
+template <typename T> void testKernels() {
+  for (prac::simd::isa set : supportedSets()) {
+    ASSERT(prac::simd::set_isa(set) == set);
+    // Sizes around the vector widths, and offsets that misalign the
+    // start of the data.
+    for (size_t n = 1; n < 200; n += rand() % 7 + 1) {
+      for (size_t offset = 0; offset < 4; offset++) {
+        prac::vector<T> storage;
+        prac::vector<T> other;
+        for (size_t i = 0; i < n + offset; i++) {
+          storage.push_back(smallVal<T>());
+          other.push_back(smallVal<T>());
+        }
+        const T *data = storage.data() + offset;
+        const T *second = other.data() + offset;
+        T sum = 0;
+        T min = data[0];
+        T max = data[0];
+        T dot = 0;
+        size_t count = 0;
+        for (size_t i = 0; i < n; i++) {
+          sum += data[i];
+          dot += data[i] * second[i];
+          min = data[i] < min ? data[i] : min;
+          max = data[i] > max ? data[i] : max;
+          count += data[i] == data[n / 2];
+        }
+        ASSERT(prac::simd::sum(data, n) == sum);
+        ASSERT(prac::simd::min(data, n) == min);
+        ASSERT(prac::simd::max(data, n) == max);
+        ASSERT(prac::simd::dot(data, second, n) == dot);
+        ASSERT_EQ(prac::simd::count(data, n, data[n / 2]), count);
+        size_t found = prac::simd::find(data, n, data[n / 2]);
+        ASSERT(found <= n / 2 && data[found] == data[n / 2]);
+        for (size_t i = 0; i < found; i++) {
+          ASSERT(data[i] != data[n / 2]);
+        }
+        ASSERT_EQ(prac::simd::find(data, n, T(100)), n);
+
+        prac::vector<T> out(n + offset);
+        prac::simd::transform(data, second, out.data() + offset, n,
+                              prac::simd::multiplies());
+        for (size_t i = 0; i < n; i++) {
+          ASSERT(out[i + offset] == data[i] * second[i]);
+        }
+        prac::simd::transform(data, T(3), out.data(), n, prac::simd::minus());
+        for (size_t i = 0; i < n; i++) {
+          ASSERT(out[i] == data[i] - T(3));
+        }
+      }
+    }
+  }
+  prac::simd::set_isa(prac::simd::detected_isa());
+}
+
+template <typename T> void testVectorOverloads() {
+  prac::vector<T> values;
+  prac::vector<T> ones(1000, T(1));
+  for (size_t i = 0; i < 1000; i++) {
+    values.push_back(T(i % 100));
+  }
+  ASSERT(prac::simd::sum(values) == T(49500));
+  ASSERT(prac::simd::min(values) == T(0));
+  ASSERT(prac::simd::max(values) == T(99));
+  ASSERT_EQ(prac::simd::find(values, T(42)), 42);
+  ASSERT_EQ(prac::simd::count(values, T(42)), 10);
+  ASSERT(prac::simd::dot(values, ones) == T(49500));
+  prac::vector<T> out;
+  prac::simd::transform(values, ones, out, prac::simd::plus());
+  ASSERT_EQ(out.size(), values.size());
+  ASSERT(out[999] == T(100));
+  prac::simd::transform(values, T(2), out, prac::simd::multiplies());
+  ASSERT(out[999] == T(198));
+  // Unequal sizes stop at the shorter vector, in either order.
+  prac::vector<T> few(37, T(5));
+  prac::simd::transform(values, few, out, prac::simd::plus());
+  ASSERT_EQ(out.size(), 37);
+  ASSERT(out[36] == T(41));
+  prac::simd::transform(few, values, out, prac::simd::minus());
+  ASSERT_EQ(out.size(), 37);
+  ASSERT(out[36] == T(5 - 36));
+}
+
+void testCountOverflow() {
+  // More matches than a one-byte lane can count.
+  std::vector<int8_t> bytes(100000, 7);
+  bytes[500] = 8;
+  for (prac::simd::isa set : supportedSets()) {
+    prac::simd::set_isa(set);
+    ASSERT_EQ(prac::simd::count(bytes.data(), bytes.size(), int8_t(7)),
+              99999);
+    ASSERT_EQ(prac::simd::find(bytes.data(), bytes.size(), int8_t(8)), 500);
+  }
+  // Integer arithmetic wraps, in the vector lanes and the scalar ends.
+  std::vector<int32_t> big(66, INT32_MAX);
+  std::vector<int32_t> sums(big.size());
+  std::vector<uint16_t> wide(66, 65535);
+  std::vector<uint16_t> products(wide.size());
+  for (prac::simd::isa set : supportedSets()) {
+    prac::simd::set_isa(set);
+    ASSERT_EQ(prac::simd::sum(big.data(), big.size()), -66);
+    // (2^31 - 1)^2 is 1 modulo 2^32.
+    ASSERT_EQ(prac::simd::dot(big.data(), big.data(), big.size()), 66);
+    prac::simd::transform(big.data(), big.data(), sums.data(), big.size(),
+                          prac::simd::plus());
+    ASSERT(sums == std::vector<int32_t>(big.size(), -2));
+    prac::simd::transform(wide.data(), uint16_t(65535), products.data(),
+                          wide.size(), prac::simd::multiplies());
+    ASSERT(products == std::vector<uint16_t>(wide.size(), 1));
+  }
+  prac::simd::set_isa(prac::simd::detected_isa());
+}
+
+int main(int argc, char **argv) {
+  testKernels<float>();
+  testKernels<double>();
+  testKernels<int32_t>();
+  testKernels<int64_t>();
+  testKernels<int16_t>();
+  testVectorOverloads<float>();
+  testVectorOverloads<int32_t>();
+  testVectorOverloads<int64_t>();
+  testCountOverflow();
+}
@@ -0,0 +1,160 @@
+#include "small_vector.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename T, size_t N>
+void fillRandom(prac::small_vector<T, N> *vec, std::vector<T> *stl_vec,
+                const size_t &size) {
+  for (size_t j = 0; j < size; j++) {
+    T val = randomVal<T>();
+    vec->push_back(val);
+    stl_vec->push_back(val);
+  }
+}
+
+template <typename Vector, typename T>
+void assertSame(const Vector &vec, const std::vector<T> &stl_vec) {
+  ASSERT_EQ(vec.size(), stl_vec.size());
+  for (size_t i = 0; i < stl_vec.size(); i++) {
+    ASSERT(vec[i] == stl_vec[i]);
+  }
+}
+
+}; // namespace
+
+void testStaysInline() {
+  // Up to N trivially copyable elements never touch the heap.
+  size_t allocations_before = g_num_allocations;
+  {
+    prac::small_vector<int, 8> vec;
+    for (int i = 0; i < 8; i++) {
+      vec.push_back(i);
+    }
+    prac::small_vector<int, 8> filled(8, 3);
+    prac::small_vector<int, 8> copied(vec);
+    prac::small_vector<int, 8> moved(std::move(copied));
+    copied = filled;
+    std::sort(vec.rbegin(), vec.rend());
+    ASSERT_EQ(vec[0], 7);
+    ASSERT_EQ(moved[7], 7);
+    ASSERT_EQ(copied[7], 3);
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  // The inline bookkeeping lives in small_vector only.
+  ASSERT(sizeof(prac::vector<int>) <= 4 * sizeof(size_t));
+}
+
+template <typename T> void testSpill() {
+  prac::small_vector<T, 4> vec;
+  std::vector<T> stl_vec;
+  fillRandom(&vec, &stl_vec, 4);
+  assertSame(vec, stl_vec);
+  // The fifth element moves everything to the heap.
+  size_t allocations_before = g_num_allocations;
+  fillRandom(&vec, &stl_vec, 1);
+  ASSERT(g_num_allocations > allocations_before);
+  fillRandom(&vec, &stl_vec, rand() % 50);
+  assertSame(vec, stl_vec);
+  size_t num_visitations = 0;
+  for (const auto &elem : vec) {
+    ASSERT(elem == stl_vec[num_visitations]);
+    num_visitations++;
+  }
+  ASSERT_EQ(num_visitations, stl_vec.size());
+  vec.resize(2);
+  stl_vec.resize(2);
+  assertSame(vec, stl_vec);
+}
+
+template <typename T> void testCopyAndMove() {
+  for (size_t size = 0; size < 12; size++) {
+    prac::small_vector<T, 6> vec;
+    std::vector<T> stl_vec;
+    fillRandom(&vec, &stl_vec, size);
+    prac::small_vector<T, 6> copied(vec);
+    assertSame(copied, stl_vec);
+    prac::small_vector<T, 6> moved(std::move(copied));
+    assertSame(moved, stl_vec);
+    ASSERT_EQ(copied.size(), 0);
+    // A moved-from small_vector is usable again.
+    copied.push_back(randomVal<T>());
+    ASSERT_EQ(copied.size(), 1);
+    // Copying and moving from a plain vector.
+    prac::vector<T> plain(stl_vec.begin(), stl_vec.end());
+    prac::small_vector<T, 6> copied_plain(plain);
+    assertSame(copied_plain, stl_vec);
+    prac::small_vector<T, 6> from_plain(std::move(plain));
+    assertSame(from_plain, stl_vec);
+    ASSERT_EQ(plain.size(), 0);
+    // Assignment keeps elements that fit inline.
+    prac::small_vector<T, 6> assigned;
+    assigned = from_plain;
+    assertSame(assigned, stl_vec);
+    prac::small_vector<T, 6> move_assigned(20, randomVal<T>());
+    move_assigned = std::move(assigned);
+    assertSame(move_assigned, stl_vec);
+    move_assigned = std::move(moved);
+    assertSame(move_assigned, stl_vec);
+  }
+}
+
+template <typename T> void testSwap() {
+  // Every combination of inline and heap storage.
+  size_t sizes[] = {0, 3, 5, 20};
+  for (size_t first_size : sizes) {
+    for (size_t second_size : sizes) {
+      prac::small_vector<T, 5> first;
+      prac::small_vector<T, 5> second;
+      std::vector<T> stl_first;
+      std::vector<T> stl_second;
+      fillRandom(&first, &stl_first, first_size);
+      fillRandom(&second, &stl_second, second_size);
+      first.swap(second);
+      assertSame(first, stl_second);
+      assertSame(second, stl_first);
+    }
+  }
+}
+
+template <typename T> void testShrinkToFit() {
+  prac::small_vector<T, 4> vec;
+  std::vector<T> stl_vec;
+  fillRandom(&vec, &stl_vec, 10);
+  vec.resize(3);
+  stl_vec.resize(3);
+  // Three elements fit inline again, so they move back without
+  // allocating and the heap storage is freed.
+  size_t allocations_before = g_num_allocations;
+  vec.shrink_to_fit();
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  ASSERT_EQ(vec.capacity(), 4);
+  assertSame(vec, stl_vec);
+  fillRandom(&vec, &stl_vec, 1);
+  ASSERT_EQ(vec.capacity(), 4);
+  assertSame(vec, stl_vec);
+  // Past N, shrinking allocates exactly the size.
+  fillRandom(&vec, &stl_vec, 5);
+  vec.shrink_to_fit();
+  ASSERT_EQ(vec.capacity(), 9);
+  assertSame(vec, stl_vec);
+}
+
+template <typename T> void testAll() {
+  for (size_t trials = 0; trials < 20; trials++) {
+    testSpill<T>();
+    testCopyAndMove<T>();
+    testSwap<T>();
+    testShrinkToFit<T>();
+  }
+}
+
+int main(int argc, char **argv) {
+  testStaysInline();
+  testAll<int>();
+  testAll<std::string>();
+}
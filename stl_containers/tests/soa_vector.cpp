@@ -0,0 +1,227 @@
+#include "soa_vector.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+typedef prac::soa_vector<uint64_t, double, std::string> Trades;
+
+/// Throws on the copy after next, to check that a failed push_back
+/// leaves every column as it was.
+struct ThrowOnCopy {
+  static int copies_left;
+
+  ThrowOnCopy() = default;
+  ThrowOnCopy(const ThrowOnCopy &) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy failed");
+    }
+  }
+  ThrowOnCopy &operator=(const ThrowOnCopy &) = default;
+};
+int ThrowOnCopy::copies_left = 0;
+
+Trades
+randomTrades(std::vector<std::tuple<uint64_t, double, std::string>> &rows,
+             const size_t &n) {
+  Trades trades;
+  for (size_t i = 0; i < n; i++) {
+    rows.emplace_back(randomVal<int>(), randomVal<int>() / 7.0,
+                      randomVal<std::string>());
+    trades.push_back(rows.back());
+  }
+  return trades;
+}
+
+}; // namespace
+
+void testSpan() {
+  prac::vector<int> values;
+  for (int i = 0; i < 10; i++) {
+    values.push_back(i);
+  }
+  prac::span<int> all(values);
+  ASSERT_EQ(all.size(), 10);
+  ASSERT(all.data() == values.data());
+  all[3] = 30;
+  ASSERT_EQ(values[3], 30);
+  prac::span<const int> read_only = all;
+  ASSERT_EQ(read_only.back(), 9);
+  ASSERT_EQ(read_only.subspan(2, 3).front(), 2);
+  ASSERT_EQ(read_only.subspan(2, 3).size(), 3);
+  ASSERT_EQ(read_only.first(4).back(), 30);
+  ASSERT_EQ(read_only.last(2).front(), 8);
+  int sum = 0;
+  for (int value : read_only) {
+    sum += value;
+  }
+  ASSERT_EQ(sum, 45 - 3 + 30);
+  const prac::vector<int> &const_values = values;
+  prac::span<const int> from_const(const_values);
+  ASSERT_EQ(from_const.size(), 10);
+  ASSERT(prac::span<int>().empty());
+}
+
+void testPushBack() {
+  std::vector<std::tuple<uint64_t, double, std::string>> rows;
+  Trades trades = randomTrades(rows, 100);
+  trades.emplace_back(7, 1.5, "venue");
+  rows.emplace_back(7, 1.5, "venue");
+  std::tuple<uint64_t, double, std::string> moved(8, 2.5,
+                                                   std::string(100, 'x'));
+  trades.push_back(std::move(moved));
+  rows.emplace_back(8, 2.5, std::string(100, 'x'));
+  ASSERT(std::get<2>(moved).empty());
+  ASSERT_EQ(trades.size(), rows.size());
+  ASSERT(!trades.empty());
+  ASSERT(trades.capacity() >= trades.size());
+
+  for (size_t i = 0; i < rows.size(); i++) {
+    ASSERT(trades[i] == rows[i]);
+    ASSERT(trades[i].value() == rows[i]);
+    ASSERT_EQ(trades.column<0>()[i], std::get<0>(rows[i]));
+    ASSERT(trades.data<2>()[i] == std::get<2>(rows[i]));
+  }
+  // Writing through a row reference.
+  std::get<1>(trades[5]) = -1.0;
+  ASSERT_EQ(trades.column<1>()[5], -1.0);
+  auto [id, price, venue] = trades[6];
+  id = 12345;
+  venue = "renamed";
+  ASSERT_EQ(trades.column<0>()[6], 12345);
+  ASSERT(trades.column<2>()[6] == "renamed");
+  ASSERT_EQ(price, std::get<1>(rows[6]));
+
+  trades.pop_back();
+  ASSERT_EQ(trades.size(), rows.size() - 1);
+  ASSERT_EQ(trades.column<2>().size(), rows.size() - 1);
+  trades.clear();
+  ASSERT(trades.empty());
+  ASSERT_EQ(trades.column<1>().size(), 0);
+}
+
+void testColumns() {
+  // Column spans are plain arrays: a loop over one field touches only
+  // that field's memory.
+  prac::soa_vector<int, float, int64_t> rows;
+  rows.reserve(1000);
+  ASSERT(rows.capacity() >= 1000);
+  size_t allocations_before = g_num_allocations;
+  int64_t expected = 0;
+  for (int i = 0; i < 1000; i++) {
+    rows.emplace_back(i, float(i) / 2, int64_t(i) * 3);
+    expected += int64_t(i) * 3;
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  int64_t sum = 0;
+  for (int64_t value : rows.column<2>()) {
+    sum += value;
+  }
+  ASSERT_EQ(sum, expected);
+  prac::span<float> halves = rows.column<1>();
+  for (float &half : halves) {
+    half *= 2;
+  }
+  const auto &const_rows = rows;
+  prac::span<const int> ints = const_rows.column<0>();
+  prac::span<const float> floats = const_rows.column<1>();
+  for (size_t i = 0; i < rows.size(); i++) {
+    ASSERT_EQ(float(ints[i]), floats[i]);
+  }
+
+  rows.resize(1500);
+  ASSERT_EQ(rows.size(), 1500);
+  ASSERT_EQ(rows.column<2>()[1499], 0);
+  ASSERT_EQ(rows.column<0>()[999], 999);
+  rows.resize(10);
+  ASSERT_EQ(rows.column<1>().size(), 10);
+  rows.shrink_to_fit();
+  ASSERT_EQ(rows.capacity(), 10);
+}
+
+void testIterators() {
+  std::vector<std::tuple<uint64_t, double, std::string>> rows;
+  Trades trades = randomTrades(rows, 500);
+  ASSERT_EQ(size_t(trades.end() - trades.begin()), trades.size());
+  size_t i = 0;
+  for (auto row : trades) {
+    ASSERT(row == rows[i]);
+    i++;
+  }
+  const Trades &const_trades = trades;
+  Trades::const_iterator citr = trades.begin();
+  ASSERT(citr == const_trades.begin());
+  ASSERT(*(citr + 3) == rows[3]);
+  ASSERT(citr[4] == rows[4]);
+  ASSERT(const_trades.end() - 1 == const_trades.begin() + 499);
+
+  // std algorithms move whole rows through the references.
+  std::sort(trades.begin(), trades.end(),
+            [](const Trades::reference &a, const Trades::reference &b) {
+              return std::get<1>(a) < std::get<1>(b);
+            });
+  std::stable_sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+    return std::get<1>(a) < std::get<1>(b);
+  });
+  prac::span<const double> prices = const_trades.column<1>();
+  ASSERT(std::is_sorted(prices.begin(), prices.end()));
+  // Ties may have been reordered, but each row stays together.
+  std::vector<std::tuple<uint64_t, double, std::string>> sorted_rows;
+  for (auto row : trades) {
+    sorted_rows.push_back(row.value());
+  }
+  std::sort(sorted_rows.begin(), sorted_rows.end());
+  std::sort(rows.begin(), rows.end());
+  ASSERT(sorted_rows == rows);
+
+  std::sort(trades.begin(), trades.end());
+  for (size_t j = 0; j < rows.size(); j++) {
+    ASSERT(trades[j] == rows[j]);
+  }
+  std::reverse(trades.begin(), trades.end());
+  ASSERT(trades[0] == rows.back());
+  auto found = std::find_if(trades.begin(), trades.end(),
+                            [&](const Trades::reference &row) {
+                              return std::get<2>(row) == std::get<2>(rows[7]);
+                            });
+  ASSERT(found != trades.end());
+  ASSERT(std::get<0>(*found) == std::get<0>(rows[7]));
+  swap(trades[0], trades[1]);
+  ASSERT(trades[1] == rows.back());
+}
+
+void testExceptionSafety() {
+  prac::soa_vector<std::string, ThrowOnCopy, int> rows;
+  ThrowOnCopy thrower;
+  for (int i = 0; i < 20; i++) {
+    ThrowOnCopy::copies_left = 100;
+    rows.emplace_back(std::string(50, 'a'), thrower, i);
+  }
+  ThrowOnCopy::copies_left = 0;
+  bool threw = false;
+  try {
+    rows.emplace_back(std::string(50, 'b'), thrower, 20);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ASSERT_EQ(rows.size(), 20);
+  ASSERT_EQ(rows.column<0>().size(), 20);
+  ASSERT_EQ(rows.column<2>().size(), 20);
+  ASSERT(rows.column<0>().back() == std::string(50, 'a'));
+  ASSERT_EQ(rows.column<2>().back(), 19);
+}
+
+int main(int argc, char **argv) {
+  testSpan();
+  testPushBack();
+  testColumns();
+  testIterators();
+  testExceptionSafety();
+}
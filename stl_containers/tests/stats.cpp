@@ -0,0 +1,107 @@
+#include "list.hpp"
+#include "assert.hpp"
+#include "small_vector.hpp"
+#include "test_utils.hpp"
+#include "vector.hpp"
+#include <sstream>
+#include <string>
+
+// This test is built with PRAC_CONTAINER_STATS defined.
+
+void testVectorStats() {
+  prac::stats_registry::global().reset();
+  prac::vector<std::string> vec;
+  // The default constructor allocates nothing.
+  ASSERT_EQ(vec.stats().reallocations, 0);
+  ASSERT_EQ(vec.stats().peak_capacity, 0);
+  for (size_t i = 0; i < 11; i++) {
+    vec.push_back(randomVal<std::string>());
+  }
+  // The first element allocated 10, which isn't a reallocation. The
+  // 11th doubled the capacity and relocated 10 elements.
+  ASSERT_EQ(vec.stats().reallocations, 1);
+  ASSERT_EQ(vec.stats().elements_relocated, 10);
+  ASSERT_EQ(vec.stats().peak_capacity, 20);
+  // resize() doubles too, leaving 15 elements of slack.
+  vec.resize(25);
+  ASSERT_EQ(vec.stats().reallocations, 2);
+  ASSERT_EQ(vec.stats().elements_relocated, 21);
+  ASSERT_EQ(vec.stats().slack_capacity, 15);
+  ASSERT_EQ(vec.stats().peak_capacity, 40);
+
+  prac::vector<int> other;
+  for (int i = 0; i < 100; i++) {
+    other.push_back(i);
+  }
+  prac::container_stats totals =
+      prac::stats_registry::global().snapshot(prac::stats_kind::vector);
+  ASSERT_EQ(totals.reallocations,
+            vec.stats().reallocations + other.stats().reallocations);
+  ASSERT_EQ(totals.elements_relocated, vec.stats().elements_relocated +
+                                           other.stats().elements_relocated);
+  ASSERT_EQ(totals.peak_capacity, 160);
+}
+
+void testMovedVectorStats() {
+  prac::vector<int> vec;
+  for (int i = 0; i < 11; i++) {
+    vec.push_back(i);
+  }
+  ASSERT_EQ(vec.stats().reallocations, 1);
+  // The counters go wherever the storage goes.
+  prac::vector<int> moved(std::move(vec));
+  ASSERT_EQ(moved.stats().reallocations, 1);
+  ASSERT_EQ(moved.stats().peak_capacity, 20);
+  ASSERT_EQ(vec.stats().reallocations, 0);
+  prac::vector<int> assigned;
+  assigned = std::move(moved);
+  ASSERT_EQ(assigned.stats().reallocations, 1);
+  ASSERT_EQ(moved.stats().reallocations, 0);
+  prac::vector<int> swapped(5, 0);
+  swapped.swap(assigned);
+  ASSERT_EQ(swapped.stats().reallocations, 1);
+  ASSERT_EQ(swapped.stats().peak_capacity, 20);
+  ASSERT_EQ(assigned.stats().reallocations, 0);
+  ASSERT_EQ(assigned.stats().peak_capacity, 5);
+}
+
+void testSmallVectorStats() {
+  prac::small_vector<int, 4> vec;
+  for (int i = 0; i < 4; i++) {
+    vec.push_back(i);
+  }
+  ASSERT_EQ(vec.stats().reallocations, 0);
+  // Spilling out of the inline storage counts as a reallocation.
+  vec.push_back(4);
+  ASSERT_EQ(vec.stats().reallocations, 1);
+  ASSERT_EQ(vec.stats().elements_relocated, 4);
+}
+
+void testListStats() {
+  prac::stats_registry::global().reset();
+  prac::list<int> new_list;
+  for (int i = 0; i < 10; i++) {
+    new_list.push_back(i);
+  }
+  for (int i = 0; i < 4; i++) {
+    new_list.pop_front();
+  }
+  ASSERT_EQ(new_list.stats().node_allocations, 10);
+  ASSERT_EQ(new_list.stats().node_frees, 4);
+  prac::container_stats totals =
+      prac::stats_registry::global().snapshot(prac::stats_kind::list);
+  ASSERT_EQ(totals.node_allocations, 10);
+  ASSERT_EQ(totals.node_frees, 4);
+
+  std::ostringstream out;
+  prac::stats_registry::global().dump(out);
+  ASSERT(out.str().find("prac::list: ") != std::string::npos);
+  ASSERT(out.str().find("node_allocations=10") != std::string::npos);
+}
+
+int main(int argc, char **argv) {
+  testVectorStats();
+  testMovedVectorStats();
+  testSmallVectorStats();
+  testListStats();
+}
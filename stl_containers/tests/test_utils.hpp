@@ -1,7 +1,55 @@
+#include <atomic>
+#include <new>
+#include <stdlib.h>
 #include <string>
 #include <vector>
 #pragma once
 
+/// Number of calls to the global operator new in this test binary.
+/// Atomic, since the parallel tests allocate from several threads.
+std::atomic<size_t> g_num_allocations(0);
+
+void *operator new(size_t size) {
+  g_num_allocations++;
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  g_num_allocations++;
+  size_t align = static_cast<size_t>(alignment);
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  size = (size + align - 1) / align * align;
+  void *ptr = aligned_alloc(align, size == 0 ? align : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+  free(ptr);
+}
+
+/// Used by std::stable_sort's temporary buffer, among others.
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  g_num_allocations++;
+  return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  free(ptr);
+}
+
 template <typename T> T randomVal() { return T(rand() % 1000); }
 
 template <> std::string randomVal<std::string>() {
@@ -13,3 +61,36 @@ template <> std::string randomVal<std::string>() {
   return new_val;
 }
 
+
+/// A value type that counts how often it is copied and moved.
+struct CopyCounter {
+  static size_t num_copies;
+  static size_t num_moves;
+  static void reset() {
+    num_copies = 0;
+    num_moves = 0;
+  }
+
+  CopyCounter(int value_in = 0) : value(value_in) {}
+  CopyCounter(const CopyCounter &other) : value(other.value) { num_copies++; }
+  CopyCounter(CopyCounter &&other) noexcept : value(other.value) {
+    num_moves++;
+  }
+  CopyCounter &operator=(const CopyCounter &other) {
+    value = other.value;
+    num_copies++;
+    return *this;
+  }
+  CopyCounter &operator=(CopyCounter &&other) noexcept {
+    value = other.value;
+    num_moves++;
+    return *this;
+  }
+  bool operator==(const CopyCounter &other) const {
+    return value == other.value;
+  }
+
+  int value;
+};
+size_t CopyCounter::num_copies = 0;
+size_t CopyCounter::num_moves = 0;
@@ -0,0 +1,247 @@
+#include "unordered_map.hpp"
+#include "assert.hpp"
+#include "test_utils.hpp"
+#include "unordered_set.hpp"
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+/// Counts live instances, to check that nothing leaks or is destroyed
+/// twice when elements are shifted and rehashed.
+struct Tracked {
+  static int num_live;
+
+  Tracked(const int &value_in = 0) : value(value_in) { num_live++; }
+  Tracked(const Tracked &other) : value(other.value) { num_live++; }
+  Tracked(Tracked &&other) noexcept : value(other.value) { num_live++; }
+  Tracked &operator=(const Tracked &other) = default;
+  ~Tracked() { num_live--; }
+
+  int value;
+};
+int Tracked::num_live = 0;
+
+/// Puts every key in one of a few home slots, so that probes run
+/// across groups and erases shift long runs.
+struct CollidingHash {
+  size_t operator()(const int &key) const { return size_t(key % 3); }
+};
+
+template <typename Map, typename Expected>
+void assertSameElements(const Map &map, const Expected &expected) {
+  ASSERT_EQ(map.size(), expected.size());
+  ASSERT_EQ(map.empty(), expected.empty());
+  size_t visited = 0;
+  for (const auto &elem : map) {
+    auto it = expected.find(elem.first);
+    ASSERT(it != expected.end());
+    ASSERT(it->second == elem.second);
+    visited++;
+  }
+  ASSERT_EQ(visited, expected.size());
+  for (const auto &elem : expected) {
+    auto it = map.find(elem.first);
+    ASSERT(it != map.end());
+    ASSERT(it->second == elem.second);
+  }
+}
+
+}; // namespace
+
+void testRandomOps() {
+  // Random inserts, erases and lookups, checked against std.
+  prac::unordered_map<int, std::string> map;
+  std::unordered_map<int, std::string> expected;
+  for (int i = 0; i < 50000; i++) {
+    int key = randomVal<int>() % 2000;
+    int op = randomVal<int>() & 3;
+    if (op < 2) {
+      std::string value = std::to_string(i);
+      bool inserted = map.insert(std::make_pair(key, value)).second;
+      ASSERT_EQ(inserted, expected.insert(std::make_pair(key, value)).second);
+    } else if (op == 2) {
+      ASSERT_EQ(map.erase(key), expected.erase(key));
+    } else {
+      ASSERT_EQ(map.contains(key), expected.count(key) == 1);
+      ASSERT_EQ(map.count(key), expected.count(key));
+    }
+    ASSERT(map.load_factor() <= map.max_load_factor());
+  }
+  assertSameElements(map, expected);
+}
+
+void testCollisions() {
+  prac::unordered_map<int, int, CollidingHash> map;
+  std::unordered_map<int, int> expected;
+  for (int i = 0; i < 20000; i++) {
+    int key = randomVal<int>() % 300;
+    if (randomVal<int>() % 3 != 0) {
+      map.insert(std::make_pair(key, i));
+      expected.insert(std::make_pair(key, i));
+    } else {
+      ASSERT_EQ(map.erase(key), expected.erase(key));
+    }
+  }
+  assertSameElements(map, expected);
+  // Erase through iterators until nothing is left.
+  while (!map.empty()) {
+    expected.erase(map.begin()->first);
+    map.erase(map.begin());
+    ASSERT_EQ(map.size(), expected.size());
+  }
+  ASSERT(map.begin() == map.end());
+}
+
+void testHeterogeneous() {
+  prac::unordered_map<std::string, int> map;
+  std::string long_key(100, 'k');
+  map[long_key] = 1;
+  map["short"] = 2;
+  // Looking up a string_view or a C string builds no std::string.
+  size_t allocations_before = g_num_allocations;
+  std::string_view view(long_key);
+  ASSERT(map.find(view) != map.end());
+  ASSERT_EQ(map.find(view)->second, 1);
+  ASSERT(map.contains("short"));
+  ASSERT(!map.contains(view.substr(1)));
+  ASSERT_EQ(map.at(std::string_view("short")), 2);
+  ASSERT_EQ(map.erase(std::string_view("short")), 1);
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+
+  prac::unordered_set<std::string> set{"a", "b", "c"};
+  ASSERT(set.contains(std::string_view("b")));
+  ASSERT(!set.contains("d"));
+}
+
+void testReserve() {
+  prac::unordered_map<int, int> map;
+  ASSERT_EQ(map.bucket_count(), 0);
+  ASSERT(map.find(3) == map.end());
+  map.reserve(1000);
+  size_t buckets = map.bucket_count();
+  ASSERT(buckets >= 1000);
+  ASSERT_EQ(buckets & (buckets - 1), 0);
+  size_t allocations_before = g_num_allocations;
+  for (int i = 0; i < 1000; i++) {
+    map[i] = i;
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  ASSERT_EQ(map.bucket_count(), buckets);
+  // Churn doesn't grow the table: there are no tombstones to clean up.
+  for (int i = 1000; i < 100000; i++) {
+    map.erase(i - 1000);
+    map[i] = i;
+  }
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  ASSERT_EQ(map.bucket_count(), buckets);
+  map.clear();
+  ASSERT(map.empty());
+  ASSERT_EQ(map.bucket_count(), buckets);
+  ASSERT(map.begin() == map.end());
+
+  // Sizes past max_size() throw instead of wrapping the capacity.
+  ASSERT(map.max_size() >= 1000);
+  for (size_t n : {map.max_size() + 1, size_t(-1) - 1}) {
+    bool threw = false;
+    try {
+      map.reserve(n);
+    } catch (const std::length_error &) {
+      threw = true;
+    }
+    ASSERT(threw);
+    ASSERT_EQ(map.bucket_count(), buckets);
+  }
+}
+
+void testMapInterface() {
+  prac::unordered_map<std::string, std::unique_ptr<int>> map;
+  map.emplace("one", std::unique_ptr<int>(new int(1)));
+  std::unique_ptr<int> two(new int(2));
+  ASSERT(map.try_emplace("two", std::move(two)).second);
+  ASSERT(two == nullptr);
+  // The key is there, so the argument isn't moved from.
+  std::unique_ptr<int> other(new int(22));
+  ASSERT(!map.try_emplace("two", std::move(other)).second);
+  ASSERT(other != nullptr);
+  ASSERT_EQ(*map.at("two"), 2);
+  ASSERT(!map.insert_or_assign("two", std::move(other)).second);
+  ASSERT_EQ(*map.at("two"), 22);
+  ASSERT(map["three"] == nullptr);
+  ASSERT_EQ(map.size(), 3);
+  bool threw = false;
+  try {
+    map.at("four");
+  } catch (const std::out_of_range &) {
+    threw = true;
+  }
+  ASSERT(threw);
+
+  prac::unordered_map<int, std::string> small{{1, "a"}, {2, "b"}, {1, "c"}};
+  ASSERT_EQ(small.size(), 2);
+  ASSERT(small.at(1) == "a");
+  prac::unordered_map<int, std::string> copy(small);
+  copy[3] = "c";
+  ASSERT_EQ(small.size(), 2);
+  ASSERT_EQ(copy.size(), 3);
+  prac::unordered_map<int, std::string> moved(std::move(copy));
+  ASSERT_EQ(moved.size(), 3);
+  ASSERT(copy.empty());
+  copy = moved;
+  ASSERT(copy.at(3) == "c");
+  small = std::move(moved);
+  ASSERT_EQ(small.size(), 3);
+}
+
+void testLifetimes() {
+  {
+    prac::unordered_map<int, Tracked> map;
+    for (int i = 0; i < 5000; i++) {
+      map.try_emplace(i, i);
+      if (i % 3 == 0) {
+        map.erase(i / 2);
+      }
+    }
+    for (const auto &elem : map) {
+      ASSERT_EQ(elem.first, elem.second.value);
+    }
+    ASSERT_EQ(Tracked::num_live, int(map.size()));
+    prac::unordered_map<int, Tracked> copy(map);
+    ASSERT_EQ(Tracked::num_live, int(2 * map.size()));
+    copy.clear();
+    ASSERT_EQ(Tracked::num_live, int(map.size()));
+  }
+  ASSERT_EQ(Tracked::num_live, 0);
+}
+
+void testSet() {
+  prac::unordered_set<int> set;
+  std::set<int> expected;
+  for (int i = 0; i < 10000; i++) {
+    int value = randomVal<int>() % 500;
+    if (randomVal<int>() & 1) {
+      ASSERT_EQ(set.insert(value).second, expected.insert(value).second);
+    } else {
+      ASSERT_EQ(set.erase(value), expected.erase(value));
+    }
+  }
+  ASSERT_EQ(set.size(), expected.size());
+  std::set<int> visited(set.begin(), set.end());
+  ASSERT(visited == expected);
+  set.insert(expected.begin(), expected.end());
+  ASSERT_EQ(set.size(), expected.size());
+}
+
+int main(int argc, char **argv) {
+  testRandomOps();
+  testCollisions();
+  testHeterogeneous();
+  testReserve();
+  testMapInterface();
+  testLifetimes();
+  testSet();
+}
@@ -3,7 +3,12 @@
 #include "test_utils.hpp"
 #include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <stdint.h>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace {
@@ -133,11 +138,26 @@ template <typename T> void testResizeSmaller() {
   int new_size = size_before - 10;
   vec.resize(new_size, val);
   ASSERT_EQ(vec.size(), new_size);
-  for (size_t i = 0; i < size_before; i++) {
+  // Elements past the new size are destroyed, so only the
+  // survivors can be checked.
+  for (size_t i = 0; i < new_size; i++) {
     ASSERT(vec[i] == stl_vec[i]);
   }
 }
 
+template <typename T> void testPopBack() {
+  std::vector<T> stl_vec;
+  prac::vector<T> vec = randomVector<T>(&stl_vec);
+  size_t capacity = vec.capacity();
+  while (vec.size() > 0) {
+    ASSERT(vec[vec.size() - 1] == stl_vec.back());
+    vec.pop_back();
+    stl_vec.pop_back();
+    ASSERT_EQ(vec.size(), stl_vec.size());
+  }
+  ASSERT_EQ(vec.capacity(), capacity);
+}
+
 template <typename T> void testIterConstruction() {
   std::vector<T> stl_vec;
   prac::vector<T> vec = randomVector<T>(&stl_vec, rand() % 30 + 20);
@@ -219,6 +239,353 @@ template <typename T> void testAlgorithms() {
   }
 }
 
+void testGrowthDoesNotCopy() {
+  // Growing the storage should move existing elements rather than
+  // copy them, so the only copies are the ones push_back makes.
+  prac::vector<CopyCounter> vec;
+  CopyCounter::reset();
+  const size_t num_elements = 1000;
+  for (size_t i = 0; i < num_elements; i++) {
+    CopyCounter val(i);
+    vec.push_back(val);
+  }
+  ASSERT_EQ(CopyCounter::num_copies, num_elements);
+  ASSERT(CopyCounter::num_moves > 0);
+  for (size_t i = 0; i < num_elements; i++) {
+    ASSERT_EQ(vec[i].value, i);
+  }
+  // Copies and moves of the whole vector keep every element.
+  prac::vector<CopyCounter> copied(vec);
+  prac::vector<CopyCounter> moved(std::move(vec));
+  ASSERT_EQ(vec.size(), 0);
+  ASSERT_EQ(copied.size(), num_elements);
+  ASSERT_EQ(moved.size(), num_elements);
+  for (size_t i = 0; i < num_elements; i++) {
+    ASSERT(copied[i] == moved[i]);
+  }
+  // A moved-from vector can be reused.
+  vec.push_back(CopyCounter(1));
+  ASSERT_EQ(vec[0].value, 1);
+}
+
+void testEmplace() {
+  // A string long enough to defeat the small string optimization,
+  // so every copy of it costs an allocation.
+  const std::string payload(100, 'x');
+  prac::vector<std::string> vec;
+  vec.reserve(10);
+  size_t allocations_before = g_num_allocations;
+  vec.push_back(payload);
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  // Moving in or constructing in place doesn't copy the payload.
+  std::string moved_payload(payload);
+  allocations_before = g_num_allocations;
+  vec.push_back(std::move(moved_payload));
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  allocations_before = g_num_allocations;
+  vec.emplace_back(100, 'y');
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  ASSERT(vec[0] == payload);
+  ASSERT(vec[1] == payload);
+  ASSERT(vec[2] == std::string(100, 'y'));
+
+  prac::vector<CopyCounter> counters;
+  CopyCounter::reset();
+  counters.emplace_back(3);
+  counters.push_back(CopyCounter(4));
+  ASSERT_EQ(CopyCounter::num_copies, 0);
+  ASSERT_EQ(CopyCounter::num_moves, 1);
+
+  // Insert in the middle, at the front and at the end.
+  prac::vector<int> ints;
+  for (int i = 0; i < 20; i++) {
+    ints.push_back(i * 2);
+  }
+  auto itr = ints.emplace(ints.begin() + 5, 9);
+  ASSERT_EQ(*itr, 9);
+  ints.emplace(ints.begin(), -1);
+  ints.emplace(ints.end(), 100);
+  ASSERT_EQ(ints.size(), 23);
+  ASSERT_EQ(ints[0], -1);
+  ASSERT_EQ(ints[5], 8);
+  ASSERT_EQ(ints[6], 9);
+  ASSERT_EQ(ints[7], 10);
+  ASSERT_EQ(ints[22], 100);
+  // Inserting a copy of one of our own elements.
+  ints.emplace(ints.begin(), ints[22]);
+  ASSERT_EQ(ints[0], 100);
+}
+
+template <typename T> void testRandomAccess() {
+  typedef typename prac::vector<T>::iterator iterator;
+  typedef typename prac::vector<T>::const_iterator const_iterator;
+  static_assert(
+      std::is_same<typename std::iterator_traits<iterator>::iterator_category,
+                   std::random_access_iterator_tag>::value,
+      "vector iterators should be random access");
+  static_assert(std::is_signed<typename std::iterator_traits<
+                    const_iterator>::difference_type>::value,
+                "vector iterator differences should be signed");
+#if __cplusplus >= 202002L
+  static_assert(std::contiguous_iterator<iterator>);
+  static_assert(std::contiguous_iterator<const_iterator>);
+#endif
+  std::vector<T> stl_vec;
+  prac::vector<T> vec = randomVector<T>(&stl_vec, rand() % 30 + 20);
+  ASSERT(vec.data() == &vec[0]);
+  ASSERT(vec.begin() - vec.end() < 0);
+  ASSERT_EQ(vec.end() - vec.begin(), vec.size());
+  ASSERT(vec.begin() <= vec.end());
+  ASSERT(vec.end() >= vec.begin());
+  ASSERT(vec.begin()[3] == vec[3]);
+  auto itr = vec.begin();
+  itr += 5;
+  ASSERT(*itr == vec[5]);
+  itr -= 2;
+  ASSERT(*itr == vec[3]);
+
+  // Const access goes through const_iterator and const_reverse_iterator.
+  const prac::vector<T> &const_vec = vec;
+  size_t i = 0;
+  for (const_iterator citr = const_vec.begin(); citr != const_vec.end();
+       citr++) {
+    ASSERT(*citr == stl_vec[i]);
+    i++;
+  }
+  ASSERT_EQ(i, stl_vec.size());
+  ASSERT(const_vec.cbegin() == vec.begin());
+  for (auto ritr = const_vec.crbegin(); ritr != const_vec.crend(); ritr++) {
+    i--;
+    ASSERT(*ritr == stl_vec[i]);
+  }
+  ASSERT(const_vec.rbegin() == const_vec.crbegin());
+
+  // Algorithms that need random access.
+  std::sort(vec.begin(), vec.end());
+  std::sort(stl_vec.begin(), stl_vec.end());
+  T needle = stl_vec[stl_vec.size() / 2];
+  ASSERT_EQ(std::lower_bound(vec.begin(), vec.end(), needle) - vec.begin(),
+            std::lower_bound(stl_vec.begin(), stl_vec.end(), needle) -
+                stl_vec.begin());
+  std::vector<T> copied(vec.size());
+  std::copy(vec.cbegin(), vec.cend(), copied.begin());
+  ASSERT(copied == stl_vec);
+}
+
+void testGrowthPolicies() {
+  // An empty vector allocates nothing.
+  size_t allocations_before = g_num_allocations;
+  prac::vector<int> empty;
+  prac::vector<int> sized(0);
+  ASSERT_EQ(empty.capacity(), 0);
+  ASSERT_EQ(g_num_allocations - allocations_before, 0);
+  // The sized constructor allocates exactly what it needs.
+  prac::vector<int> exact(7, 1);
+  ASSERT_EQ(exact.capacity(), 7);
+
+  prac::vector<int> doubling;
+  prac::vector<int, prac::allocator<int>, prac::growth_1_5x> one_and_half;
+  size_t doubling_capacities[] = {10, 20, 40, 80};
+  size_t one_and_half_capacities[] = {10, 15, 22, 33};
+  for (size_t i = 0; i < 4; i++) {
+    doubling.resize(doubling.capacity() + 1);
+    one_and_half.resize(one_and_half.capacity() + 1);
+    ASSERT_EQ(doubling.capacity(), doubling_capacities[i]);
+    ASSERT_EQ(one_and_half.capacity(), one_and_half_capacities[i]);
+  }
+  // A jump past the next step goes straight to the requested size.
+  doubling.resize(1000);
+  ASSERT_EQ(doubling.capacity(), 1000);
+
+  // Page rounding fills the last page with elements.
+  prac::vector<int, prac::allocator<int>,
+               prac::page_rounded<prac::growth_1_5x>>
+      paged;
+  paged.push_back(1);
+  ASSERT_EQ(paged.capacity(), 1024);
+  paged.resize(1025);
+  ASSERT_EQ(paged.capacity() * sizeof(int) % 4096, 0);
+  ASSERT(paged.capacity() >= 1536);
+
+  // Growing one element at a time reallocates logarithmically often.
+  prac::vector<int> grown;
+  allocations_before = g_num_allocations;
+  for (size_t i = 0; i < 100000; i++) {
+    grown.resize(grown.size() + 1, int(i));
+  }
+  ASSERT(g_num_allocations - allocations_before < 20);
+  ASSERT_EQ(grown[99999], 99999);
+}
+
+/// Grows by a fixed 4 elements, to check user-provided policies work.
+struct GrowByFour {
+  static size_t grow(const size_t &capacity, const size_t &required,
+                     const size_t & /*element_size*/) {
+    return capacity + 4 < required ? required : capacity + 4;
+  }
+};
+
+template <typename T> void testReserveAndShrink() {
+  prac::vector<T, prac::allocator<T>, GrowByFour> vec;
+  std::vector<T> stl_vec;
+  for (size_t i = 0; i < 9; i++) {
+    T val = randomVal<T>();
+    vec.push_back(val);
+    stl_vec.push_back(val);
+  }
+  ASSERT_EQ(vec.capacity(), 12);
+  // reserve() never shrinks and allocates exactly what's asked for.
+  vec.reserve(5);
+  ASSERT_EQ(vec.capacity(), 12);
+  vec.reserve(50);
+  ASSERT_EQ(vec.capacity(), 50);
+  vec.shrink_to_fit();
+  ASSERT_EQ(vec.capacity(), 9);
+  ASSERT_EQ(vec.size(), stl_vec.size());
+  for (size_t i = 0; i < stl_vec.size(); i++) {
+    ASSERT(vec[i] == stl_vec[i]);
+  }
+  // Shrinking an empty vector gives back all of its storage.
+  vec.clear();
+  vec.shrink_to_fit();
+  ASSERT_EQ(vec.capacity(), 0);
+  ASSERT(vec.data() == nullptr);
+  vec.push_back(stl_vec[0]);
+  ASSERT(vec[0] == stl_vec[0]);
+}
+
+template <typename T> void testBulkInsert() {
+  std::vector<T> values;
+  for (size_t i = 0; i < 30; i++) {
+    values.push_back(randomVal<T>());
+  }
+  // Every split between the elements after pos and the range length.
+  for (size_t size = 0; size < 12; size++) {
+    for (size_t index = 0; index <= size; index++) {
+      for (size_t length = 0; length < 8; length++) {
+        std::vector<T> stl_vec(values.begin(), values.begin() + size);
+        prac::vector<T> vec(stl_vec.begin(), stl_vec.end());
+        ASSERT_EQ(vec.capacity(), size);
+        const T *first = values.data() + 20;
+        auto itr = vec.insert(vec.begin() + index, first, first + length);
+        stl_vec.insert(stl_vec.begin() + index, first, first + length);
+        ASSERT(itr == vec.begin() + index);
+        ASSERT_EQ(vec.size(), stl_vec.size());
+        for (size_t i = 0; i < stl_vec.size(); i++) {
+          ASSERT(vec[i] == stl_vec[i]);
+        }
+      }
+    }
+  }
+
+  // Inserting with room to spare, from a list's iterators.
+  std::list<T> source(values.begin(), values.begin() + 4);
+  prac::vector<T> vec;
+  vec.reserve(40);
+  vec.append(values.begin(), values.begin() + 10);
+  vec.insert(vec.begin() + 2, source.begin(), source.end());
+  ASSERT_EQ(vec.capacity(), 40);
+  ASSERT_EQ(vec.size(), 14);
+  ASSERT(vec[2] == values[0]);
+  ASSERT(vec[5] == values[3]);
+  ASSERT(vec[6] == values[2]);
+  ASSERT(vec[13] == values[9]);
+
+  // assign() replaces the contents, reusing the storage if it fits.
+  vec.assign(values.begin() + 1, values.begin() + 6);
+  ASSERT_EQ(vec.size(), 5);
+  ASSERT_EQ(vec.capacity(), 40);
+  ASSERT(vec[0] == values[1]);
+  vec.assign(values.begin(), values.end());
+  ASSERT_EQ(vec.size(), values.size());
+  ASSERT(vec[29] == values[29]);  vec.assign(source.begin(), source.end());
+  ASSERT_EQ(vec.size(), 4);
+  ASSERT(vec[3] == values[3]);
+}
+
+void testBulkInsertAllocations() {
+  // Loading ids from a std::vector allocates once.
+  std::vector<int> ids(100000);
+  for (size_t i = 0; i < ids.size(); i++) {
+    ids[i] = int(i);
+  }
+  size_t allocations_before = g_num_allocations;
+  prac::vector<int> loaded(ids.begin(), ids.end());
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  ASSERT_EQ(loaded.capacity(), ids.size());
+  ASSERT_EQ(loaded[99999], 99999);
+  allocations_before = g_num_allocations;
+  prac::vector<int> appended;
+  appended.append(ids.data(), ids.data() + ids.size());
+  appended.assign(ids.data(), ids.data() + 10);
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  appended.insert(appended.begin() + 5, ids.data(), ids.data() + 1000);
+  ASSERT_EQ(g_num_allocations - allocations_before, 1);
+  ASSERT_EQ(appended.size(), 1010);
+  ASSERT_EQ(appended[5], 0);
+  ASSERT_EQ(appended[1005], 5);
+
+  // Input ranges are collected, then inserted.
+  std::istringstream input("7 8 9");
+  appended.insert(appended.begin(), std::istream_iterator<int>(input),
+                  std::istream_iterator<int>());
+  ASSERT_EQ(appended.size(), 1013);
+  ASSERT_EQ(appended[0], 7);
+  ASSERT_EQ(appended[2], 9);
+  ASSERT_EQ(appended[3], 0);
+}
+
+void testAlignedStorage() {
+  // Every reallocation keeps the alignment.
+  prac::aligned_vector<float, 64> floats;
+  for (size_t i = 0; i < 10000; i++) {
+    const float *before = floats.data();
+    floats.push_back(float(i));
+    if (floats.data() != before) {
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(floats.data()) % 64, 0);
+    }
+  }
+  ASSERT_EQ(floats[9999], 9999.0f);
+  floats.shrink_to_fit();
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(floats.data()) % 64, 0);
+  prac::aligned_vector<float, 64> copied(floats);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(copied.data()) % 64, 0);
+  ASSERT_EQ(copied[1234], 1234.0f);
+
+  prac::aligned_vector<std::string, 4096> strings;
+  strings.push_back("page aligned");
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(strings.data()) % 4096, 0);
+  // The alignment is at least T's own.
+  static_assert(prac::aligned_allocator<long double, 1>::alignment ==
+                    alignof(long double),
+                "aligned_allocator must honor alignof(T)");
+}
+
+void testOversizedReserve() {
+  // n * sizeof(T) would wrap to a tiny block, so reserve() must throw
+  // and leave the vector as it was.
+  prac::vector<uint64_t> vec(3, 7);
+  bool threw = false;
+  try {
+    vec.reserve(size_t(-1) / sizeof(uint64_t) + 2);
+  } catch (const std::bad_array_new_length &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ASSERT_EQ(vec.capacity(), 3);
+  ASSERT_EQ(vec[2], 7);
+
+  prac::aligned_vector<float, 64> floats;
+  threw = false;
+  try {
+    floats.reserve(size_t(-1) / sizeof(float) + 2);
+  } catch (const std::bad_array_new_length &) {
+    threw = true;
+  }
+  ASSERT(threw);
+  ASSERT_EQ(floats.capacity(), 0);
+}
+
 template <typename T> void testAll() {
   for (size_t trials = 0; trials < 50; trials++) {
     testConstruction<T>();
@@ -228,10 +595,12 @@ template <typename T> void testAll() {
     testReverseIterators<T>();
     testResizeLarger<T>();
     testResizeSmaller<T>();
+    testPopBack<T>();
     testIterConstruction<T>();
     testOperators<T>();
     testReverseOperators<T>();
     testAlgorithms<T>();
+    testRandomAccess<T>();
   }
 }
 
@@ -239,4 +608,14 @@ int main(int argc, char **argv) {
   testAll<int>();
   testAll<std::string>();
   testAlgorithms<int>();
+  testGrowthDoesNotCopy();
+  testEmplace();
+  testGrowthPolicies();
+  testReserveAndShrink<int>();
+  testReserveAndShrink<std::string>();
+  testBulkInsert<int>();
+  testBulkInsert<std::string>();
+  testBulkInsertAllocations();
+  testAlignedStorage();
+  testOversizedReserve();
 }